@@ -108,6 +108,7 @@ namespace gw2b {
         FCC_cmaC = 0x43616d63,
         FCC_mMet = 0x74654d6d,
         FCC_AFNT = 0x544e4641,
+        FCC_PGTB = 0x42544750,  // chunk of PIMG files, the page table
 
         // Not quite FourCC
         FCC_MZ = 0x5a4d,        // Executable or Dynamic Link Library
@@ -348,6 +349,34 @@ namespace gw2b {
         byte uvPSInputIndex;
     };
 
+    /** PIMG file, PGTB chunk layer data. */
+    struct ANetPagedImageLayerData {
+        uint32 rawFormat;               /**< FourCC of the raw pages' textures. */
+        uint32 strippedFormat;          /**< FourCC of the stripped pages' textures. */
+        uint32 depth;
+        uint32 hasMask;
+    };
+
+    /** PIMG file, PGTB chunk page data. */
+    struct ANetPagedImagePageData {
+        uint32 layer;                   /**< Layer the page belongs to. */
+        float coord[2];                 /**< Position of the page in the layer, in pages. */
+        int32 offsetToFileReference;    /**< Offset to the texture file reference, 0 for solid pages. */
+        uint32 flags;
+        byte solidColor[4];             /**< Color of the page if it has no texture, as RGBA. */
+    };
+
+    /** PIMG file, PGTB chunk data, version 3. */
+    struct ANetPagedImageTableData {
+        uint32 layersCount;             /**< Amount of layers. */
+        int32 layersOffset;             /**< Offset to the layers. */
+        uint32 rawPagesCount;           /**< Amount of raw pages. */
+        int32 rawPagesOffset;           /**< Offset to the raw pages. */
+        uint32 strippedPagesCount;      /**< Amount of stripped pages. */
+        int32 strippedPagesOffset;      /**< Offset to the stripped pages. */
+        uint32 flags;
+    };
+
 #pragma pack(pop)
 
 }; // namespace gw2mw
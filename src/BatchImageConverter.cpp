@@ -0,0 +1,243 @@
+/** \file       BatchImageConverter.cpp
+ *  \brief      Contains definition of the batch image converter.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <wx/file.h>
+
+#include "DatFile.h"
+#include "DatIndex.h"
+#include "FileReader.h"
+#include "Readers/ImageReader.h"
+
+#include "BatchImageConverter.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Amount of decode threads. Decoding is cheaper than deflating, so
+        *  the decoders get the smaller half of the cores. */
+        uint numDecoders( ) {
+            return wxMax( std::thread::hardware_concurrency( ) / 2, 1u );
+        }
+
+        /** Amount of encode threads, the rest of the cores. */
+        uint numEncoders( ) {
+            return wxMax( std::thread::hardware_concurrency( ), 2u ) - numDecoders( );
+        }
+
+    };
+
+    BatchImageConverter::BatchImageConverter( DatFile& p_datFile, ImageFileFormat p_format, int p_level )
+        : m_datFile( p_datFile )
+        , m_format( p_format )
+        , m_level( p_level )
+        , m_readImages( numDecoders( ) )
+        , m_decodedImages( numEncoders( ) )
+        , m_startTime( Clock::now( ) )
+        , m_elapsed( 0 )
+        , m_numAdded( 0 )
+        , m_numDone( 0 )
+        , m_numWritten( 0 )
+        , m_readTime( 0 )
+        , m_decodeTime( 0 )
+        , m_encodeTime( 0 )
+        , m_writeTime( 0 ) {
+        for ( uint i = 0; i < numDecoders( ); i++ ) {
+            m_decoders.push_back( std::thread( &BatchImageConverter::decodeThread, this ) );
+        }
+        for ( uint i = 0; i < numEncoders( ); i++ ) {
+            m_encoders.push_back( std::thread( &BatchImageConverter::encodeThread, this ) );
+        }
+    }
+
+    //============================================================================/
+
+    BatchImageConverter::~BatchImageConverter( ) {
+        this->abort( );
+    }
+
+    //============================================================================/
+
+    bool BatchImageConverter::add( const DatIndexEntry& p_entry, const wxString& p_path ) {
+        auto start = Clock::now( );
+
+        ReadImage image;
+        image.path = p_path;
+        image.data = m_datFile.readFile( p_entry.mftEntry( ) );
+        if ( !image.data.GetSize( ) ) {
+            wxLogMessage( wxT( "Failed to read entry %s, most likely due to a decompression error." ), p_entry.name( ) );
+            return false;
+        }
+        m_datFile.identifyFileType( image.data.GetPointer( ), image.data.GetSize( ), image.fileType );
+        m_readTime += microsecondsSince( start );
+
+        // Waits here while the decoders are busy
+        if ( !m_readImages.Push( std::move( image ) ) ) {
+            return false;
+        }
+        m_numAdded++;
+        return true;
+    }
+
+    //============================================================================/
+
+    void BatchImageConverter::finish( ) {
+        m_readImages.Close( );
+        for ( auto& it : m_decoders ) {
+            it.join( );
+        }
+        m_decoders.clear( );
+
+        // Only close the encoders' queue once nothing can push to it anymore
+        m_decodedImages.Close( );
+        this->join( );
+    }
+
+    //============================================================================/
+
+    void BatchImageConverter::abort( ) {
+        m_readImages.Abort( );
+        m_decodedImages.Abort( );
+        this->join( );
+    }
+
+    //============================================================================/
+
+    void BatchImageConverter::join( ) {
+        for ( auto& it : m_decoders ) {
+            it.join( );
+        }
+        for ( auto& it : m_encoders ) {
+            it.join( );
+        }
+        if ( !m_decoders.empty( ) || !m_encoders.empty( ) ) {
+            m_elapsed = microsecondsSince( m_startTime ) / 1e6;
+        }
+        m_decoders.clear( );
+        m_encoders.clear( );
+    }
+
+    //============================================================================/
+
+    wxString BatchImageConverter::report( ) const {
+        auto seconds = [] ( uint64 p_microseconds ) { return p_microseconds / 1e6; };
+        uint numWritten = m_numWritten;
+
+        return wxString::Format( wxT( "Converted %u of %u images in %.2f s, %.1f images/s. Busy time: read %.2f s, decode %.2f s, encode %.2f s, write %.2f s." ),
+            numWritten, m_numAdded, m_elapsed, ( m_elapsed > 0 ) ? numWritten / m_elapsed : 0.0,
+            seconds( m_readTime ), seconds( m_decodeTime ), seconds( m_encodeTime ), seconds( m_writeTime ) );
+    }
+
+    //============================================================================/
+
+    void BatchImageConverter::decodeThread( ) {
+        ReadImage image;
+        while ( m_readImages.Pop( image ) ) {
+            auto start = Clock::now( );
+
+            DecodedImage decoded;
+            decoded.path = image.path;
+
+            // Without an entry number the image isn't looked up in or added to
+            // the image cache. Each image is converted once, caching it would
+            // only cost time and push out the images being browsed.
+            auto reader = FileReader::readerForData( image.data, m_datFile, image.fileType, FileReader::NoEntry );
+            auto imgReader = dynamic_cast<ImageReader*>( reader );
+            if ( imgReader && ( m_format == IFF_DDS ) && imgReader->getDDS( decoded.file ) ) {
+                // No decoding needed, the blocks go to the file as they are
+            } else if ( imgReader ) {
+                auto output = imgReader->getImage( );
+                if ( output.IsOk( ) ) {
+                    auto numPixels = static_cast<size_t>( output.GetWidth( ) ) * output.GetHeight( );
+                    decoded.size = output.GetSize( );
+                    decoded.colors = Array<byte>( numPixels * 3 );
+                    ::memcpy( decoded.colors.GetPointer( ), output.GetData( ), numPixels * 3 );
+                    if ( output.HasAlpha( ) ) {
+                        decoded.alphas = Array<byte>( numPixels );
+                        ::memcpy( decoded.alphas.GetPointer( ), output.GetAlpha( ), numPixels );
+                    }
+                }
+            }
+            deletePointer( reader );
+            image.data = Array<byte>( );
+            m_decodeTime += microsecondsSince( start );
+
+            if ( !decoded.colors.GetSize( ) && !decoded.file.GetSize( ) ) {
+                wxLogMessage( wxT( "Failed to decode image %s." ), image.path );
+                m_numDone++;
+                continue;
+            }
+
+            // Waits here while the encoders are busy
+            if ( !m_decodedImages.Push( std::move( decoded ) ) ) {
+                return;
+            }
+        }
+    }
+
+    //============================================================================/
+
+    void BatchImageConverter::encodeThread( ) {
+        DecodedImage image;
+        while ( m_decodedImages.Pop( image ) ) {
+            auto start = Clock::now( );
+
+            Array<byte> data = image.file;
+            bool isEncoded = data.GetSize( ) > 0;
+            if ( !isEncoded ) {
+                isEncoded = ImageEncoder::encode( image.size, image.colors.GetPointer( ), image.alphas.GetSize( ) ? image.alphas.GetPointer( ) : nullptr, m_format, m_level, data );
+            }
+            image.colors = Array<byte>( );
+            image.alphas = Array<byte>( );
+            image.file = Array<byte>( );
+            m_encodeTime += microsecondsSince( start );
+
+            if ( !isEncoded ) {
+                wxLogMessage( wxT( "Failed to encode image %s." ), image.path );
+                m_numDone++;
+                continue;
+            }
+
+            start = Clock::now( );
+            wxFile file( image.path, wxFile::write );
+            if ( file.IsOpened( ) && file.Write( data.GetPointer( ), data.GetSize( ) ) == data.GetSize( ) ) {
+                m_numWritten++;
+            } else {
+                wxLogMessage( wxT( "Failed to open the file %s for writing." ), image.path );
+            }
+            file.Close( );
+            m_writeTime += microsecondsSince( start );
+            m_numDone++;
+        }
+    }
+
+    //============================================================================/
+
+    uint64 BatchImageConverter::microsecondsSince( const Clock::time_point& p_start ) {
+        return static_cast<uint64>( std::chrono::duration_cast<std::chrono::microseconds>( Clock::now( ) - p_start ).count( ) );
+    }
+
+}; // namespace gw2b
@@ -0,0 +1,138 @@
+/** \file       BatchImageConverter.h
+ *  \brief      Contains declaration of the batch image converter.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef BATCHIMAGECONVERTER_H_INCLUDED
+#define BATCHIMAGECONVERTER_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "ANetStructs.h"
+#include "Util/BoundedQueue.h"
+#include "Util/ImageEncoder.h"
+
+namespace gw2b {
+    class DatFile;
+    class DatIndexEntry;
+
+    /** Converts image entries to image files in three stages: the calling
+    *  thread reads the entries from the .dat, a pool of threads decodes them
+    *  and another pool encodes and writes them.
+    *
+    *  The stages are linked by bounded queues, so reading stalls while the
+    *  pools are busy instead of holding every entry in memory.
+    *
+    *  DDS output keeps block compressed textures as blocks: the decoders only
+    *  inflate them and the encoders just write them. */
+    class BatchImageConverter {
+        typedef std::chrono::steady_clock   Clock;
+
+        /** Entry read from the .dat, waiting to be decoded. */
+        struct ReadImage {
+            wxString        path;
+            ANetFileType    fileType;
+            Array<byte>     data;
+        };
+        /** Decoded image, waiting to be encoded. */
+        struct DecodedImage {
+            wxString        path;
+            wxSize          size;
+            Array<byte>     colors;
+            Array<byte>     alphas;
+            Array<byte>     file;       // Set instead of the pixels when already encoded
+        };
+    private:
+        DatFile&                    m_datFile;
+        ImageFileFormat             m_format;
+        int                         m_level;
+        BoundedQueue<ReadImage>     m_readImages;
+        BoundedQueue<DecodedImage>  m_decodedImages;
+        std::vector<std::thread>    m_decoders;
+        std::vector<std::thread>    m_encoders;
+        Clock::time_point           m_startTime;
+        double                      m_elapsed;
+        uint                        m_numAdded;
+        std::atomic<uint>           m_numDone;
+        std::atomic<uint>           m_numWritten;
+        // Busy time of each stage, in microseconds summed over its threads
+        uint64                      m_readTime;
+        std::atomic<uint64>         m_decodeTime;
+        std::atomic<uint64>         m_encodeTime;
+        std::atomic<uint64>         m_writeTime;
+    public:
+        /** Constructor. Starts the decode and encode pools.
+        *  \param[in]  p_datFile    .dat file to read the entries from. Only
+        *                           used by the calling thread.
+        *  \param[in]  p_format     Format of the written files.
+        *  \param[in]  p_level      Deflate level of PNG files, see ImageEncoder. */
+        BatchImageConverter( DatFile& p_datFile, ImageFileFormat p_format, int p_level );
+        /** Destructor. Aborts the conversion if not finished. */
+        ~BatchImageConverter( );
+
+        /** Reads an entry and queues it for conversion, waiting while the
+        *  decoders are busy.
+        *  \param[in]  p_entry  Entry to convert.
+        *  \param[in]  p_path   Path of the file to write, extension included.
+        *  \return bool    true if queued, false if it could not be read or the
+        *                  conversion was aborted. */
+        bool add( const DatIndexEntry& p_entry, const wxString& p_path );
+        /** Waits for the queued entries to be written and stops the pools. */
+        void finish( );
+        /** Drops the queued entries and stops the pools. */
+        void abort( );
+
+        /** Gets the amount of entries queued so far.
+        *  \return uint    Amount of entries. */
+        uint numAdded( ) const {
+            return m_numAdded;
+        }
+        /** Gets the amount of queued entries that are done, written or failed.
+        *  Safe to call while converting.
+        *  \return uint    Amount of entries. */
+        uint numDone( ) const {
+            return m_numDone;
+        }
+        /** Gets a line telling the images per second and the time spent in
+        *  each stage. Meant to be called after finish().
+        *  \return wxString    The report. */
+        wxString report( ) const;
+
+    private:
+        /** Main loop of the decode threads. */
+        void decodeThread( );
+        /** Main loop of the encode threads. */
+        void encodeThread( );
+        /** Stops the pools, after the queues were closed or aborted. */
+        void join( );
+        /** Gets the microseconds passed since the given time. */
+        static uint64 microsecondsSince( const Clock::time_point& p_start );
+    }; // class BatchImageConverter
+
+}; // namespace gw2b
+
+#endif // BATCHIMAGECONVERTER_H_INCLUDED
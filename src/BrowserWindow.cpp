@@ -39,6 +39,7 @@
 #include "ProgressStatusBar.h"
 #include "PreviewPanel.h"
 #include "PreviewGLCanvas.h"
+#include "ThumbnailGrid.h"
 
 #include "Tasks/ReadIndexTask.h"
 #include "Tasks/ScanDatTask.h"
@@ -54,8 +55,11 @@ namespace gw2b {
         , m_progress( nullptr )
         , m_currentTask( nullptr )
         , m_catTree( nullptr )
+        , m_filterTextBox( nullptr )
+        , m_filterList( nullptr )
         , m_previewPanel( nullptr )
-        , m_previewGLCanvas( nullptr ) {
+        , m_previewGLCanvas( nullptr )
+        , m_thumbnailGrid( nullptr ) {
         // Initializes all available image handlers
         wxInitAllImageHandlers( );
         // Notify wxAUI which frame to use
@@ -68,11 +72,14 @@ namespace gw2b {
         wxAcceleratorEntry openAccel( wxACCEL_CTRL, 'O' );
         fileMenu->Append( wxID_OPEN, wxT( "&Open" ), wxT( "Open a file for browsing" ) )->SetAccel( &openAccel );
         fileMenu->AppendSeparator( );
+        fileMenu->AppendCheckItem( ID_UseEntryCache, wxT( "Use Asset &Cache" ), wxT( "Keep decompressed files on disk to load them faster next time" ) );
+        fileMenu->AppendSeparator( );
         fileMenu->Append( wxID_EXIT, wxT( "E&xit\tAlt+F4" ) );
         // View menu
         auto viewMenu = new wxMenu;
         viewMenu->AppendCheckItem( ID_ShowFindFile, wxT( "&Show Find File Window" ), wxT( "Toggle show find file window" ) );
         viewMenu->AppendCheckItem( ID_ShowFileList, wxT( "&Show File List Window" ), wxT( "Toggle show file list window" ) );
+        viewMenu->AppendCheckItem( ID_ShowFilter, wxT( "&Show Filter Window" ), wxT( "Toggle show filter window" ) );
         viewMenu->AppendCheckItem( ID_ShowLog, wxT( "&Show Log Window" ), wxT( "Toggle show log window" ) );
         //viewMenu->Append( ID_ResetLayout, wxT( "&Reset Layout" ) );
         viewMenu->AppendSeparator( );
@@ -105,6 +112,7 @@ namespace gw2b {
         // Make log window read only
         m_log->SetEditable( false );
         m_logTarget = wxLog::SetActiveTarget( new wxLogTextCtrl( m_log ) );
+        Log::start( );
 
         // Category tree
         m_catTree = new CategoryTree( this );
@@ -121,6 +129,18 @@ namespace gw2b {
         flex->Add( btnFindFile, 1, wxALL | wxALIGN_CENTRE, 5 );
         findPanel->SetSizer( flex );
 
+        // Filter panel
+        auto filterPanel = new wxPanel( this, wxID_ANY, wxDefaultPosition, wxSize( 170, 300 ), wxBORDER_SIMPLE | wxTAB_TRAVERSAL );
+        auto filterSizer = new wxBoxSizer( wxVERTICAL );
+        m_filterTextBox = new wxTextCtrl( filterPanel, wxID_ANY, wxT( "" ) );
+        m_filterTextBox->SetHint( wxT( "ID, ID range or name" ) );
+        m_filterList = new IndexFilterList( filterPanel );
+        m_filterList->setDatIndex( m_index );
+
+        filterSizer->Add( m_filterTextBox, 0, wxALL | wxEXPAND, 5 );
+        filterSizer->Add( m_filterList, 1, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5 );
+        filterPanel->SetSizer( filterSizer );
+
         // Add the panes to the manager
 
         // Find file panel
@@ -129,12 +149,19 @@ namespace gw2b {
         // CategoryTree
         m_uiManager.AddPane( m_catTree, wxAuiPaneInfo( ).Name( wxT( "CategoryTree" ) ).Caption( wxT( "File List" ) ).BestSize( wxSize( 170, 500 ) ).Left( ) );
 
+        // Filter panel
+        m_uiManager.AddPane( filterPanel, wxAuiPaneInfo( ).Name( wxT( "FilterPanel" ) ).Caption( wxT( "Filter" ) ).BestSize( wxSize( 170, 300 ) ).Left( ).Hide( ) );
+
         // Log window
         m_uiManager.AddPane( m_log, wxAuiPaneInfo( ).Name( wxT( "LogWindow" ) ).Caption( wxT( "Log" ) ).Bottom( ).Layer( 1 ).Position( 1 ).Hide( ) );
 
         // Preview panel
         m_previewPanel = new PreviewPanel( this );
 
+        // Thumbnail grid
+        m_thumbnailGrid = new ThumbnailGrid( this );
+        m_thumbnailGrid->addListener( this );
+
         // OpenGL canvas
         m_previewGLCanvas = nullptr;
         wxGLAttributes vAttrs;
@@ -173,6 +200,7 @@ namespace gw2b {
         // Main content window
         m_uiManager.AddPane( m_previewGLCanvas, wxAuiPaneInfo( ).Name( wxT( "gl_content" ) ).CenterPane( ) );
         m_uiManager.AddPane( m_previewPanel, wxAuiPaneInfo( ).Name( wxT( "panel_content" ) ).CenterPane( ).Hide( )  );
+        m_uiManager.AddPane( m_thumbnailGrid, wxAuiPaneInfo( ).Name( wxT( "grid_content" ) ).CenterPane( ).Hide( ) );
 
         // Set default settings
         this->SetDefaults( );
@@ -196,18 +224,27 @@ namespace gw2b {
         this->Bind( wxEVT_MENU, &BrowserWindow::onAboutEvt, this, wxID_ABOUT );
         this->Bind( wxEVT_MENU, &BrowserWindow::onTogglePaneEvt, this, ID_ShowFindFile );
         this->Bind( wxEVT_MENU, &BrowserWindow::onTogglePaneEvt, this, ID_ShowFileList );
+        this->Bind( wxEVT_MENU, &BrowserWindow::onTogglePaneEvt, this, ID_ShowFilter );
         this->Bind( wxEVT_MENU, &BrowserWindow::onTogglePaneEvt, this, ID_ShowLog );
         this->Bind( wxEVT_MENU, &BrowserWindow::onClearLogEvt, this, ID_ClearLog );
+        this->Bind( wxEVT_MENU, &BrowserWindow::onToggleEntryCacheEvt, this, ID_UseEntryCache );
         this->Bind( wxEVT_BUTTON, &BrowserWindow::onButtonEvt, this );
         this->Bind( wxEVT_TEXT_ENTER, &BrowserWindow::onEnterPressedInSrchBoxEvt, this );
         this->Bind( wxEVT_AUI_PANE_CLOSE, &BrowserWindow::onPaneCloseEvt, this );
         this->Bind( wxEVT_CLOSE_WINDOW, &BrowserWindow::onCloseEvt, this );
+        m_filterTextBox->Bind( wxEVT_TEXT, &BrowserWindow::onFilterTextEvt, this );
+        m_filterList->Bind( wxEVT_LIST_ITEM_SELECTED, &BrowserWindow::onFilterItemSelectedEvt, this );
     }
 
     //============================================================================/
 
     BrowserWindow::~BrowserWindow( ) {
         deletePointer( m_currentTask );
+        m_datFile.setEntryCache( nullptr );
+        m_entryCache.close( );
+        m_thumbnailGrid->close( );
+        m_thumbnailCache.close( );
+        Log::stop( );
         deletePointer( m_logTarget );
         // Deinitialize the frame manager
         m_uiManager.UnInit( );
@@ -247,6 +284,12 @@ namespace gw2b {
     //============================================================================/
 
     void BrowserWindow::openFile( const wxString& p_path ) {
+        // The caches belong to the previous file
+        m_datFile.setEntryCache( nullptr );
+        m_entryCache.close( );
+        m_thumbnailGrid->close( );
+        m_thumbnailCache.close( );
+
         // Try to open the file
         if ( !m_datFile.open( p_path ) ) {
             wxMessageBox( wxString::Format( wxT( "Failed to open file: %s" ), p_path ),
@@ -255,6 +298,8 @@ namespace gw2b {
         }
         wxLogMessage( wxT( "Open dat file: %s" ), p_path );
         m_datPath = p_path;
+        this->openEntryCache( );
+        this->openThumbnailLoader( );
 
         // Open the index file
         uint64 datTimeStamp = wxFileModificationTime( p_path );
@@ -271,6 +316,7 @@ namespace gw2b {
         // As this will improve performance
         m_previewGLCanvas->clear();
         m_uiManager.GetPane(wxT("gl_content")).Hide();
+        m_uiManager.GetPane(wxT("grid_content")).Hide();
         m_uiManager.GetPane(wxT("panel_content")).Show();
         m_uiManager.Update();
 
@@ -281,6 +327,10 @@ namespace gw2b {
     //============================================================================/
 
     void BrowserWindow::viewEntry( const DatIndexEntry& p_entry ) {
+        // The grid is hidden either way, no use loading more thumbnails
+        m_thumbnailGrid->cancel( );
+        m_uiManager.GetPane( wxT( "grid_content" ) ).Hide( );
+
         switch ( p_entry.fileType( ) ) {
         //case ANFT_MapParam:
         case ANFT_Model:
@@ -327,8 +377,70 @@ namespace gw2b {
 
     //============================================================================/
 
+    wxFileName BrowserWindow::findDatHeaderCache( ) {
+        auto cacheFile = this->findDatIndex( );
+        cacheFile.SetExt( wxT( "hdr" ) );
+        return cacheFile;
+    }
+
+    //============================================================================/
+
+    wxFileName BrowserWindow::findDatEntryCache( ) {
+        auto cacheFile = this->findDatIndex( );
+        cacheFile.SetExt( wxT( "cache" ) );
+        return cacheFile;
+    }
+
+    //============================================================================/
+
+    void BrowserWindow::openEntryCache( ) {
+        if ( m_datPath.IsEmpty( ) || !this->GetMenuBar( )->IsChecked( ID_UseEntryCache ) ) {
+            return;
+        }
+
+        auto cacheFile = this->findDatEntryCache( );
+        cacheFile.Mkdir( 511, wxPATH_MKDIR_FULL );
+        if ( !m_entryCache.open( cacheFile.GetFullPath( ) ) ) {
+            wxLogMessage( wxT( "Failed to open asset cache: %s" ), cacheFile.GetFullPath( ) );
+            return;
+        }
+        m_datFile.setEntryCache( &m_entryCache );
+    }
+
+    //============================================================================/
+
+    wxFileName BrowserWindow::findDatThumbnailCache( ) {
+        auto cacheFile = this->findDatIndex( );
+        cacheFile.SetExt( wxT( "thumbs" ) );
+        return cacheFile;
+    }
+
+    //============================================================================/
+
+    void BrowserWindow::openThumbnailLoader( ) {
+        // Thumbnails are cheap to keep and slow to make, so they're always
+        // cached, whether the asset cache is enabled or not
+        auto cacheFile = this->findDatThumbnailCache( );
+        cacheFile.Mkdir( 511, wxPATH_MKDIR_FULL );
+        m_thumbnailCache.setLimits( DatEntryCache_ThumbnailMaxSize, DatEntryCache_DefaultMaxEntrySize );
+        if ( !m_thumbnailCache.open( cacheFile.GetFullPath( ) ) ) {
+            wxLogMessage( wxT( "Failed to open thumbnail cache: %s" ), cacheFile.GetFullPath( ) );
+        }
+
+        if ( !m_thumbnailGrid->open( m_datPath, m_thumbnailCache.isOpen( ) ? &m_thumbnailCache : nullptr ) ) {
+            wxLogMessage( wxT( "Failed to open dat file for thumbnails: %s" ), m_datPath );
+        }
+    }
+
+    //============================================================================/
+
     void BrowserWindow::indexDat( ) {
-        auto scanTask = new ScanDatTask( m_index, m_datFile );
+        // Load the headers of a previous scan, if they're of this .dat
+        if ( !m_headerCache.numRecords( ) || m_headerCache.datTimestamp( ) != m_index->datTimestamp( ) ) {
+            m_headerCache.read( this->findDatHeaderCache( ).GetFullPath( ), m_index->datTimestamp( ) );
+        }
+
+        auto scanTask = new ScanDatTask( m_index, m_datFile, m_headerCache, this->findDatIndex( ) );
         scanTask->addOnCompleteHandler( [this] ( ) { this->onScanTaskComplete( ); } );
         this->performTask( scanTask );
     }
@@ -457,6 +569,12 @@ namespace gw2b {
             m_uiManager.GetPane( wxT( "CategoryTree" ) ).Hide( );
         }
 
+        if ( GetMenuBar( )->IsChecked( ID_ShowFilter ) ) {
+            m_uiManager.GetPane( wxT( "FilterPanel" ) ).Show( );
+        } else {
+            m_uiManager.GetPane( wxT( "FilterPanel" ) ).Hide( );
+        }
+
         if ( GetMenuBar( )->IsChecked( ID_ShowLog ) ) {
             m_uiManager.GetPane( wxT( "LogWindow" ) ).Show( );
         } else {
@@ -474,6 +592,14 @@ namespace gw2b {
 
     //============================================================================/
 
+    void BrowserWindow::onToggleEntryCacheEvt( wxCommandEvent &p_event ) {
+        m_datFile.setEntryCache( nullptr );
+        m_entryCache.close( );
+        this->openEntryCache( );
+    }
+
+    //============================================================================/
+
     void BrowserWindow::onPaneCloseEvt( wxAuiManagerEvent &p_event ) {
         auto evt = p_event.GetPane( )->window;
         if ( evt == m_uiManager.GetPane( wxT( "FindFilePanel" ) ).window ) {
@@ -482,6 +608,9 @@ namespace gw2b {
         if ( evt == m_uiManager.GetPane( wxT( "CategoryTree" ) ).window ) {
             this->GetMenuBar( )->Check( ID_ShowFileList, false );
         }
+        if ( evt == m_uiManager.GetPane( wxT( "FilterPanel" ) ).window ) {
+            this->GetMenuBar( )->Check( ID_ShowFilter, false );
+        }
         if ( evt == m_uiManager.GetPane( wxT( "LogWindow" ) ).window ) {
             this->GetMenuBar( )->Check( ID_ShowLog, false );
         }
@@ -497,6 +626,23 @@ namespace gw2b {
 
     //============================================================================/
 
+    void BrowserWindow::onFilterTextEvt( wxCommandEvent &p_event ) {
+        // Every keystroke cancels the running query and starts a new one
+        m_filterList->setFilter( m_filterTextBox->GetValue( ) );
+    }
+
+    //============================================================================/
+
+    void BrowserWindow::onFilterItemSelectedEvt( wxListEvent &p_event ) {
+        auto entry = m_filterList->entry( p_event.GetIndex( ) );
+        if ( entry ) {
+            wxLogMessage( wxT( "Open Entry: %s" ), entry->name( ) );
+            this->viewEntry( *entry );
+        }
+    }
+
+    //============================================================================/
+
     void BrowserWindow::onReadIndexComplete( ) {
         // If it failed, it was cleared.
         if ( m_index->datTimestamp( ) == 0 || m_index->numEntries( ) == 0 ) {
@@ -514,6 +660,12 @@ namespace gw2b {
     //============================================================================/
 
     void BrowserWindow::onScanTaskComplete( ) {
+        if ( m_headerCache.isDirty( ) && !m_headerCache.write( this->findDatHeaderCache( ).GetFullPath( ) ) ) {
+            wxLogMessage( wxT( "Failed to write header cache." ) );
+        }
+        // Only needed while scanning
+        m_headerCache.clear( );
+
         auto writeTask = new WriteIndexTask( m_index, this->findDatIndex( ).GetFullPath( ) );
         this->performTask( writeTask );
     }
@@ -543,13 +695,31 @@ namespace gw2b {
     //============================================================================/
 
     void BrowserWindow::onTreeCategoryClicked( CategoryTree& p_tree, const DatIndexCategory& p_category ) {
-        // TODO
+        m_thumbnailGrid->setCategory( p_category );
+        if ( !m_thumbnailGrid->numEntries( ) ) {
+            return;
+        }
+
+        // Clear the OpenGL canvas to reduce memory usage
+        m_previewGLCanvas->clear( );
+        m_uiManager.GetPane( wxT( "gl_content" ) ).Hide( );
+        m_uiManager.GetPane( wxT( "panel_content" ) ).Hide( );
+        m_uiManager.GetPane( wxT( "grid_content" ) ).Show( );
+        m_uiManager.Update( );
     }
 
     //============================================================================/
 
     void BrowserWindow::onTreeCleared( CategoryTree& p_tree ) {
-        // TODO
+        // The grid points into the index being cleared
+        m_thumbnailGrid->clear( );
+    }
+
+    //============================================================================/
+
+    void BrowserWindow::onThumbnailActivated( ThumbnailGrid& p_grid, const DatIndexEntry& p_entry ) {
+        wxLogMessage( wxT( "Open Entry: %s" ), p_entry.name( ) );
+        this->viewEntry( p_entry );
     }
 
     //============================================================================/
@@ -630,7 +800,9 @@ namespace gw2b {
     void BrowserWindow::SetDefaults( ) {
         this->GetMenuBar( )->Check( ID_ShowFindFile, true );
         this->GetMenuBar( )->Check( ID_ShowFileList, true );
+        this->GetMenuBar( )->Check( ID_ShowFilter, false );
         this->GetMenuBar( )->Check( ID_ShowLog, false );
+        this->GetMenuBar( )->Check( ID_UseEntryCache, true );
     }
 
     void BrowserWindow::onFindFile( ) {
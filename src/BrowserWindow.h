@@ -34,9 +34,13 @@
 #include <wx/aboutdlg.h>
 
 #include "CategoryTree.h"
+#include "DatEntryCache.h"
 #include "DatFile.h"
+#include "DatHeaderCache.h"
+#include "IndexFilterList.h"
 #include "PreviewPanel.h"
 #include "PreviewGLCanvas.h"
+#include "ThumbnailGrid.h"
 
 namespace gw2b {
     class DatIndex;
@@ -44,12 +48,16 @@ namespace gw2b {
     class PreviewGLCanvas;
     class ProgressStatusBar;
     class Task;
+    class ThumbnailGrid;
 
     /** Represents the browser's main window. */
-    class BrowserWindow : public wxFrame, public ICategoryTreeListener {
+    class BrowserWindow : public wxFrame, public ICategoryTreeListener, public IThumbnailGridListener {
         wxString                    m_datPath;
         DatFile                     m_datFile;
         std::shared_ptr<DatIndex>   m_index;
+        DatHeaderCache              m_headerCache;
+        DatEntryCache               m_entryCache;
+        DatEntryCache               m_thumbnailCache;
         ProgressStatusBar*          m_progress;
         Task*                       m_currentTask;
         wxAuiManager                m_uiManager;
@@ -60,6 +68,9 @@ namespace gw2b {
         wxLog*                      m_logTarget;
         wxTextCtrl*                 m_findTextBox;
         bool                        m_findFirstTime = true;
+        wxTextCtrl*                 m_filterTextBox;
+        IndexFilterList*            m_filterList;
+        ThumbnailGrid*              m_thumbnailGrid;
 
     public:
         /** Constructs the frame with the given title and size.
@@ -90,6 +101,24 @@ namespace gw2b {
         *   index file should be located.
         *   \return wxFileName containing the path to the index file. */
         wxFileName findDatIndex( );
+        /** Determines where the header cache of the loaded .dat file should be
+        *   located, next to its index file.
+        *   \return wxFileName containing the path to the header cache file. */
+        wxFileName findDatHeaderCache( );
+        /** Determines where the decompressed entry cache of the loaded .dat
+        *   file should be located, next to its index file.
+        *   \return wxFileName containing the path to the entry cache file. */
+        wxFileName findDatEntryCache( );
+        /** Opens the entry cache of the loaded .dat file if enabled, and hands
+        *   it to the .dat file. */
+        void openEntryCache( );
+        /** Determines where the thumbnail cache of the loaded .dat file should
+        *   be located, next to its index file.
+        *   \return wxFileName containing the path to the thumbnail cache file. */
+        wxFileName findDatThumbnailCache( );
+        /** Opens the thumbnail cache of the loaded .dat file, and points the
+        *   thumbnail grid at the .dat file. */
+        void openThumbnailLoader( );
         /** Resumes indexing the loaded .dat file. */
         void indexDat( );
         /** Re-indexes the loaded .dat file. */
@@ -119,12 +148,21 @@ namespace gw2b {
         /** Executed when the user clicks <em>View -> Clear Log</em> in the menu.
         *  \param[in]  p_event  Unused event object handed to us by wxWidgets. */
         void onClearLogEvt( wxCommandEvent &p_event );
+        /** Executed when the user clicks <em>File -> Use Asset Cache</em> in the menu.
+        *  \param[in]  p_event  Unused event object handed to us by wxWidgets. */
+        void onToggleEntryCacheEvt( wxCommandEvent &p_event );
         /** Executed when the user close aui pane.
         *  \param[in]  p_event  Unused event object handed to us by wxWidgets. */
         void onPaneCloseEvt( wxAuiManagerEvent &p_event );
         /** Executed when the user press enter key in search box.
         *  \param[in]  p_event  Unused event object handed to us by wxWidgets. */
         void onEnterPressedInSrchBoxEvt( wxCommandEvent &p_event );
+        /** Executed when the text in the filter box changes.
+        *  \param[in]  p_event  Unused event object handed to us by wxWidgets. */
+        void onFilterTextEvt( wxCommandEvent &p_event );
+        /** Executed when the user selects an entry in the filter result list.
+        *  \param[in]  p_event  Event object handed to us by wxWidgets. */
+        void onFilterItemSelectedEvt( wxListEvent &p_event );
 
         /** Raised when the index has been read. */
         void onReadIndexComplete( );
@@ -148,6 +186,10 @@ namespace gw2b {
         *  \param[in]  p_tree   category tree invoking the callback.
         *  \param[in]  p_mode   if false extract raw file, if true extract converted file. */
         virtual void onTreeExtractFile( CategoryTree& p_tree, bool p_mode ) override;
+        /** Raised when the user double clicks an entry in the thumbnail grid.
+        *  \param[in]  p_grid   grid that raised the event.
+        *  \param[in]  p_entry  entry that was activated. */
+        virtual void onThumbnailActivated( ThumbnailGrid& p_grid, const DatIndexEntry& p_entry ) override;
 
         /** Initialize about dialog data.*/
         void InitAboutInfo( wxAboutDialogInfo& info );
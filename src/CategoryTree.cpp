@@ -418,8 +418,9 @@ namespace gw2b {
         if ( m_index ) {
             m_index->addListener( this );
 
-            for ( uint i = 0; i < m_index->numEntries( ); i++ ) {
-                this->addEntry( *m_index->entry( i ) );
+            auto snapshot = m_index->snapshot( );
+            for ( uint i = 0; i < snapshot.numEntries( ); i++ ) {
+                this->addEntry( *snapshot.entry( i ) );
             }
         }
     }
@@ -0,0 +1,177 @@
+/** \file       Compression/BitReader.h
+ *  \brief      Contains the declaration of the bit reader used by the inflaters.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef COMPRESSION_BITREADER_H_INCLUDED
+#define COMPRESSION_BITREADER_H_INCLUDED
+
+#include <cstring>
+
+#include "Util/DataStream.h"
+
+namespace gw2b {
+
+    /** Reads a compressed stream, most significant bit first, from little
+    *  endian 32-bit words. In .dat entries the last word of every 64 KiB
+    *  block is a checksum and gets skipped.
+    *
+    *  Bits are kept in a 64-bit buffer, so one refill covers any read of up
+    *  to 32 bits. Reading past the end of the input yields zeros and is
+    *  reported by isOverrun().
+    *
+    *  Given a source, the input is read into a caller owned buffer one piece
+    *  at a time, so the whole stream never needs to be in memory. */
+    class BitReader {
+        enum {
+            BlockWords = 0x4000,    /**< Amount of words in a 64 KiB block, checksum included. */
+        };
+
+        const byte*     m_input;
+        IDataSource*    m_source;
+        byte*           m_buffer;
+        uint32          m_bufferSize;
+        uint32          m_numWords;
+        uint32          m_position;
+        uint32          m_nextChecksum;
+        uint64          m_bits;
+        uint            m_count;
+        uint            m_overrun;
+    public:
+        /** Constructor.
+        *  \param[in]  p_input          Compressed data.
+        *  \param[in]  p_size           Size of the compressed data, in bytes.
+        *  \param[in]  p_hasChecksums   true if the data has block checksums to skip. */
+        BitReader( const byte* p_input, uint32 p_size, bool p_hasChecksums = true )
+            : m_input( p_input )
+            , m_source( nullptr )
+            , m_buffer( nullptr )
+            , m_bufferSize( 0 )
+            , m_numWords( p_size / 4 )
+            , m_position( 0 )
+            , m_nextChecksum( p_hasChecksums ? BlockWords - 1 : 0xffffffff )
+            , m_bits( 0 )
+            , m_count( 0 )
+            , m_overrun( 0 ) {
+        }
+        /** Constructor. Reads the input from a source.
+        *  \param[in]  p_source         Source of the compressed data. Every read but the
+        *                               last must fill the buffer.
+        *  \param[in]  p_buffer         Buffer to read the source into.
+        *  \param[in]  p_bufferSize     Size of the buffer, a multiple of 4 bytes.
+        *  \param[in]  p_hasChecksums   true if the data has block checksums to skip. */
+        BitReader( IDataSource& p_source, byte* p_buffer, uint32 p_bufferSize, bool p_hasChecksums = true )
+            : m_input( p_buffer )
+            , m_source( &p_source )
+            , m_buffer( p_buffer )
+            , m_bufferSize( p_bufferSize )
+            , m_numWords( 0 )
+            , m_position( 0 )
+            , m_nextChecksum( p_hasChecksums ? BlockWords - 1 : 0xffffffff )
+            , m_bits( 0 )
+            , m_count( 0 )
+            , m_overrun( 0 ) {
+        }
+
+        /** Makes sure at least 32 bits are buffered. */
+        void refill( ) {
+            if ( m_count <= 32 ) {
+                m_bits |= static_cast<uint64>( this->nextWord( ) ) << ( 32 - m_count );
+                m_count += 32;
+            }
+        }
+        /** Gets the next bits without consuming them. Needs a refill first.
+        *  \param[in]  p_bits   Amount of bits to get, 1 to 32.
+        *  \return uint32  The bits, right aligned. */
+        uint32 peek( uint p_bits ) const {
+            return static_cast<uint32>( m_bits >> ( 64 - p_bits ) );
+        }
+        /** Consumes bits. Needs a refill first.
+        *  \param[in]  p_bits   Amount of bits to consume, 0 to 32. */
+        void drop( uint p_bits ) {
+            m_bits <<= p_bits;
+            m_count -= p_bits;
+        }
+        /** Refills, then gets and consumes the next bits.
+        *  \param[in]  p_bits   Amount of bits to read, 1 to 32.
+        *  \return uint32  The bits, right aligned. */
+        uint32 read( uint p_bits ) {
+            this->refill( );
+            auto value = this->peek( p_bits );
+            this->drop( p_bits );
+            return value;
+        }
+        /** Determines whether more data was read than the input holds. One word
+        *  of read-ahead past the end is tolerated.
+        *  \return bool    true if the input was overrun, false if not. */
+        bool isOverrun( ) const {
+            return m_overrun > 1;
+        }
+        /** Gets the index of the first word no bit has been consumed from. Only
+        *  meaningful for data without checksums, not read from a source.
+        *  \return uint32  Index of the word. */
+        uint32 wordPosition( ) const {
+            return m_position - m_count / 32;
+        }
+
+    private:
+        uint32 nextWord( ) {
+            if ( m_position == m_nextChecksum ) {
+                m_position++;
+                m_nextChecksum += BlockWords;
+            }
+            if ( m_position >= m_numWords && !this->nextInput( ) ) {
+                m_overrun++;
+                return 0;
+            }
+
+            uint32 word;
+            ::memcpy( &word, m_input + m_position * 4, sizeof( word ) );
+            m_position++;
+            return word;
+        }
+
+        bool nextInput( ) {
+            if ( !m_source ) {
+                return false;
+            }
+            auto size = m_source->read( m_buffer, m_bufferSize );
+            if ( !size ) {
+                m_source = nullptr;
+                return false;
+            }
+
+            // Positions are relative to the current piece, carry them over
+            m_position -= m_numWords;
+            if ( m_nextChecksum != 0xffffffff ) {
+                m_nextChecksum -= m_numWords;
+            }
+            m_numWords = size / 4;
+            return m_position < m_numWords;
+        }
+    }; // class BitReader
+
+}; // namespace gw2b
+
+#endif // COMPRESSION_BITREADER_H_INCLUDED
@@ -0,0 +1,735 @@
+/** \file       Compression/DXTDecoder.cpp
+ *  \brief      Contains the definition of the DXT block decoders.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#   define GW2B_DXT_SSE41   1
+#   include <smmintrin.h>
+#   if defined(_MSC_VER)
+#       define GW2B_TARGET_SSE41
+#   else
+#       define GW2B_TARGET_SSE41    __attribute__( ( target( "sse4.1" ) ) )
+#   endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   define GW2B_DXT_NEON    1
+#   include <arm_neon.h>
+#endif
+
+#include "DXTDecoder.h"
+
+namespace gw2b {
+
+    namespace {
+
+        //============================================================================/
+        //      Palettes, shared by all instruction sets
+        //============================================================================/
+
+        /** Expands a 565 color to 3 bytes, first the 5 high bits. */
+        void expandColor( uint16 p_color, uint8* po_color ) {
+            uint high = p_color >> 11;
+            uint middle = ( p_color >> 5 ) & 0x3f;
+            uint low = p_color & 0x1f;
+            po_color[0] = static_cast<uint8>( ( high << 3 ) | ( high >> 2 ) );
+            po_color[1] = static_cast<uint8>( ( middle << 2 ) | ( middle >> 4 ) );
+            po_color[2] = static_cast<uint8>( ( low << 3 ) | ( low >> 2 ) );
+        }
+
+        /** Builds the 4 colors of a block, 4 bytes each with the alpha last.
+        *  Only DXT1 blocks use the 3 color mode, with a transparent 4th color. */
+        void colorPalette( const byte* p_block, bool p_isDXT1, uint8* po_palette ) {
+            uint16 color1;
+            uint16 color2;
+            ::memcpy( &color1, p_block, sizeof( color1 ) );
+            ::memcpy( &color2, p_block + 2, sizeof( color2 ) );
+
+            expandColor( color1, po_palette );
+            expandColor( color2, po_palette + 4 );
+            po_palette[3] = 0xff;
+            po_palette[7] = 0xff;
+
+            if ( !p_isDXT1 || color1 > color2 ) {
+                for ( uint i = 0; i < 3; i++ ) {
+                    po_palette[8 + i] = static_cast<uint8>( ( po_palette[i] * 2 + po_palette[4 + i] ) / 3 );
+                    po_palette[12 + i] = static_cast<uint8>( ( po_palette[i] + po_palette[4 + i] * 2 ) / 3 );
+                }
+                po_palette[11] = 0xff;
+                po_palette[15] = 0xff;
+            } else {
+                for ( uint i = 0; i < 3; i++ ) {
+                    po_palette[8 + i] = static_cast<uint8>( ( po_palette[i] + po_palette[4 + i] ) >> 1 );
+                    po_palette[12 + i] = 0;
+                }
+                po_palette[11] = 0xff;
+                po_palette[15] = 0x00;
+            }
+        }
+
+        /** Builds the 8 values of an interpolated alpha, gray or normal channel
+        *  from its first 2 bytes. */
+        void channelPalette( uint64 p_channel, uint8* po_palette ) {
+            po_palette[0] = ( p_channel & 0xff );
+            po_palette[1] = ( p_channel & 0xff00 ) >> 8;
+            if ( po_palette[0] > po_palette[1] ) {
+                for ( uint i = 2; i < 8; i++ ) {
+                    po_palette[i] = ( ( 8 - i ) * po_palette[0] + ( i - 1 ) * po_palette[1] ) / 7;
+                }
+            } else {
+                for ( uint i = 2; i < 6; i++ ) {
+                    po_palette[i] = ( ( 6 - i ) * po_palette[0] + ( i - 1 ) * po_palette[1] ) / 5;
+                }
+                po_palette[6] = 0x00;
+                po_palette[7] = 0xff;
+            }
+        }
+
+        /** Computes the 3DCX normal of the given red and green, as RGB. */
+        void normalColor( uint8 p_red, uint8 p_green, uint8* po_color ) {
+            const float floatToByte = 127.5f;
+            const float byteToFloat = ( 1.0f / floatToByte );
+
+            struct {
+                float r; float g; float b;
+            } normal;
+
+            // Get normal
+            normal.r = ( ( float ) p_red * byteToFloat ) - 1.0f;
+            normal.g = ( ( float ) p_green * byteToFloat ) - 1.0f;
+
+            // Compute blue, based on red/green
+            normal.b = ::sqrt( 1.0f - normal.r * normal.r - normal.g * normal.g );
+
+            // Store normal
+            po_color[0] = ( ( normal.r + 1.0f ) * floatToByte );
+            po_color[1] = ( ( normal.g + 1.0f ) * floatToByte );
+            po_color[2] = ( ( normal.b + 1.0f ) * floatToByte );
+
+            // Invert green as that seems to be the more common format
+            po_color[1] = 0xff - po_color[1];
+        }
+
+        //============================================================================/
+        //      Row decoders, shared by all instruction sets
+        //============================================================================/
+
+        /** The Ops of every instruction set write the pixels of one block from
+        *  its palettes and indices:
+        *  - colorRows: 4 colors with alpha, 2-bit indices. Alphas may be nullptr.
+        *  - alphaRows: 8 alphas, 3-bit indices.
+        *  - nibbleRows: 4-bit alphas, expanded to 8 bits.
+        *  - grayRows: 8 grays, 3-bit indices, written to all 3 color bytes.
+        *  - normalRows: 8 reds and 8 greens, 3-bit indices, as normals.
+        *  BlockWidth is the amount of pixels they write per row of a block.
+        *  Blocks are always written whole, so a row needs room for
+        *  p_numBlocks * BlockWidth pixels. */
+
+        template <typename Ops>
+        void decodeDXT1Row( const byte* p_blocks, uint p_numBlocks, uint8* po_colors, uint8* po_alphas, uint p_width ) {
+            Assert( p_width >= p_numBlocks * Ops::BlockWidth );
+            uint8 palette[16];
+            for ( uint i = 0; i < p_numBlocks; i++ ) {
+                auto block = p_blocks + i * 8;
+                uint32 indices;
+                ::memcpy( &indices, block + 4, sizeof( indices ) );
+
+                colorPalette( block, true, palette );
+                Ops::colorRows( palette, indices, po_colors + i * Ops::BlockWidth * 3, po_alphas + i * Ops::BlockWidth, p_width );
+            }
+        }
+
+        template <typename Ops>
+        void decodeDXT3Row( const byte* p_blocks, uint p_numBlocks, uint8* po_colors, uint8* po_alphas, uint p_width ) {
+            Assert( p_width >= p_numBlocks * Ops::BlockWidth );
+            uint8 palette[16];
+            for ( uint i = 0; i < p_numBlocks; i++ ) {
+                auto block = p_blocks + i * 16;
+                uint64 alpha;
+                uint32 indices;
+                ::memcpy( &alpha, block, sizeof( alpha ) );
+                ::memcpy( &indices, block + 12, sizeof( indices ) );
+
+                colorPalette( block + 8, false, palette );
+                Ops::colorRows( palette, indices, po_colors + i * Ops::BlockWidth * 3, nullptr, p_width );
+                Ops::nibbleRows( alpha, po_alphas + i * Ops::BlockWidth, p_width );
+            }
+        }
+
+        template <typename Ops>
+        void decodeDXT5Row( const byte* p_blocks, uint p_numBlocks, uint8* po_colors, uint8* po_alphas, uint p_width ) {
+            Assert( p_width >= p_numBlocks * Ops::BlockWidth );
+            uint8 palette[16];
+            uint8 alphas[8];
+            for ( uint i = 0; i < p_numBlocks; i++ ) {
+                auto block = p_blocks + i * 16;
+                uint64 alpha;
+                uint32 indices;
+                ::memcpy( &alpha, block, sizeof( alpha ) );
+                ::memcpy( &indices, block + 12, sizeof( indices ) );
+
+                colorPalette( block + 8, false, palette );
+                channelPalette( alpha, alphas );
+                Ops::colorRows( palette, indices, po_colors + i * Ops::BlockWidth * 3, nullptr, p_width );
+                Ops::alphaRows( alphas, alpha >> 16, po_alphas + i * Ops::BlockWidth, p_width );
+            }
+        }
+
+        template <typename Ops>
+        void decodeDXTARow( const byte* p_blocks, uint p_numBlocks, uint8* po_colors, uint8* po_alphas, uint p_width ) {
+            Assert( p_width >= p_numBlocks * Ops::BlockWidth );
+            uint8 grays[8];
+            for ( uint i = 0; i < p_numBlocks; i++ ) {
+                uint64 gray;
+                ::memcpy( &gray, p_blocks + i * 8, sizeof( gray ) );
+
+                channelPalette( gray, grays );
+                Ops::grayRows( grays, gray >> 16, po_colors + i * Ops::BlockWidth * 3, p_width );
+            }
+        }
+
+        template <typename Ops>
+        void decodeDCXRow( const byte* p_blocks, uint p_numBlocks, uint8* po_colors, uint8* po_alphas, uint p_width ) {
+            Assert( p_width >= p_numBlocks * Ops::BlockWidth );
+            uint8 reds[8];
+            uint8 greens[8];
+            for ( uint i = 0; i < p_numBlocks; i++ ) {
+                uint64 green;
+                uint64 red;
+                ::memcpy( &green, p_blocks + i * 16, sizeof( green ) );
+                ::memcpy( &red, p_blocks + i * 16 + 8, sizeof( red ) );
+
+                channelPalette( red, reds );
+                channelPalette( green, greens );
+                Ops::normalRows( reds, red >> 16, greens, green >> 16, po_colors + i * Ops::BlockWidth * 3, p_width );
+            }
+        }
+
+        //============================================================================/
+        //      Plain C++, the reference
+        //============================================================================/
+
+        struct ScalarOps {
+            static const uint BlockWidth = 4;
+
+            static void colorRows( const uint8* p_palette, uint32 p_indices, uint8* po_colors, uint8* po_alphas, uint p_stride ) {
+                for ( uint y = 0; y < 4; y++ ) {
+                    for ( uint x = 0; x < 4; x++ ) {
+                        auto color = p_palette + ( p_indices & 3 ) * 4;
+                        ::memcpy( po_colors + ( y * p_stride + x ) * 3, color, 3 );
+                        if ( po_alphas ) {
+                            po_alphas[y * p_stride + x] = color[3];
+                        }
+                        p_indices >>= 2;
+                    }
+                }
+            }
+
+            static void alphaRows( const uint8* p_palette, uint64 p_indices, uint8* po_alphas, uint p_stride ) {
+                for ( uint y = 0; y < 4; y++ ) {
+                    for ( uint x = 0; x < 4; x++ ) {
+                        po_alphas[y * p_stride + x] = p_palette[p_indices & 7];
+                        p_indices >>= 3;
+                    }
+                }
+            }
+
+            static void nibbleRows( uint64 p_alpha, uint8* po_alphas, uint p_stride ) {
+                for ( uint y = 0; y < 4; y++ ) {
+                    for ( uint x = 0; x < 4; x++ ) {
+                        po_alphas[y * p_stride + x] = static_cast<uint8>( ( ( p_alpha & 0xf ) << 4 ) | ( p_alpha & 0xf ) );
+                        p_alpha >>= 4;
+                    }
+                }
+            }
+
+            static void grayRows( const uint8* p_palette, uint64 p_indices, uint8* po_colors, uint p_stride ) {
+                for ( uint y = 0; y < 4; y++ ) {
+                    for ( uint x = 0; x < 4; x++ ) {
+                        ::memset( po_colors + ( y * p_stride + x ) * 3, p_palette[p_indices & 7], 3 );
+                        p_indices >>= 3;
+                    }
+                }
+            }
+
+            static void normalRows( const uint8* p_reds, uint64 p_redIndices, const uint8* p_greens, uint64 p_greenIndices, uint8* po_colors, uint p_stride ) {
+                for ( uint y = 0; y < 4; y++ ) {
+                    for ( uint x = 0; x < 4; x++ ) {
+                        normalColor( p_reds[p_redIndices & 7], p_greens[p_greenIndices & 7], po_colors + ( y * p_stride + x ) * 3 );
+                        p_redIndices >>= 3;
+                        p_greenIndices >>= 3;
+                    }
+                }
+            }
+        };
+
+        //============================================================================/
+        //      Block averages, for reduced size images
+        //============================================================================/
+
+        /** Counts how often each palette entry is used by the 16 indices of a block. */
+        template <uint Bits>
+        void countIndices( uint64 p_indices, uint* po_counts ) {
+            const uint mask = ( 1 << Bits ) - 1;
+            for ( uint i = 0; i < ( 1 << Bits ); i++ ) {
+                po_counts[i] = 0;
+            }
+            for ( uint i = 0; i < 16; i++ ) {
+                po_counts[p_indices & mask]++;
+                p_indices >>= Bits;
+            }
+        }
+
+        /** Averages a channel of a palette, weighted by the given counts. */
+        uint8 averageChannel( const uint8* p_palette, uint p_step, const uint* p_counts, uint p_numEntries ) {
+            uint sum = 8;   // rounding
+            for ( uint i = 0; i < p_numEntries; i++ ) {
+                sum += p_palette[i * p_step] * p_counts[i];
+            }
+            return static_cast<uint8>( sum >> 4 );
+        }
+
+        /** Writes a single pixel per block, the average of its 16 pixels,
+        *  computed from the palettes and how often the indices use them.
+        *  Normals are averaged before computing blue, which keeps them unit
+        *  length. */
+        struct AverageOps {
+            static const uint BlockWidth = 1;
+
+            static void colorRows( const uint8* p_palette, uint32 p_indices, uint8* po_colors, uint8* po_alphas, uint p_stride ) {
+                uint counts[4];
+                countIndices<2>( p_indices, counts );
+                for ( uint i = 0; i < 3; i++ ) {
+                    po_colors[i] = averageChannel( p_palette + i, 4, counts, 4 );
+                }
+                if ( po_alphas ) {
+                    *po_alphas = averageChannel( p_palette + 3, 4, counts, 4 );
+                }
+            }
+
+            static void alphaRows( const uint8* p_palette, uint64 p_indices, uint8* po_alphas, uint p_stride ) {
+                uint counts[8];
+                countIndices<3>( p_indices, counts );
+                *po_alphas = averageChannel( p_palette, 1, counts, 8 );
+            }
+
+            static void nibbleRows( uint64 p_alpha, uint8* po_alphas, uint p_stride ) {
+                uint sum = 8;
+                for ( uint i = 0; i < 16; i++ ) {
+                    sum += ( p_alpha & 0xf ) * 0x11;
+                    p_alpha >>= 4;
+                }
+                *po_alphas = static_cast<uint8>( sum >> 4 );
+            }
+
+            static void grayRows( const uint8* p_palette, uint64 p_indices, uint8* po_colors, uint p_stride ) {
+                uint counts[8];
+                countIndices<3>( p_indices, counts );
+                ::memset( po_colors, averageChannel( p_palette, 1, counts, 8 ), 3 );
+            }
+
+            static void normalRows( const uint8* p_reds, uint64 p_redIndices, const uint8* p_greens, uint64 p_greenIndices, uint8* po_colors, uint p_stride ) {
+                uint redCounts[8];
+                uint greenCounts[8];
+                countIndices<3>( p_redIndices, redCounts );
+                countIndices<3>( p_greenIndices, greenCounts );
+                normalColor( averageChannel( p_reds, 1, redCounts, 8 ), averageChannel( p_greens, 1, greenCounts, 8 ), po_colors );
+            }
+        };
+
+        //============================================================================/
+        //      Tables used by the vector instruction sets
+        //============================================================================/
+
+#if GW2B_DXT_SSE41 || GW2B_DXT_NEON
+
+        /** Shuffle masks turning the 4 colors of a block into a row of 4 pixels:
+        *  12 bytes of color followed by 4 alphas, for every byte of indices. */
+        struct ColorMasks {
+            uint8   masks[256][16];
+
+            ColorMasks( ) {
+                for ( uint indices = 0; indices < 256; indices++ ) {
+                    for ( uint x = 0; x < 4; x++ ) {
+                        auto index = ( indices >> ( x * 2 ) ) & 3;
+                        for ( uint i = 0; i < 3; i++ ) {
+                            masks[indices][x * 3 + i] = static_cast<uint8>( index * 4 + i );
+                        }
+                        masks[indices][12 + x] = static_cast<uint8>( index * 4 + 3 );
+                    }
+                }
+            }
+        };
+
+        const ColorMasks& colorMasks( ) {
+            static const ColorMasks s_masks;
+            return s_masks;
+        }
+
+        /** Normals of every red and green, so no square root is needed per pixel. */
+        struct NormalTables {
+            uint8   reds[256];
+            uint8   greens[256];
+            uint8   blues[256][256];
+
+            NormalTables( ) {
+                uint8 color[3];
+                for ( uint red = 0; red < 256; red++ ) {
+                    for ( uint green = 0; green < 256; green++ ) {
+                        normalColor( red, green, color );
+                        blues[red][green] = color[2];
+                    }
+                    normalColor( red, 0, color );
+                    reds[red] = color[0];
+                    normalColor( 0, red, color );
+                    greens[red] = color[1];
+                }
+            }
+        };
+
+        const NormalTables& normalTables( ) {
+            static const NormalTables s_tables;
+            return s_tables;
+        }
+
+        /** Shuffle masks spreading 16 values into the 3 bytes of the pixels of
+        *  each row. Unused bytes are 0x80, which shuffles in a zero. */
+        const uint8 GrayMasks[4][16] = {
+            { 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 0x80, 0x80, 0x80, 0x80 },
+            { 4, 4, 4, 5, 5, 5, 6, 6, 6, 7, 7, 7, 0x80, 0x80, 0x80, 0x80 },
+            { 8, 8, 8, 9, 9, 9, 10, 10, 10, 11, 11, 11, 0x80, 0x80, 0x80, 0x80 },
+            { 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15, 0x80, 0x80, 0x80, 0x80 },
+        };
+        /** Shuffle masks placing one of the 3 color bytes of a row of pixels,
+        *  per row and then per byte. */
+        const uint8 InterleaveMasks[4][3][16] = {
+            {
+                { 0, 0x80, 0x80, 1, 0x80, 0x80, 2, 0x80, 0x80, 3, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+                { 0x80, 0, 0x80, 0x80, 1, 0x80, 0x80, 2, 0x80, 0x80, 3, 0x80, 0x80, 0x80, 0x80, 0x80 },
+                { 0x80, 0x80, 0, 0x80, 0x80, 1, 0x80, 0x80, 2, 0x80, 0x80, 3, 0x80, 0x80, 0x80, 0x80 },
+            }, {
+                { 4, 0x80, 0x80, 5, 0x80, 0x80, 6, 0x80, 0x80, 7, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+                { 0x80, 4, 0x80, 0x80, 5, 0x80, 0x80, 6, 0x80, 0x80, 7, 0x80, 0x80, 0x80, 0x80, 0x80 },
+                { 0x80, 0x80, 4, 0x80, 0x80, 5, 0x80, 0x80, 6, 0x80, 0x80, 7, 0x80, 0x80, 0x80, 0x80 },
+            }, {
+                { 8, 0x80, 0x80, 9, 0x80, 0x80, 10, 0x80, 0x80, 11, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+                { 0x80, 8, 0x80, 0x80, 9, 0x80, 0x80, 10, 0x80, 0x80, 11, 0x80, 0x80, 0x80, 0x80, 0x80 },
+                { 0x80, 0x80, 8, 0x80, 0x80, 9, 0x80, 0x80, 10, 0x80, 0x80, 11, 0x80, 0x80, 0x80, 0x80 },
+            }, {
+                { 12, 0x80, 0x80, 13, 0x80, 0x80, 14, 0x80, 0x80, 15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+                { 0x80, 12, 0x80, 0x80, 13, 0x80, 0x80, 14, 0x80, 0x80, 15, 0x80, 0x80, 0x80, 0x80, 0x80 },
+                { 0x80, 0x80, 12, 0x80, 0x80, 13, 0x80, 0x80, 14, 0x80, 0x80, 15, 0x80, 0x80, 0x80, 0x80 },
+            },
+        };
+
+        /** Byte pairs holding each of the 16 3-bit indices, first of indices 0 to 7,
+        *  then of 8 to 15. */
+        const uint8 IndexPairs[2][16] = {
+            { 0, 1, 0, 1, 0, 1, 1, 2, 1, 2, 1, 2, 2, 3, 2, 3 },
+            { 3, 4, 3, 4, 3, 4, 4, 5, 4, 5, 4, 5, 5, 6, 5, 6 },
+        };
+
+        /** Writes the first 12 bytes of a vector stored in p_row. */
+        void storeRow( uint8* po_output, const uint8* p_row ) {
+            ::memcpy( po_output, p_row, 12 );
+        }
+
+        /** Looks up the blues of a block's normals. */
+        void normalBlues( const uint8* p_reds, const uint8* p_redIndices, const uint8* p_greens, const uint8* p_greenIndices, uint8* po_blues ) {
+            auto& tables = normalTables( );
+            for ( uint i = 0; i < 16; i++ ) {
+                po_blues[i] = tables.blues[p_reds[p_redIndices[i]]][p_greens[p_greenIndices[i]]];
+            }
+        }
+
+#endif
+
+        //============================================================================/
+        //      SSE4.1
+        //============================================================================/
+
+#if GW2B_DXT_SSE41
+
+        /** Left shifts moving every 3-bit index of a byte pair to bits 8 to 10. */
+        const uint16 IndexShifts[8] = { 256, 32, 4, 128, 16, 2, 64, 8 };
+
+        struct SSE41Ops {
+            static const uint BlockWidth = 4;
+
+            GW2B_TARGET_SSE41 static __m128i load( const uint8* p_data ) {
+                return _mm_loadu_si128( reinterpret_cast<const __m128i*>( p_data ) );
+            }
+
+            GW2B_TARGET_SSE41 static void store( uint8* po_data, __m128i p_value ) {
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( po_data ), p_value );
+            }
+
+            /** Spreads 16 3-bit indices over 16 bytes. */
+            GW2B_TARGET_SSE41 static __m128i expandIndices( uint64 p_indices ) {
+                auto bits = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( &p_indices ) );
+                auto shifts = load( reinterpret_cast<const uint8*>( IndexShifts ) );
+                auto mask = _mm_set1_epi16( 7 );
+
+                auto low = _mm_mullo_epi16( _mm_shuffle_epi8( bits, load( IndexPairs[0] ) ), shifts );
+                auto high = _mm_mullo_epi16( _mm_shuffle_epi8( bits, load( IndexPairs[1] ) ), shifts );
+                low = _mm_and_si128( _mm_srli_epi16( low, 8 ), mask );
+                high = _mm_and_si128( _mm_srli_epi16( high, 8 ), mask );
+                return _mm_packus_epi16( low, high );
+            }
+
+            GW2B_TARGET_SSE41 static void colorRows( const uint8* p_palette, uint32 p_indices, uint8* po_colors, uint8* po_alphas, uint p_stride ) {
+                auto& masks = colorMasks( ).masks;
+                auto palette = load( p_palette );
+                uint8 row[16];
+
+                for ( uint y = 0; y < 4; y++ ) {
+                    store( row, _mm_shuffle_epi8( palette, load( masks[p_indices & 0xff] ) ) );
+                    storeRow( po_colors + y * p_stride * 3, row );
+                    if ( po_alphas ) {
+                        ::memcpy( po_alphas + y * p_stride, row + 12, 4 );
+                    }
+                    p_indices >>= 8;
+                }
+            }
+
+            GW2B_TARGET_SSE41 static void alphaRows( const uint8* p_palette, uint64 p_indices, uint8* po_alphas, uint p_stride ) {
+                auto palette = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( p_palette ) );
+                uint8 alphas[16];
+                store( alphas, _mm_shuffle_epi8( palette, expandIndices( p_indices ) ) );
+
+                for ( uint y = 0; y < 4; y++ ) {
+                    ::memcpy( po_alphas + y * p_stride, alphas + y * 4, 4 );
+                }
+            }
+
+            GW2B_TARGET_SSE41 static void nibbleRows( uint64 p_alpha, uint8* po_alphas, uint p_stride ) {
+                auto bits = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( &p_alpha ) );
+                auto mask = _mm_set1_epi8( 0x0f );
+                auto low = _mm_and_si128( bits, mask );
+                auto high = _mm_and_si128( _mm_srli_epi16( bits, 4 ), mask );
+                auto nibbles = _mm_unpacklo_epi8( low, high );
+                uint8 alphas[16];
+                store( alphas, _mm_or_si128( nibbles, _mm_slli_epi16( nibbles, 4 ) ) );
+
+                for ( uint y = 0; y < 4; y++ ) {
+                    ::memcpy( po_alphas + y * p_stride, alphas + y * 4, 4 );
+                }
+            }
+
+            GW2B_TARGET_SSE41 static void grayRows( const uint8* p_palette, uint64 p_indices, uint8* po_colors, uint p_stride ) {
+                auto palette = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( p_palette ) );
+                auto grays = _mm_shuffle_epi8( palette, expandIndices( p_indices ) );
+                uint8 row[16];
+
+                for ( uint y = 0; y < 4; y++ ) {
+                    store( row, _mm_shuffle_epi8( grays, load( GrayMasks[y] ) ) );
+                    storeRow( po_colors + y * p_stride * 3, row );
+                }
+            }
+
+            GW2B_TARGET_SSE41 static void normalRows( const uint8* p_reds, uint64 p_redIndices, const uint8* p_greens, uint64 p_greenIndices, uint8* po_colors, uint p_stride ) {
+                auto& tables = normalTables( );
+                uint8 redIndices[16];
+                uint8 greenIndices[16];
+                uint8 blues[16];
+                store( redIndices, expandIndices( p_redIndices ) );
+                store( greenIndices, expandIndices( p_greenIndices ) );
+                normalBlues( p_reds, redIndices, p_greens, greenIndices, blues );
+
+                uint8 palette[16];
+                for ( uint i = 0; i < 8; i++ ) {
+                    palette[i] = tables.reds[p_reds[i]];
+                    palette[8 + i] = tables.greens[p_greens[i]];
+                }
+                auto reds = _mm_shuffle_epi8( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( palette ) ), load( redIndices ) );
+                auto greens = _mm_shuffle_epi8( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( palette + 8 ) ), load( greenIndices ) );
+                auto blueValues = load( blues );
+                uint8 row[16];
+
+                for ( uint y = 0; y < 4; y++ ) {
+                    auto value = _mm_or_si128( _mm_shuffle_epi8( reds, load( InterleaveMasks[y][0] ) ),
+                        _mm_or_si128( _mm_shuffle_epi8( greens, load( InterleaveMasks[y][1] ) ),
+                            _mm_shuffle_epi8( blueValues, load( InterleaveMasks[y][2] ) ) ) );
+                    store( row, value );
+                    storeRow( po_colors + y * p_stride * 3, row );
+                }
+            }
+        };
+
+#endif
+
+        //============================================================================/
+        //      NEON
+        //============================================================================/
+
+#if GW2B_DXT_NEON
+
+        struct NEONOps {
+            static const uint BlockWidth = 4;
+
+            /** Spreads 16 3-bit indices over 16 bytes. */
+            static uint8x16_t expandIndices( uint64 p_indices ) {
+                const int16 shifts[8] = { 0, -3, -6, -1, -4, -7, -2, -5 };
+                auto bits = vcombine_u8( vcreate_u8( p_indices ), vdup_n_u8( 0 ) );
+                auto shift = vld1q_s16( shifts );
+                auto mask = vdupq_n_u16( 7 );
+
+                auto low = vreinterpretq_u16_u8( vqtbl1q_u8( bits, vld1q_u8( IndexPairs[0] ) ) );
+                auto high = vreinterpretq_u16_u8( vqtbl1q_u8( bits, vld1q_u8( IndexPairs[1] ) ) );
+                low = vandq_u16( vshlq_u16( low, shift ), mask );
+                high = vandq_u16( vshlq_u16( high, shift ), mask );
+                return vcombine_u8( vmovn_u16( low ), vmovn_u16( high ) );
+            }
+
+            static void colorRows( const uint8* p_palette, uint32 p_indices, uint8* po_colors, uint8* po_alphas, uint p_stride ) {
+                auto& masks = colorMasks( ).masks;
+                auto palette = vld1q_u8( p_palette );
+                uint8 row[16];
+
+                for ( uint y = 0; y < 4; y++ ) {
+                    vst1q_u8( row, vqtbl1q_u8( palette, vld1q_u8( masks[p_indices & 0xff] ) ) );
+                    storeRow( po_colors + y * p_stride * 3, row );
+                    if ( po_alphas ) {
+                        ::memcpy( po_alphas + y * p_stride, row + 12, 4 );
+                    }
+                    p_indices >>= 8;
+                }
+            }
+
+            static void alphaRows( const uint8* p_palette, uint64 p_indices, uint8* po_alphas, uint p_stride ) {
+                auto palette = vcombine_u8( vld1_u8( p_palette ), vdup_n_u8( 0 ) );
+                uint8 alphas[16];
+                vst1q_u8( alphas, vqtbl1q_u8( palette, expandIndices( p_indices ) ) );
+
+                for ( uint y = 0; y < 4; y++ ) {
+                    ::memcpy( po_alphas + y * p_stride, alphas + y * 4, 4 );
+                }
+            }
+
+            static void nibbleRows( uint64 p_alpha, uint8* po_alphas, uint p_stride ) {
+                auto bits = vcreate_u8( p_alpha );
+                auto mask = vdup_n_u8( 0x0f );
+                auto nibbles = vzip_u8( vand_u8( bits, mask ), vshr_n_u8( bits, 4 ) );
+                auto values = vcombine_u8( nibbles.val[0], nibbles.val[1] );
+                uint8 alphas[16];
+                vst1q_u8( alphas, vorrq_u8( values, vshlq_n_u8( values, 4 ) ) );
+
+                for ( uint y = 0; y < 4; y++ ) {
+                    ::memcpy( po_alphas + y * p_stride, alphas + y * 4, 4 );
+                }
+            }
+
+            static void grayRows( const uint8* p_palette, uint64 p_indices, uint8* po_colors, uint p_stride ) {
+                auto palette = vcombine_u8( vld1_u8( p_palette ), vdup_n_u8( 0 ) );
+                auto grays = vqtbl1q_u8( palette, expandIndices( p_indices ) );
+                uint8 row[16];
+
+                for ( uint y = 0; y < 4; y++ ) {
+                    vst1q_u8( row, vqtbl1q_u8( grays, vld1q_u8( GrayMasks[y] ) ) );
+                    storeRow( po_colors + y * p_stride * 3, row );
+                }
+            }
+
+            static void normalRows( const uint8* p_reds, uint64 p_redIndices, const uint8* p_greens, uint64 p_greenIndices, uint8* po_colors, uint p_stride ) {
+                auto& tables = normalTables( );
+                uint8 redIndices[16];
+                uint8 greenIndices[16];
+                uint8 blues[16];
+                vst1q_u8( redIndices, expandIndices( p_redIndices ) );
+                vst1q_u8( greenIndices, expandIndices( p_greenIndices ) );
+                normalBlues( p_reds, redIndices, p_greens, greenIndices, blues );
+
+                uint8 palette[16];
+                for ( uint i = 0; i < 8; i++ ) {
+                    palette[i] = tables.reds[p_reds[i]];
+                    palette[8 + i] = tables.greens[p_greens[i]];
+                }
+                auto zero = vdup_n_u8( 0 );
+                auto reds = vqtbl1q_u8( vcombine_u8( vld1_u8( palette ), zero ), vld1q_u8( redIndices ) );
+                auto greens = vqtbl1q_u8( vcombine_u8( vld1_u8( palette + 8 ), zero ), vld1q_u8( greenIndices ) );
+                auto blueValues = vld1q_u8( blues );
+                uint8 row[16];
+
+                for ( uint y = 0; y < 4; y++ ) {
+                    auto value = vorrq_u8( vqtbl1q_u8( reds, vld1q_u8( InterleaveMasks[y][0] ) ),
+                        vorrq_u8( vqtbl1q_u8( greens, vld1q_u8( InterleaveMasks[y][1] ) ),
+                            vqtbl1q_u8( blueValues, vld1q_u8( InterleaveMasks[y][2] ) ) ) );
+                    vst1q_u8( row, value );
+                    storeRow( po_colors + y * p_stride * 3, row );
+                }
+            }
+        };
+
+#endif
+
+        template <typename Ops>
+        DXTDecoder makeDecoder( const char* p_name ) {
+            DXTDecoder decoder = {
+                p_name,
+                &decodeDXT1Row<Ops>,
+                &decodeDXT3Row<Ops>,
+                &decodeDXT5Row<Ops>,
+                &decodeDXTARow<Ops>,
+                &decodeDCXRow<Ops>,
+            };
+            return decoder;
+        }
+
+        DXTDecoder pickDecoder( ) {
+#if GW2B_DXT_SSE41
+            if ( hasSSE41( ) ) {
+                return makeDecoder<SSE41Ops>( "SSE4.1" );
+            }
+#elif GW2B_DXT_NEON
+            return makeDecoder<NEONOps>( "NEON" );
+#endif
+            return makeDecoder<ScalarOps>( "C++" );
+        }
+
+    };
+
+    //============================================================================/
+
+    const DXTDecoder& dxtDecoder( ) {
+        static const DXTDecoder s_decoder = pickDecoder( );
+        return s_decoder;
+    }
+
+    //============================================================================/
+
+    const DXTDecoder& dxtReferenceDecoder( ) {
+        static const DXTDecoder s_decoder = makeDecoder<ScalarOps>( "C++" );
+        return s_decoder;
+    }
+
+    //============================================================================/
+
+    const DXTDecoder& dxtBlockAverager( ) {
+        static const DXTDecoder s_decoder = makeDecoder<AverageOps>( "Average" );
+        return s_decoder;
+    }
+
+}; // namespace gw2b
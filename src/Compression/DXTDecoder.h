@@ -0,0 +1,73 @@
+/** \file       Compression/DXTDecoder.h
+ *  \brief      Contains the declaration of the DXT block decoders.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef COMPRESSION_DXTDECODER_H_INCLUDED
+#define COMPRESSION_DXTDECODER_H_INCLUDED
+
+namespace gw2b {
+
+    /** Decodes a row of 4x4 blocks, so 4 rows of pixels. Blocks are always
+    *  written whole, so the width must be at least 4 pixels per block. Images
+    *  whose width isn't a multiple of 4 need a padded buffer.
+    *  \param[in]  p_blocks     First block of the row.
+    *  \param[in]  p_numBlocks  Amount of blocks in the row.
+    *  \param[out] po_colors    First pixel of the row, 3 bytes per pixel.
+    *  \param[out] po_alphas    First alpha of the row, 1 byte per pixel. Unused by
+    *                          formats without alpha.
+    *  \param[in]  p_width      Width of the image, in pixels, at least p_numBlocks * 4. */
+    typedef void ( *DXTRowDecoder )( const byte* p_blocks, uint p_numBlocks, uint8* po_colors, uint8* po_alphas, uint p_width );
+
+    /** Set of decoders for the block formats of textures. All sets but the
+    *  block averages decode to exactly the same output.
+    *
+    *  Colors come out in the order the 565 endpoints store them, which is the
+    *  reverse of the BGR the image reader calls them. 3DCX normals come out as
+    *  RGB, with the blue computed from red and green and green inverted. */
+    struct DXTDecoder {
+        const char*     name;   /**< Name of the instruction set used. */
+        DXTRowDecoder   dxt1;   /**< DXT1, 8 byte blocks. Alpha is 0 for the transparent color. */
+        DXTRowDecoder   dxt3;   /**< DXT2/3/N, 16 byte blocks with 4-bit alpha. */
+        DXTRowDecoder   dxt5;   /**< DXT4/5/L, 16 byte blocks with interpolated alpha. */
+        DXTRowDecoder   dxta;   /**< DXTA, 8 byte blocks of interpolated gray. No alpha. */
+        DXTRowDecoder   dcx;    /**< 3DCX, 16 byte blocks of interpolated normal red and green. No alpha. */
+    };
+
+    /** Gets the fastest decoders the CPU supports, picked on first use.
+    *  \return DXTDecoder&  The decoders. */
+    const DXTDecoder& dxtDecoder( );
+    /** Gets the plain C++ decoders, the reference for all others.
+    *  \return DXTDecoder&  The decoders. */
+    const DXTDecoder& dxtReferenceDecoder( );
+    /** Gets decoders that write a single pixel per block instead of 4x4: the
+    *  average of the block, without decoding its pixels. A row of blocks then
+    *  becomes a single row of pixels, and p_width needs to be at least
+    *  p_numBlocks.
+    *  \return DXTDecoder&  The decoders. */
+    const DXTDecoder& dxtBlockAverager( );
+
+}; // namespace gw2b
+
+#endif // COMPRESSION_DXTDECODER_H_INCLUDED
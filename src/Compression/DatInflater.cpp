@@ -0,0 +1,355 @@
+/** \file       Compression/DatInflater.cpp
+ *  \brief      Contains the definition of the .dat entry inflater.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include "BitReader.h"
+#include "HuffmanTree.h"
+
+#include "DatInflater.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Symbols of the literal/length tree below this are literals. */
+        const uint LiteralCount = 0x100;
+        /** Length symbol with a fixed size of 0xff. */
+        const uint MaxLengthSymbol = 28;
+        /** Amount of codes decoded per block before a new block follows. */
+        const uint BlockCodesShift = 12;
+        /** Farthest a match can reach back, in bytes. */
+        const uint32 HistorySize = 0x20000;
+        /** Most bytes a single code can output, rounded up. */
+        const uint32 MaxCodeOutput = 0x200;
+        /** Size of the window inflated into before it is handed to a sink. */
+        const uint32 StreamWindowSize = HistorySize + 0x100000;
+        /** Size of the pieces the compressed data is read in, a multiple of the
+        *  64 KiB checksum blocks. */
+        const uint32 StreamInputSize = 0x100000;
+
+        /** Code lengths of the static dictionary used to read the trees of
+        *  every block, indexed by length - 3. Missing symbols are 16 bits long. */
+        const uint8 DictionaryBits3[] = { 0x0A, 0x09, 0x08 };
+        const uint8 DictionaryBits4[] = { 0x0C, 0x0B, 0x07, 0x00 };
+        const uint8 DictionaryBits5[] = { 0xE0, 0x2A, 0x29, 0x06 };
+        const uint8 DictionaryBits6[] = { 0x4A, 0x40, 0x2C, 0x2B, 0x28, 0x20, 0x05, 0x04 };
+        const uint8 DictionaryBits7[] = { 0x49, 0x48, 0x27, 0x26, 0x25, 0x0D, 0x03 };
+        const uint8 DictionaryBits8[] = { 0x6A, 0x69, 0x4C, 0x4B, 0x47, 0x24 };
+        const uint8 DictionaryBits9[] = { 0xE8, 0xA0, 0x89, 0x88, 0x68, 0x67, 0x63, 0x60, 0x46, 0x23 };
+        const uint8 DictionaryBits10[] = { 0xE9, 0xC9, 0xC0, 0xA9, 0xA8, 0x8A, 0x87, 0x80, 0x66, 0x65, 0x45, 0x44, 0x43, 0x2D, 0x02, 0x01 };
+        const uint8 DictionaryBits11[] = { 0xE5, 0xC8, 0xAA, 0xA5, 0xA4, 0x8B, 0x85, 0x84, 0x6C, 0x6B, 0x64, 0x4D, 0x0E };
+        const uint8 DictionaryBits12[] = { 0xE7, 0xCA, 0xC7, 0xA7, 0xA6, 0x86, 0x83 };
+        const uint8 DictionaryBits13[] = { 0xE6, 0xE4, 0xC4, 0x8C, 0x2E, 0x22 };
+        const uint8 DictionaryBits14[] = { 0xEC, 0xC6, 0x6D, 0x4E };
+        const uint8 DictionaryBits15[] = { 0xEA, 0xCC, 0xAC, 0xAB, 0x8D, 0x11, 0x10, 0x0F };
+
+        struct DictionaryLength {
+            const uint8*    symbols;
+            uint            count;
+        };
+
+        /** Builds the static dictionary tree. */
+        HuffmanTree buildDictionary( ) {
+            const DictionaryLength lengths[] = {
+                { DictionaryBits3, sizeof( DictionaryBits3 ) },
+                { DictionaryBits4, sizeof( DictionaryBits4 ) },
+                { DictionaryBits5, sizeof( DictionaryBits5 ) },
+                { DictionaryBits6, sizeof( DictionaryBits6 ) },
+                { DictionaryBits7, sizeof( DictionaryBits7 ) },
+                { DictionaryBits8, sizeof( DictionaryBits8 ) },
+                { DictionaryBits9, sizeof( DictionaryBits9 ) },
+                { DictionaryBits10, sizeof( DictionaryBits10 ) },
+                { DictionaryBits11, sizeof( DictionaryBits11 ) },
+                { DictionaryBits12, sizeof( DictionaryBits12 ) },
+                { DictionaryBits13, sizeof( DictionaryBits13 ) },
+                { DictionaryBits14, sizeof( DictionaryBits14 ) },
+                { DictionaryBits15, sizeof( DictionaryBits15 ) },
+            };
+
+            uint8 codeBits[0x100];
+            ::memset( codeBits, 16, sizeof( codeBits ) );
+            for ( uint i = 0; i < sizeof( lengths ) / sizeof( lengths[0] ); i++ ) {
+                for ( uint j = 0; j < lengths[i].count; j++ ) {
+                    codeBits[lengths[i].symbols[j]] = i + 3;
+                }
+            }
+
+            HuffmanTree tree;
+            tree.build( codeBits, 0x100 );
+            return tree;
+        }
+
+        const HuffmanTree& dictionary( ) {
+            static const HuffmanTree s_dictionary = buildDictionary( );
+            return s_dictionary;
+        }
+
+        /** Reads the code lengths of a tree from the stream and builds it.
+        *  Symbols are given from the highest down, in runs of equal length. */
+        bool parseTree( BitReader& p_reader, HuffmanTree& po_tree, uint p_pairLimit ) {
+            auto& dict = dictionary( );
+
+            auto numSymbols = p_reader.read( 16 );
+            if ( numSymbols > HuffmanTree::MaxSymbols ) {
+                return false;
+            }
+
+            uint8 codeBits[HuffmanTree::MaxSymbols];
+            ::memset( codeBits, 0, sizeof( codeBits ) );
+
+            auto remaining = static_cast<int>( numSymbols ) - 1;
+            while ( remaining >= 0 ) {
+                uint code;
+                p_reader.refill( );
+                if ( !dict.read( p_reader, code ) || p_reader.isOverrun( ) ) {
+                    return false;
+                }
+
+                auto bits = code & 0x1f;
+                auto count = static_cast<int>( code >> 5 ) + 1;
+                if ( count > remaining + 1 ) {
+                    return false;
+                }
+                if ( bits ) {
+                    for ( int i = 0; i < count; i++ ) {
+                        codeBits[remaining - i] = bits;
+                    }
+                }
+                remaining -= count;
+            }
+
+            return po_tree.build( codeBits, numSymbols, p_pairLimit );
+        }
+
+        /** Copies a match. The source may overlap the destination. */
+        void copyMatch( byte* po_output, uint32 p_offset, uint32 p_size ) {
+            const byte* source = po_output - p_offset;
+            if ( p_offset == 1 ) {
+                ::memset( po_output, *source, p_size );
+            } else if ( p_offset >= 8 ) {
+                // Chunks of up to offset bytes never overlap
+                while ( p_size >= 8 ) {
+                    ::memcpy( po_output, source, 8 );
+                    po_output += 8;
+                    source += 8;
+                    p_size -= 8;
+                }
+                while ( p_size-- ) {
+                    *po_output++ = *source++;
+                }
+            } else {
+                while ( p_size-- ) {
+                    *po_output++ = *source++;
+                }
+            }
+        }
+
+        /** Output of the inflater. Either the whole output buffer, or a window
+        *  that is handed to a sink whenever it fills up, keeping the last
+        *  HistorySize bytes for the matches that follow. */
+        struct Output {
+            byte*       data;           /**< Buffer or window. */
+            uint32      flushLimit;     /**< Position past which the window is flushed. */
+            uint32      flushed;        /**< Position up to which the window was flushed. */
+            IDataSink*  sink;           /**< Sink of the window, nullptr when inflating into a buffer. */
+        };
+
+        /** Hands the window to the sink and keeps the history at its start.
+        *  \return uint32  Amount of bytes the positions in the window moved by, 0 if the sink aborted. */
+        uint32 flushOutput( Output& p_output, uint32 p_position ) {
+            if ( !p_output.sink->write( p_output.data + p_output.flushed, p_position - p_output.flushed ) ) {
+                return 0;
+            }
+            auto shift = p_position - HistorySize;
+            ::memmove( p_output.data, p_output.data + shift, HistorySize );
+            p_output.flushed = HistorySize;
+            return shift;
+        }
+
+        /** Inflates the data following the header.
+        *  \return bool    true if inflated, false if the data is corrupt or the sink aborted. */
+        bool inflate( BitReader& p_reader, uint32 p_outputSize, Output& p_output ) {
+            p_reader.read( 4 );
+            auto sizeAdd = p_reader.read( 4 ) + 1;
+            if ( p_reader.isOverrun( ) ) {
+                return false;
+            }
+
+            HuffmanTree symbols;
+            HuffmanTree copies;
+            auto output = p_output.data;
+            uint32 position = 0;
+            // Where the output ends, relative to the window
+            uint64 outputEnd = p_outputSize;
+
+            while ( position < outputEnd ) {
+                // An empty tree ends the data
+                if ( !parseTree( p_reader, symbols, LiteralCount ) || !parseTree( p_reader, copies, 0 ) ) {
+                    break;
+                }
+
+                auto codesLeft = ( p_reader.read( 4 ) + 1 ) << BlockCodesShift;
+                while ( codesLeft && position < outputEnd ) {
+                    // Window full?
+                    if ( position >= p_output.flushLimit ) {
+                        auto shift = flushOutput( p_output, position );
+                        if ( !shift ) {
+                            return false;
+                        }
+                        position -= shift;
+                        outputEnd -= shift;
+                    }
+
+                    p_reader.refill( );
+                    auto entry = symbols.lookup( p_reader );
+
+                    // Two literals in one go
+                    if ( entry.count( ) == 2 && codesLeft >= 2 && outputEnd - position >= 2 ) {
+                        p_reader.drop( entry.totalBits( ) );
+                        output[position++] = static_cast<byte>( entry.first( ) );
+                        output[position++] = static_cast<byte>( entry.second( ) );
+                        codesLeft -= 2;
+                        continue;
+                    }
+
+                    uint symbol;
+                    if ( entry.count( ) ) {
+                        p_reader.drop( entry.firstBits( ) );
+                        symbol = entry.first( );
+                    } else if ( !symbols.readLong( p_reader, symbol ) ) {
+                        return false;
+                    }
+                    codesLeft--;
+
+                    if ( symbol < LiteralCount ) {
+                        output[position++] = static_cast<byte>( symbol );
+                        continue;
+                    }
+
+                    // Match size
+                    symbol -= LiteralCount;
+                    auto group = symbol >> 2;
+                    uint32 size;
+                    if ( group == 0 ) {
+                        size = symbol;
+                    } else if ( group < 7 ) {
+                        size = ( 1u << ( group - 1 ) ) * ( 4 + ( symbol & 3 ) );
+                        if ( group > 1 ) {
+                            size |= p_reader.read( group - 1 );
+                        }
+                    } else if ( symbol == MaxLengthSymbol ) {
+                        size = 0xff;
+                    } else {
+                        return false;
+                    }
+                    size += sizeAdd;
+
+                    // Match offset
+                    p_reader.refill( );
+                    if ( !copies.read( p_reader, symbol ) ) {
+                        return false;
+                    }
+                    group = symbol >> 1;
+                    uint32 offset;
+                    if ( group == 0 ) {
+                        offset = symbol;
+                    } else if ( group < 17 ) {
+                        offset = ( 1u << ( group - 1 ) ) * ( 2 + ( symbol & 1 ) );
+                        if ( group > 1 ) {
+                            offset |= p_reader.read( group - 1 );
+                        }
+                    } else {
+                        return false;
+                    }
+                    offset += 1;
+
+                    if ( offset > position ) {
+                        return false;
+                    }
+                    if ( size > outputEnd - position ) {
+                        size = static_cast<uint32>( outputEnd - position );
+                    }
+                    copyMatch( output + position, offset, size );
+                    position += size;
+                }
+
+                if ( p_reader.isOverrun( ) ) {
+                    return false;
+                }
+            }
+
+            if ( p_reader.isOverrun( ) ) {
+                return false;
+            }
+            // Hand the rest of the window to the sink
+            if ( p_output.sink && position > p_output.flushed ) {
+                return p_output.sink->write( output + p_output.flushed, position - p_output.flushed );
+            }
+            return true;
+        }
+
+    };
+
+    //============================================================================/
+
+    bool inflateDatBuffer( uint32 p_inputSize, const byte* p_input, uint32& po_outputSize, byte* po_output ) {
+        if ( !p_input || !po_output ) {
+            return false;
+        }
+
+        BitReader reader( p_input, p_inputSize );
+
+        // Skip the header, then get the size of the inflated data
+        reader.read( 32 );
+        auto outputSize = reader.read( 32 );
+        if ( po_outputSize && po_outputSize < outputSize ) {
+            outputSize = po_outputSize;
+        }
+        po_outputSize = outputSize;
+
+        // The whole buffer is the window, it never fills up
+        Output output = { po_output, outputSize, 0, nullptr };
+        return inflate( reader, outputSize, output );
+    }
+
+    //============================================================================/
+
+    bool inflateDatStream( IDataSource& p_input, IDataSink& po_output, uint32* po_outputSize ) {
+        Array<byte> input( StreamInputSize );
+        Array<byte> window( StreamWindowSize );
+        BitReader reader( p_input, input.GetPointer( ), input.GetSize( ) );
+
+        // Skip the header, then get the size of the inflated data
+        reader.read( 32 );
+        auto outputSize = reader.read( 32 );
+        if ( po_outputSize ) {
+            *po_outputSize = outputSize;
+        }
+
+        Output output = { window.GetPointer( ), StreamWindowSize - MaxCodeOutput, 0, &po_output };
+        return inflate( reader, outputSize, output );
+    }
+
+}; // namespace gw2b
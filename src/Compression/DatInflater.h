@@ -0,0 +1,63 @@
+/** \file       Compression/DatInflater.h
+ *  \brief      Contains the declaration of the .dat entry inflater.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef COMPRESSION_DATINFLATER_H_INCLUDED
+#define COMPRESSION_DATINFLATER_H_INCLUDED
+
+#include "Util/DataStream.h"
+
+/** Set to 0 to inflate .dat entries with gw2dattools rather than with
+ *  gw2b::inflateDatBuffer. Streamed entries always use gw2b::inflateDatStream. */
+#ifndef GW2B_INTREE_INFLATE
+#   define GW2B_INTREE_INFLATE  1
+#endif
+
+namespace gw2b {
+
+    /** Inflates a compressed .dat entry. Does the same as
+    *  gw2dt::compression::inflateDatFileBuffer, but decodes short codes with
+    *  a single table lookup, two literals at a time where possible, and
+    *  reports errors instead of throwing.
+    *  \param[in]      p_inputSize      Size of the compressed data, in bytes.
+    *  \param[in]      p_input          Compressed data.
+    *  \param[in,out]  po_outputSize    Max amount of bytes to inflate, 0 for all. Receives the size of the inflated data.
+    *  \param[out]     po_output        Buffer receiving the inflated data.
+    *  \return bool    true if inflated, false if the data is corrupt. */
+    bool inflateDatBuffer( uint32 p_inputSize, const byte* p_input, uint32& po_outputSize, byte* po_output );
+
+    /** Inflates a compressed .dat entry piece by piece. The compressed data is
+    *  read from a source 1 MiB at a time and inflated into a window that is
+    *  handed to a sink whenever it fills up, so memory use doesn't depend on
+    *  the size of the entry.
+    *  \param[in]  p_input          Source of the compressed data.
+    *  \param[in]  po_output        Sink receiving the inflated data.
+    *  \param[out] po_outputSize    Receives the size of the inflated data, if not nullptr.
+    *  \return bool    true if inflated, false if the data is corrupt or the sink aborted. */
+    bool inflateDatStream( IDataSource& p_input, IDataSink& po_output, uint32* po_outputSize = nullptr );
+
+}; // namespace gw2b
+
+#endif // COMPRESSION_DATINFLATER_H_INCLUDED
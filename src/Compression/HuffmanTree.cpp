@@ -0,0 +1,149 @@
+/** \file       Compression/HuffmanTree.cpp
+ *  \brief      Contains the definition of the table driven Huffman decoder.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include "HuffmanTree.h"
+
+namespace gw2b {
+
+    namespace {
+
+        uint32 makeEntry( uint p_first, uint p_second, uint p_firstBits, uint p_totalBits, uint p_count ) {
+            return p_first | ( p_second << 9 ) | ( p_firstBits << 17 ) | ( p_totalBits << 22 ) | ( p_count << 27 );
+        }
+
+    };
+
+    HuffmanTree::HuffmanTree( )
+        : m_numLong( 0 ) {
+        ::memset( m_table, 0, sizeof( m_table ) );
+        m_longCodes[0] = 0;
+    }
+
+    //============================================================================/
+
+    bool HuffmanTree::build( const uint8* p_codeBits, uint p_numSymbols, uint p_pairLimit ) {
+        Assert( p_pairLimit <= 0x100 );
+
+        ::memset( m_table, 0, sizeof( m_table ) );
+        m_numLong = 0;
+        m_longCodes[0] = 0;
+
+        if ( p_numSymbols > MaxSymbols ) {
+            return false;
+        }
+
+        // Every length starts at its highest code, counting down per symbol
+        int64 code = 0;
+        uint numCodes = 0;
+        uint numLongSymbols = 0;
+
+        for ( uint bits = 1; bits < MaxCodeBits; bits++ ) {
+            code = code * 2 + 1;
+            bool hasSymbols = false;
+
+            for ( uint symbol = 0; symbol < p_numSymbols; symbol++ ) {
+                if ( p_codeBits[symbol] != bits ) {
+                    continue;
+                }
+                // Over-subscribed
+                if ( code < 0 ) {
+                    return false;
+                }
+
+                if ( bits <= TableBits ) {
+                    auto first = static_cast<uint>( code ) << ( TableBits - bits );
+                    auto count = 1u << ( TableBits - bits );
+                    auto entry = makeEntry( symbol, 0, bits, bits, 1 );
+                    for ( uint i = 0; i < count; i++ ) {
+                        m_table[first + i] = entry;
+                    }
+                } else {
+                    m_longSymbols[numLongSymbols++] = symbol;
+                }
+
+                code--;
+                numCodes++;
+                hasSymbols = true;
+            }
+
+            // Lowest code of the length, left aligned, and where its symbol is
+            if ( hasSymbols && bits > TableBits ) {
+                m_longCodes[m_numLong] = static_cast<uint32>( ( code + 1 ) << ( 32 - bits ) );
+                m_longBits[m_numLong] = bits;
+                m_longOffsets[m_numLong] = numLongSymbols - 1;
+                m_numLong++;
+            }
+        }
+        // Makes the search in readLong stop
+        m_longCodes[m_numLong] = 0;
+
+        if ( !numCodes ) {
+            return false;
+        }
+
+        // Resolve a second symbol wherever the table bits left over hold a
+        // complete code
+        if ( p_pairLimit ) {
+            for ( uint i = 0; i < ( 1u << TableBits ); i++ ) {
+                Entry first = { m_table[i] };
+                if ( first.count( ) != 1 || first.first( ) >= p_pairLimit || first.firstBits( ) >= TableBits ) {
+                    continue;
+                }
+
+                auto firstBits = first.firstBits( );
+                Entry second = { m_table[( i << firstBits ) & ( ( 1u << TableBits ) - 1 )] };
+                if ( !second.count( ) || second.first( ) >= p_pairLimit || second.firstBits( ) > TableBits - firstBits ) {
+                    continue;
+                }
+
+                m_table[i] = makeEntry( first.first( ), second.first( ), firstBits, firstBits + second.firstBits( ), 2 );
+            }
+        }
+
+        return true;
+    }
+
+    //============================================================================/
+
+    bool HuffmanTree::readLong( BitReader& p_reader, uint& po_symbol ) const {
+        auto code = p_reader.peek( 32 );
+
+        uint index = 0;
+        while ( code < m_longCodes[index] ) {
+            index++;
+        }
+        if ( index >= m_numLong ) {
+            return false;
+        }
+
+        auto bits = m_longBits[index];
+        auto delta = ( code - m_longCodes[index] ) >> ( 32 - bits );
+        po_symbol = m_longSymbols[m_longOffsets[index] - delta];
+        p_reader.drop( bits );
+        return true;
+    }
+
+}; // namespace gw2b
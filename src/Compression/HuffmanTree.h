@@ -0,0 +1,128 @@
+/** \file       Compression/HuffmanTree.h
+ *  \brief      Contains the declaration of the table driven Huffman decoder.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef COMPRESSION_HUFFMANTREE_H_INCLUDED
+#define COMPRESSION_HUFFMANTREE_H_INCLUDED
+
+#include "BitReader.h"
+
+namespace gw2b {
+
+    /** Huffman code as used by the .dat compression formats. Codes are
+    *  assigned per length, shortest first, with the smallest symbol of each
+    *  length getting the highest code.
+    *
+    *  Codes of up to TableBits bits are decoded with a single table lookup.
+    *  When built with a pair limit, a lookup also yields a second symbol if
+    *  both symbols are below the limit and their codes fit in the table bits
+    *  together. Longer codes fall back to a search over the code lengths. */
+    class HuffmanTree {
+    public:
+        enum {
+            TableBits = 10,         /**< Amount of bits resolved by the lookup table. */
+            MaxSymbols = 286,       /**< Max amount of symbols in a tree. */
+            MaxCodeBits = 32,       /**< Max code length, exclusive. */
+        };
+
+        /** Result of a table lookup. */
+        struct Entry {
+            uint32  value;
+
+            /** Gets the amount of decoded symbols: 0 for a code longer than
+            *  TableBits, 1 or 2.
+            *  \return uint    Amount of decoded symbols. */
+            uint count( ) const {
+                return value >> 27;
+            }
+            /** Gets the first decoded symbol.
+            *  \return uint    The symbol. */
+            uint first( ) const {
+                return value & 0x1ff;
+            }
+            /** Gets the second decoded symbol, if count() is 2.
+            *  \return uint    The symbol. */
+            uint second( ) const {
+                return ( value >> 9 ) & 0xff;
+            }
+            /** Gets the code length of the first symbol.
+            *  \return uint    Length, in bits. */
+            uint firstBits( ) const {
+                return ( value >> 17 ) & 0x1f;
+            }
+            /** Gets the code length of both symbols.
+            *  \return uint    Length, in bits. */
+            uint totalBits( ) const {
+                return ( value >> 22 ) & 0x1f;
+            }
+        };
+    private:
+        uint32  m_table[1 << TableBits];
+        uint32  m_longCodes[MaxCodeBits];
+        uint8   m_longBits[MaxCodeBits];
+        uint16  m_longOffsets[MaxCodeBits];
+        uint16  m_longSymbols[MaxSymbols];
+        uint    m_numLong;
+    public:
+        /** Constructor. Creates an empty tree. */
+        HuffmanTree( );
+
+        /** Builds the tree from the code length of every symbol.
+        *  \param[in]  p_codeBits       Code length of every symbol, 0 if unused.
+        *  \param[in]  p_numSymbols     Amount of symbols.
+        *  \param[in]  p_pairLimit      Symbols below this may be decoded in pairs, 0 to disable.
+        *  \return bool    true if built, false if the lengths don't form a valid code. */
+        bool build( const uint8* p_codeBits, uint p_numSymbols, uint p_pairLimit = 0 );
+
+        /** Looks up the next code. Needs a refilled reader.
+        *  \param[in]  p_reader     Reader to peek the code from.
+        *  \return Entry   The lookup result. */
+        Entry lookup( const BitReader& p_reader ) const {
+            Entry entry = { m_table[p_reader.peek( TableBits )] };
+            return entry;
+        }
+        /** Reads the next symbol. Needs a refilled reader.
+        *  \param[in]  p_reader     Reader to read the code from.
+        *  \param[out] po_symbol    The read symbol.
+        *  \return bool    true if read, false if the code is invalid. */
+        bool read( BitReader& p_reader, uint& po_symbol ) const {
+            auto entry = this->lookup( p_reader );
+            if ( entry.count( ) ) {
+                p_reader.drop( entry.firstBits( ) );
+                po_symbol = entry.first( );
+                return true;
+            }
+            return this->readLong( p_reader, po_symbol );
+        }
+        /** Reads the next symbol with a code longer than TableBits.
+        *  \param[in]  p_reader     Reader to read the code from.
+        *  \param[out] po_symbol    The read symbol.
+        *  \return bool    true if read, false if the code is invalid. */
+        bool readLong( BitReader& p_reader, uint& po_symbol ) const;
+    }; // class HuffmanTree
+
+}; // namespace gw2b
+
+#endif // COMPRESSION_HUFFMANTREE_H_INCLUDED
@@ -0,0 +1,416 @@
+/** \file       Compression/TextureInflater.cpp
+ *  \brief      Contains the definition of the ATEX texture inflater.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <vector>
+
+#include "ANetStructs.h"
+#include "BitReader.h"
+#include "HuffmanTree.h"
+
+#include "TextureInflater.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** What the blocks of a format hold. */
+        enum FormatFlags {
+            FF_Color = 0x10,            /**< Has a color component. */
+            FF_Alpha = 0x20,            /**< Has an alpha component. */
+            FF_DeferredAlpha = 0x40,    /**< Alpha is part of the color component (DXT1). */
+            FF_PlainColor = 0x80,       /**< Color and alpha are separate components. */
+            FF_BiColor = 0x200,         /**< Two color components (DXTN, 3DCX). */
+        };
+
+        /** Passes filling blocks of a single value, as given by the stream. */
+        enum CompressionFlags {
+            CF_WhiteColor = 0x01,
+            CF_ConstantAlphaFrom4Bits = 0x02,
+            CF_ConstantAlphaFrom8Bits = 0x04,
+            CF_PlainColor = 0x08,
+        };
+
+        struct TextureFormat {
+            uint    flags;
+            uint    numBlocks;
+            uint    bytesPerBlock;
+            uint    bytesPerComponent;
+            bool    hasTwoComponents;
+        };
+
+        bool deduceFormat( uint32 p_fourcc, TextureFormat& po_format ) {
+            uint pixelBits;
+            switch ( p_fourcc ) {
+            case FCC_DXT1:
+                po_format.flags = FF_Color | FF_Alpha | FF_DeferredAlpha;
+                pixelBits = 4;
+                break;
+            case FCC_DXT2:
+            case FCC_DXT3:
+            case FCC_DXT4:
+            case FCC_DXT5:
+            case FCC_DXTL:
+                po_format.flags = FF_Color | FF_Alpha | FF_PlainColor;
+                pixelBits = 8;
+                break;
+            case FCC_DXTA:
+                po_format.flags = FF_Alpha | FF_PlainColor;
+                pixelBits = 4;
+                break;
+            case FCC_DXTN:
+            case FCC_3DCX:
+                po_format.flags = FF_Alpha | FF_BiColor;
+                pixelBits = 8;
+                break;
+            default:
+                return false;
+            }
+
+            po_format.bytesPerBlock = pixelBits * 2;
+            po_format.hasTwoComponents = ( ( po_format.flags & ( FF_Color | FF_PlainColor ) ) == ( FF_Color | FF_PlainColor ) ) || ( po_format.flags & FF_BiColor );
+            po_format.bytesPerComponent = po_format.bytesPerBlock / ( po_format.hasTwoComponents ? 2 : 1 );
+            return true;
+        }
+
+        /** Builds the tree of the run lengths used by the fill passes. */
+        HuffmanTree buildDictionary( ) {
+            uint8 codeBits[0x13];
+            ::memset( codeBits, 6, sizeof( codeBits ) );
+            codeBits[0x00] = 0;
+            codeBits[0x01] = 1;
+            codeBits[0x12] = 2;
+
+            HuffmanTree tree;
+            tree.build( codeBits, sizeof( codeBits ) );
+            return tree;
+        }
+
+        const HuffmanTree& dictionary( ) {
+            static const HuffmanTree s_dictionary = buildDictionary( );
+            return s_dictionary;
+        }
+
+        /** Decoding state shared by the fill passes. */
+        struct TextureState {
+            BitReader               reader;
+            const TextureFormat&    format;
+            byte*                   output;
+            std::vector<uint8>      colorDone;
+            std::vector<uint8>      alphaDone;
+
+            TextureState( const byte* p_input, uint32 p_size, const TextureFormat& p_format, byte* po_output )
+                : reader( p_input, p_size, false )
+                , format( p_format )
+                , output( po_output )
+                , colorDone( p_format.numBlocks, 0 )
+                , alphaDone( p_format.numBlocks, 0 ) {
+            }
+
+            byte* block( uint p_index ) {
+                return &output[p_index * format.bytesPerBlock];
+            }
+            byte* colorComponent( uint p_index ) {
+                return this->block( p_index ) + ( format.hasTwoComponents ? format.bytesPerComponent : 0 );
+            }
+        };
+
+        /** Runs a fill pass. The stream holds runs of blocks not yet done in
+        *  the pass' bitmap, each with a flag telling whether to fill them.
+        *  p_readFlags reads the flags, p_fill fills a block. */
+        template <typename ReadFlags, typename Fill>
+        bool fillPass( TextureState& p_state, std::vector<uint8>& p_done, ReadFlags p_readFlags, Fill p_fill ) {
+            auto& dict = dictionary( );
+            auto numBlocks = p_state.format.numBlocks;
+            uint position = 0;
+
+            while ( position < numBlocks ) {
+                uint count;
+                p_state.reader.refill( );
+                if ( !dict.read( p_state.reader, count ) ) {
+                    return false;
+                }
+                auto flags = p_readFlags( p_state.reader );
+
+                while ( count && position < numBlocks ) {
+                    if ( !p_done[position] ) {
+                        if ( flags & 1 ) {
+                            p_fill( position, flags );
+                        }
+                        count--;
+                    }
+                    position++;
+                }
+                while ( position < numBlocks && p_done[position] ) {
+                    position++;
+                }
+
+                if ( p_state.reader.isOverrun( ) ) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        uint32 readFillFlag( BitReader& p_reader ) {
+            return p_reader.read( 1 );
+        }
+
+        /** Fill flag, then for filled runs whether the alpha is the constant
+        *  rather than 0. */
+        uint32 readAlphaFlags( BitReader& p_reader ) {
+            p_reader.refill( );
+            auto flags = p_reader.peek( 2 );
+            p_reader.drop( ( flags & 2 ) ? 2 : 1 );
+            // Bit 0: fill, bit 1: constant
+            return ( flags >> 1 ) | ( ( flags & 1 ) << 1 );
+        }
+
+        bool decodeWhiteColor( TextureState& p_state ) {
+            const uint64 white = 0xfffffffffffffffeull;
+            return fillPass( p_state, p_state.colorDone, readFillFlag, [&p_state, &white]( uint p_index, uint32 ) {
+                ::memcpy( p_state.block( p_index ), &white, sizeof( white ) );
+                if ( p_state.format.hasTwoComponents ) {
+                    ::memcpy( p_state.block( p_index ) + p_state.format.bytesPerComponent, &white, sizeof( white ) );
+                }
+                p_state.alphaDone[p_index] = 1;
+                p_state.colorDone[p_index] = 1;
+            } );
+        }
+
+        bool decodeConstantAlpha( TextureState& p_state, uint64 p_alpha ) {
+            const uint64 zero = 0;
+            return fillPass( p_state, p_state.alphaDone, readAlphaFlags, [&p_state, &p_alpha, &zero]( uint p_index, uint32 p_flags ) {
+                ::memcpy( p_state.block( p_index ), ( p_flags & 2 ) ? &p_alpha : &zero, p_state.format.bytesPerComponent );
+                p_state.alphaDone[p_index] = 1;
+            } );
+        }
+
+        bool decodeConstantAlphaFrom4Bits( TextureState& p_state ) {
+            // Explicit alpha, every pixel the same nibble
+            uint64 alpha = p_state.reader.read( 4 );
+            alpha |= alpha << 4;
+            alpha |= alpha << 8;
+            alpha |= alpha << 16;
+            alpha |= alpha << 32;
+            return decodeConstantAlpha( p_state, alpha );
+        }
+
+        bool decodeConstantAlphaFrom8Bits( TextureState& p_state ) {
+            // Interpolated alpha with both end points the same, all indices 0
+            uint64 alpha = p_state.reader.read( 8 );
+            alpha |= alpha << 8;
+            return decodeConstantAlpha( p_state, alpha );
+        }
+
+        /** Splits an 8-bit channel into two end point values and a weight in
+        *  twelfths of the distance between them. */
+        void splitChannel( uint p_value, uint p_bits, uint& po_low, uint& po_first, uint& po_second, uint& po_weight ) {
+            auto shift = 8 - p_bits;
+            auto low = ( p_value - ( p_value >> p_bits ) ) >> shift;
+            auto expanded = ( low << shift ) + ( low >> ( p_bits - shift ) );
+            auto mask = ( p_bits == 6 ) ? 0x1111u : 0x11u;
+            auto weight = 12 * ( p_value - expanded ) / ( 8 - ( ( low & mask ) == mask ? 1 : 0 ) );
+
+            po_low = low;
+            po_weight = weight;
+            if ( weight < 2 ) {
+                po_first = low;
+                po_second = low;
+            } else if ( weight < 6 ) {
+                po_first = low;
+                po_second = low + 1;
+            } else if ( weight < 10 ) {
+                po_first = low + 1;
+                po_second = low;
+            } else {
+                po_first = low + 1;
+                po_second = low + 1;
+            }
+        }
+
+        bool decodePlainColor( TextureState& p_state ) {
+            auto blue = p_state.reader.read( 8 );
+            auto green = p_state.reader.read( 8 );
+            auto red = p_state.reader.read( 8 );
+
+            uint redLow, red1, red2, redWeight;
+            uint greenLow, green1, green2, greenWeight;
+            uint blueLow, blue1, blue2, blueWeight;
+            splitChannel( red, 5, redLow, red1, red2, redWeight );
+            splitChannel( green, 6, greenLow, green1, green2, greenWeight );
+            splitChannel( blue, 5, blueLow, blue1, blue2, blueWeight );
+
+            uint32 color1 = red1 | ( ( green1 | ( blue1 << 6 ) ) << 5 );
+            uint32 color2 = red2 | ( ( green2 | ( blue2 << 6 ) ) << 5 );
+
+            // Average weight of the channels whose end points differ
+            uint weight = 0;
+            uint numSplit = 0;
+            const uint lows[] = { redLow, blueLow, greenLow };
+            const uint firsts[] = { red1, blue1, green1 };
+            const uint seconds[] = { red2, blue2, green2 };
+            const uint weights[] = { redWeight, blueWeight, greenWeight };
+            for ( uint i = 0; i < 3; i++ ) {
+                if ( firsts[i] != seconds[i] ) {
+                    weight += ( firsts[i] == lows[i] ) ? weights[i] : 12 - weights[i];
+                    numSplit++;
+                }
+            }
+            if ( numSplit ) {
+                weight = ( weight + numSplit / 2 ) / numSplit;
+            }
+
+            bool dxt1Special = ( p_state.format.flags & FF_DeferredAlpha ) && weight == 5 && numSplit == 1;
+            if ( numSplit && !dxt1Special ) {
+                if ( color2 == 0xffff ) {
+                    weight = 12;
+                    color1--;
+                } else {
+                    weight = 0;
+                    color2++;
+                }
+            }
+
+            if ( color2 >= color1 ) {
+                std::swap( color1, color2 );
+                weight = 12 - weight;
+            }
+
+            uint64 index;
+            if ( dxt1Special ) {
+                index = 2;
+            } else if ( weight < 2 ) {
+                index = 0;
+            } else if ( weight < 6 ) {
+                index = 2;
+            } else if ( weight < 10 ) {
+                index = 3;
+            } else {
+                index = 1;
+            }
+
+            uint64 indices = index | ( index << 2 ) | ( ( index | ( index << 2 ) ) << 4 );
+            indices |= indices << 8;
+            indices |= indices << 16;
+            uint64 color = color1 | ( static_cast<uint64>( color2 ) << 16 ) | ( indices << 32 );
+
+            return fillPass( p_state, p_state.colorDone, readFillFlag, [&p_state, &color]( uint p_index, uint32 ) {
+                ::memcpy( p_state.colorComponent( p_index ), &color, p_state.format.bytesPerComponent );
+                p_state.colorDone[p_index] = 1;
+            } );
+        }
+
+        /** Copies the words that follow the bit stream into the blocks no pass
+        *  filled: whole alpha components first, then the first and second half
+        *  of the color components. */
+        void copyRemaining( TextureState& p_state, const byte* p_input, uint32 p_numWords ) {
+            auto& format = p_state.format;
+            auto position = p_state.reader.wordPosition( );
+
+            auto copyHalf = [&]( std::vector<uint8>& p_done, uint p_offset, bool p_color ) {
+                for ( uint i = 0; i < format.numBlocks && position < p_numWords; i++ ) {
+                    if ( !p_done[i] ) {
+                        auto target = ( p_color ? p_state.colorComponent( i ) : p_state.block( i ) ) + p_offset;
+                        ::memcpy( target, p_input + position * 4, 4 );
+                        position++;
+                    }
+                }
+            };
+
+            if ( ( format.flags & FF_Alpha ) && !( format.flags & FF_DeferredAlpha ) ) {
+                for ( uint i = 0; i < format.numBlocks && position < p_numWords; i++ ) {
+                    if ( p_state.alphaDone[i] ) {
+                        continue;
+                    }
+                    ::memcpy( p_state.block( i ), p_input + position * 4, 4 );
+                    position++;
+                    if ( format.bytesPerComponent > 4 && position < p_numWords ) {
+                        ::memcpy( p_state.block( i ) + 4, p_input + position * 4, 4 );
+                        position++;
+                    }
+                }
+            }
+
+            if ( format.flags & ( FF_Color | FF_BiColor ) ) {
+                copyHalf( p_state.colorDone, 0, true );
+                if ( format.bytesPerComponent > 4 ) {
+                    copyHalf( p_state.colorDone, 4, true );
+                }
+            }
+        }
+
+    };
+
+    //============================================================================/
+
+    bool inflateTextureBuffer( uint32 p_inputSize, const byte* p_input, uint32& po_outputSize, byte* po_output ) {
+        if ( !p_input || !po_output || p_inputSize < sizeof( ANetAtexHeader ) ) {
+            return false;
+        }
+
+        auto header = reinterpret_cast<const ANetAtexHeader*>( p_input );
+        TextureFormat format;
+        if ( !deduceFormat( header->formatInteger, format ) ) {
+            return false;
+        }
+        format.numBlocks = ( ( header->width + 3 ) / 4 ) * ( ( header->height + 3 ) / 4 );
+
+        auto outputSize = format.numBlocks * format.bytesPerBlock;
+        if ( po_outputSize && po_outputSize < outputSize ) {
+            return false;
+        }
+        po_outputSize = outputSize;
+        ::memset( po_output, 0, outputSize );
+
+        auto input = p_input + sizeof( ANetAtexHeader );
+        auto inputSize = p_inputSize - sizeof( ANetAtexHeader );
+        TextureState state( input, inputSize, format, po_output );
+
+        // Size of the data, unused
+        state.reader.read( 32 );
+        auto flags = state.reader.read( 32 );
+
+        if ( ( flags & CF_WhiteColor ) && !decodeWhiteColor( state ) ) {
+            return false;
+        }
+        if ( ( flags & CF_ConstantAlphaFrom4Bits ) && !decodeConstantAlphaFrom4Bits( state ) ) {
+            return false;
+        }
+        if ( ( flags & CF_ConstantAlphaFrom8Bits ) && !decodeConstantAlphaFrom8Bits( state ) ) {
+            return false;
+        }
+        if ( ( flags & CF_PlainColor ) && !decodePlainColor( state ) ) {
+            return false;
+        }
+        if ( state.reader.isOverrun( ) ) {
+            return false;
+        }
+
+        copyRemaining( state, input, inputSize / 4 );
+        return true;
+    }
+
+}; // namespace gw2b
@@ -0,0 +1,46 @@
+/** \file       Compression/TextureInflater.h
+ *  \brief      Contains the declaration of the ATEX texture inflater.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef COMPRESSION_TEXTUREINFLATER_H_INCLUDED
+#define COMPRESSION_TEXTUREINFLATER_H_INCLUDED
+
+#include "DatInflater.h"
+
+namespace gw2b {
+
+    /** Inflates an ATEX family texture (ATEX, ATTX, ATEC, ...) into its BCn
+    *  blocks. Does the same as gw2dt::compression::inflateTextureFileBuffer,
+    *  but reports errors instead of throwing.
+    *  \param[in]      p_inputSize      Size of the texture file, in bytes.
+    *  \param[in]      p_input          Texture file, header included.
+    *  \param[in,out]  po_outputSize    Size of po_output, 0 if large enough. Receives the size of the blocks.
+    *  \param[out]     po_output        Buffer receiving the blocks, preferably 16 byte aligned.
+    *  \return bool    true if inflated, false if the format is unsupported or the buffer too small. */
+    bool inflateTextureBuffer( uint32 p_inputSize, const byte* p_input, uint32& po_outputSize, byte* po_output );
+
+}; // namespace gw2b
+
+#endif // COMPRESSION_TEXTUREINFLATER_H_INCLUDED
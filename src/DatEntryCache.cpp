@@ -0,0 +1,510 @@
+/** \file       DatEntryCache.cpp
+ *  \brief      Contains the definition of the decompressed entry cache.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <ctime>
+#include <vector>
+#include <wx/filename.h>
+#include <wx/mstream.h>
+#include <wx/wfstream.h>
+#include <wx/zstream.h>
+
+#include "DatEntryCache.h"
+
+namespace gw2b {
+
+    namespace {
+
+        bool readExact( wxInputStream& p_stream, void* po_buffer, size_t p_size ) {
+            auto buffer = static_cast<char*>( po_buffer );
+            while ( p_size ) {
+                p_stream.Read( buffer, p_size );
+                auto read = p_stream.LastRead( );
+                if ( !read ) {
+                    return false;
+                }
+                buffer += read;
+                p_size -= read;
+            }
+            return true;
+        }
+
+        wxString indexFilename( const wxString& p_packFilename ) {
+            wxFileName filename( p_packFilename );
+            filename.SetExt( wxT( "cidx" ) );
+            return filename.GetFullPath( );
+        }
+
+    };
+
+    DatEntryCache::DatEntryCache( )
+        : m_packSize( 0 )
+        , m_liveSize( 0 )
+        , m_maxSize( DatEntryCache_DefaultMaxSize )
+        , m_maxEntrySize( DatEntryCache_DefaultMaxEntrySize )
+        , m_compactSize( 2 * DatEntryCache_DefaultMaxSize )
+        , m_generation( 0 )
+        , m_useCounter( 0 )
+        , m_isDirty( false ) {
+    }
+
+    //============================================================================/
+
+    DatEntryCache::~DatEntryCache( ) {
+        this->close( );
+    }
+
+    //============================================================================/
+
+    bool DatEntryCache::open( const wxString& p_filename ) {
+        this->close( );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_filename = p_filename;
+
+        if ( wxFile::Exists( p_filename ) && m_pack.Open( p_filename, wxFile::read_write ) ) {
+            DatEntryCachePackHead header;
+            if ( m_pack.Read( &header, sizeof( header ) ) == static_cast<ssize_t>( sizeof( header ) ) &&
+                header.magicInteger == DatEntryCache_Magic &&
+                header.version == DatEntryCache_Version ) {
+                m_generation = header.generation;
+                m_packSize = m_pack.Length( );
+                if ( this->readIndex( ) ) {
+                    this->updateCompactSize( );
+                    return true;
+                }
+            }
+            m_pack.Close( );
+        }
+
+        // Missing or unusable, start over
+        this->reset( );
+        this->updateCompactSize( );
+        return m_pack.IsOpened( );
+    }
+
+    //============================================================================/
+
+    void DatEntryCache::close( ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( !m_pack.IsOpened( ) ) {
+            return;
+        }
+
+        if ( m_isDirty ) {
+            // Only rewrite the pack when most of it is evicted payloads
+            auto deadSize = m_packSize - sizeof( DatEntryCachePackHead ) - m_liveSize;
+            if ( deadSize > m_liveSize && deadSize > ( 1 << 20 ) ) {
+                this->compact( );
+            }
+            if ( !this->writeIndex( ) ) {
+                LogWarning( wxT( "Failed to write entry cache index." ) );
+            }
+        }
+
+        m_pack.Close( );
+        this->clearRecords( );
+        m_packSize = 0;
+        m_isDirty = false;
+    }
+
+    //============================================================================/
+
+    bool DatEntryCache::isOpen( ) const {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_pack.IsOpened( );
+    }
+
+    //============================================================================/
+
+    void DatEntryCache::setLimits( uint64 p_maxSize, uint64 p_maxEntrySize ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_maxSize = p_maxSize;
+        m_maxEntrySize = p_maxEntrySize;
+        this->evict( );
+        this->updateCompactSize( );
+    }
+
+    //============================================================================/
+
+    uint64 DatEntryCache::maxSize( ) const {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_maxSize;
+    }
+
+    //============================================================================/
+
+    bool DatEntryCache::find( const DatEntryCacheKey& p_key, uint& po_size ) const {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto it = m_records.find( p_key );
+        if ( it == m_records.end( ) ) {
+            return false;
+        }
+        po_size = it->second.record.size;
+        return true;
+    }
+
+    //============================================================================/
+
+    uint DatEntryCache::read( const DatEntryCacheKey& p_key, byte* po_buffer, uint p_size ) {
+        DatEntryCacheRecord record;
+        uint32 generation;
+        wxFile pack;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            auto it = m_records.find( p_key );
+            if ( it == m_records.end( ) ) {
+                return 0;
+            }
+            record = it->second.record;
+            generation = m_generation;
+            this->touch( it );
+
+            // Open the pack of this generation while locked, so compaction
+            // can't swap it before the payload is read
+            if ( !pack.Open( m_filename, wxFile::read ) ) {
+                return 0;
+            }
+        }
+
+        // Inflate outside of the lock, through a handle of our own. The zlib
+        // stream reads the pack in small chunks as needed, so peeks only
+        // read the start of the payload.
+        auto size = wxMin( p_size, record.size );
+        pack.Seek( record.packOffset, wxFromStart );
+        wxFileInputStream file( pack );
+        wxZlibInputStream stream( file, wxZLIB_ZLIB );
+        if ( readExact( stream, po_buffer, size ) ) {
+            return size;
+        }
+
+        // Corrupt, forget about it unless it was replaced meanwhile
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto it = m_records.find( p_key );
+        if ( it != m_records.end( ) && m_generation == generation && it->second.record.packOffset == record.packOffset ) {
+            this->erase( it );
+        }
+        return 0;
+    }
+
+    //============================================================================/
+
+    Array<byte> DatEntryCache::read( const DatEntryCacheKey& p_key ) {
+        uint size;
+        if ( !this->find( p_key, size ) ) {
+            return Array<byte>( );
+        }
+
+        Array<byte> output( size );
+        if ( this->read( p_key, output.GetPointer( ), size ) != size ) {
+            return Array<byte>( );
+        }
+        return output;
+    }
+
+    //============================================================================/
+
+    void DatEntryCache::add( const DatEntryCacheKey& p_key, const byte* p_data, uint p_size ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            if ( !m_pack.IsOpened( ) || p_size < DatEntryCache_MinEntrySize || p_size > m_maxEntrySize || m_records.count( p_key ) ) {
+                return;
+            }
+        }
+
+        // Compress outside of the lock, it's the slow part
+        wxMemoryOutputStream memory;
+        {
+            wxZlibOutputStream stream( memory, wxZ_BEST_SPEED, wxZLIB_ZLIB );
+            stream.Write( p_data, p_size );
+            if ( !stream.Close( ) ) {
+                return;
+            }
+        }
+        std::vector<byte> packed( memory.GetSize( ) );
+        memory.CopyTo( packed.data( ), packed.size( ) );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( !m_pack.IsOpened( ) || m_records.count( p_key ) ) {
+            return;
+        }
+
+        m_pack.Seek( m_packSize, wxFromStart );
+        if ( m_pack.Write( packed.data( ), packed.size( ) ) != packed.size( ) ) {
+            return;
+        }
+
+        DatEntryCacheRecord record;
+        record.key = p_key;
+        record.packOffset = m_packSize;
+        record.packedSize = packed.size( );
+        record.size = p_size;
+        record.lastUse = ++m_useCounter;
+        this->insert( record );
+
+        m_packSize += record.packedSize;
+        m_isDirty = true;
+        this->evict( );
+
+        // Evicted payloads still take space in the pack, reclaim it before
+        // the pack outgrows its limit
+        if ( m_packSize >= m_compactSize ) {
+            if ( this->compact( ) && !this->writeIndex( ) ) {
+                LogWarning( wxT( "Failed to write entry cache index." ) );
+            }
+            this->updateCompactSize( );
+        }
+    }
+
+    //============================================================================/
+
+    bool DatEntryCache::readIndex( ) {
+        auto filename = indexFilename( m_filename );
+        if ( !wxFile::Exists( filename ) ) {
+            return false;
+        }
+
+        wxFile file( filename );
+        if ( !file.IsOpened( ) ) {
+            return false;
+        }
+
+        DatEntryCacheIndexHead header;
+        if ( file.Read( &header, sizeof( header ) ) != static_cast<ssize_t>( sizeof( header ) ) ) {
+            return false;
+        }
+        if ( header.magicInteger != DatEntryCache_Magic || header.version != DatEntryCache_Version ) {
+            return false;
+        }
+        if ( header.generation != m_generation ) {
+            return false;
+        }
+
+        std::vector<DatEntryCacheRecord> records( header.numRecords );
+        auto recordsSize = static_cast<ssize_t>( records.size( ) * sizeof( DatEntryCacheRecord ) );
+        if ( file.Read( records.data( ), recordsSize ) != recordsSize ) {
+            return false;
+        }
+
+        // Rebuild the use order from the use counters
+        std::sort( records.begin( ), records.end( ), [] ( const DatEntryCacheRecord& p_a, const DatEntryCacheRecord& p_b ) {
+            return p_a.lastUse < p_b.lastUse;
+        } );
+
+        this->clearRecords( );
+        for ( auto const& it : records ) {
+            if ( it.packOffset < sizeof( DatEntryCachePackHead ) || it.packOffset + it.packedSize > m_packSize ) {
+                this->clearRecords( );
+                return false;
+            }
+            this->insert( it );
+        }
+        m_useCounter = header.useCounter;
+        m_isDirty = false;
+
+        this->evict( );
+        return true;
+    }
+
+    //============================================================================/
+
+    bool DatEntryCache::writeIndex( ) {
+        auto filename = indexFilename( m_filename );
+        auto tempFilename = filename + wxT( ".tmp" );
+
+        wxFile file;
+        if ( !file.Create( tempFilename, true ) ) {
+            return false;
+        }
+
+        DatEntryCacheIndexHead header;
+        header.magicInteger = DatEntryCache_Magic;
+        header.version = DatEntryCache_Version;
+        header.generation = m_generation;
+        header.useCounter = m_useCounter;
+        header.numRecords = m_records.size( );
+
+        bool isWritten = file.Write( &header, sizeof( header ) ) == sizeof( header );
+        for ( auto it = m_records.begin( ); isWritten && it != m_records.end( ); ++it ) {
+            isWritten = file.Write( &it->second.record, sizeof( it->second.record ) ) == sizeof( it->second.record );
+        }
+        isWritten = isWritten && file.Flush( ) && file.Close( );
+
+        // Replace the index only once it's completely written
+        if ( !isWritten || !wxRenameFile( tempFilename, filename, true ) ) {
+            file.Close( );
+            wxRemoveFile( tempFilename );
+            return false;
+        }
+
+        m_isDirty = false;
+        return true;
+    }
+
+    //============================================================================/
+
+    bool DatEntryCache::compact( ) {
+        auto tempFilename = m_filename + wxT( ".tmp" );
+
+        wxFile file;
+        if ( !file.Create( tempFilename, true ) ) {
+            return false;
+        }
+
+        DatEntryCachePackHead header;
+        header.magicInteger = DatEntryCache_Magic;
+        header.version = DatEntryCache_Version;
+        header.generation = m_generation + 1;
+
+        // Copy in pack order, so the pack is read sequentially
+        std::vector<DatEntryCacheRecord*> records;
+        records.reserve( m_records.size( ) );
+        for ( auto& it : m_records ) {
+            records.push_back( &it.second.record );
+        }
+        std::sort( records.begin( ), records.end( ), [] ( const DatEntryCacheRecord* p_a, const DatEntryCacheRecord* p_b ) {
+            return p_a->packOffset < p_b->packOffset;
+        } );
+
+        bool isWritten = file.Write( &header, sizeof( header ) ) == sizeof( header );
+        uint64 packSize = sizeof( header );
+        std::vector<uint64> offsets;
+        offsets.reserve( records.size( ) );
+        std::vector<byte> packed;
+
+        for ( uint i = 0; isWritten && i < records.size( ); i++ ) {
+            packed.resize( records[i]->packedSize );
+            m_pack.Seek( records[i]->packOffset, wxFromStart );
+            isWritten = m_pack.Read( packed.data( ), packed.size( ) ) == static_cast<ssize_t>( packed.size( ) ) &&
+                file.Write( packed.data( ), packed.size( ) ) == packed.size( );
+            offsets.push_back( packSize );
+            packSize += packed.size( );
+        }
+        isWritten = isWritten && file.Flush( ) && file.Close( );
+
+        if ( !isWritten ) {
+            file.Close( );
+            wxRemoveFile( tempFilename );
+            return false;
+        }
+
+        m_pack.Close( );
+        if ( !wxRenameFile( tempFilename, m_filename, true ) ) {
+            wxRemoveFile( tempFilename );
+            m_pack.Open( m_filename, wxFile::read_write );
+            return false;
+        }
+        m_pack.Open( m_filename, wxFile::read_write );
+
+        for ( uint i = 0; i < records.size( ); i++ ) {
+            records[i]->packOffset = offsets[i];
+        }
+        m_generation = header.generation;
+        m_packSize = packSize;
+        return true;
+    }
+
+    //============================================================================/
+
+    void DatEntryCache::insert( const DatEntryCacheRecord& p_record ) {
+        auto result = m_records.emplace( p_record.key, Entry( ) );
+        if ( !result.second ) {
+            return;
+        }
+        result.first->second.record = p_record;
+        result.first->second.use = m_uses.insert( m_uses.end( ), p_record.key );
+        m_liveSize += p_record.packedSize;
+    }
+
+    //============================================================================/
+
+    void DatEntryCache::touch( RecordMap::iterator p_it ) {
+        p_it->second.record.lastUse = ++m_useCounter;
+        m_uses.splice( m_uses.end( ), m_uses, p_it->second.use );
+        m_isDirty = true;
+    }
+
+    //============================================================================/
+
+    void DatEntryCache::erase( RecordMap::iterator p_it ) {
+        m_liveSize -= p_it->second.record.packedSize;
+        m_uses.erase( p_it->second.use );
+        m_records.erase( p_it );
+        m_isDirty = true;
+    }
+
+    //============================================================================/
+
+    void DatEntryCache::clearRecords( ) {
+        RecordMap( ).swap( m_records );
+        UseList( ).swap( m_uses );
+        m_liveSize = 0;
+    }
+
+    //============================================================================/
+
+    void DatEntryCache::evict( ) {
+        // The front of the use list is the least recently used
+        while ( m_liveSize > m_maxSize && !m_uses.empty( ) ) {
+            this->erase( m_records.find( m_uses.front( ) ) );
+        }
+    }
+
+    //============================================================================/
+
+    void DatEntryCache::updateCompactSize( ) {
+        // Right after compacting the pack holds at most m_maxSize of live
+        // payloads, so this bounds it to about twice the limit. If compacting
+        // failed, wait for another m_maxSize of payloads before trying again.
+        m_compactSize = std::max<uint64>( 2 * m_maxSize, m_packSize + m_maxSize );
+    }
+
+    //============================================================================/
+
+    void DatEntryCache::reset( ) {
+        this->clearRecords( );
+        m_useCounter = 0;
+        m_generation = static_cast<uint32>( ::time( nullptr ) );
+
+        if ( !m_pack.Create( m_filename, true, wxS_DEFAULT ) ) {
+            m_packSize = 0;
+            return;
+        }
+        m_pack.Close( );
+        m_pack.Open( m_filename, wxFile::read_write );
+
+        DatEntryCachePackHead header;
+        header.magicInteger = DatEntryCache_Magic;
+        header.version = DatEntryCache_Version;
+        header.generation = m_generation;
+        m_pack.Write( &header, sizeof( header ) );
+        m_packSize = sizeof( header );
+
+        // Have a matching index written on close, even if nothing is added
+        m_isDirty = true;
+    }
+
+}; // namespace gw2b
@@ -0,0 +1,205 @@
+/** \file       DatEntryCache.h
+ *  \brief      Contains the declaration of the decompressed entry cache.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef DATENTRYCACHE_H_INCLUDED
+#define DATENTRYCACHE_H_INCLUDED
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <wx/file.h>
+
+namespace gw2b {
+
+    enum DatEntryCacheMagicNumber {
+        DatEntryCache_Magic = 0x4345,
+        DatEntryCache_Version = 0x1,
+    };
+
+    /** Default limits of the entry cache. */
+    enum DatEntryCacheLimits : uint64 {
+        DatEntryCache_DefaultMaxSize = 256ull << 20,        /**< Max size of the pack, in bytes. */
+        DatEntryCache_DefaultMaxEntrySize = 32ull << 20,    /**< Max size of a single cached payload, in bytes. */
+        DatEntryCache_MinEntrySize = 4096,                  /**< Smaller payloads are cheaper to decode again than to cache. */
+        DatEntryCache_ThumbnailMaxSize = 512ull << 20,      /**< Max size of the thumbnail pack, in bytes. */
+    };
+
+    /** What a cached payload holds. */
+    enum DatEntryCacheKind {
+        DECK_Entry,     /**< Decompressed .dat entry. */
+        DECK_Image,     /**< Image converted by ImageReader. */
+        DECK_Thumbnail, /**< Thumbnail decoded by ThumbnailLoader. */
+    };
+
+#pragma pack(push, 1)
+
+    /** Identifies a cached payload. For entries and images the MFT fields tell
+    *  whether the .dat entry changed since it was cached. Thumbnails are keyed
+    *  by the file ID and MFT entry crc of their file, and their size. */
+    struct DatEntryCacheKey {
+        uint32 kind;                /**< See DatEntryCacheKind. */
+        uint32 mftEntry;            /**< MFT entry number, file ID for thumbnails. */
+        uint32 crc;                 /**< MFT entry crc. */
+        uint32 size;                /**< MFT entry size, or max width and height of thumbnails. */
+        uint64 offset;              /**< MFT entry offset, 0 for thumbnails. */
+
+        bool operator<( const DatEntryCacheKey& p_other ) const {
+            return ::memcmp( this, &p_other, sizeof( *this ) ) < 0;
+        }
+    };
+
+    /** Structure of the entry cache pack file header. The packed payloads
+    *  follow it back to back. */
+    struct DatEntryCachePackHead {
+        union {
+            char magic[2];          /**< Contains 'EC'. */
+            uint16 magicInteger;    /**< Contains 0x4345, in little endian. */
+        };
+        uint16 version;             /**< Cache format version. */
+        uint32 generation;          /**< Must match the index, changes when the pack is compacted. */
+    };
+
+    /** Structure of the entry cache index file header, followed by the
+    *  records. */
+    struct DatEntryCacheIndexHead {
+        union {
+            char magic[2];          /**< Contains 'EC'. */
+            uint16 magicInteger;    /**< Contains 0x4345, in little endian. */
+        };
+        uint16 version;             /**< Cache format version. */
+        uint32 generation;          /**< Generation of the pack this index belongs to. */
+        uint32 useCounter;          /**< Last value handed out for DatEntryCacheRecord::lastUse. */
+        uint32 numRecords;          /**< Amount of records in the index. */
+    };
+
+    /** Structure of an entry cache index record. */
+    struct DatEntryCacheRecord {
+        DatEntryCacheKey key;       /**< Identifies the payload. */
+        uint64 packOffset;          /**< Offset of the packed payload in the pack. */
+        uint32 packedSize;          /**< Size of the packed payload. */
+        uint32 size;                /**< Size of the payload. */
+        uint32 lastUse;             /**< When the payload was last used, for eviction. */
+    };
+
+#pragma pack(pop)
+
+    /** Keeps decompressed .dat entries and converted images across sessions.
+    *  Payloads are zlib compressed at the fastest level and appended to a
+    *  pack file, each on its own so a single one can be read with one seek.
+    *  An index file next to the pack locates them.
+    *
+    *  When the payloads grow past the size limit, the least recently used
+    *  ones are dropped from the index. Their space is reclaimed by rewriting
+    *  the pack once it grows past twice the limit, and on close. Payloads
+    *  are inflated outside of the lock, so reads don't wait on each other.
+    *  All methods may be called from any thread. */
+    class DatEntryCache {
+        /** Keys of the records, least recently used first. */
+        typedef std::list<DatEntryCacheKey> UseList;
+        struct Entry {
+            DatEntryCacheRecord record;
+            UseList::iterator   use;
+        };
+        typedef std::map<DatEntryCacheKey, Entry> RecordMap;
+    private:
+        wxString            m_filename;
+        wxFile              m_pack;
+        RecordMap           m_records;
+        UseList             m_uses;
+        uint64              m_packSize;
+        uint64              m_liveSize;
+        uint64              m_maxSize;
+        uint64              m_maxEntrySize;
+        uint64              m_compactSize;
+        uint32              m_generation;
+        uint32              m_useCounter;
+        bool                m_isDirty;
+        mutable std::mutex  m_mutex;
+    public:
+        /** Constructor. */
+        DatEntryCache( );
+        /** Destructor. Closes the cache. */
+        ~DatEntryCache( );
+
+        /** Opens the cache, creating it if needed. The index is kept in a file
+        *  with the same name and the "cidx" extension.
+        *  \param[in]  p_filename   Pack file of the cache.
+        *  \return bool    true if opened, false if not. */
+        bool open( const wxString& p_filename );
+        /** Writes the index and closes the cache, compacting the pack first if
+        *  it's mostly evicted payloads. */
+        void close( );
+        /** Determines whether the cache is open.
+        *  \return bool    true if open, false if not. */
+        bool isOpen( ) const;
+
+        /** Sets the limits of the cache, evicting payloads if it's now too big.
+        *  \param[in]  p_maxSize        Max size of the live payloads in the pack, in bytes.
+        *  \param[in]  p_maxEntrySize   Payloads larger than this are not cached. */
+        void setLimits( uint64 p_maxSize, uint64 p_maxEntrySize );
+        /** Gets the max size of the live payloads in the pack.
+        *  \return uint64  Size, in bytes. */
+        uint64 maxSize( ) const;
+
+        /** Finds the size of a cached payload.
+        *  \param[in]  p_key    Key of the payload.
+        *  \param[out] po_size  Size of the payload.
+        *  \return bool    true if cached, false if not. */
+        bool find( const DatEntryCacheKey& p_key, uint& po_size ) const;
+        /** Reads the leading bytes of a cached payload. Only as much of the
+        *  packed payload is read and inflated as these bytes need.
+        *  \param[in]  p_key        Key of the payload.
+        *  \param[out] po_buffer    Buffer receiving the payload.
+        *  \param[in]  p_size       Amount of bytes to read.
+        *  \return uint    Amount of bytes read, 0 if not cached. */
+        uint read( const DatEntryCacheKey& p_key, byte* po_buffer, uint p_size );
+        /** Reads a cached payload.
+        *  \param[in]  p_key    Key of the payload.
+        *  \return Array<byte>  The payload, empty if not cached. */
+        Array<byte> read( const DatEntryCacheKey& p_key );
+        /** Adds a payload to the cache, unless it's too small, too large or
+        *  already cached.
+        *  \param[in]  p_key    Key of the payload.
+        *  \param[in]  p_data   The payload.
+        *  \param[in]  p_size   Size of the payload. */
+        void add( const DatEntryCacheKey& p_key, const byte* p_data, uint p_size );
+
+    private:
+        bool readIndex( );
+        bool writeIndex( );
+        bool compact( );
+        void insert( const DatEntryCacheRecord& p_record );
+        void touch( RecordMap::iterator p_it );
+        void erase( RecordMap::iterator p_it );
+        void clearRecords( );
+        void evict( );
+        void updateCompactSize( );
+        void reset( );
+    }; // class DatEntryCache
+
+}; // namespace gw2b
+
+#endif // DATENTRYCACHE_H_INCLUDED
@@ -27,6 +27,8 @@
 
 #include <gw2dattools/exception/Exception.h>
 
+#include "Compression/DatInflater.h"
+#include "DatEntryCache.h"
 #include "FileReader.h"
 
 #include "DatFile.h"
@@ -38,14 +40,61 @@ namespace gw2b {
         uint32  fileId;
     };
 
+    namespace {
+
+        /** Size of the 64 KiB blocks of an entry, checksum included. */
+        const uint32 EntryBlockSize = 0x10000;
+        /** Size of the pieces an entry is streamed in, a multiple of the blocks. */
+        const uint32 EntryStreamSize = 0x100000;
+
+        /** Reads an entry straight from the .dat file. */
+        class EntrySource : public IDataSource {
+            wxFile&     m_file;
+            uint64      m_offset;
+            uint32      m_remaining;
+            bool        m_isFailed;
+        public:
+            EntrySource( wxFile& p_file, uint64 p_offset, uint32 p_size )
+                : m_file( p_file )
+                , m_offset( p_offset )
+                , m_remaining( p_size )
+                , m_isFailed( false ) {
+            }
+
+            bool isFailed( ) const {
+                return m_isFailed;
+            }
+
+            virtual uint32 read( byte* po_buffer, uint32 p_size ) override {
+                auto size = wxMin( p_size, m_remaining );
+                if ( !size ) {
+                    return 0;
+                }
+                // Seek every time, the sink may read the file as well
+                m_file.Seek( m_offset, wxFromStart );
+                if ( m_file.Read( po_buffer, size ) != static_cast<ssize_t>( size ) ) {
+                    m_remaining = 0;
+                    m_isFailed = true;
+                    return 0;
+                }
+                m_offset += size;
+                m_remaining -= size;
+                return size;
+            }
+        };
+
+    };
+
     DatFile::DatFile( )
-        : m_lastReadEntry( -1 ) {
+        : m_lastReadEntry( -1 )
+        , m_entryCache( nullptr ) {
         ::memset( &m_datHead, 0, sizeof( m_datHead ) );
         ::memset( &m_mftHead, 0, sizeof( m_mftHead ) );
     }
 
     DatFile::DatFile( const wxString& p_filename )
-        : m_lastReadEntry( -1 ) {
+        : m_lastReadEntry( -1 )
+        , m_entryCache( nullptr ) {
         ::memset( &m_datHead, 0, sizeof( m_datHead ) );
         ::memset( &m_mftHead, 0, sizeof( m_mftHead ) );
         this->open( p_filename );
@@ -154,6 +203,13 @@ namespace gw2b {
         m_file.Close( );
     }
 
+    uint32 DatFile::entryCrc( uint p_entryNum ) const {
+        if ( p_entryNum >= m_mftEntries.GetSize( ) ) {
+            return 0;
+        }
+        return m_mftEntries[p_entryNum].crc;
+    }
+
     uint DatFile::entrySize( uint p_entryNum ) {
         if ( !isOpen( ) ) {
             return std::numeric_limits<uint>::max( );
@@ -166,6 +222,12 @@ namespace gw2b {
 
         // If the entry is compressed we need to read the uncompressed size from the .dat
         if ( entry.compressionFlag & ANCF_Compressed ) {
+            DatEntryCacheKey cacheKey;
+            uint cachedSize;
+            if ( this->entryCacheKey( p_entryNum, cacheKey ) && m_entryCache->find( cacheKey, cachedSize ) ) {
+                return cachedSize;
+            }
+
             uint32 uncompressedSize = 0;
             m_file.Seek( entry.offset + 4, wxFromStart );
             m_file.Read( &uncompressedSize, sizeof( uncompressedSize ) );
@@ -240,6 +302,16 @@ namespace gw2b {
             return 0;
         }
 
+        // Decompressed before?
+        DatEntryCacheKey cacheKey;
+        auto isCacheable = this->entryCacheKey( p_entryNum, cacheKey );
+        if ( isCacheable ) {
+            auto cachedSize = m_entryCache->read( cacheKey, po_Buffer, p_peekSize );
+            if ( cachedSize ) {
+                return cachedSize;
+            }
+        }
+
         // If this was the last entry we read, there's no need to re-read it. The
         // input buffer should already contain the full file.
         if ( m_lastReadEntry != p_entryNum ) {
@@ -272,12 +344,28 @@ namespace gw2b {
         // If the file is compressed we need to uncompress it
         if ( m_mftEntries[p_entryNum].compressionFlag ) {
             uint32 outputSize = p_peekSize;
+#if GW2B_INTREE_INFLATE
+            if ( !inflateDatBuffer( inputSize, m_inputBuffer.GetPointer( ), outputSize, po_Buffer ) ) {
+                wxLogMessage( wxT( "Failed to decompress file %u: corrupt data" ), p_entryNum );
+                outputSize = 0;
+            }
+#else
             try {
                 gw2dt::compression::inflateDatFileBuffer( inputSize, m_inputBuffer.GetPointer( ), outputSize, po_Buffer );
             } catch ( const gw2dt::exception::Exception& err ) {
                 wxLogMessage( wxT( "Failed to decompress file %u: %s" ), p_entryNum, std::string( err.what( ) ) );
                 outputSize = 0;
             }
+#endif
+
+            // Only whole entries go in the cache
+            if ( isCacheable && outputSize && inputSize >= 8 ) {
+                uint32 entrySize;
+                ::memcpy( &entrySize, &m_inputBuffer[4], sizeof( entrySize ) );
+                if ( outputSize == entrySize ) {
+                    m_entryCache->add( cacheKey, po_Buffer, outputSize );
+                }
+            }
             return outputSize;
         } else {
             const uint dataSize = wxMin( p_peekSize, inputSize );
@@ -357,6 +445,69 @@ namespace gw2b {
         return Array<byte>( );
     }
 
+    bool DatFile::streamFile( uint p_fileNum, IDataSink& po_sink ) {
+        return this->streamEntry( p_fileNum + MFT_FILE_OFFSET, po_sink );
+    }
+
+    bool DatFile::streamEntry( uint p_entryNum, IDataSink& po_sink ) {
+        if ( !this->isOpen( ) || p_entryNum >= m_mftEntries.GetSize( ) ) {
+            return false;
+        }
+
+        auto& entry = m_mftEntries[p_entryNum];
+        auto entryIsInUse = ( entry.entryFlags & ANMEF_InUse );
+        auto fileIsLargeEnough = ( uint64 ) m_file.Length( ) >= entry.offset + entry.size;
+        if ( !entryIsInUse || !fileIsLargeEnough ) {
+            return false;
+        }
+
+        EntrySource source( m_file, entry.offset, entry.size );
+
+        // Always in-tree, gw2dattools can't inflate piece by piece and would
+        // need the whole entry in memory
+        if ( entry.compressionFlag ) {
+            if ( !inflateDatStream( source, po_sink ) ) {
+                wxLogMessage( wxT( "Failed to stream file %u: corrupt data or write error" ), p_entryNum );
+                return false;
+            }
+            return true;
+        }
+
+        // Uncompressed, skip the checksum at the end of every full block
+        Array<byte> buffer( EntryStreamSize );
+        uint32 size;
+        while ( ( size = source.read( buffer.GetPointer( ), buffer.GetSize( ) ) ) > 0 ) {
+            for ( uint32 block = 0; block < size; block += EntryBlockSize ) {
+                auto blockSize = wxMin( size - block, EntryBlockSize );
+                if ( blockSize == EntryBlockSize ) {
+                    blockSize -= 4;
+                }
+                if ( !po_sink.write( buffer.GetPointer( ) + block, blockSize ) ) {
+                    return false;
+                }
+            }
+        }
+        return !source.isFailed( );
+    }
+
+    bool DatFile::entryCacheKey( uint p_entryNum, DatEntryCacheKey& po_key ) const {
+        if ( !m_entryCache || p_entryNum >= m_mftEntries.GetSize( ) ) {
+            return false;
+        }
+
+        auto& entry = m_mftEntries[p_entryNum];
+        if ( !( entry.compressionFlag & ANCF_Compressed ) ) {
+            return false;
+        }
+
+        po_key.kind = DECK_Entry;
+        po_key.mftEntry = p_entryNum;
+        po_key.crc = entry.crc;
+        po_key.size = entry.size;
+        po_key.offset = entry.offset;
+        return true;
+    }
+
     DatFile::IdentificationResult DatFile::identifyFileType( const byte* p_data, size_t p_size, ANetFileType& po_fileType ) {
         po_fileType = ANFT_Unknown;
 
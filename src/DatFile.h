@@ -31,9 +31,12 @@
 #include <wx/file.h>
 
 #include "ANetStructs.h"
+#include "Util/DataStream.h"
 
 namespace gw2b {
+    class DatEntryCache;
     class FileReader;
+    struct DatEntryCacheKey;
 
     /** Represents a GW2 .dat file. */
     class DatFile {
@@ -50,6 +53,7 @@ namespace gw2b {
         EntryToIdArray      m_entryToId;
         InputBufferArray    m_inputBuffer;
         uint                m_lastReadEntry;
+        DatEntryCache*      m_entryCache;
     private:
         enum MFTFileOffset {
             MFT_FILE_OFFSET = 16
@@ -79,6 +83,23 @@ namespace gw2b {
         /** Closes the open .dat file, if any. */
         void close( );
 
+        /** Sets the cache that decompressed entries are read from and added to.
+        *  \param[in]  p_cache  Cache to use, nullptr for none. */
+        void setEntryCache( DatEntryCache* p_cache ) {
+            m_entryCache = p_cache;
+        }
+        /** Gets the cache of decompressed entries.
+        *  \return DatEntryCache*  The cache, nullptr if none. */
+        DatEntryCache* entryCache( ) const {
+            return m_entryCache;
+        }
+        /** Gets the cache key of the given MFT entry, made of its MFT fields.
+        *  \param[in]  p_entryNum   MFT entry number.
+        *  \param[out] po_key       Receives the key, of kind DECK_Entry.
+        *  \return bool    true if the entry can be cached, false if there is no
+        *                  cache, no such entry or the entry isn't compressed. */
+        bool entryCacheKey( uint p_entryNum, DatEntryCacheKey& po_key ) const;
+
         /** Gets the MFT entry number for the file with the given file id.
         *  \param[in]  p_fileId     ID of the file to get the entry number for.
         *  \return uint    The MFT entry num if it was found, UINT_MAX if not. */
@@ -101,6 +122,12 @@ namespace gw2b {
         *  \return uint    The base id if it was found, UINT_MAX if not. */
         uint baseIdFromFileNum( uint p_entryNum ) const;
 
+        /** Gets the crc the MFT stores for the given entry. It changes whenever
+        *  the entry does.
+        *  \param[in]  p_entryNum   Entry number to get the crc for.
+        *  \return uint32  crc of the entry, 0 if not found. */
+        uint32 entryCrc( uint p_entryNum ) const;
+
         /** Gets the total uncompressed size of the given entry.
         *  \param[in]  p_entryNum   Entry number to check the size for.
         *  \return uint    Uncompressed size of the entry. */
@@ -176,6 +203,20 @@ namespace gw2b {
         *  \return Array<byte>  Object used to handle the read file. */
         Array<byte> readFile( uint p_fileNum );
 
+        /** Streams the contents of the given MFT entry to a sink. The entry is
+        *  read and inflated a piece at a time with the in-tree inflater, even
+        *  when GW2B_INTREE_INFLATE is 0, so memory use stays the same for
+        *  entries of any size. The entry cache is bypassed.
+        *  \param[in]  p_entryNum   MFT entry number to stream.
+        *  \param[in]  po_sink      Sink receiving the contents.
+        *  \return bool    true if streamed, false on a read or decompression error, or if the sink aborted. */
+        bool streamEntry( uint p_entryNum, IDataSink& po_sink );
+        /** Streams the contents of the given MFT file entry to a sink.
+        *  \param[in]  p_fileNum    MFT file entry number to stream.
+        *  \param[in]  po_sink      Sink receiving the contents.
+        *  \return bool    true if streamed, false on a read or decompression error, or if the sink aborted. */
+        bool streamFile( uint p_fileNum, IDataSink& po_sink );
+
         IdentificationResult identifyFileType( const byte* p_data, size_t p_size, ANetFileType& p_fileType );
         static uint fileIdFromFileReference( const ANetFileReference& p_fileRef );
 
@@ -0,0 +1,238 @@
+/** \file       DatHeaderCache.cpp
+ *  \brief      Contains the definition of the .dat header prefix cache.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <wx/file.h>
+#include <wx/wfstream.h>
+#include <wx/zstream.h>
+
+#include "DatHeaderCache.h"
+
+namespace gw2b {
+
+    namespace {
+
+        bool readExact( wxInputStream& p_stream, void* po_buffer, size_t p_size ) {
+            auto buffer = static_cast<char*>( po_buffer );
+            while ( p_size ) {
+                p_stream.Read( buffer, p_size );
+                auto read = p_stream.LastRead( );
+                if ( !read ) {
+                    return false;
+                }
+                buffer += read;
+                p_size -= read;
+            }
+            return true;
+        }
+
+    };
+
+    DatHeaderCache::DatHeaderCache( )
+        : m_datTimestamp( 0 )
+        , m_isDirty( false ) {
+    }
+
+    //============================================================================/
+
+    DatHeaderCache::~DatHeaderCache( ) {
+    }
+
+    //============================================================================/
+
+    bool DatHeaderCache::read( const wxString& p_filename, uint64 p_datTimestamp ) {
+        this->clear( );
+        m_datTimestamp = p_datTimestamp;
+
+        if ( !wxFile::Exists( p_filename ) ) {
+            return false;
+        }
+
+        wxFileInputStream file( p_filename );
+        if ( !file.IsOk( ) ) {
+            return false;
+        }
+
+        DatHeaderCacheHead header;
+        if ( !readExact( file, &header, sizeof( header ) ) ) {
+            return false;
+        }
+        if ( header.magicInteger != DatHeaderCache_Magic || header.version != DatHeaderCache_Version ) {
+            return false;
+        }
+        if ( header.datTimestamp != p_datTimestamp ) {
+            return false;
+        }
+
+        wxZlibInputStream stream( file, wxZLIB_ZLIB );
+        m_records.reserve( header.numRecords );
+
+        for ( uint i = 0; i < header.numRecords; i++ ) {
+            DatHeaderCacheRecordFields fields;
+            if ( !readExact( stream, &fields, sizeof( fields ) ) || fields.size > DatHeaderCache_PrefixSize ) {
+                this->clear( );
+                return false;
+            }
+
+            Record record;
+            record.mftEntry = fields.mftEntry;
+            record.fileSize = fields.fileSize;
+            record.offset = m_data.size( );
+            record.size = fields.size;
+
+            m_data.resize( m_data.size( ) + record.size );
+            if ( record.size && !readExact( stream, &m_data[record.offset], record.size ) ) {
+                this->clear( );
+                return false;
+            }
+
+            // Records are written in order, anything else means a corrupt file
+            if ( !m_records.empty( ) && m_records.back( ).mftEntry >= record.mftEntry ) {
+                this->clear( );
+                return false;
+            }
+            m_records.push_back( record );
+        }
+
+        return true;
+    }
+
+    //============================================================================/
+
+    bool DatHeaderCache::write( const wxString& p_filename ) {
+        auto tempFilename = p_filename + wxT( ".tmp" );
+
+        wxFile file( tempFilename, wxFile::write );
+        if ( !file.IsOpened( ) ) {
+            return false;
+        }
+
+        // Make sure the data hit the disk before the old cache is replaced
+        if ( !this->writeTo( file ) || !file.Flush( ) ) {
+            file.Close( );
+            wxRemoveFile( tempFilename );
+            return false;
+        }
+        file.Close( );
+
+        if ( !wxRenameFile( tempFilename, p_filename, true ) ) {
+            wxRemoveFile( tempFilename );
+            return false;
+        }
+
+        m_isDirty = false;
+        return true;
+    }
+
+    //============================================================================/
+
+    bool DatHeaderCache::writeTo( wxFile& p_file ) {
+        wxFileOutputStream file( p_file );
+        if ( !file.IsOk( ) ) {
+            return false;
+        }
+
+        DatHeaderCacheHead header;
+        header.magicInteger = DatHeaderCache_Magic;
+        header.version = DatHeaderCache_Version;
+        header.datTimestamp = m_datTimestamp;
+        header.numRecords = m_records.size( );
+        file.Write( &header, sizeof( header ) );
+
+        {
+            wxZlibOutputStream stream( file, wxZ_DEFAULT_COMPRESSION, wxZLIB_ZLIB );
+            for ( auto const& it : m_records ) {
+                DatHeaderCacheRecordFields fields;
+                fields.mftEntry = it.mftEntry;
+                fields.fileSize = it.fileSize;
+                fields.size = it.size;
+
+                stream.Write( &fields, sizeof( fields ) );
+                if ( it.size ) {
+                    stream.Write( &m_data[it.offset], it.size );
+                }
+            }
+            if ( !stream.Close( ) ) {
+                return false;
+            }
+        }
+
+        return file.IsOk( );
+    }
+
+    //============================================================================/
+
+    void DatHeaderCache::clear( ) {
+        std::vector<Record>( ).swap( m_records );
+        std::vector<byte>( ).swap( m_data );
+        m_isDirty = false;
+    }
+
+    //============================================================================/
+
+    void DatHeaderCache::add( uint32 p_mftEntry, uint32 p_fileSize, const byte* p_data, uint p_size ) {
+        auto it = std::lower_bound( m_records.begin( ), m_records.end( ), p_mftEntry,
+            [] ( const Record& p_record, uint32 p_entry ) { return p_record.mftEntry < p_entry; } );
+        if ( it != m_records.end( ) && it->mftEntry == p_mftEntry ) {
+            return;
+        }
+
+        Record record;
+        record.mftEntry = p_mftEntry;
+        record.fileSize = p_fileSize;
+        record.offset = m_data.size( );
+        record.size = std::min<uint>( p_size, DatHeaderCache_PrefixSize );
+
+        m_data.insert( m_data.end( ), p_data, p_data + record.size );
+        // The scan goes in order, so this is nearly always an append
+        m_records.insert( it, record );
+        m_isDirty = true;
+    }
+
+    //============================================================================/
+
+    const byte* DatHeaderCache::find( uint32 p_mftEntry, uint& po_size, uint& po_fileSize ) const {
+        auto it = std::lower_bound( m_records.begin( ), m_records.end( ), p_mftEntry,
+            [] ( const Record& p_record, uint32 p_entry ) { return p_record.mftEntry < p_entry; } );
+        if ( it == m_records.end( ) || it->mftEntry != p_mftEntry ) {
+            return nullptr;
+        }
+
+        po_size = it->size;
+        po_fileSize = it->fileSize;
+        return it->size ? &m_data[it->offset] : nullptr;
+    }
+
+    //============================================================================/
+
+    void DatHeaderCache::setDatTimestamp( uint64 p_timestamp ) {
+        if ( m_datTimestamp != p_timestamp ) {
+            this->clear( );
+            m_datTimestamp = p_timestamp;
+        }
+    }
+
+}; // namespace gw2b
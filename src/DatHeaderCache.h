@@ -0,0 +1,142 @@
+/** \file       DatHeaderCache.h
+ *  \brief      Contains the declaration of the .dat header prefix cache.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef DATHEADERCACHE_H_INCLUDED
+#define DATHEADERCACHE_H_INCLUDED
+
+#include <vector>
+#include <wx/file.h>
+
+namespace gw2b {
+
+    enum DatHeaderCacheMagicNumber {
+        DatHeaderCache_Magic = 0x4348,
+        DatHeaderCache_Version = 0x1,
+        DatHeaderCache_PrefixSize = 64,     /**< Max amount of leading bytes kept per file. */
+    };
+
+#pragma pack(push, 1)
+
+    /** Structure of the header cache header in the file. The records that
+    *  follow it are zlib compressed. */
+    struct DatHeaderCacheHead {
+        union {
+            char magic[2];          /**< Contains 'HC'. */
+            uint16 magicInteger;    /**< Contains 0x4348, in little endian. */
+        };
+        uint16 version;             /**< Cache format version. */
+        uint64 datTimestamp;        /**< Cached .dat file's timestamp. */
+        uint32 numRecords;          /**< Amount of records in the cache. */
+    };
+
+    /** Structure of the fixed-width record fields in the header cache file,
+    *  followed by \e size bytes of file data. */
+    struct DatHeaderCacheRecordFields {
+        uint32 mftEntry;            /**< MFT entry number of the cached file. */
+        uint32 fileSize;            /**< Uncompressed size of the cached file. */
+        uint16 size;                /**< Amount of cached leading bytes. */
+    };
+
+#pragma pack(pop)
+
+    /** Keeps the leading bytes of every scanned .dat file, so the index can be
+    *  rebuilt with new categorization rules without reading the .dat again.
+    *  The cache is persisted in a side file next to the index. */
+    class DatHeaderCache {
+        struct Record {
+            uint32  mftEntry;
+            uint32  fileSize;
+            uint32  offset;
+            uint16  size;
+        };
+    private:
+        std::vector<Record> m_records;
+        std::vector<byte>   m_data;
+        uint64              m_datTimestamp;
+        bool                m_isDirty;
+    public:
+        /** Constructor. */
+        DatHeaderCache( );
+        /** Destructor. */
+        ~DatHeaderCache( );
+
+        /** Reads the cache from file, replacing its current contents. If the file
+        *  can't be read or belongs to another .dat, the cache is left empty.
+        *  \param[in]  p_filename       File to read.
+        *  \param[in]  p_datTimestamp   Timestamp of the .dat the cache must belong to.
+        *  \return bool    true if the file was read, false if not. */
+        bool read( const wxString& p_filename, uint64 p_datTimestamp );
+        /** Writes the cache to file. The cache is written to a temporary file
+        *  first and renamed over the old one, so a crash never leaves a
+        *  truncated cache behind.
+        *  \param[in]  p_filename       File to write.
+        *  \return bool    true if the file was written, false if not. */
+        bool write( const wxString& p_filename );
+        /** Removes every record from the cache and frees its memory. */
+        void clear( );
+
+        /** Adds the leading bytes of a file to the cache. Data beyond
+        *  DatHeaderCache_PrefixSize is not kept. Files already in the cache are
+        *  left untouched.
+        *  \param[in]  p_mftEntry   MFT entry number of the file.
+        *  \param[in]  p_fileSize   Uncompressed size of the file.
+        *  \param[in]  p_data       Leading bytes of the file.
+        *  \param[in]  p_size       Size of p_data. */
+        void add( uint32 p_mftEntry, uint32 p_fileSize, const byte* p_data, uint p_size );
+        /** Finds the cached leading bytes of a file.
+        *  \param[in]  p_mftEntry   MFT entry number of the file.
+        *  \param[out] po_size      Amount of cached bytes.
+        *  \param[out] po_fileSize  Uncompressed size of the file.
+        *  \return byte*   Pointer to the cached bytes, or nullptr if not cached. */
+        const byte* find( uint32 p_mftEntry, uint& po_size, uint& po_fileSize ) const;
+
+        /** Gets the amount of cached files.
+        *  \return uint    Amount of cached files. */
+        uint numRecords( ) const {
+            return m_records.size( );
+        }
+        /** Gets the timestamp of the .dat this cache belongs to.
+        *  \return uint64  Timestamp of the .dat. */
+        uint64 datTimestamp( ) const {
+            return m_datTimestamp;
+        }
+        /** Sets the timestamp of the .dat this cache belongs to. Clears the
+        *  cache if it belonged to another .dat.
+        *  \param[in]  p_timestamp  Timestamp of the .dat. */
+        void setDatTimestamp( uint64 p_timestamp );
+        /** Determines whether the cache changed since it was read or written.
+        *  \return bool    true if changed, false if not. */
+        bool isDirty( ) const {
+            return m_isDirty;
+        }
+    private:
+        /** Writes the header and the records to an open file. */
+        bool writeTo( wxFile& p_file );
+    }; // class DatHeaderCache
+
+}; // namespace gw2b
+
+#endif // DATHEADERCACHE_H_INCLUDED
@@ -97,21 +97,51 @@ namespace gw2b {
     }
 
     void DatIndexCategory::addEntry( DatIndexEntry* p_entry ) {
-        m_entries.Add( p_entry );
+        // Link the entry before readers can see it in this category
         p_entry->onAddedToCategory( this );
+        m_entries.Add( p_entry );
     }
 
     void DatIndexCategory::addSubCategory( DatIndexCategory* p_subCategory ) {
         Ensure::notNull( p_subCategory );
         Assert( !p_subCategory->parent( ) );
 
-        m_subCategories.Add( p_subCategory );
         p_subCategory->onAddedToCategory( this );
+        m_subCategories.Add( p_subCategory );
     }
 
     void DatIndexCategory::onAddedToCategory( DatIndexCategory* p_parent ) {
-        Ensure::isNull( m_parent );
-        m_parent = p_parent;
+        Ensure::isNull( this->parent( ) );
+        m_parent.store( p_parent, std::memory_order_release );
+    }
+
+    //----------------------------------------------------------------------------
+    //      DatIndexSnapshot
+    //----------------------------------------------------------------------------
+
+    DatIndexSnapshot::DatIndexSnapshot( const DatIndex& p_index )
+        : m_index( &p_index )
+        , m_numEntries( p_index.numEntries( ) )
+        , m_numCategories( p_index.numCategories( ) )
+        , m_epoch( p_index.epoch( ) ) {
+    }
+
+    const DatIndexEntry* DatIndexSnapshot::entry( uint p_index ) const {
+        if ( p_index >= m_numEntries ) {
+            return nullptr;
+        }
+        return m_index->entry( p_index );
+    }
+
+    const DatIndexCategory* DatIndexSnapshot::category( uint p_index ) const {
+        if ( p_index >= m_numCategories ) {
+            return nullptr;
+        }
+        return m_index->category( p_index );
+    }
+
+    bool DatIndexSnapshot::isValid( ) const {
+        return m_index->epoch( ) == m_epoch;
     }
 
     //----------------------------------------------------------------------------
@@ -122,8 +152,7 @@ namespace gw2b {
         : m_datTimestamp( 0 )
         , m_highestMftEntry( -1 )
         , m_isDirty( false )
-        , m_numEntries( 0 )
-        , m_numCategories( 0 ) {
+        , m_epoch( 0 ) {
     }
 
     DatIndex::~DatIndex( ) {
@@ -136,13 +165,22 @@ namespace gw2b {
     }
 
     void DatIndex::clear( ) {
-        // destruct all entries before clearing their memory
-        for ( uint i = 0; i < m_numEntries; i++ ) {
+        // Let readers on other threads stop before anything is freed
+        for ( auto const& it : m_listeners ) {
+            it->onIndexClearing( *this );
+        }
+
+        // Invalidate snapshots first
+        m_epoch++;
+
+        // destruct all entries before clearing their memory, including any
+        // that were added but never finalized
+        for ( uint i = 0; i < m_entries.GetPendingSize( ); i++ ) {
             delete m_entries[i];
         }
         m_entries.Clear( );
         // also destruct all categories before clearing their memory
-        for ( uint i = 0; i < m_numCategories; i++ ) {
+        for ( uint i = 0; i < m_categories.GetPendingSize( ); i++ ) {
             delete m_categories[i];
         }
         m_categories.Clear( );
@@ -150,8 +188,6 @@ namespace gw2b {
         m_datTimestamp = 0;
         m_highestMftEntry = -1;
         m_isDirty = false;
-        m_numEntries = 0;
-        m_numCategories = 0;
 
         // Notify listeners
         for ( auto const& it : m_listeners ) {
@@ -160,21 +196,18 @@ namespace gw2b {
     }
 
     DatIndexEntry* DatIndex::addIndexEntry( bool p_setDirty ) {
-        if ( m_numEntries == m_entries.GetSize( ) ) {
-            if ( !reserveEntries( 1 ) ) {
-                return nullptr;
-            }
-        }
+        // Published in onEntryAddComplete, once the caller filled it in
+        auto entry = new DatIndexEntry( *this );
+        m_entries.Push( entry );
 
-        uint index = m_numEntries++;
-        m_entries[index] = new DatIndexEntry( *this );
-
-        m_isDirty = ( m_isDirty || p_setDirty );
-        return m_entries[index];
+        if ( p_setDirty ) {
+            m_isDirty = true;
+        }
+        return entry;
     }
 
     DatIndexCategory* DatIndex::findCategory( const wxString& p_name, bool p_rootsOnly ) {
-        for ( uint i = 0; i < m_numCategories; i++ ) {
+        for ( uint i = 0; i < m_categories.GetSize( ); i++ ) {
             if ( !p_rootsOnly || !( m_categories[i]->parent( ) ) ) {
                 if ( m_categories[i]->name( ) == p_name ) {
                     return m_categories[i];
@@ -185,22 +218,18 @@ namespace gw2b {
     }
 
     DatIndexCategory* DatIndex::addIndexCategory( const wxString& p_name, bool p_setDirty ) {
-        if ( m_numCategories == m_categories.GetSize( ) ) {
-            if ( !reserveCategories( 1 ) ) {
-                return nullptr;
-            }
-        }
-
-        uint index = m_numCategories++;
-        m_categories[index] = new DatIndexCategory( *this, p_name, index );
-        auto& category = *m_categories[index];
+        auto index = m_categories.GetPendingSize( );
+        auto& category = *new DatIndexCategory( *this, p_name, index );
+        m_categories.Add( &category );
 
         // Notify listeners
         for ( auto const& it : m_listeners ) {
             it->onIndexCategoryAdded( *this, category );
         }
 
-        m_isDirty = ( m_isDirty || p_setDirty );
+        if ( p_setDirty ) {
+            m_isDirty = true;
+        }
         return &category;
     }
 
@@ -213,18 +242,18 @@ namespace gw2b {
     }
 
     bool DatIndex::reserveEntries( uint p_additionalEntries ) {
-        if ( ( UINT_MAX - m_entries.GetSize( ) ) < p_additionalEntries ) {
+        if ( ( UINT_MAX - m_entries.GetPendingSize( ) ) < p_additionalEntries ) {
             return false;
         }
-        m_entries.SetSize( m_entries.GetSize( ) + p_additionalEntries );
+        m_entries.Reserve( m_entries.GetPendingSize( ) + p_additionalEntries );
         return true;
     }
 
     bool DatIndex::reserveCategories( uint p_additionalCategories ) {
-        if ( ( UINT_MAX - m_categories.GetSize( ) ) < p_additionalCategories ) {
+        if ( ( UINT_MAX - m_categories.GetPendingSize( ) ) < p_additionalCategories ) {
             return false;
         }
-        m_categories.SetSize( m_categories.GetSize( ) + p_additionalCategories );
+        m_categories.Reserve( m_categories.GetPendingSize( ) + p_additionalCategories );
         return true;
     }
 
@@ -237,6 +266,9 @@ namespace gw2b {
     }
 
     void DatIndex::onEntryAddComplete( DatIndexEntry& p_entry ) {
+        // The entry is complete, make it visible to readers
+        m_entries.Publish( );
+
         if ( static_cast<int>( p_entry.mftEntry( ) ) > m_highestMftEntry ) {
             m_highestMftEntry = static_cast<int>( p_entry.mftEntry( ) );
         }
@@ -28,16 +28,19 @@
 #define DATINDEX_H_INCLUDED
 
 #include <wx/filename.h>
+#include <atomic>
 #include <set>
 
 #include "ANetStructs.h"
+#include "Util/ChunkedArray.h"
 
 namespace gw2b {
     class DatIndex;
     class DatIndexEntry;
     class DatIndexCategory;
 
-    /** Represents an entry in the .dat index. */
+    /** Represents an entry in the .dat index. Entries are immutable once
+    *  finalizeAdd() published them. */
     class DatIndexEntry {
         DatIndex*           m_owner;
         uint32              m_fileId;
@@ -135,14 +138,15 @@ namespace gw2b {
         void onAddedToCategory( DatIndexCategory* p_category );
     };
 
-    /** Represents a category of entries and other categories. */
+    /** Represents a category of entries and other categories. Its entry and
+    *  subcategory lists may be read while the index is being appended to. */
     class DatIndexCategory {
-        DatIndex*           m_owner;
-        int                 m_index;
-        wxString            m_name;
-        DatIndexCategory*   m_parent;
-        Array<DatIndexCategory*, 0x3>  m_subCategories;
-        Array<DatIndexEntry*, 0x3>     m_entries;
+        DatIndex*                           m_owner;
+        int                                 m_index;
+        wxString                            m_name;
+        std::atomic<DatIndexCategory*>      m_parent;
+        ChunkedArray<DatIndexCategory*, 4>  m_subCategories;
+        ChunkedArray<DatIndexEntry*, 8>     m_entries;
     public:
         /** Constructor. Creates a category with the given name and index.
         *  \param[in]  p_owner  owner index.
@@ -242,12 +246,12 @@ namespace gw2b {
         /** Gets this category's parent category, or nullptr if it is top-level.
         *  \return DatIndexCategory*   this category's parent. */
         DatIndexCategory* parent( ) {
-            return m_parent;
+            return m_parent.load( std::memory_order_acquire );
         }
         /** Gets this category's parent category, or nullptr if it is top-level.
         *  \return DatIndexCategory*   this category's parent. */
         const DatIndexCategory* parent( ) const {
-            return m_parent;
+            return m_parent.load( std::memory_order_acquire );
         }
         /** Gets this category's index.
         *  \return uint    this category's index. */
@@ -274,6 +278,11 @@ namespace gw2b {
         *  \param[in]  p_category   Reference to the newly added category. */
         virtual void onIndexCategoryAdded( DatIndex& p_index, const DatIndexCategory& p_category ) {
         }
+        /** Raised when the index is about to be cleared, while its entries are
+        *  still valid. Readers on other threads must stop reading it here.
+        *  \param[in]  p_index  Reference to the index being cleared. */
+        virtual void onIndexClearing( DatIndex& p_index ) {
+        }
         /** Raised when the index is cleared.
         *  \param[in]  p_index  Reference to the index being cleared. */
         virtual void onIndexCleared( DatIndex& p_index ) {
@@ -284,20 +293,63 @@ namespace gw2b {
         }
     };
 
-    /** Represents a .dat index, for faster lookup. */
+    /** Consistent, read-only view of the first entries and categories of a
+    *  DatIndex, as they were when the snapshot was taken. Snapshots can be
+    *  taken and read from any thread while the index is being appended to,
+    *  without locking. They are invalidated when the index is cleared. */
+    class DatIndexSnapshot {
+        const DatIndex*     m_index;
+        uint                m_numEntries;
+        uint                m_numCategories;
+        uint                m_epoch;
+    public:
+        /** Constructor. Takes a snapshot of the given index.
+        *  \param[in]  p_index  Index to take a snapshot of. */
+        DatIndexSnapshot( const DatIndex& p_index );
+
+        /** Gets the amount of entries in this snapshot.
+        *  \return uint    Amount of entries. */
+        uint numEntries( ) const {
+            return m_numEntries;
+        }
+        /** Gets the amount of categories in this snapshot.
+        *  \return uint    Amount of categories. */
+        uint numCategories( ) const {
+            return m_numCategories;
+        }
+        /** Gets the entry with the given index.
+        *  \param[in]  p_index  Index of the entry to get.
+        *  \return DatIndexEntry*  Const pointer to the entry if valid, nullptr if not. */
+        const DatIndexEntry* entry( uint p_index ) const;
+        /** Gets the category with the given index.
+        *  \param[in]  p_index  Index of the category to get.
+        *  \return DatIndexCategory*   Const pointer to the category if valid, nullptr if not. */
+        const DatIndexCategory* category( uint p_index ) const;
+        /** Determines whether the index was cleared since this snapshot was taken.
+        *  \return bool    true if the snapshot can still be read, false if not. */
+        bool isValid( ) const;
+    }; // class DatIndexSnapshot
+
+    /** Represents a .dat index, for faster lookup.
+    *
+    *  Entries and categories are appended by a single writer into chunked
+    *  storage that never moves. Readers on other threads see a consistent
+    *  prefix through numEntries(), numCategories() or a DatIndexSnapshot,
+    *  without locking. Only clear() frees memory, so it must not run
+    *  concurrently with readers: listeners get onIndexClearing() first to
+    *  stop theirs. */
     class DatIndex {
-        typedef Array<DatIndexCategory*>        CategoryArray;
-        typedef Array<DatIndexEntry*>           EntryArray;
-        typedef std::set<IDatIndexListener*>    ListenerSet;
+        typedef ChunkedArray<DatIndexCategory*, 6>  CategoryArray;
+        typedef ChunkedArray<DatIndexEntry*, 12>    EntryArray;
+        typedef std::set<IDatIndexListener*>        ListenerSet;
     private:
         CategoryArray       m_categories;
         uint64              m_datTimestamp;
         EntryArray          m_entries;
-        int                 m_highestMftEntry;
-        bool                m_isDirty;
+        std::atomic<int>    m_highestMftEntry;
+        std::atomic<bool>   m_isDirty;
+        std::atomic<uint>   m_epoch;
         ListenerSet         m_listeners;
-        uint                m_numEntries;
-        uint                m_numCategories;
     public:
         /** Constructor. Initializes internals. */
         DatIndex( );
@@ -306,7 +358,8 @@ namespace gw2b {
 
         /** Clears all data. */
         void clear( );
-        /** Adds an entry to this index.
+        /** Adds an entry to this index. The entry stays invisible to readers
+        *  until its finalizeAdd() is called.
         *  \param[in]  p_setDirty   true to flag this index as dirty, false to not.
         *  \return DatIndexEntry&  the newly added entry. */
         DatIndexEntry* addIndexEntry( bool p_setDirty = true );
@@ -340,18 +393,18 @@ namespace gw2b {
         /** Gets the amount of entries in this index.
         *  \return uint    Amount of entries. */
         uint numEntries( ) const {
-            return m_numEntries;
+            return m_entries.GetSize( );
         }
         /** Gets the amount of categories in this index.
         *  \return uint    Amount of categories. */
         uint numCategories( ) const {
-            return m_numCategories;
+            return m_categories.GetSize( );
         }
         /** Gets the entry with the given index.
         *  \param[in]  p_index  Index of the entry to get.
         *  \return DatIndexEntry*  Const pointer to the entry if valid, nullptr if not. */
         const DatIndexEntry* entry( uint p_index ) const {
-            if ( p_index >= m_numEntries ) {
+            if ( p_index >= m_entries.GetSize( ) ) {
                 return nullptr;
             } return m_entries[p_index];
         }
@@ -359,7 +412,7 @@ namespace gw2b {
         *  \param[in]  p_index  Index of the category to get.
         *  \return DatIndexCategory*   pointer to the category if valid, nullptr if not. */
         DatIndexCategory* category( uint p_index ) {
-            if ( p_index >= m_numCategories ) {
+            if ( p_index >= m_categories.GetSize( ) ) {
                 return nullptr;
             } return m_categories[p_index];
         }
@@ -367,25 +420,36 @@ namespace gw2b {
         *  \param[in]  p_index  Index of the category to get.
         *  \return DatIndexCategory*   Const pointer to the category if valid, nullptr if not. */
         const DatIndexCategory* category( uint p_index ) const {
-            if ( p_index >= m_numCategories ) {
+            if ( p_index >= m_categories.GetSize( ) ) {
                 return nullptr;
             } return m_categories[p_index];
         }
+        /** Takes a consistent snapshot of the entries and categories added so far.
+        *  \return DatIndexSnapshot    Snapshot of this index. */
+        DatIndexSnapshot snapshot( ) const {
+            return DatIndexSnapshot( *this );
+        }
+        /** Gets the number of times this index was cleared, used to invalidate
+        *  snapshots.
+        *  \return uint    Current epoch. */
+        uint epoch( ) const {
+            return m_epoch.load( std::memory_order_acquire );
+        }
 
         /** Return the highest available MFT entry found in the index.
         *  \return uint    Highest MFT entry found in the table. */
         uint highestMftEntry( ) const {
-            return m_highestMftEntry;
+            return m_highestMftEntry.load( std::memory_order_relaxed );
         }
         /** Returns whether or not the data has been changed since writing to file.
         *  \return bool    true if data is dirty, false if not. */
         bool isDirty( ) const {
-            return m_isDirty;
+            return m_isDirty.load( std::memory_order_relaxed );
         }
         /** Sets the dirty flag for this index.
         *  \param[in]  p_isDirty    New dirty flag. */
         void setDirty( bool p_isDirty ) {
-            m_isDirty = p_isDirty;
+            m_isDirty.store( p_isDirty, std::memory_order_relaxed );
         }
 
         /** Gets the .dat timestamp stored for this index.
@@ -0,0 +1,503 @@
+/** \file       DatIndexFilter.cpp
+ *  \brief      Contains definition of the incremental .dat index filter.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "DatIndexFilter.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Number of results gathered before they are handed to the UI thread. */
+        const size_t ResultBatchSize    = 256;
+        /** Number of records visited between cancellation checks. */
+        const uint   CancelCheckInterval = 1024;
+
+        bool isNumber( const std::string& p_text, size_t p_start, size_t p_end ) {
+            if ( p_start >= p_end ) {
+                return false;
+            }
+            for ( size_t i = p_start; i < p_end; i++ ) {
+                if ( p_text[i] < '0' || p_text[i] > '9' ) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        uint32 toNumber( const std::string& p_text, size_t p_start, size_t p_end ) {
+            uint64 value = 0;
+            for ( size_t i = p_start; i < p_end && value <= 0xffffffff; i++ ) {
+                value = value * 10 + ( p_text[i] - '0' );
+            }
+            return static_cast<uint32>( std::min<uint64>( value, 0xffffffff ) );
+        }
+
+        void intersect( std::vector<uint>& po_list, const std::vector<uint>& p_other ) {
+            auto end = std::set_intersection( po_list.begin( ), po_list.end( ), p_other.begin( ), p_other.end( ), po_list.begin( ) );
+            po_list.erase( end, po_list.end( ) );
+        }
+
+        void unite( std::vector<uint>& po_list, const std::vector<uint>& p_other ) {
+            std::vector<uint> merged;
+            merged.reserve( po_list.size( ) + p_other.size( ) );
+            std::set_union( po_list.begin( ), po_list.end( ), p_other.begin( ), p_other.end( ), std::back_inserter( merged ) );
+            po_list.swap( merged );
+        }
+
+        std::string lowerUtf8( const wxString& p_string ) {
+            return std::string( p_string.Lower( ).utf8_str( ) );
+        }
+
+    };
+
+    DatIndexFilter::DatIndexFilter( wxEvtHandler* p_handler, int p_eventId )
+        : m_handler( p_handler )
+        , m_eventId( p_eventId )
+        , m_resetRequested( false )
+        , m_syncing( false )
+        , m_notified( false )
+        , m_stop( false )
+        , m_generation( 0 )
+        , m_numSynced( 0 ) {
+        Ensure::notNull( p_handler );
+        m_thread = std::thread( &DatIndexFilter::workerThread, this );
+    }
+
+    DatIndexFilter::~DatIndexFilter( ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+            m_generation++;
+        }
+        m_wakeUp.notify_one( );
+        m_thread.join( );
+    }
+
+    //============================================================================/
+
+    void DatIndexFilter::setIndex( const std::shared_ptr<DatIndex>& p_index ) {
+        // Released once unlocked, destroying the index notifies its listeners
+        std::shared_ptr<DatIndex> previous;
+
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            previous.swap( m_index );
+            m_index = p_index;
+            m_results.clear( );
+            m_query.clear( );
+            m_resetRequested = true;
+            m_notified = false;
+            m_generation++;
+
+            // The worker stops syncing early once cancelled
+            m_synced.wait( lock, [this] ( ) { return !m_syncing; } );
+        }
+        m_wakeUp.notify_one( );
+    }
+
+    //============================================================================/
+
+    void DatIndexFilter::query( const wxString& p_query ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_query = lowerUtf8( p_query );
+            m_results.clear( );
+            m_notified = false;
+            m_generation++;
+        }
+        m_wakeUp.notify_one( );
+    }
+
+    //============================================================================/
+
+    void DatIndexFilter::cancel( ) {
+        this->query( wxEmptyString );
+    }
+
+    //============================================================================/
+
+    bool DatIndexFilter::fetchResults( std::vector<const DatIndexEntry*>& po_results, size_t p_offset ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_notified = false;
+
+        if ( p_offset >= m_results.size( ) ) {
+            return false;
+        }
+        po_results.insert( po_results.end( ), m_results.begin( ) + p_offset, m_results.end( ) );
+        return true;
+    }
+
+    //============================================================================/
+
+    void DatIndexFilter::syncEntries( const DatIndex& p_index, uint p_generation ) {
+        auto snapshot = p_index.snapshot( );
+        if ( m_numSynced >= snapshot.numEntries( ) ) {
+            return;
+        }
+
+        std::vector<Record> records;
+        std::vector<std::string> categories;
+        records.reserve( snapshot.numEntries( ) - m_numSynced );
+
+        uint synced = m_numSynced;
+        for ( ; synced < snapshot.numEntries( ); synced++ ) {
+            if ( ( ( synced - m_numSynced ) % CancelCheckInterval ) == 0 && this->isCancelled( p_generation ) ) {
+                break;
+            }
+            auto entry = snapshot.entry( synced );
+
+            Record record;
+            record.entry = entry;
+            record.fileId = entry->fileId( );
+            record.baseId = entry->baseId( );
+            record.name = lowerUtf8( entry->name( ) );
+
+            // Category paths are few and shared, give each one an id
+            auto category = entry->category( );
+            auto it = m_categoryIds.find( category );
+            if ( it == m_categoryIds.end( ) ) {
+                std::string path;
+                for ( auto parent = category; parent; parent = parent->parent( ) ) {
+                    path.insert( 0, "/" + lowerUtf8( parent->name( ) ) );
+                }
+                it = m_categoryIds.emplace( category, static_cast<uint>( m_categoryIds.size( ) ) ).first;
+                categories.push_back( path );
+            }
+            record.category = it->second;
+
+            records.push_back( std::move( record ) );
+        }
+        m_numSynced = synced;
+
+        if ( !records.empty( ) ) {
+            this->addRecords( records, categories );
+        }
+    }
+
+    //============================================================================/
+
+    void DatIndexFilter::workerThread( ) {
+        uint handled = 0;
+
+        for ( ;; ) {
+            const DatIndex* index;
+            std::string query;
+            uint generation;
+            bool reset;
+
+            {
+                std::unique_lock<std::mutex> lock( m_mutex );
+                m_wakeUp.wait( lock, [this, handled] ( ) { return m_stop || m_generation.load( ) != handled; } );
+                if ( m_stop ) {
+                    return;
+                }
+
+                generation = m_generation.load( );
+                query = m_query;
+                index = m_index.get( );
+                reset = m_resetRequested;
+                m_resetRequested = false;
+                // setIndex() waits for this to clear before the index can go away
+                m_syncing = ( index != nullptr );
+            }
+            handled = generation;
+
+            if ( reset ) {
+                m_numSynced = 0;
+                m_categoryIds.clear( );
+                m_records.clear( );
+                m_categoryPaths.clear( );
+                m_byCategory.clear( );
+                m_byName.clear( );
+                m_byBaseId.clear( );
+                m_byFileId.clear( );
+                m_trigrams.clear( );
+            }
+
+            if ( index ) {
+                this->syncEntries( *index, generation );
+                {
+                    std::lock_guard<std::mutex> lock( m_mutex );
+                    m_syncing = false;
+                }
+                m_synced.notify_all( );
+            }
+
+            this->runQuery( query, generation );
+        }
+    }
+
+    //============================================================================/
+
+    void DatIndexFilter::addRecords( std::vector<Record>& p_records, std::vector<std::string>& p_categories ) {
+        std::move( p_categories.begin( ), p_categories.end( ), std::back_inserter( m_categoryPaths ) );
+        m_byCategory.resize( m_categoryPaths.size( ) );
+
+        auto first = static_cast<uint>( m_records.size( ) );
+        m_records.reserve( m_records.size( ) + p_records.size( ) );
+
+        for ( auto& it : p_records ) {
+            auto index = static_cast<uint>( m_records.size( ) );
+
+            // Record indices only grow, so the posting lists stay sorted
+            for ( size_t i = 0; i + 3 <= it.name.size( ); i++ ) {
+                auto& list = m_trigrams[trigram( &it.name[i] )];
+                if ( list.empty( ) || list.back( ) != index ) {
+                    list.push_back( index );
+                }
+            }
+            m_byCategory[it.category].push_back( index );
+
+            m_records.push_back( std::move( it ) );
+        }
+
+        // Merge the new records into the sorted lookup tables
+        auto merge = [this, first] ( std::vector<uint>& po_order, auto p_less ) {
+            auto middle = po_order.size( );
+            for ( auto i = first; i < m_records.size( ); i++ ) {
+                po_order.push_back( i );
+            }
+            std::sort( po_order.begin( ) + middle, po_order.end( ), p_less );
+            std::inplace_merge( po_order.begin( ), po_order.begin( ) + middle, po_order.end( ), p_less );
+        };
+
+        merge( m_byName, [this] ( uint a, uint b ) { return m_records[a].name < m_records[b].name; } );
+        merge( m_byBaseId, [this] ( uint a, uint b ) { return m_records[a].baseId < m_records[b].baseId; } );
+        merge( m_byFileId, [this] ( uint a, uint b ) { return m_records[a].fileId < m_records[b].fileId; } );
+    }
+
+    //============================================================================/
+
+    void DatIndexFilter::runQuery( const std::string& p_query, uint p_generation ) {
+        auto terms = parseQuery( p_query );
+        if ( terms.empty( ) ) {
+            return;
+        }
+
+        // Narrow down the candidates with the lookup tables
+        PostingList candidates;
+        bool narrowed = false;
+        for ( auto const& it : terms ) {
+            PostingList list;
+            if ( !this->candidates( it, list ) ) {
+                continue;
+            }
+            if ( narrowed ) {
+                intersect( candidates, list );
+            } else {
+                candidates.swap( list );
+                narrowed = true;
+            }
+            if ( this->isCancelled( p_generation ) ) {
+                return;
+            }
+        }
+
+        // Verify each candidate against every term
+        std::vector<const DatIndexEntry*> batch;
+        batch.reserve( ResultBatchSize );
+
+        auto count = narrowed ? candidates.size( ) : m_records.size( );
+        for ( size_t i = 0; i < count; i++ ) {
+            if ( ( i % CancelCheckInterval ) == 0 && this->isCancelled( p_generation ) ) {
+                return;
+            }
+
+            auto& record = m_records[narrowed ? candidates[i] : i];
+            auto match = std::all_of( terms.begin( ), terms.end( ), [this, &record] ( const Term& p_term ) {
+                return this->matches( record, p_term );
+            } );
+            if ( !match ) {
+                continue;
+            }
+
+            batch.push_back( record.entry );
+            if ( batch.size( ) >= ResultBatchSize && !this->publish( batch, p_generation ) ) {
+                return;
+            }
+        }
+
+        if ( !batch.empty( ) ) {
+            this->publish( batch, p_generation );
+        }
+    }
+
+    //============================================================================/
+
+    bool DatIndexFilter::publish( std::vector<const DatIndexEntry*>& p_batch, uint p_generation ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( this->isCancelled( p_generation ) ) {
+            return false;
+        }
+
+        m_results.insert( m_results.end( ), p_batch.begin( ), p_batch.end( ) );
+        p_batch.clear( );
+
+        // Only one notification in flight, the handler fetches everything
+        if ( !m_notified ) {
+            m_notified = true;
+            wxQueueEvent( m_handler, new wxThreadEvent( wxEVT_THREAD, m_eventId ) );
+        }
+        return true;
+    }
+
+    //============================================================================/
+
+    std::vector<DatIndexFilter::Term> DatIndexFilter::parseQuery( const std::string& p_query ) {
+        std::vector<Term> terms;
+
+        size_t start = 0;
+        while ( start < p_query.size( ) ) {
+            auto end = p_query.find_first_of( " \t", start );
+            if ( end == std::string::npos ) {
+                end = p_query.size( );
+            }
+
+            if ( end > start ) {
+                Term term;
+                auto dash = p_query.find( '-', start );
+
+                if ( dash < end && isNumber( p_query, start, dash ) && isNumber( p_query, dash + 1, end ) ) {
+                    term.type = Term::TT_Range;
+                    term.low = toNumber( p_query, start, dash );
+                    term.high = toNumber( p_query, dash + 1, end );
+                    if ( term.low > term.high ) {
+                        std::swap( term.low, term.high );
+                    }
+                } else if ( isNumber( p_query, start, end ) ) {
+                    term.type = Term::TT_Prefix;
+                    term.low = term.high = 0;
+                    term.text = p_query.substr( start, end - start );
+                } else {
+                    term.type = Term::TT_Text;
+                    term.low = term.high = 0;
+                    term.text = p_query.substr( start, end - start );
+                }
+                terms.push_back( term );
+            }
+            start = end + 1;
+        }
+
+        return terms;
+    }
+
+    //============================================================================/
+
+    bool DatIndexFilter::matches( const Record& p_record, const Term& p_term ) const {
+        switch ( p_term.type ) {
+        case Term::TT_Range:
+            return ( p_record.baseId >= p_term.low && p_record.baseId <= p_term.high ) ||
+                ( p_record.fileId >= p_term.low && p_record.fileId <= p_term.high );
+        case Term::TT_Prefix:
+            return p_record.name.compare( 0, p_term.text.size( ), p_term.text ) == 0;
+        case Term::TT_Text:
+        default:
+            return p_record.name.find( p_term.text ) != std::string::npos ||
+                m_categoryPaths[p_record.category].find( p_term.text ) != std::string::npos;
+        }
+    }
+
+    //============================================================================/
+
+    bool DatIndexFilter::candidates( const Term& p_term, PostingList& po_result ) const {
+        po_result.clear( );
+
+        switch ( p_term.type ) {
+        case Term::TT_Range:
+        {
+            // Either ID may be in range, so take the union of both lookups
+            auto collect = [this, &p_term, &po_result] ( const std::vector<uint>& p_order, uint32 Record::* p_id ) {
+                auto begin = std::lower_bound( p_order.begin( ), p_order.end( ), p_term.low, [this, p_id] ( uint a, uint32 b ) {
+                    return m_records[a].*p_id < b;
+                } );
+                auto end = std::upper_bound( begin, p_order.end( ), p_term.high, [this, p_id] ( uint32 a, uint b ) {
+                    return a < m_records[b].*p_id;
+                } );
+                po_result.insert( po_result.end( ), begin, end );
+            };
+            collect( m_byBaseId, &Record::baseId );
+            collect( m_byFileId, &Record::fileId );
+
+            std::sort( po_result.begin( ), po_result.end( ) );
+            po_result.erase( std::unique( po_result.begin( ), po_result.end( ) ), po_result.end( ) );
+            return true;
+        }
+        case Term::TT_Prefix:
+        {
+            auto it = std::lower_bound( m_byName.begin( ), m_byName.end( ), p_term.text, [this] ( uint a, const std::string& b ) {
+                return m_records[a].name < b;
+            } );
+            for ( ; it != m_byName.end( ); ++it ) {
+                if ( m_records[*it].name.compare( 0, p_term.text.size( ), p_term.text ) != 0 ) {
+                    break;
+                }
+                po_result.push_back( *it );
+            }
+            std::sort( po_result.begin( ), po_result.end( ) );
+            return true;
+        }
+        case Term::TT_Text:
+        default:
+        {
+            // Too short for trigrams, verify every record instead
+            if ( p_term.text.size( ) < 3 ) {
+                return false;
+            }
+
+            // Entries whose name contains every trigram of the term
+            bool first = true;
+            for ( size_t i = 0; i + 3 <= p_term.text.size( ); i++ ) {
+                auto it = m_trigrams.find( trigram( &p_term.text[i] ) );
+                if ( it == m_trigrams.end( ) ) {
+                    po_result.clear( );
+                    break;
+                }
+                if ( first ) {
+                    po_result = it->second;
+                    first = false;
+                } else {
+                    intersect( po_result, it->second );
+                }
+                if ( po_result.empty( ) ) {
+                    break;
+                }
+            }
+
+            // Plus every entry of a matching category
+            for ( size_t i = 0; i < m_categoryPaths.size( ); i++ ) {
+                if ( m_categoryPaths[i].find( p_term.text ) != std::string::npos ) {
+                    unite( po_result, m_byCategory[i] );
+                }
+            }
+            return true;
+        }
+        }
+    }
+
+}; // namespace gw2b
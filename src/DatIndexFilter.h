@@ -0,0 +1,178 @@
+/** \file       DatIndexFilter.h
+ *  \brief      Contains declaration of the incremental .dat index filter.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef DATINDEXFILTER_H_INCLUDED
+#define DATINDEXFILTER_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "DatIndex.h"
+
+namespace gw2b {
+
+    /** Matches the entries of a DatIndex against a filter string on a background
+    *  thread, streaming the matches back to an event handler as they are found.
+    *
+    *  The filter string is split on whitespace and every term must match:
+    *  - \c 1000-2000 matches entries whose base or file ID lies in the range.
+    *  - \c 1234 matches entries whose name (the base ID) starts with it.
+    *  - anything else matches a case-insensitive substring of the entry name or
+    *    its category path, e.g. \c atex or \c 512x.
+    *
+    *  Every call to query() cancels the query in progress. Entries are copied
+    *  from a snapshot of the index on the worker thread too, so the index must
+    *  be detached with setIndex() before it is cleared. */
+    class DatIndexFilter {
+        /** Searchable copy of an index entry, owned by the worker thread. */
+        struct Record {
+            const DatIndexEntry*    entry;
+            uint32                  fileId;
+            uint32                  baseId;
+            uint                    category;
+            std::string             name;
+        };
+        /** A single parsed filter term. */
+        struct Term {
+            enum TermType {
+                TT_Range,
+                TT_Prefix,
+                TT_Text,
+            };
+            TermType                type;
+            uint32                  low;
+            uint32                  high;
+            std::string             text;
+        };
+        typedef std::vector<uint>   PostingList;
+    private:
+        wxEvtHandler*               m_handler;
+        int                         m_eventId;
+
+        // Shared between the UI and the worker thread, guarded by m_mutex
+        std::mutex                  m_mutex;
+        std::condition_variable     m_wakeUp;
+        std::condition_variable     m_synced;
+        std::shared_ptr<DatIndex>   m_index;
+        std::vector<const DatIndexEntry*> m_results;
+        std::string                 m_query;
+        bool                        m_resetRequested;
+        bool                        m_syncing;
+        bool                        m_notified;
+        bool                        m_stop;
+        std::atomic<uint>           m_generation;
+        std::thread                 m_thread;
+
+        // Owned by the worker thread
+        uint                        m_numSynced;
+        std::unordered_map<const DatIndexCategory*, uint> m_categoryIds;
+        std::vector<Record>         m_records;
+        std::vector<std::string>    m_categoryPaths;
+        std::vector<PostingList>    m_byCategory;
+        std::vector<uint>           m_byName;
+        std::vector<uint>           m_byBaseId;
+        std::vector<uint>           m_byFileId;
+        std::unordered_map<uint32, PostingList> m_trigrams;
+    public:
+        /** Constructor. Starts the worker thread.
+        *  \param[in]  p_handler    Handler receiving a wxThreadEvent whenever new
+        *                           results are available.
+        *  \param[in]  p_eventId    Id of the posted wxThreadEvent. */
+        DatIndexFilter( wxEvtHandler* p_handler, int p_eventId );
+        /** Destructor. Cancels the running query and stops the worker thread. */
+        ~DatIndexFilter( );
+
+        /** Sets the index to filter. Drops every record of the previous index,
+        *  and waits until the worker thread stops reading it, so it can be
+        *  cleared or destroyed once this returns. The records are rebuilt on
+        *  the next query.
+        *  \param[in]  p_index  Index to filter, nullptr to detach the current one. */
+        void setIndex( const std::shared_ptr<DatIndex>& p_index );
+        /** Starts a new query, cancelling the previous one. Entries added to the
+        *  index since the last query are picked up first, on the worker thread.
+        *  \param[in]  p_query  Filter string. */
+        void query( const wxString& p_query );
+        /** Cancels the running query, if any. */
+        void cancel( );
+        /** Appends results of the current query found since the last call.
+        *  \param[in]  po_results   Array to append the results to.
+        *  \param[in]  p_offset     Number of results the caller already has.
+        *  \return bool    true if results were appended, false if not. */
+        bool fetchResults( std::vector<const DatIndexEntry*>& po_results, size_t p_offset );
+
+    private:
+        /** Main loop of the worker thread. */
+        void workerThread( );
+        /** Copies the entries indexed since the last sync into searchable
+        *  records, from a snapshot of the index. Stops early if the query is
+        *  cancelled, the next one picks up the rest.
+        *  \param[in]  p_index      Index to read.
+        *  \param[in]  p_generation Generation of the query syncing. */
+        void syncEntries( const DatIndex& p_index, uint p_generation );
+        /** Merges new records into the search structures.
+        *  \param[in]  p_records    Records to add.
+        *  \param[in]  p_categories Category paths to add. */
+        void addRecords( std::vector<Record>& p_records, std::vector<std::string>& p_categories );
+        /** Runs a query, publishing results until done or cancelled.
+        *  \param[in]  p_query      Lower-case UTF-8 query to run.
+        *  \param[in]  p_generation Generation the query belongs to. */
+        void runQuery( const std::string& p_query, uint p_generation );
+        /** Publishes a batch of results if the query is still current.
+        *  \param[in]  p_batch      Results to publish, cleared on return.
+        *  \param[in]  p_generation Generation the results belong to.
+        *  \return bool    true if the query is still current, false if not. */
+        bool publish( std::vector<const DatIndexEntry*>& p_batch, uint p_generation );
+        /** Checks whether the given query was cancelled. */
+        bool isCancelled( uint p_generation ) const {
+            return m_generation.load( std::memory_order_relaxed ) != p_generation;
+        }
+
+        /** Parses a filter string into terms.
+        *  \param[in]  p_query  Lower-case UTF-8 filter string.
+        *  \return std::vector<Term>   Parsed terms. */
+        static std::vector<Term> parseQuery( const std::string& p_query );
+        /** Determines whether a record matches a term. */
+        bool matches( const Record& p_record, const Term& p_term ) const;
+        /** Gets the candidates for a term from the search structures.
+        *  \param[in]  p_term       Term to look up.
+        *  \param[in]  po_result    Sorted record indices of the candidates.
+        *  \return bool    true if the term narrowed the candidates, false if all
+        *                  records are candidates. */
+        bool candidates( const Term& p_term, PostingList& po_result ) const;
+        /** Packs three characters into a trigram key. */
+        static uint32 trigram( const char* p_text ) {
+            return ( static_cast<uint8>( p_text[0] ) << 16 ) | ( static_cast<uint8>( p_text[1] ) << 8 ) | static_cast<uint8>( p_text[2] );
+        }
+    }; // class DatIndexFilter
+
+}; // namespace gw2b
+
+#endif // DATINDEXFILTER_H_INCLUDED
@@ -155,8 +155,14 @@ namespace gw2b {
     //      DatIndexWriter
     //----------------------------------------------------------------------------
 
+    namespace {
+        /** Amount of data gathered before it is written to file. */
+        const size_t WriteBufferSize = 256 * 1024;
+    };
+
     DatIndexWriter::DatIndexWriter( DatIndex& p_index )
         : m_index( p_index )
+        , m_snapshot( p_index )
         , m_categoriesWritten( 0 )
         , m_entriesWritten( 0 ) {
         Ensure::notNull( &p_index );
@@ -169,20 +175,21 @@ namespace gw2b {
     bool DatIndexWriter::open( const wxString& p_filename ) {
         this->close( );
 
-        m_file.Open( p_filename, wxFile::write );
+        m_snapshot = m_index.snapshot( );
+        m_filename = p_filename;
+        m_tempFilename = p_filename + wxT( ".tmp" );
+
+        m_file.Open( m_tempFilename, wxFile::write );
         if ( m_file.IsOpened( ) ) {
             DatIndexHead header;
             header.magicInteger = DatIndex_Magic;
             header.version = DatIndex_Version;
             header.datTimestamp = m_index.datTimestamp( );
-            header.numEntries = m_index.numEntries( );
-            header.numCategories = m_index.numCategories( );
-
-            auto bytesWritten = m_file.Write( &header, sizeof( header ) );
-            if ( bytesWritten < sizeof( header ) ) {
-                this->close( ); return false;
-            }
+            header.numEntries = m_snapshot.numEntries( );
+            header.numCategories = m_snapshot.numCategories( );
 
+            m_buffer.reserve( WriteBufferSize + 1024 );
+            this->append( &header, sizeof( header ) );
             return true;
         }
 
@@ -190,45 +197,46 @@ namespace gw2b {
     }
 
     void DatIndexWriter::close( ) {
-        m_file.Close( );
+        // Still open means the index wasn't completely written
+        if ( m_file.IsOpened( ) ) {
+            m_file.Close( );
+            wxRemoveFile( m_tempFilename );
+        }
+        std::vector<char>( ).swap( m_buffer );
         m_categoriesWritten = 0;
         m_entriesWritten = 0;
     }
 
     bool DatIndexWriter::isDone( ) const {
-        return ( m_index.numEntries( ) == m_entriesWritten )
-            && ( m_index.numCategories( ) == m_categoriesWritten );
+        return ( m_snapshot.numEntries( ) == m_entriesWritten )
+            && ( m_snapshot.numCategories( ) == m_categoriesWritten );
     }
 
     bool DatIndexWriter::write( uint p_amount ) {
-        for ( uint i = 0; i < p_amount; i++ ) {
-            ssize_t bytesWritten;
+        if ( !m_file.IsOpened( ) ) {
+            return false;
+        }
 
+        for ( uint i = 0; i < p_amount; i++ ) {
             // First write categories, one at a time
-            if ( m_categoriesWritten < m_index.numCategories( ) ) {
-                auto category = m_index.category( m_categoriesWritten );
+            if ( m_categoriesWritten < m_snapshot.numCategories( ) ) {
+                auto category = m_snapshot.category( m_categoriesWritten );
                 auto parent = category->parent( );
                 wxScopedCharBuffer nameBuffer = category->name( ).ToUTF8( );
                 // Fixed-width fields
                 DatIndexCategoryFields fields;
                 fields.parent = ( parent ? parent->index( ) : -1 );
                 fields.nameLength = nameBuffer.length( );
-                bytesWritten = m_file.Write( &fields, sizeof( fields ) );
-                if ( bytesWritten < static_cast<ssize_t>( sizeof( fields ) ) ) {
-                    return false;
-                }
+                this->append( &fields, sizeof( fields ) );
                 // Name
-                bytesWritten = m_file.Write( nameBuffer, fields.nameLength );
-                if ( bytesWritten < fields.nameLength ) {
-                    return false;
-                }
+                this->append( nameBuffer, fields.nameLength );
                 // Increase the counter
                 m_categoriesWritten++;
             }
 
             // Then, write entries one at a time (note the 'else')
-            else if ( m_entriesWritten < m_index.numEntries( ) ) {
-                auto entry = m_index.entry( m_entriesWritten );
+            else if ( m_entriesWritten < m_snapshot.numEntries( ) ) {
+                auto entry = m_snapshot.entry( m_entriesWritten );
                 auto category = entry->category( );
                 auto nameBuffer = entry->name( ).ToUTF8( );
                 // Fixed-width fields
@@ -239,15 +247,9 @@ namespace gw2b {
                 fields.mftEntry = entry->mftEntry( );
                 fields.fileType = entry->fileType( );
                 fields.nameLength = nameBuffer.length( );
-                bytesWritten = m_file.Write( &fields, sizeof( fields ) );
-                if ( bytesWritten < static_cast<ssize_t>( sizeof( fields ) ) ) {
-                    return false;
-                }
+                this->append( &fields, sizeof( fields ) );
                 // Name
-                bytesWritten = m_file.Write( nameBuffer, fields.nameLength );
-                if ( bytesWritten < fields.nameLength ) {
-                    return false;
-                }
+                this->append( nameBuffer, fields.nameLength );
                 // Increase the counter
                 m_entriesWritten++;
             }
@@ -258,12 +260,48 @@ namespace gw2b {
             }
         }
 
-        // Remove dirty flag if everything is saved
+        if ( m_buffer.size( ) >= WriteBufferSize && !this->flush( ) ) {
+            return false;
+        }
+
+        // Replace the target file once everything is written
         if ( this->isDone( ) ) {
-            m_index.setDirty( false );
+            return this->commit( );
         }
 
         return true;
     }
 
+    void DatIndexWriter::append( const void* p_data, size_t p_size ) {
+        auto data = static_cast<const char*>( p_data );
+        m_buffer.insert( m_buffer.end( ), data, data + p_size );
+    }
+
+    bool DatIndexWriter::flush( ) {
+        if ( m_buffer.empty( ) ) {
+            return true;
+        }
+
+        auto bytesWritten = m_file.Write( m_buffer.data( ), m_buffer.size( ) );
+        if ( bytesWritten < m_buffer.size( ) ) {
+            return false;
+        }
+        m_buffer.clear( );
+        return true;
+    }
+
+    bool DatIndexWriter::commit( ) {
+        // Make sure the data hit the disk before the old index is replaced
+        if ( !this->flush( ) || !m_file.Flush( ) ) {
+            return false;
+        }
+        m_file.Close( );
+
+        if ( !wxRenameFile( m_tempFilename, m_filename, true ) ) {
+            wxRemoveFile( m_tempFilename );
+            return false;
+        }
+        return true;
+    }
+
 }; // namespace gw2b
@@ -28,6 +28,7 @@
 #ifndef DATINDEXREADER_H_INCLUDED
 #define DATINDEXREADER_H_INCLUDED
 
+#include <vector>
 #include <wx/file.h>
 
 #include "DatIndex.h"
@@ -138,12 +139,19 @@ namespace gw2b {
         ReadResult read( uint p_amount = 1 );
     }; // class DatIndexReader
 
-    /** Responsible for writing a .dat index to file. */
+    /** Responsible for writing a .dat index to file. Writes a snapshot of the
+    *  index taken on open, so the index may keep growing while it is written.
+    *  The data goes to a temporary file that replaces the target only once
+    *  complete, so a crash never leaves a corrupt index behind. */
     class DatIndexWriter {
-        DatIndex&       m_index;
-        wxFile          m_file;
-        uint            m_categoriesWritten;
-        uint            m_entriesWritten;
+        DatIndex&           m_index;
+        DatIndexSnapshot    m_snapshot;
+        wxFile              m_file;
+        wxString            m_filename;
+        wxString            m_tempFilename;
+        std::vector<char>   m_buffer;
+        uint                m_categoriesWritten;
+        uint                m_entriesWritten;
     public:
         /** Constructor.
         *  \param[in]  p_index  Index to write onto disk. */
@@ -151,11 +159,13 @@ namespace gw2b {
         /** Destructor. */
         ~DatIndexWriter( );
 
-        /** Opens the given file for writing.
-        *  \param[in]  p_filename   File to open.
+        /** Takes a snapshot of the index and opens a temporary file next to the
+        *  given one for writing it.
+        *  \param[in]  p_filename   File to write the index to.
         *  \return bool    true if open was successful, false if not. */
         bool open( const wxString& p_filename );
-        /** Closes the opened file. */
+        /** Closes the opened file. If the index was not completely written, the
+        *  temporary file is removed and the target file is left untouched. */
         void close( );
         /** Determines whether this task is done.
         *  \return bool    true if the task is done, false if not. */
@@ -174,7 +184,7 @@ namespace gw2b {
         /** Gets the total amount of categories to write.
         *  \return uint    amount of categories. */
         uint numCategories( ) const {
-            return m_index.numCategories( );
+            return m_snapshot.numCategories( );
         }
 
         /** Gets the current amount of written entries.
@@ -185,13 +195,25 @@ namespace gw2b {
         /** Gets the total amount of entries to write.
         *  \return uint    amount of entries. */
         uint numEntries( ) const {
-            return m_index.numEntries( );
+            return m_snapshot.numEntries( );
         }
 
         /** Performs a write cycle, writing some categories/entries to the file.
+        *  Once everything is written, the temporary file replaces the target.
         *  \param[in]  p_amount     Amount of write cycles to perform.
         *  \return bool    true if successful, false if not. */
         bool write( uint p_amount = 1 );
+    private:
+        /** Appends data to the write buffer.
+        *  \param[in]  p_data   Data to append.
+        *  \param[in]  p_size   Size of the data. */
+        void append( const void* p_data, size_t p_size );
+        /** Writes the buffered data to the temporary file.
+        *  \return bool    true if successful, false if not. */
+        bool flush( );
+        /** Flushes and closes the temporary file, then moves it over the target.
+        *  \return bool    true if successful, false if not. */
+        bool commit( );
 
     }; // class DatIndexWriter
 
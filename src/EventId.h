@@ -29,14 +29,18 @@ namespace gw2b {
         enum {
             ID_ShowFindFile = wxID_HIGHEST + 1, // Show find file window
             ID_ShowFileList,                    // Show file list window
+            ID_ShowFilter,                      // Show filter window
             ID_ShowLog,                         // Show log window
             ID_ClearLog,                        // Clear the log window
+            ID_UseEntryCache,                   // Toggle the decompressed entry cache
             //ID_ResetLayout,
             //ID_SetBackgroundColor,
             //ID_ShowGrid,                      // Show grid on PreviewGLCanvas
             //ID_ShowMask,                      // Apply white texture with black background, no shader
             //ID_SetCanvasSize,                 // Set PreviewGLCanvas size
             ID_BtnFindFile,                     // Browser's find file button
+            ID_FilterResults,                   // Index filter has new results
+            ID_ThumbnailsLoaded,                // Thumbnail loader has new thumbnails
             ID_BtnBack,                         // Sound player's back button
             ID_BtnPlay,                         // Sound player's play button
             ID_BtnStop,                         // Sound player's stop button
@@ -26,11 +26,14 @@
 
 #include "stdafx.h"
 
+#include <memory>
 #include <sstream>
 #include <string>
+#include <wx/choicdlg.h>
 #include <wx/sstream.h>
 #include <wx/wfstream.h>
 
+#include "BatchImageConverter.h"
 #include "DatFile.h"
 #include "DatIndex.h"
 #include "FileReader.h"
@@ -43,11 +46,35 @@
 #include "Readers/EulaReader.h"
 #include "Readers/ContentReader.h"
 #include "Readers/AFNTReader.h"
+#include "Util/ImageEncoder.h"
 
 #include "Exporter.h"
 
 namespace gw2b {
 
+    namespace {
+
+        /** Determines whether entries of the given type are converted by
+        *  exportImage. */
+        bool isConvertedImage( ANetFileType p_fileType ) {
+            switch ( p_fileType ) {
+            case ANFT_ATEX:
+            case ANFT_ATTX:
+            case ANFT_ATEC:
+            case ANFT_ATEP:
+            case ANFT_ATEU:
+            case ANFT_ATET:
+            case ANFT_DDS:
+            case ANFT_JPEG:
+            case ANFT_WEBP:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    };
+
     Exporter::Exporter( const Array<const DatIndexEntry*>& p_entries, DatFile& p_datFile, ExtractionMode p_mode )
         : m_datFile( p_datFile )
         , m_entries( p_entries )
@@ -59,15 +86,20 @@ namespace gw2b {
         // If it's just one file, we could handle it here
         if ( m_entries.GetSize( ) == 1 ) {
             auto& entry = m_entries[0];
-            auto entryData = m_datFile.readFile( entry->mftEntry( ) );
-            // Valid data?
-            if ( !entryData.GetSize( ) ) {
-                wxMessageBox( wxT( "Failed to get file data, most likely due to a decompression error." ), wxT( "Error" ), wxOK | wxICON_ERROR );
-                return;
-            }
+            if ( m_mode == EM_Raw ) {
+                // The index knows the type, no need to read the whole file
+                m_fileType = entry->fileType( );
+            } else {
+                auto entryData = m_datFile.readFile( entry->mftEntry( ) );
+                // Valid data?
+                if ( !entryData.GetSize( ) ) {
+                    wxMessageBox( wxT( "Failed to get file data, most likely due to a decompression error." ), wxT( "Error" ), wxOK | wxICON_ERROR );
+                    return;
+                }
 
-            // Identify file type
-            m_datFile.identifyFileType( entryData.GetPointer( ), entryData.GetSize( ), m_fileType );
+                // Identify file type
+                m_datFile.identifyFileType( entryData.GetPointer( ), entryData.GetSize( ), m_fileType );
+            }
 
             // Ask for location
             wxFileDialog dialog( this,
@@ -98,11 +130,31 @@ namespace gw2b {
 
                 uint numFile = static_cast<uint>( p_entries.GetSize( ) );
 
+                // Images are converted on their own threads, in the format the
+                // user picks
+                std::unique_ptr<BatchImageConverter> converter;
+                ImageFileFormat imageFormat = IFF_PNG;
+                if ( m_mode == EM_Converted ) {
+                    uint numImages = 0;
+                    for ( uint i = 0; i < m_entries.GetSize( ); i++ ) {
+                        numImages += isConvertedImage( m_entries[i]->fileType( ) ) ? 1 : 0;
+                    }
+
+                    if ( numImages ) {
+                        int imageLevel;
+                        if ( !this->askImageFormat( imageFormat, imageLevel ) ) {
+                            return;
+                        }
+                        converter.reset( new BatchImageConverter( m_datFile, imageFormat, imageLevel ) );
+                    }
+                }
+
                 auto title = wxString::Format( wxT( "Extracting %d %s..." ), numFile, ( p_entries.GetSize( ) == 1 ? wxT( "file" ) : wxT( "files" ) ) );
                 m_progress = new wxProgressDialog( title, wxT( "Preparing to extract..." ), p_entries.GetSize( ), this, wxPD_SMOOTH | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME );
                 m_progress->Show( );
 
                 // Loop through each files and update progress bar
+                bool isCancelled = false;
                 for ( uint i = 0; i < m_entries.GetSize( ); i++ ) {
                     // DONE
                     if ( m_currentProgress >= m_entries.GetSize( ) ) {
@@ -116,6 +168,9 @@ namespace gw2b {
                     // Set file name
                     m_filename.SetName( entry->name( ) );
                     // Set file extension
+                    if ( m_mode == EM_Raw ) {
+                        m_fileType = entry->fileType( );
+                    }
                     m_filename.SetExt( wxString( this->GetExtension( ) ) );
 
                     // Appen category name as path
@@ -127,15 +182,37 @@ namespace gw2b {
                     }
 
                     // Extract current file
-                    this->extractFile( *m_entries[m_currentProgress] );
+                    if ( converter && isConvertedImage( entry->fileType( ) ) ) {
+                        m_filename.SetExt( ImageEncoder::extension( imageFormat ) );
+                        converter->add( *entry, m_filename.GetFullPath( ) );
+                    } else {
+                        this->extractFile( *m_entries[m_currentProgress] );
+                    }
 
                     bool shouldContinue = m_progress->Update( m_currentProgress, wxString::Format( wxT( "Extracting file %d/%d..." ), m_currentProgress, numFile ) );
                     if ( shouldContinue ) {
                         m_currentProgress++;
                     } else {
                         m_currentProgress = m_entries.GetSize( );
+                        isCancelled = true;
                     }
                 }
+
+                // Wait for the images still being converted
+                if ( converter ) {
+                    while ( !isCancelled && converter->numDone( ) < converter->numAdded( ) ) {
+                        auto message = wxString::Format( wxT( "Writing image %d/%d..." ), converter->numDone( ), converter->numAdded( ) );
+                        isCancelled = !m_progress->Pulse( message );
+                        wxMilliSleep( 50 );
+                    }
+
+                    if ( isCancelled ) {
+                        converter->abort( );
+                    } else {
+                        converter->finish( );
+                    }
+                    wxLogMessage( converter->report( ) );
+                }
                 deletePointer( m_progress );
             }
         }
@@ -529,6 +606,12 @@ namespace gw2b {
     }
 
     void Exporter::extractFile( const DatIndexEntry& p_entry ) {
+        // Raw files go straight from the .dat to disk, a piece at a time
+        if ( m_mode == EM_Raw ) {
+            this->streamFile( p_entry );
+            return;
+        }
+
         auto entryData = m_datFile.readFile( p_entry.mftEntry( ) );
         // Valid data?
         if ( !entryData.GetSize( ) ) {
@@ -539,7 +622,7 @@ namespace gw2b {
         // Identify file type
         m_datFile.identifyFileType( entryData.GetPointer( ), entryData.GetSize( ), m_fileType );
 
-        auto reader = FileReader::readerForData( entryData, m_datFile, m_fileType );
+        auto reader = FileReader::readerForData( entryData, m_datFile, m_fileType, p_entry.mftEntry( ) + m_datFile.mftFileOffset( ) );
 
         if ( reader ) {
             // Should we convert the file?
@@ -1035,7 +1118,7 @@ namespace gw2b {
         // Convert to image
         ANetFileType fileType;
         m_datFile.identifyFileType( fileData.GetPointer( ), fileData.GetSize( ), fileType );
-        auto reader = FileReader::readerForData( fileData, m_datFile, fileType );
+        auto reader = FileReader::readerForData( fileData, m_datFile, fileType, entryNumber );
 
         wxLogMessage( wxString::Format( wxT( "Writing texture file %s." ), m_filename.GetFullPath( ) ) );
 
@@ -1083,24 +1166,51 @@ namespace gw2b {
 
     void Exporter::writeImage( wxImage p_image ) {
         // Write the png to memory
-        wxMemoryOutputStream stream;
-        if ( !p_image.SaveFile( stream, wxBITMAP_TYPE_PNG ) ) {
+        Array<byte> data;
+        if ( !ImageEncoder::encode( p_image, IFF_PNG, IEPL_Default, data ) ) {
             wxMessageBox( wxT( "Failed to write png to memory." ), wxT( "Error" ), wxOK | wxICON_ERROR );
             return;
         }
 
-        // Reset the position of the stream
-        auto buffer = stream.GetOutputStreamBuffer( );
-        buffer->Seek( 0, wxFromStart );
-
-        // Read the data from the stream and into a buffer
-        Array<byte> data( buffer->GetBytesLeft( ) );
-        buffer->Read( data.GetPointer( ), data.GetSize( ) );
-
         // Write to file
         this->writeFile( data );
     }
 
+    bool Exporter::askImageFormat( ImageFileFormat& po_format, int& po_level ) {
+        wxArrayString choices;
+        choices.Add( wxT( "PNG" ) );
+        choices.Add( wxT( "PNG, smallest files (slower)" ) );
+        choices.Add( wxT( "QOI (fast)" ) );
+        choices.Add( wxT( "TGA (fastest, uncompressed)" ) );
+        choices.Add( wxT( "DDS, textures kept block compressed (no decoding)" ) );
+
+        wxSingleChoiceDialog dialog( this, wxT( "Save the images as:" ), wxT( "Image format" ), choices );
+        if ( dialog.ShowModal( ) != wxID_OK ) {
+            return false;
+        }
+
+        po_level = IEPL_Default;
+        switch ( dialog.GetSelection( ) ) {
+        case 1:
+            po_format = IFF_PNG;
+            po_level = IEPL_Smallest;
+            break;
+        case 2:
+            po_format = IFF_QOI;
+            break;
+        case 3:
+            po_format = IFF_TGA;
+            break;
+        case 4:
+            po_format = IFF_DDS;
+            break;
+        default:
+            po_format = IFF_PNG;
+            break;
+        }
+        return true;
+    }
+
     void Exporter::writeXML( std::unique_ptr<tinyxml2::XMLDocument> p_xml ) {
         tinyxml2::XMLError eResult = p_xml->SaveFile( m_filename.GetFullPath( ).c_str( ) );
         if ( eResult != tinyxml2::XML_SUCCESS ) {
@@ -1124,6 +1234,28 @@ namespace gw2b {
         return true;
     }
 
+    bool Exporter::streamFile( const DatIndexEntry& p_entry ) {
+        // Open file for writing
+        wxFile file( m_filename.GetFullPath( ), wxFile::write );
+        if ( !file.IsOpened( ) ) {
+            wxMessageBox( wxString::Format( wxT( "Failed to open the file %s for writing." ), m_filename.GetFullPath( ) ),
+                wxT( "Error" ),
+                wxOK | wxICON_ERROR );
+            wxLogMessage( wxString::Format( wxT( "Failed to open the file %s for writing." ), m_filename.GetFullPath( ) ) );
+            return false;
+        }
+
+        FileDataSink sink( file );
+        if ( !m_datFile.streamFile( p_entry.mftEntry( ), sink ) ) {
+            file.Close( );
+            wxRemoveFile( m_filename.GetFullPath( ) );
+            wxMessageBox( wxT( "Failed to extract the file, most likely due to a decompression error." ), wxT( "Error" ), wxOK | wxICON_ERROR );
+            return false;
+        }
+        file.Close( );
+        return true;
+    }
+
     void Exporter::appendPaths( wxFileName& p_path, const DatIndexCategory& p_category ) {
         auto parent = p_category.parent( );
         if ( parent ) {
@@ -36,6 +36,7 @@
 #include "Util/Array.h"
 #include "ANetStructs.h"
 #include "FileReader.h"
+#include "Util/ImageEncoder.h"
 
 namespace gw2b {
     class DatFile;
@@ -83,8 +84,14 @@ namespace gw2b {
         void exportGameContent( FileReader* p_reader, const wxString& p_entryname );
         void exportBitmapFont( FileReader* p_reader, const wxString& p_entryname );
         void writeImage( wxImage p_image );
+        /** Asks the user which format to convert images to.
+        *  \param[out] po_format   Receives the chosen format.
+        *  \param[out] po_level    Receives the deflate level, for PNG.
+        *  \return bool    true if chosen, false if cancelled. */
+        bool askImageFormat( ImageFileFormat& po_format, int& po_level );
         void writeXML( std::unique_ptr<tinyxml2::XMLDocument> p_xml );
         bool writeFile( const Array<byte>& p_data );
+        bool streamFile( const DatIndexEntry& p_entry );
         void appendPaths( wxFileName& p_path, const DatIndexCategory& p_category );
 
     };
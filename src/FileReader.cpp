@@ -37,6 +37,7 @@
 #include "Readers/MapReader.h"
 #include "Readers/ContentReader.h"
 #include "Readers/AFNTReader.h"
+#include "Readers/PagedImageReader.h"
 
 #include "FileReader.h"
 
@@ -45,7 +46,8 @@ namespace gw2b {
     FileReader::FileReader( const Array<byte>& p_data, DatFile& p_datFile, ANetFileType p_fileType )
         : m_data( p_data )
         , m_datFile( p_datFile )
-        , m_fileType( p_fileType ) {
+        , m_fileType( p_fileType )
+        , m_entryNum( NoEntry ) {
     }
 
     FileReader::~FileReader() {
@@ -60,7 +62,13 @@ namespace gw2b {
         return m_data;
     }
 
-    FileReader* FileReader::readerForData( const Array<byte>& p_data, DatFile& p_datFile, ANetFileType p_fileType ) {
+    FileReader* FileReader::readerForData( const Array<byte>& p_data, DatFile& p_datFile, ANetFileType p_fileType, uint p_entryNum ) {
+        auto reader = createReader( p_data, p_datFile, p_fileType );
+        reader->m_entryNum = p_entryNum;
+        return reader;
+    }
+
+    FileReader* FileReader::createReader( const Array<byte>& p_data, DatFile& p_datFile, ANetFileType p_fileType ) {
         switch ( p_fileType ) {
         case ANFT_ATEX:
         case ANFT_ATTX:
@@ -110,6 +118,9 @@ namespace gw2b {
         case ANFT_BitmapFontFile:
             return new AFNTReader( p_data, p_datFile, p_fileType );
             break;
+        case ANFT_PagedImageTable:
+            return new PagedImageReader( p_data, p_datFile, p_fileType );
+            break;
         default:
             break;
         }
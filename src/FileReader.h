@@ -43,7 +43,11 @@ namespace gw2b {
         Array<byte>     m_data;
         DatFile&        m_datFile;
         ANetFileType    m_fileType;
+        uint            m_entryNum;
     public:
+        /** Entry number of data that wasn't read from a .dat entry. */
+        static const uint NoEntry = 0xffffffff;
+
         /** Type of data contained in this file. Determines how it is exported. */
         enum DataType {
             DT_None,            /**< Invalid data. */
@@ -57,6 +61,7 @@ namespace gw2b {
             DT_Map,             /**< Map data. */
             DT_Content,         /**< Content manifest data. */
             DT_BitmapFont,      /**< Bitmap font data. */
+            DT_PagedImage,      /**< Paged image data. */
         };
     public:
         /** Constructor.
@@ -78,13 +83,23 @@ namespace gw2b {
         /** Gets unconverted data for the contents of this reader.
         *  \return Array<byte> unconverted file data. */
         Array<byte> rawData( ) const;
+        /** Gets the number of the .dat entry the data was read from.
+        *  \return uint    Entry number, NoEntry if not known. */
+        uint entryNum( ) const {
+            return m_entryNum;
+        }
 
         /** Analyzes the given data and creates an appropriate subclass of
         *  FileReader to handle it. Caller is responsible for freeing the reader.
         *  \param[in]  p_data      Data to read.
         *  \param[in]  p_fileType   File type of the given data.
+        *  \param[in]  p_entryNum   Number of the .dat entry the data was read
+        *                           from. Lets readers cache what they convert.
         *  \return FileReader* Newly created FileReader for the data. */
-        static FileReader* readerForData( const Array<byte>& p_data, DatFile& p_datfile, ANetFileType p_fileType );
+        static FileReader* readerForData( const Array<byte>& p_data, DatFile& p_datfile, ANetFileType p_fileType, uint p_entryNum = NoEntry );
+
+    private:
+        static FileReader* createReader( const Array<byte>& p_data, DatFile& p_datFile, ANetFileType p_fileType );
     };
 
 }; // namespace gw2b
@@ -0,0 +1,149 @@
+/** \file       IndexFilterList.cpp
+ *  \brief      Contains definition of the filtered index entry list control.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include "EventId.h"
+
+#include "IndexFilterList.h"
+
+namespace gw2b {
+
+    IndexFilterList::IndexFilterList( wxWindow* p_parent, const wxPoint& p_location, const wxSize& p_size )
+        : wxListCtrl( p_parent, wxID_ANY, p_location, p_size, wxLC_REPORT | wxLC_VIRTUAL | wxLC_SINGLE_SEL )
+        , m_filter( this, ID_FilterResults ) {
+        this->InsertColumn( COL_Name, wxT( "Name" ), wxLIST_FORMAT_LEFT, 80 );
+        this->InsertColumn( COL_FileId, wxT( "File ID" ), wxLIST_FORMAT_LEFT, 70 );
+        this->InsertColumn( COL_Category, wxT( "Category" ), wxLIST_FORMAT_LEFT, 160 );
+
+        this->Bind( wxEVT_THREAD, &IndexFilterList::onFilterResults, this, ID_FilterResults );
+    }
+
+    //============================================================================/
+
+    IndexFilterList::~IndexFilterList( ) {
+        if ( m_index ) {
+            m_index->removeListener( this );
+        }
+    }
+
+    //============================================================================/
+
+    void IndexFilterList::setDatIndex( const std::shared_ptr<DatIndex>& p_index ) {
+        if ( m_index ) {
+            m_index->removeListener( this );
+        }
+
+        this->clearResults( );
+        m_index = p_index;
+        m_filter.setIndex( p_index );
+
+        if ( m_index ) {
+            m_index->addListener( this );
+        }
+    }
+
+    //============================================================================/
+
+    void IndexFilterList::setFilter( const wxString& p_filter ) {
+        this->clearResults( );
+        m_filter.query( p_filter );
+    }
+
+    //============================================================================/
+
+    const DatIndexEntry* IndexFilterList::entry( long p_item ) const {
+        if ( p_item < 0 || static_cast<size_t>( p_item ) >= m_results.size( ) ) {
+            return nullptr;
+        }
+        return m_results[p_item];
+    }
+
+    //============================================================================/
+
+    wxString IndexFilterList::OnGetItemText( long p_item, long p_column ) const {
+        auto entry = this->entry( p_item );
+        if ( !entry ) {
+            return wxEmptyString;
+        }
+
+        switch ( p_column ) {
+        case COL_Name:
+            return entry->name( );
+        case COL_FileId:
+            return wxString::Format( wxT( "%u" ), entry->fileId( ) );
+        case COL_Category:
+        {
+            wxString path;
+            for ( auto category = entry->category( ); category; category = category->parent( ) ) {
+                path = path.IsEmpty( ) ? category->name( ) : category->name( ) + wxT( "/" ) + path;
+            }
+            return path;
+        }
+        }
+        return wxEmptyString;
+    }
+
+    //============================================================================/
+
+    void IndexFilterList::clearResults( ) {
+        m_results.clear( );
+        this->SetItemCount( 0 );
+        this->Refresh( );
+    }
+
+    //============================================================================/
+
+    void IndexFilterList::onFilterResults( wxThreadEvent& WXUNUSED( p_event ) ) {
+        if ( m_filter.fetchResults( m_results, m_results.size( ) ) ) {
+            this->SetItemCount( m_results.size( ) );
+            this->Refresh( );
+        }
+    }
+
+    //============================================================================/
+
+    void IndexFilterList::onIndexClearing( DatIndex& p_index ) {
+        Assert( &p_index == m_index.get( ) );
+        this->clearResults( );
+        m_filter.setIndex( nullptr );
+    }
+
+    //============================================================================/
+
+    void IndexFilterList::onIndexCleared( DatIndex& p_index ) {
+        Assert( &p_index == m_index.get( ) );
+        m_filter.setIndex( m_index );
+    }
+
+    //============================================================================/
+
+    void IndexFilterList::onIndexDestruction( DatIndex& p_index ) {
+        Assert( &p_index == m_index.get( ) );
+        m_index = nullptr;
+        this->clearResults( );
+        m_filter.setIndex( nullptr );
+    }
+
+}; // namespace gw2b
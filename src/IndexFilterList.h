@@ -0,0 +1,97 @@
+/** \file       IndexFilterList.h
+ *  \brief      Contains declaration of the filtered index entry list control.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef INDEXFILTERLIST_H_INCLUDED
+#define INDEXFILTERLIST_H_INCLUDED
+
+#include <wx/listctrl.h>
+#include <vector>
+
+#include "DatIndex.h"
+#include "DatIndexFilter.h"
+
+namespace gw2b {
+
+    /** Virtual list control showing the entries of a DatIndex that match a
+    *  filter string. Matches stream in from a DatIndexFilter while the user
+    *  types. */
+    class IndexFilterList : public wxListCtrl, public IDatIndexListener {
+        /** Columns shown by the list. */
+        enum Column {
+            COL_Name,
+            COL_FileId,
+            COL_Category,
+        };
+    private:
+        std::shared_ptr<DatIndex>           m_index;
+        DatIndexFilter                      m_filter;
+        std::vector<const DatIndexEntry*>   m_results;
+    public:
+        /** Constructor. Creates the list control with the given parent.
+        *  \param[in]  p_parent     Parent of the control.
+        *  \param[in]  p_location   Optional location of the control.
+        *  \param[in]  p_size       Optional size of the control. */
+        IndexFilterList( wxWindow* p_parent, const wxPoint& p_location = wxDefaultPosition, const wxSize& p_size = wxDefaultSize );
+        /** Destructor. */
+        virtual ~IndexFilterList( );
+
+        /** Sets the .dat file index to filter.
+        *  \param[in]  p_index  Index to filter. */
+        void setDatIndex( const std::shared_ptr<DatIndex>& p_index );
+        /** Replaces the current filter, cancelling the previous query.
+        *  \param[in]  p_filter Filter string, see DatIndexFilter. */
+        void setFilter( const wxString& p_filter );
+        /** Gets the entry shown at the given row.
+        *  \param[in]  p_item   Row of the entry.
+        *  \return DatIndexEntry*  pointer to the entry, or nullptr if not valid. */
+        const DatIndexEntry* entry( long p_item ) const;
+
+        /** Called by the .dat index before it is cleared, detaches it from the
+        *  filter so the filter thread stops reading it.
+        *  \param[in]  p_index  Reference to the index being cleared. */
+        virtual void onIndexClearing( DatIndex& p_index ) override;
+        /** Called by the .dat index when it is cleared.
+        *  \param[in]  p_index  Reference to the index being cleared. */
+        virtual void onIndexCleared( DatIndex& p_index ) override;
+        /** Called by the .dat index when it is destroyed.
+        *  \param[in]  p_index  Reference to the index being destroyed. */
+        virtual void onIndexDestruction( DatIndex& p_index ) override;
+    protected:
+        /** Gets the text of a cell, called by wxWidgets for visible rows only.
+        *  \param[in]  p_item   Row of the cell.
+        *  \param[in]  p_column Column of the cell. */
+        virtual wxString OnGetItemText( long p_item, long p_column ) const override;
+    private:
+        /** Clears the shown results. */
+        void clearResults( );
+        /** Event raised by the filter when new results are available.
+        *  \param[in]  p_event  Unused event object handed to us by wxWidgets. */
+        void onFilterResults( wxThreadEvent& p_event );
+    }; // class IndexFilterList
+
+}; // namespace gw2b
+
+#endif // INDEXFILTERLIST_H_INCLUDED
@@ -149,9 +149,12 @@ namespace gw2b {
 
 
             } if ( isOfType<ModelReader>( m_reader ) ) {
-                // Load model
+                // Load model, the most detailed level
                 auto reader = this->modelReader( );
                 auto model = reader->getModel( );
+                m_datFile = &p_datFile;
+                m_lodLevel = model.lodLevel( );
+                m_numLodLevels = model.numLodLevels( );
 
                 m_glRenderer->loadModel( p_datFile, model );
             }
@@ -174,6 +177,22 @@ namespace gw2b {
         if ( m_reader ) {
             deletePointer( m_reader );
         }
+        m_datFile = nullptr;
+        m_lodLevel = 0;
+        m_numLodLevels = 1;
+    }
+
+    void PreviewGLCanvas::showNextLodLevel( ) {
+        if ( !m_datFile || !isOfType<ModelReader>( m_reader ) || m_numLodLevels < 2 ) {
+            return;
+        }
+
+        m_lodLevel = ( m_lodLevel + 1 ) % m_numLodLevels;
+        auto model = this->modelReader( )->getModel( m_lodLevel );
+
+        m_glRenderer->clear( );
+        m_glRenderer->loadModel( *m_datFile, model );
+        m_glRenderer->render( );
     }
 
     bool PreviewGLCanvas::initGL( ) {
@@ -298,6 +317,10 @@ namespace gw2b {
             m_glRenderer->toggleStatusAntiAlising();
             // Force re-create framebuffer
             m_glRenderer->createFrameBuffer( );
+        } else if ( p_event.GetKeyCode( ) == '8' ) {
+            m_glRenderer->toggleStatusOptimizeMeshes();
+        } else if ( p_event.GetKeyCode( ) == '9' ) {
+            this->showNextLodLevel( );
         }
 
         // Rendering debugging/visualization control
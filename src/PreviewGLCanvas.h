@@ -52,10 +52,13 @@ namespace gw2b {
     class PreviewGLCanvas : public wxGLCanvas {
         // Internal status
         bool                        m_isViewingMap = false;             // Is we are viewing map?
+        uint                        m_lodLevel = 0;                     // Level of detail of the model shown
+        uint                        m_numLodLevels = 1;                 // Levels of detail of the model shown
 
         wxWindow*                   m_parent;
 
         FileReader*                 m_reader;
+        DatFile*                    m_datFile = nullptr;                // .dat file of the model shown, for its other levels of detail
         wxGLContext*                m_glContext;
         Renderer*                   m_glRenderer;
         RenderTimer*                m_renderTimer;
@@ -117,6 +120,9 @@ namespace gw2b {
             return reinterpret_cast<const MapReader*>( this->reader( ) );
         } // already asserted with a dynamic_cast
 
+        /** Shows the next level of detail of the model, decoding it only now. */
+        void showNextLodLevel( );
+
         void onPaintEvt( wxPaintEvent& p_event );
         void onMotionEvt( wxMouseEvent& p_event );
         void onMouseWheelEvt( wxMouseEvent& p_event );
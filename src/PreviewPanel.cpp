@@ -57,7 +57,7 @@ namespace gw2b {
         }
 
         // Create file reader
-        auto reader = FileReader::readerForData( entryData, p_datFile, p_entry.fileType( ) );
+        auto reader = FileReader::readerForData( entryData, p_datFile, p_entry.fileType( ), p_entry.mftEntry( ) + p_datFile.mftFileOffset( ) );
 
         if ( reader ) {
             if ( m_currentView ) {
@@ -107,6 +107,7 @@ namespace gw2b {
                 newViewer = new SoundPlayer( this );
                 break;
             case FileReader::DT_Image:
+            case FileReader::DT_PagedImage:
                 newViewer = new ImageViewer( this );
                 break;
             case FileReader::DT_String:
@@ -130,7 +130,7 @@ namespace gw2b {
         ANetPfChunkHeader* chunkHeader = (ANetPfChunkHeader*)( afnt );
 
         if ( chunkHeader->chunkTypeInteger != FCC_AFNT ) {
-            wxLogMessage( wxT( "Not AFNT file. Seriously!?" ) );
+            LogWarning( wxT( "Not AFNT file. Seriously!?" ) );
             return fonts;
         }
 
@@ -141,7 +141,7 @@ namespace gw2b {
         uint32 fontCount = *(uint32*)(afnt + sizeof( ANetPfChunkHeader ));
 
         for ( int x = 0; x < static_cast<int>( fontCount ); x++ ) {
-            wxLogMessage( wxT( "Processing font %d" ), x );
+            LogDebug( wxT( "Processing font %d" ), x );
 
             std::vector<Glyph> glyphs;
             auto& fnt = fontArray[x];
@@ -163,7 +163,7 @@ namespace gw2b {
                 auto entryNumber = m_datFile.entryNumFromFileOrBaseId( fileId );
                 auto fileData = m_datFile.readEntry( entryNumber );
                 if ( !fileData.GetSize( ) ) {
-                    wxLogMessage( wxT( "File id %d is empty or not exist." ), fileId );
+                    LogWarning( wxT( "File id %d is empty or not exist." ), fileId );
                     continue;
                 }
 
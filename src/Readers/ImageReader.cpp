@@ -25,86 +25,23 @@
 
 #include "stdafx.h"
 
+#include <algorithm>
 #include <wx/mstream.h>
 
 #include <webp/decode.h> // libwebp
 #include <gw2dattools/compression/inflateTextureFileBuffer.h>
 #include <gw2dattools/exception/Exception.h>
 
-#include "ImageReader.h"
+#include "Compression/DXTDecoder.h"
+#include "Compression/TextureInflater.h"
+#include "DatEntryCache.h"
+#include "Util/ImageEncoder.h"
+#include "Util/PixelConverter.h"
 
-#ifdef RGB
-#undef RGB
-#endif
+#include "ImageReader.h"
 
 namespace gw2b {
 
-    union ImageReader::BGRA {
-        struct {
-            uint8 b;
-            uint8 g;
-            uint8 r;
-            uint8 a;
-        };
-        uint8 parts[4];
-        uint32 color;
-    };
-
-    union ImageReader::RGBA {
-        struct {
-            uint8 r;
-            uint8 g;
-            uint8 b;
-            uint8 a;
-        };
-        uint8 parts[4];
-        uint32 color;
-    };
-
-    struct ImageReader::BGR {
-        uint8   b;
-        uint8   g;
-        uint8   r;
-    };
-
-    struct ImageReader::RGB {
-        uint8   r;
-        uint8   g;
-        uint8   b;
-    };
-
-    union ImageReader::DXTColor {
-        struct {
-            uint16 red1 : 5;
-            uint16 green1 : 6;
-            uint16 blue1 : 5;
-            uint16 red2 : 5;
-            uint16 green2 : 6;
-            uint16 blue2 : 5;
-        };
-        struct {
-            uint16 color1;
-            uint16 color2;
-        };
-    };
-
-    struct ImageReader::DXT1Block {
-        DXTColor colors;
-        uint32   indices;
-    };
-
-    struct ImageReader::DXT3Block {
-        uint64   alpha;
-        DXTColor colors;
-        uint32   indices;
-    };
-
-    struct ImageReader::DCXBlock     // Should be 3DCXBlock, but names can't start with a number D:
-    {
-        uint64  green;
-        uint64  red;
-    };
-
     struct ImageReader::DDSPixelFormat {
         uint32          size;                   /**< Structure size; set to 32 (bytes). */
         uint32          flags;                  /**< Values which indicate what type of data is in the surface. */
@@ -134,6 +71,155 @@ namespace gw2b {
         uint32          reserved2;              /**< Unused. */
     };
 
+    struct ImageReader::PixelLayout {
+        uint8*          colors;                 /**< First color of the image, red first unless isBGR is set. */
+        uint8*          alphas;                 /**< First alpha of the image, nullptr if there is none. */
+        uint            colorStep;              /**< Bytes from one color to the next. */
+        uint            alphaStep;              /**< Bytes from one alpha to the next. */
+        size_t          colorPitch;             /**< Bytes from one row of colors to the next. */
+        size_t          alphaPitch;             /**< Bytes from one row of alphas to the next. */
+        bool            isBGR;                  /**< Colors are stored blue first. */
+
+        /** Gets the layout of wxImage: a plane of colors and an optional plane of alphas. */
+        static PixelLayout planar( uint8* p_colors, uint8* p_alphas, uint p_width ) {
+            PixelLayout layout = { p_colors, p_alphas, 3, 1, static_cast<size_t>( p_width ) * 3, p_width, false };
+            return layout;
+        }
+
+        /** Gets the layout of 4 byte pixels with the alpha last. */
+        static PixelLayout interleaved( uint8* p_pixels, size_t p_pitch, bool p_isBGR ) {
+            PixelLayout layout = { p_pixels, p_pixels + 3, 4, 4, p_pitch, p_pitch, p_isBGR };
+            return layout;
+        }
+
+        /** Determines whether this is the layout planar( ) gives for the given width. */
+        bool isPlanar( uint p_width ) const {
+            return ( colorStep == 3 ) && ( colorPitch == static_cast<size_t>( p_width ) * 3 ) && !isBGR &&
+                ( !alphas || ( ( alphaStep == 1 ) && ( alphaPitch == p_width ) ) );
+        }
+
+        /** Determines whether this is a layout interleaved( ) gives. */
+        bool isInterleaved( ) const {
+            return ( colorStep == 4 ) && ( alphas == colors + 3 ) && ( alphaStep == 4 ) && ( alphaPitch == colorPitch );
+        }
+
+        /** Determines whether the rows hold 3 byte colors and, if any, 1 byte alphas. */
+        bool isPlanarRow( ) const {
+            return ( colorStep == 3 ) && ( !alphas || ( alphaStep == 1 ) );
+        }
+
+        /** Gets the layout starting at the given row. */
+        PixelLayout row( uint p_y ) const {
+            PixelLayout layout = *this;
+            layout.colors += p_y * colorPitch;
+            if ( alphas ) {
+                layout.alphas += p_y * alphaPitch;
+            }
+            return layout;
+        }
+
+        /** Copies the first row of another layout into the first row of this one.
+        *  Alphas become 0xff if the other layout has none. */
+        void copyRow( const PixelLayout& p_from, uint p_width ) const {
+            auto& converter = pixelConverter( );
+            const bool swapRedBlue = ( p_from.isBGR != isBGR );
+            const uint8 order[4] = { static_cast<uint8>( swapRedBlue ? 2 : 0 ), 1, static_cast<uint8>( swapRedBlue ? 0 : 2 ), 3 };
+
+            // Layouts the converter has kernels for
+            if ( p_from.isInterleaved( ) && this->isInterleaved( ) ) {
+                if ( swapRedBlue ) {
+                    converter.swizzle( p_from.colors, colors, p_width, order );
+                } else {
+                    ::memcpy( colors, p_from.colors, static_cast<size_t>( p_width ) * 4 );
+                }
+                return;
+            } else if ( p_from.isInterleaved( ) && this->isPlanarRow( ) ) {
+                converter.splitAlpha( p_from.colors, colors, alphas, p_width, order );
+                return;
+            } else if ( p_from.isPlanarRow( ) && this->isInterleaved( ) ) {
+                converter.mergeAlpha( p_from.colors, p_from.alphas, colors, p_width, swapRedBlue );
+                return;
+            }
+
+            const uint fromRed = p_from.isBGR ? 2 : 0;
+            const uint toRed = isBGR ? 2 : 0;
+
+            auto from = p_from.colors;
+            auto to = colors;
+            for ( uint x = 0; x < p_width; x++ ) {
+                to[toRed] = from[fromRed];
+                to[1] = from[1];
+                to[2 - toRed] = from[2 - fromRed];
+                from += p_from.colorStep;
+                to += colorStep;
+            }
+
+            if ( !alphas ) {
+                return;
+            }
+
+            to = alphas;
+            if ( p_from.alphas ) {
+                from = p_from.alphas;
+                for ( uint x = 0; x < p_width; x++ ) {
+                    *to = *from;
+                    from += p_from.alphaStep;
+                    to += alphaStep;
+                }
+            } else {
+                for ( uint x = 0; x < p_width; x++ ) {
+                    *to = 0xff;
+                    to += alphaStep;
+                }
+            }
+        }
+    };
+
+    namespace {
+
+        /** Head of a converted image in the entry cache, followed by the
+        *  colors and, if any, the alphas. */
+        struct CachedImageHead {
+            uint32  width;
+            uint32  height;
+            uint32  hasAlpha;
+        };
+
+        /** Largest image kept in the entry cache, in pixels. */
+        enum { CachedImage_MaxPixels = 1024 * 1024 };
+
+        /** Determines whether a converted image is worth caching. Block
+        *  compressed textures decode faster than they inflate from the cache,
+        *  and large images cost more to compress than they save. */
+        bool isCachedImage( uint32 p_fourcc, size_t p_numPixels ) {
+            return ( p_fourcc == FCC_RIFF ) && ( p_numPixels <= CachedImage_MaxPixels );
+        }
+
+        /** Gets the decoders for an image of the given reduction. Reduced
+        *  images average the blocks instead. */
+        const DXTDecoder& decodersForScale( ImageReader::ImageScale p_scale ) {
+            return ( p_scale == ImageReader::IS_Full ) ? dxtDecoder( ) : dxtBlockAverager( );
+        }
+
+        /** Reads a big-endian 16-bit value. */
+        uint16 readBigEndian16( const byte* p_data ) {
+            return ( p_data[0] << 8 ) | p_data[1];
+        }
+
+        /** Reads a big-endian 32-bit value. */
+        uint32 readBigEndian32( const byte* p_data ) {
+            return ( static_cast<uint32>( readBigEndian16( p_data ) ) << 16 ) | readBigEndian16( p_data + 2 );
+        }
+
+        /** DXGI formats of the blocks that need a DX10 header in DDS files. */
+        enum DxgiFormat {
+            DXGI_None = 0,
+            DXGI_BC4 = 80,      /**< DXGI_FORMAT_BC4_UNORM */
+            DXGI_BC5 = 83,      /**< DXGI_FORMAT_BC5_UNORM */
+        };
+
+    };
+
     //----------------------------------------------------------------------------
     //      ImageReader
     //----------------------------------------------------------------------------
@@ -149,153 +235,553 @@ namespace gw2b {
         Assert( m_data.GetSize( ) >= 4 );
         Assert( isValidHeader( m_data.GetPointer( ), m_data.GetSize( ) ) );
 
-        // Read the correct type of data
         auto fourcc = *reinterpret_cast<const uint32*>( m_data.GetPointer( ) );
-        if ( ( ( fourcc & 0xffffff ) != FCC_JPEG ) && ( fourcc != FCC_PNG ) ) {
+        if ( ( ( fourcc & 0xffffff ) == FCC_JPEG ) || ( fourcc == FCC_PNG ) ) {
+            return this->readPNGOrJPEG( );
+        }
+
+        wxSize size;
+        bool hasAlpha;
+        if ( !this->getImageInfo( size, hasAlpha ) ) {
+            return wxImage( );
+        }
+
+        // Decode straight into the buffers the image takes over
+        auto numPixels = static_cast<size_t>( size.x ) * size.y;
+        auto colors = allocate<uint8>( numPixels * 3 );
+        auto alphas = hasAlpha ? allocate<uint8>( numPixels ) : nullptr;
+
+        if ( !this->decodeImage( size, hasAlpha, PixelLayout::planar( colors, alphas, size.x ) ) ) {
+            freePointer( colors );
+            freePointer( alphas );
+            return wxImage( );
+        }
+
+        wxImage image( size.x, size.y, colors );
+        if ( alphas ) {
+            image.SetAlpha( alphas );
+        }
+
+        return image;
+    }
 
-            wxSize size;
-            BGR* colors = nullptr;
-            uint8* alphas = nullptr;
+    wxImage ImageReader::getScaledImage( ImageScale p_scale ) const {
+        Assert( m_data.GetSize( ) >= 4 );
+        Assert( isValidHeader( m_data.GetPointer( ), m_data.GetSize( ) ) );
 
-            if ( ( fourcc == FCC_DDS ) ) {
-                if ( !this->readDDS( size, colors, alphas ) ) {
-                    return wxImage( );
+        if ( p_scale == IS_Full ) {
+            return this->getImage( );
+        }
+
+        // Block compressed textures average their blocks, so the full size
+        // image never exists
+        auto fourcc = *reinterpret_cast<const uint32*>( m_data.GetPointer( ) );
+        bool isBlockTexture = ( fourcc != FCC_PNG ) && ( fourcc != FCC_RIFF ) && ( ( fourcc & 0xffffff ) != FCC_JPEG );
+
+        wxSize size;
+        bool hasAlpha;
+        if ( isBlockTexture && this->getImageInfo( size, hasAlpha ) ) {
+            auto scaledSize = scaledBlocksSize( size, p_scale );
+            auto numPixels = static_cast<size_t>( scaledSize.x ) * scaledSize.y;
+
+            if ( numPixels ) {
+                auto colors = allocate<uint8>( numPixels * 3 );
+                auto alphas = hasAlpha ? allocate<uint8>( numPixels ) : nullptr;
+                auto target = PixelLayout::planar( colors, alphas, scaledSize.x );
+
+                bool isDecoded = ( fourcc == FCC_DDS )
+                    ? this->readDDS( p_scale, target )
+                    : this->readATEX( size, p_scale, target );
+                if ( isDecoded ) {
+                    wxImage image( scaledSize.x, scaledSize.y, colors );
+                    if ( alphas ) {
+                        image.SetAlpha( alphas );
+                    }
+                    return image;
                 }
-            } else if ( fourcc == FCC_RIFF ) {  // WebP
-                if ( !this->readWebP( size, colors, alphas ) ) {
-                    return wxImage( );
+
+                freePointer( colors );
+                freePointer( alphas );
+            }
+        }
+
+        // Everything else is decoded whole and then reduced
+        auto image = this->getImage( );
+        if ( image.IsOk( ) ) {
+            image.Rescale( wxMax( image.GetWidth( ) / p_scale, 1 ), wxMax( image.GetHeight( ) / p_scale, 1 ), wxIMAGE_QUALITY_BOX_AVERAGE );
+        }
+        return image;
+    }
+
+    ImageReader::ImageScale ImageReader::scaleForSize( const wxSize& p_size, const wxSize& p_minSize ) {
+        const ImageScale scales[] = { IS_Sixteenth, IS_Eighth, IS_Quarter };
+        for ( auto scale : scales ) {
+            if ( ( p_size.x / scale >= p_minSize.x ) && ( p_size.y / scale >= p_minSize.y ) ) {
+                return scale;
+            }
+        }
+        return IS_Full;
+    }
+
+    bool ImageReader::getImageInfo( wxSize& po_size, bool& po_hasAlpha ) const {
+        if ( m_data.GetSize( ) < 0x10 ) {
+            return false;
+        }
+
+        auto data = m_data.GetPointer( );
+        auto fourcc = *reinterpret_cast<const uint32*>( data );
+
+        if ( fourcc == FCC_PNG ) {
+            // IHDR is always the first chunk. Palettes may have transparency.
+            if ( m_data.GetSize( ) < 26 ) {
+                return false;
+            }
+            po_size.Set( readBigEndian32( data + 16 ), readBigEndian32( data + 20 ) );
+            po_hasAlpha = ( data[25] & 4 ) || ( data[25] == 3 );
+            return true;
+        }
+
+        if ( ( fourcc & 0xffffff ) == FCC_JPEG ) {
+            // Walk the segments until the start of frame
+            size_t pos = 2;
+            while ( pos + 9 <= m_data.GetSize( ) ) {
+                if ( data[pos] != 0xff ) {
+                    return false;
                 }
-            } else {
-                if ( !this->readATEX( size, colors, alphas ) ) {
-                    return wxImage( );
+                auto marker = data[pos + 1];
+                if ( marker == 0xff ) {
+                    pos++;
+                    continue;
+                }
+                // SOF0 to SOF15, except DHT, JPG and DAC
+                if ( ( marker >= 0xc0 ) && ( marker <= 0xcf ) && ( marker != 0xc4 ) && ( marker != 0xc8 ) && ( marker != 0xcc ) ) {
+                    po_size.Set( readBigEndian16( data + pos + 7 ), readBigEndian16( data + pos + 5 ) );
+                    po_hasAlpha = false;
+                    return true;
                 }
+                pos += 2 + readBigEndian16( data + pos + 2 );
             }
+            return false;
+        }
+
+        if ( fourcc == FCC_DDS ) {
+            return this->readDDSInfo( po_size, po_hasAlpha );
+        } else if ( fourcc == FCC_RIFF ) {  // WebP
+            return this->readWebPInfo( po_size, po_hasAlpha );
+        }
+        return this->readATEXInfo( po_size, po_hasAlpha );
+    }
 
-            // Create image and fill it with color data
-            wxImage image( size.x, size.y );
-            image.SetData( reinterpret_cast<unsigned char*>( colors ) );
+    bool ImageReader::getPixels( PixelFormat p_format, byte* po_pixels, size_t p_pitch ) const {
+        Assert( m_data.GetSize( ) >= 4 );
+        Assert( isValidHeader( m_data.GetPointer( ), m_data.GetSize( ) ) );
 
-            // Set alpha if the format has any
-            if ( alphas ) {
-                image.SetAlpha( alphas );
+        auto target = PixelLayout::interleaved( po_pixels, p_pitch, p_format == PF_BGRA8 );
+
+        auto fourcc = *reinterpret_cast<const uint32*>( m_data.GetPointer( ) );
+        if ( ( ( fourcc & 0xffffff ) == FCC_JPEG ) || ( fourcc == FCC_PNG ) ) {
+            // Only wxImage reads these, so convert from its layout
+            auto image = this->readPNGOrJPEG( );
+            if ( !image.IsOk( ) ) {
+                return false;
             }
+            auto source = PixelLayout::planar( image.GetData( ), image.HasAlpha( ) ? image.GetAlpha( ) : nullptr, image.GetWidth( ) );
+            this->convertPixels( source, target, image.GetWidth( ), image.GetHeight( ) );
+            return true;
+        }
+
+        wxSize size;
+        bool hasAlpha;
+        if ( !this->getImageInfo( size, hasAlpha ) ) {
+            return false;
+        }
+        return this->decodeImage( size, hasAlpha, target );
+    }
 
-            return image;
+    bool ImageReader::decodeImage( const wxSize& p_size, bool p_hasAlpha, const PixelLayout& p_target ) const {
+        auto fourcc = *reinterpret_cast<const uint32*>( m_data.GetPointer( ) );
+        auto numPixels = static_cast<size_t>( p_size.x ) * p_size.y;
+
+        // Converted before? Keyed by the MFT fields of the entry, so a changed
+        // entry is converted again.
+        auto cache = isCachedImage( fourcc, numPixels ) ? m_datFile.entryCache( ) : nullptr;
+        DatEntryCacheKey cacheKey;
+        if ( cache && !m_datFile.entryCacheKey( m_entryNum, cacheKey ) ) {
+            cache = nullptr;
+        }
+        if ( cache ) {
+            cacheKey.kind = DECK_Image;
+
+            auto cached = cache->read( cacheKey );
+            if ( cached.GetSize( ) >= sizeof( CachedImageHead ) ) {
+                auto head = reinterpret_cast<const CachedImageHead*>( cached.GetPointer( ) );
+                if ( ( head->width == static_cast<uint32>( p_size.x ) ) && ( head->height == static_cast<uint32>( p_size.y ) ) &&
+                    ( cached.GetSize( ) == sizeof( *head ) + numPixels * ( head->hasAlpha ? 4 : 3 ) ) ) {
+                    auto colors = cached.GetPointer( ) + sizeof( *head );
+                    auto source = PixelLayout::planar( colors, head->hasAlpha ? colors + numPixels * 3 : nullptr, p_size.x );
+                    this->convertPixels( source, p_target, p_size.x, p_size.y );
+                    return true;
+                }
+            }
+        }
 
+        // Read the correct type of data
+        bool isDecoded;
+        if ( fourcc == FCC_DDS ) {
+            isDecoded = this->readDDS( IS_Full, p_target );
+        } else if ( fourcc == FCC_RIFF ) {  // WebP
+            isDecoded = this->readWebP( p_size, p_target );
         } else {
-            wxImage image;
-            wxMemoryInputStream stream( m_data.GetPointer( ), m_data.GetSize( ) );
-            if ( fourcc == FCC_PNG ) {
-                image.LoadFile( stream, wxBITMAP_TYPE_PNG );
-            } else {    // JPEGs
-                image.LoadFile( stream, wxBITMAP_TYPE_JPEG );
+            isDecoded = this->readATEX( p_size, IS_Full, p_target );
+        }
+
+        if ( !isDecoded ) {
+            return false;
+        }
+
+        if ( cache ) {
+            Array<byte> payload( sizeof( CachedImageHead ) + numPixels * ( p_hasAlpha ? 4 : 3 ) );
+            auto head = reinterpret_cast<CachedImageHead*>( payload.GetPointer( ) );
+            head->width = p_size.x;
+            head->height = p_size.y;
+            head->hasAlpha = p_hasAlpha ? 1 : 0;
+
+            auto colors = payload.GetPointer( ) + sizeof( *head );
+            auto layout = PixelLayout::planar( colors, p_hasAlpha ? colors + numPixels * 3 : nullptr, p_size.x );
+            this->convertPixels( p_target, layout, p_size.x, p_size.y );
+            cache->add( cacheKey, payload.GetPointer( ), payload.GetSize( ) );
+        }
+
+        return true;
+    }
+
+    wxImage ImageReader::readPNGOrJPEG( ) const {
+        auto fourcc = *reinterpret_cast<const uint32*>( m_data.GetPointer( ) );
+
+        wxImage image;
+        wxMemoryInputStream stream( m_data.GetPointer( ), m_data.GetSize( ) );
+        if ( fourcc == FCC_PNG ) {
+            image.LoadFile( stream, wxBITMAP_TYPE_PNG );
+        } else {    // JPEGs
+            image.LoadFile( stream, wxBITMAP_TYPE_JPEG );
+        }
+        return image;
+    }
+
+    ImageReader::BlockFormat ImageReader::getBlockFormat( ) const {
+        wxSize size;
+        bool hasAlpha;
+        if ( !this->getImageInfo( size, hasAlpha ) ) {
+            return BF_None;
+        }
+
+        auto fourcc = *reinterpret_cast<const uint32*>( m_data.GetPointer( ) );
+        if ( fourcc == FCC_DDS ) {
+            auto header = reinterpret_cast<const DDSHeader*>( m_data.GetPointer( ) );
+            if ( ( header->pixelFormat.flags & 0x40 ) || !( header->pixelFormat.flags & 0x4 ) ) {
+                return BF_None;
+            }
+            switch ( header->pixelFormat.fourCC ) {
+            case FCC_DXT1:
+                return BF_BC1;
+            case FCC_DXT2:
+            case FCC_DXT3:
+                return BF_BC2;
+            case FCC_DXT4:
+            case FCC_DXT5:
+                return BF_BC3;
+            }
+        } else if ( ( fourcc != FCC_PNG ) && ( fourcc != FCC_RIFF ) && ( ( fourcc & 0xffffff ) != FCC_JPEG ) ) {
+            auto atex = reinterpret_cast<const ANetAtexHeader*>( m_data.GetPointer( ) );
+            switch ( atex->formatInteger ) {
+            case FCC_DXT1:
+                return BF_BC1;
+            case FCC_DXT2:
+            case FCC_DXT3:
+            case FCC_DXTN:
+                return BF_BC2;
+            case FCC_DXT4:
+            case FCC_DXT5:
+                return BF_BC3;
+            case FCC_DXTA:
+                return BF_BC4;
+            case FCC_3DCX:
+                return BF_BC5;
             }
-            return image;
         }
+
+        // DXTL colors are premultiplied while decoding, so they have no block format
+        return BF_None;
     }
 
-    Array<byte> ImageReader::getDecompressedATEX( ) const {
-        Assert( m_data.GetSize( ) >= 4 );
-        Assert( isValidHeader( m_data.GetPointer( ), m_data.GetSize( ) ) );
+    uint ImageReader::getNumLevels( ) const {
+        if ( m_data.GetSize( ) < sizeof( DDSHeader ) ) {
+            return 1;
+        }
 
         auto fourcc = *reinterpret_cast<const uint32*>( m_data.GetPointer( ) );
-        if ( fourcc == FCC_ATEX ) {
-            auto data = reinterpret_cast<const uint8_t*>( m_data.GetPointer( ) );
-            auto atex = reinterpret_cast<const ANetAtexHeader*>( data );
-            auto format = atex->formatInteger;
+        if ( fourcc == FCC_DDS ) {
+            auto header = reinterpret_cast<const DDSHeader*>( m_data.GetPointer( ) );
+            return wxMax( 1u, header->mipMapCount );
+        }
+        return 1;
+    }
 
-            uint32_t uncompressedSize = this->getUncompressedATEXSize( atex->width, atex->height, format );
-            Array<byte> buffer( uncompressedSize );
+    bool ImageReader::getBlocks( BlockFormat& po_format, wxSize& po_size, Array<byte>& po_blocks, uint* po_numLevels ) const {
+        po_format = this->getBlockFormat( );
+        bool hasAlpha;
+        if ( ( po_format == BF_None ) || !this->getImageInfo( po_size, hasAlpha ) ) {
+            return false;
+        }
 
-            // Decompress
-            try {
-                gw2dt::compression::inflateTextureFileBuffer( m_data.GetSize( ), data, uncompressedSize, reinterpret_cast<uint8_t*>( buffer.GetPointer( ) ) );
-            } catch ( const gw2dt::exception::Exception& err ) {
-                wxLogMessage( wxT( "Failed decompress ATEX texture: %s" ), wxString( err.what( ) ) );
-                return Array<byte>( );
+        uint numLevels = 1;
+        auto fourcc = *reinterpret_cast<const uint32*>( m_data.GetPointer( ) );
+        if ( fourcc == FCC_DDS ) {
+            auto header = reinterpret_cast<const DDSHeader*>( m_data.GetPointer( ) );
+            uint maxLevels = ( po_numLevels && header->mipMapCount > 1 ) ? header->mipMapCount : 1;
+
+            // Take the levels that are all there, down to 1x1 at most
+            size_t dataSize = 0;
+            wxSize levelSize = po_size;
+            for ( numLevels = 0; numLevels < maxLevels; numLevels++ ) {
+                auto levelDataSize = blockDataSize( po_format, levelSize );
+                if ( m_data.GetSize( ) < sizeof( DDSHeader ) + dataSize + levelDataSize ) {
+                    break;
+                }
+                dataSize += levelDataSize;
+                if ( levelSize.x == 1 && levelSize.y == 1 ) {
+                    numLevels++;
+                    break;
+                }
+                levelSize.Set( wxMax( 1, levelSize.x >> 1 ), wxMax( 1, levelSize.y >> 1 ) );
             }
+            if ( !numLevels ) {
+                return false;
+            }
+            po_blocks = Array<byte>( dataSize );
+            ::memcpy( po_blocks.GetPointer( ), &m_data[sizeof( DDSHeader )], dataSize );
+        } else {
+            po_blocks = this->inflateATEX( po_size.x, po_size.y );
+        }
+
+        if ( po_numLevels ) {
+            *po_numLevels = numLevels;
+        }
+        return po_blocks.GetSize( ) > 0;
+    }
+
+    bool ImageReader::getDDS( Array<byte>& po_data ) const {
+        if ( m_data.GetSize( ) < sizeof( uint32 ) ) {
+            return false;
+        }
 
-            return buffer;
+        // Already a DDS file, mip levels and all
+        auto fourcc = *reinterpret_cast<const uint32*>( m_data.GetPointer( ) );
+        if ( fourcc == FCC_DDS ) {
+            po_data = m_data;
+            return true;
+        }
+
+        BlockFormat format;
+        wxSize size;
+        Array<byte> blocks;
+        if ( !this->getBlocks( format, size, blocks ) ) {
+            return false;
+        }
+
+        uint32 blocksFourCC = 0;
+        uint32 dxgiFormat = DXGI_None;
+        switch ( format ) {
+        case BF_BC1:
+            blocksFourCC = FCC_DXT1;
+            break;
+        case BF_BC2:
+            blocksFourCC = FCC_DXT3;
+            break;
+        case BF_BC3:
+            blocksFourCC = FCC_DXT5;
+            break;
+        case BF_BC4:
+            dxgiFormat = DXGI_BC4;
+            break;
+        case BF_BC5:
+            dxgiFormat = DXGI_BC5;
+            // 3DCX stores green before red, BC5 the other way around
+            for ( size_t i = 0; i + 16 <= blocks.GetSize( ); i += 16 ) {
+                std::swap_ranges( &blocks[i], &blocks[i + 8], &blocks[i + 8] );
+            }
+            break;
+        default:
+            return false;
+        }
+        return ImageEncoder::wrapBlocks( size, blocksFourCC, dxgiFormat, blocks.GetPointer( ), blocks.GetSize( ), po_data );
+    }
+
+    uint ImageReader::blockSize( BlockFormat p_format ) {
+        switch ( p_format ) {
+        case BF_BC1:
+        case BF_BC4:
+            return 8;
+        case BF_BC2:
+        case BF_BC3:
+        case BF_BC5:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    size_t ImageReader::blockDataSize( BlockFormat p_format, const wxSize& p_size ) {
+        size_t numBlocks = static_cast<size_t>( ( p_size.x + 3 ) >> 2 ) * ( ( p_size.y + 3 ) >> 2 );
+        return numBlocks * blockSize( p_format );
+    }
+
+    Array<byte> ImageReader::inflateATEX( uint16 p_width, uint16 p_height ) const {
+        auto data = reinterpret_cast<const uint8_t*>( m_data.GetPointer( ) );
+        auto atex = reinterpret_cast<const ANetAtexHeader*>( data );
+
+        uint32_t uncompressedSize = this->getUncompressedATEXSize( p_width, p_height, atex->formatInteger );
+        if ( !uncompressedSize ) {
+            return Array<byte>( );
+        }
+        Array<byte> buffer( uncompressedSize );
+
+        // Decompress
+#if GW2B_INTREE_INFLATE
+        if ( !inflateTextureBuffer( m_data.GetSize( ), data, uncompressedSize, buffer.GetPointer( ) ) ) {
+            wxLogMessage( wxT( "Failed decompress ATEX texture." ) );
+            return Array<byte>( );
+        }
+#else
+        try {
+            gw2dt::compression::inflateTextureFileBuffer( m_data.GetSize( ), data, uncompressedSize, reinterpret_cast<uint8_t*>( buffer.GetPointer( ) ) );
+        } catch ( const gw2dt::exception::Exception& err ) {
+            wxLogMessage( wxT( "Failed decompress ATEX texture: %s" ), wxString( err.what( ) ) );
+            return Array<byte>( );
         }
+#endif
 
-        return Array<byte>( );
+        return buffer;
     }
 
-    bool ImageReader::readDDS( wxSize& po_size, BGR*& po_colors, uint8*& po_alphas ) const {
+    bool ImageReader::readDDSInfo( wxSize& po_size, bool& po_hasAlpha ) const {
         // Get header
         auto header = reinterpret_cast<const DDSHeader*>( m_data.GetPointer( ) );
 
         // Ensure some of the values are correct
-        if ( header->magic != FCC_DDS ||
+        if ( m_data.GetSize( ) < sizeof( DDSHeader ) ||
+            header->magic != FCC_DDS ||
             header->size != sizeof( DDSHeader ) -4 ||
             header->pixelFormat.size != sizeof( DDSPixelFormat ) ) {
             return false;
         }
 
-        po_colors = nullptr;
-        po_alphas = nullptr;
+        size_t numPixels = static_cast<size_t>( header->width ) * header->height;
+        size_t numBlocks = static_cast<size_t>( header->width >> 2 ) * ( header->height >> 2 );
+        size_t dataSize;
 
         // Determine the pixel format
         if ( header->pixelFormat.flags & 0x40 ) {               // 0x40 = DDPF_RGB, uncompressed data
-            if ( !this->processUncompressedDDS( header, reinterpret_cast<RGB*&>( po_colors ), po_alphas ) ) {
+            // Ensure the image is 32-bit. Until a non-32 bit texture is found,
+            // there's no point adding support for it
+            if ( header->pixelFormat.rgbBitCount != 32 ) {
                 return false;
             }
+            dataSize = numPixels * 4;
+            po_hasAlpha = !!( header->pixelFormat.flags & 0x1 );  // 0x1 = DDPF_ALPHAPIXELS, alpha is present
         } else if ( header->pixelFormat.flags & 0x4 ) {         // 0x4 = DDPF_FOURCC, compressed
-            const BGRA* data = reinterpret_cast<const BGRA*>( &m_data[sizeof( *header )] );
             switch ( header->pixelFormat.fourCC ) {
             case FCC_DXT1:
-                this->processDXT1( data, header->width, header->height, po_colors, po_alphas );
+                dataSize = numBlocks * 8;
                 break;
             case FCC_DXT2:
             case FCC_DXT3:
-                this->processDXT3( data, header->width, header->height, po_colors, po_alphas );
-                break;
             case FCC_DXT4:
             case FCC_DXT5:
-                this->processDXT5( data, header->width, header->height, po_colors, po_alphas );
-                break;
-            case FCC_R32F:
+                dataSize = numBlocks * 16;
                 break;
+            default:
+                return false;
             }
+            po_hasAlpha = true;
         } else if ( header->pixelFormat.flags & 0x20000 ) {     // 0x20000 = DDPF_LUMINANCE, single-byte color
-            if ( !this->processLuminanceDDS( header, reinterpret_cast<RGB*&>( po_colors ) ) ) {
+            // Ensure the image is 8-bit
+            if ( header->pixelFormat.rgbBitCount != 8 ) {
                 return false;
             }
+            dataSize = numPixels;
+            po_hasAlpha = false;
+        } else {
+            return false;
         }
 
-        if ( !!po_colors ) {
-            po_size.Set( header->width, header->height );
+        // Image data buffer too small?
+        if ( m_data.GetSize( ) < ( sizeof( *header ) + dataSize ) ) {
+            return false;
         }
 
-        return !!po_colors;
+        po_size.Set( header->width, header->height );
+        return true;
     }
 
-    bool ImageReader::processLuminanceDDS( const DDSHeader* p_header, RGB*& po_colors ) const {
-        // Ensure the image is 8-bit
-        if ( p_header->pixelFormat.rgbBitCount != 8 ) {
-            return false;
-        }
-
-        // Determine the size of the pixel data
-        uint numPixels = p_header->width * p_header->height;
-        uint dataSize = ( numPixels * p_header->pixelFormat.rgbBitCount ) >> 3;
+    bool ImageReader::readDDS( ImageScale p_scale, const PixelLayout& p_target ) const {
+        auto header = reinterpret_cast<const DDSHeader*>( m_data.GetPointer( ) );
 
-        // Image data buffer too small?
-        if ( m_data.GetSize( ) < ( sizeof( *p_header ) + dataSize ) ) {
-            return false;
+        // Determine the pixel format
+        if ( header->pixelFormat.flags & 0x40 ) {               // 0x40 = DDPF_RGB, uncompressed data
+            return ( p_scale == IS_Full ) && this->processUncompressedDDS( header, p_target );
+        } else if ( header->pixelFormat.flags & 0x4 ) {         // 0x4 = DDPF_FOURCC, compressed
+            auto data = &m_data[sizeof( *header )];
+            auto& decoder = decodersForScale( p_scale );
+            switch ( header->pixelFormat.fourCC ) {
+            case FCC_DXT1:
+                this->processBlocks( decoder.dxt1, data, 8, header->width, header->height, true, false, p_scale, p_target );
+                return true;
+            case FCC_DXT2:
+            case FCC_DXT3:
+                this->processBlocks( decoder.dxt3, data, 16, header->width, header->height, true, false, p_scale, p_target );
+                return true;
+            case FCC_DXT4:
+            case FCC_DXT5:
+                this->processBlocks( decoder.dxt5, data, 16, header->width, header->height, true, false, p_scale, p_target );
+                return true;
+            }
+        } else if ( header->pixelFormat.flags & 0x20000 ) {     // 0x20000 = DDPF_LUMINANCE, single-byte color
+            return ( p_scale == IS_Full ) && this->processLuminanceDDS( header, p_target );
         }
 
-        po_colors = allocate<RGB>( numPixels );
+        return false;
+    }
 
-        // Read the data (we've already determined that the data is 8bpp above)
+    bool ImageReader::processLuminanceDDS( const DDSHeader* p_header, const PixelLayout& p_target ) const {
+        // Read the data (we've already determined that the data is 8bpp)
         auto pixelData = static_cast<const uint8*>( &m_data[sizeof( *p_header )] );
 
 #pragma omp parallel for
         for ( int y = 0; y < static_cast<int>( p_header->height ); y++ ) {
+            auto row = p_target.row( y );
+            auto colors = row.colors;
+            auto alphas = row.alphas;
             uint32 curPixel = ( y * p_header->width );
 
+            if ( row.isInterleaved( ) ) {
+                pixelConverter( ).expandGray( &pixelData[curPixel], colors, p_header->width, 4 );
+                continue;
+            } else if ( row.isPlanarRow( ) ) {
+                pixelConverter( ).expandGray( &pixelData[curPixel], colors, p_header->width, 3 );
+                if ( alphas ) {
+                    ::memset( alphas, 0xff, p_header->width );
+                }
+                continue;
+            }
+
             for ( uint x = 0; x < p_header->width; x++ ) {
-                ::memset( &po_colors[curPixel], pixelData[curPixel], sizeof( po_colors[curPixel] ) );
+                ::memset( colors, pixelData[curPixel], 3 );
+                colors += row.colorStep;
+                if ( alphas ) {
+                    *alphas = 0xff;
+                    alphas += row.alphaStep;
+                }
                 curPixel++;
             }
         }
@@ -303,50 +789,62 @@ namespace gw2b {
         return true;
     }
 
-    bool ImageReader::processUncompressedDDS( const DDSHeader* p_header, RGB*& po_colors, uint8*& po_alphas ) const {
-        // Ensure the image is 32-bit. Until a non-32 bit texture is found,
-        // there's no point adding support for it
-        if ( p_header->pixelFormat.rgbBitCount != 32 ) {
-            return false;
-        }
-
-        // Determine the size of the pixel data
-        uint numPixels = p_header->width * p_header->height;
-        uint dataSize = ( numPixels * p_header->pixelFormat.rgbBitCount ) >> 3;
-
-        // Image data buffer too small?
-        if ( m_data.GetSize( ) < ( sizeof( *p_header ) + dataSize ) ) {
-            return false;
-        }
+    bool ImageReader::processUncompressedDDS( const DDSHeader* p_header, const PixelLayout& p_target ) const {
+        const auto& format = p_header->pixelFormat;
 
         // Color data
-        RGBA shift;
-        po_colors = allocate<RGB>( numPixels );
-        shift.r = lowestSetBit( p_header->pixelFormat.rBitMask );
-        shift.g = lowestSetBit( p_header->pixelFormat.gBitMask );
-        shift.b = lowestSetBit( p_header->pixelFormat.bBitMask );
+        uint redShift = lowestSetBit( format.rBitMask );
+        uint greenShift = lowestSetBit( format.gBitMask );
+        uint blueShift = lowestSetBit( format.bBitMask );
 
         // Alpha data
-        bool hasAlpha = ( p_header->pixelFormat.flags & 0x1 );    // 0x1 = DDPF_ALPHAPIXELS, alpha is present
-        if ( hasAlpha ) {
-            po_alphas = allocate<uint8>( numPixels );
-            shift.a = lowestSetBit( p_header->pixelFormat.aBitMask );
-        }
+        bool hasAlpha = !!( format.flags & 0x1 );    // 0x1 = DDPF_ALPHAPIXELS, alpha is present
+        uint alphaShift = hasAlpha ? lowestSetBit( format.aBitMask ) : 0;
 
         // Read the data (we've already determined that the data is 32bpp)
         auto pixelData = reinterpret_cast<const uint32*>( &m_data[sizeof( *p_header )] );
 
+        // Channels of whole bytes only need their bytes reordered
+        auto isByte = []( uint32 p_mask, uint p_shift ) {
+            return !( p_shift & 7 ) && ( p_mask == ( 0xffu << p_shift ) );
+        };
+        bool isByteAligned = isByte( format.rBitMask, redShift ) && isByte( format.gBitMask, greenShift ) &&
+            isByte( format.bBitMask, blueShift ) && ( !hasAlpha || isByte( format.aBitMask, alphaShift ) );
+
 #pragma omp parallel for
         for ( int y = 0; y < static_cast<int>( p_header->height ); y++ ) {
+            auto row = p_target.row( y );
+            auto colors = row.colors;
+            auto alphas = row.alphas;
+            const uint red = row.isBGR ? 2 : 0;
             uint32 curPixel = ( y * p_header->width );
 
-            for ( uint x = 0; x < p_header->width; x++ ) {
-                po_colors[curPixel].r = ( pixelData[curPixel] & p_header->pixelFormat.rBitMask ) >> shift.r;
-                po_colors[curPixel].g = ( pixelData[curPixel] & p_header->pixelFormat.gBitMask ) >> shift.g;
-                po_colors[curPixel].b = ( pixelData[curPixel] & p_header->pixelFormat.bBitMask ) >> shift.b;
+            if ( isByteAligned && ( row.isInterleaved( ) || row.isPlanarRow( ) ) ) {
+                auto pixels = reinterpret_cast<const uint8*>( &pixelData[curPixel] );
+                const uint8 order[4] = {
+                    static_cast<uint8>( ( row.isBGR ? blueShift : redShift ) >> 3 ),
+                    static_cast<uint8>( greenShift >> 3 ),
+                    static_cast<uint8>( ( row.isBGR ? redShift : blueShift ) >> 3 ),
+                    static_cast<uint8>( hasAlpha ? ( alphaShift >> 3 ) : 4 ),
+                };
+                if ( row.isInterleaved( ) ) {
+                    pixelConverter( ).swizzle( pixels, colors, p_header->width, order );
+                } else {
+                    pixelConverter( ).splitAlpha( pixels, colors, alphas, p_header->width, order );
+                }
+                continue;
+            }
 
-                if ( hasAlpha ) {
-                    po_alphas[curPixel] = ( pixelData[curPixel] & p_header->pixelFormat.aBitMask ) >> shift.a;
+            for ( uint x = 0; x < p_header->width; x++ ) {
+                auto pixel = pixelData[curPixel];
+                colors[red] = ( pixel & format.rBitMask ) >> redShift;
+                colors[1] = ( pixel & format.gBitMask ) >> greenShift;
+                colors[2 - red] = ( pixel & format.bBitMask ) >> blueShift;
+                colors += row.colorStep;
+
+                if ( alphas ) {
+                    *alphas = hasAlpha ? ( pixel & format.aBitMask ) >> alphaShift : 0xff;
+                    alphas += row.alphaStep;
                 }
 
                 curPixel++;
@@ -378,26 +876,17 @@ namespace gw2b {
         }
     }
 
-    bool ImageReader::readATEX( wxSize& po_size, BGR*& po_colors, uint8*& po_alphas ) const {
+    bool ImageReader::readATEXInfo( wxSize& po_size, bool& po_hasAlpha ) const {
         // Determine mipmap0 size and bail if the file is too small
-        if ( m_data.GetSize( ) >= sizeof( ANetAtexHeader ) + sizeof( uint32 ) ) {
-            auto mipMap0Size = *reinterpret_cast<const uint32*>( &m_data[sizeof( ANetAtexHeader )] );
-
-            if ( mipMap0Size + sizeof( ANetAtexHeader ) > m_data.GetSize( ) ) {
-                po_size.Set( 0, 0 );
-                return false;
-            }
-        } else {
-            po_size.Set( 0, 0 );
+        if ( m_data.GetSize( ) < sizeof( ANetAtexHeader ) + sizeof( uint32 ) ) {
+            return false;
+        }
+        auto mipMap0Size = *reinterpret_cast<const uint32*>( &m_data[sizeof( ANetAtexHeader )] );
+        if ( mipMap0Size + sizeof( ANetAtexHeader ) > m_data.GetSize( ) ) {
             return false;
         }
 
-        // Init some fields
-        auto data = reinterpret_cast<const uint8_t*>( m_data.GetPointer( ) );
-        auto atex = reinterpret_cast<const ANetAtexHeader*>( data );
-
-        po_colors = nullptr;
-        po_alphas = nullptr;
+        auto atex = reinterpret_cast<const ANetAtexHeader*>( m_data.GetPointer( ) );
 
         uint16 width = atex->width;
         uint16 height = atex->height;
@@ -407,124 +896,120 @@ namespace gw2b {
             width = 128;
         }
 
-        uint32_t uncompressedSize = this->getUncompressedATEXSize( width, height, atex->formatInteger );
+        switch ( atex->formatInteger ) {
+        case FCC_DXT1:
+        case FCC_DXT2:
+        case FCC_DXT3:
+        case FCC_DXTN:
+        case FCC_DXT4:
+        case FCC_DXT5:
+        case FCC_DXTL:
+            po_hasAlpha = true;
+            break;
+        case FCC_DXTA:
+        case FCC_3DCX:
+            po_hasAlpha = false;
+            break;
+        default:
+            return false;
+        }
 
-        // Allocate output
-        auto buffer = allocate<BGRA>( width * height );
+        po_size.Set( width, height );
+        return true;
+    }
 
-        // Decompress
-        try {
-            gw2dt::compression::inflateTextureFileBuffer( m_data.GetSize( ), data, uncompressedSize, reinterpret_cast<uint8_t*>( buffer ) );
-        } catch ( const gw2dt::exception::Exception& err ) {
-            wxLogMessage( wxT( "Failed decompress ATEX texture: %s" ), wxString( err.what( ) ) );
-            freePointer( buffer );
+    bool ImageReader::readATEX( const wxSize& p_size, ImageScale p_scale, const PixelLayout& p_target ) const {
+        // Init some fields
+        auto data = reinterpret_cast<const uint8_t*>( m_data.GetPointer( ) );
+        auto atex = reinterpret_cast<const ANetAtexHeader*>( data );
+
+        uint width = p_size.x;
+        uint height = p_size.y;
+
+        auto blocks = this->inflateATEX( width, height );
+        if ( !blocks.GetSize( ) ) {
             return false;
         }
+        auto buffer = blocks.GetPointer( );
 
+        auto& decoder = decodersForScale( p_scale );
         switch ( atex->formatInteger ) {
         case FCC_DXT1:
-            this->processDXT1( buffer, width, height, po_colors, po_alphas );
+            this->processBlocks( decoder.dxt1, buffer, 8, width, height, true, false, p_scale, p_target );
             break;
         case FCC_DXT2:
         case FCC_DXT3:
         case FCC_DXTN:
-            this->processDXT3( buffer, width, height, po_colors, po_alphas );
+            this->processBlocks( decoder.dxt3, buffer, 16, width, height, true, false, p_scale, p_target );
             break;
         case FCC_DXT4:
         case FCC_DXT5:
-            this->processDXT5( buffer, width, height, po_colors, po_alphas );
+            this->processBlocks( decoder.dxt5, buffer, 16, width, height, true, false, p_scale, p_target );
             break;
         case FCC_DXTA:
-            this->processDXTA( reinterpret_cast<uint64*>( buffer ), width, height, po_colors );
+            this->processBlocks( decoder.dxta, buffer, 8, width, height, false, false, p_scale, p_target );
             break;
         case FCC_DXTL:
-            this->processDXT5( buffer, width, height, po_colors, po_alphas );
-            for ( uint i = 0; i < ( static_cast<uint>( width ) * static_cast<uint>( height ) ); i++ ) {
-                po_colors[i].r = ( po_colors[i].r * po_alphas[i] ) / 0xff;
-                po_colors[i].g = ( po_colors[i].g * po_alphas[i] ) / 0xff;
-                po_colors[i].b = ( po_colors[i].b * po_alphas[i] ) / 0xff;
-            }
+            this->processBlocks( decoder.dxt5, buffer, 16, width, height, true, true, p_scale, p_target );
             break;
         case FCC_3DCX:
-            this->process3DCX( reinterpret_cast<RGBA*>( buffer ), width, height, po_colors, po_alphas );
+            // Red and green of normals, blue is computed from them
+            this->processBlocks( decoder.dcx, buffer, 16, width, height, false, false, p_scale, p_target );
             break;
         default:
-            freePointer( buffer );
             return false;
-
-        }
-
-        freePointer( buffer );
-
-        if ( po_colors ) {
-            po_size.Set( width, height );
-            return true;
         }
 
-        return false;
+        return true;
     }
 
-    bool ImageReader::readWebP( wxSize& po_size, BGR*& po_colors, uint8*& po_alphas ) const {
-        // Init some fields
-        auto data = reinterpret_cast<const uint8_t*>( m_data.GetPointer( ) );
-        size_t data_size = m_data.GetSize( );
-        po_colors = nullptr;
-        po_alphas = nullptr;
-
-        WebPDecoderConfig config;
-        WebPBitstreamFeatures* bitstream = &config.input;
-
-        VP8StatusCode status = VP8_STATUS_OK;
-
-        status = WebPGetFeatures( reinterpret_cast<const uint8_t*>( data ), data_size, bitstream );
-
-        if ( status != VP8_STATUS_OK ) {
+    bool ImageReader::readWebPInfo( wxSize& po_size, bool& po_hasAlpha ) const {
+        WebPBitstreamFeatures features;
+        if ( WebPGetFeatures( reinterpret_cast<const uint8_t*>( m_data.GetPointer( ) ), m_data.GetSize( ), &features ) != VP8_STATUS_OK ) {
             wxLogMessage( wxT( "This file isn't WebP!" ) );
             return false;
         }
 
-        if ( bitstream->has_animation ) {
+        if ( features.has_animation ) {
             wxLogMessage( wxT( "Not support Animation WebP." ) );
             return false;
         }
 
-        uint numPixels = bitstream->width * bitstream->height;
+        po_size.Set( features.width, features.height );
+        po_hasAlpha = !!features.has_alpha;
+        return true;
+    }
 
-        // Why it need to convert RGB to BGR?
-        auto decoded_data = reinterpret_cast<BGRA*>( WebPDecodeRGBA( data, data_size, nullptr, nullptr ) );
+    bool ImageReader::readWebP( const wxSize& p_size, const PixelLayout& p_target ) const {
+        auto data = reinterpret_cast<const uint8_t*>( m_data.GetPointer( ) );
+        size_t dataSize = m_data.GetSize( );
+
+        // libwebp can write 4 byte pixels itself
+        if ( p_target.isInterleaved( ) ) {
+            auto outputSize = p_target.colorPitch * p_size.y;
+            auto output = p_target.isBGR
+                ? WebPDecodeBGRAInto( data, dataSize, p_target.colors, outputSize, static_cast<int>( p_target.colorPitch ) )
+                : WebPDecodeRGBAInto( data, dataSize, p_target.colors, outputSize, static_cast<int>( p_target.colorPitch ) );
+            if ( !output ) {
+                wxLogMessage( wxT( "Invalid WebP file format." ) );
+                return false;
+            }
+            return true;
+        }
 
-        if ( decoded_data == nullptr ) {
+        int width;
+        int height;
+        auto decoded = WebPDecodeRGBA( data, dataSize, &width, &height );
+        if ( !decoded ) {
             wxLogMessage( wxT( "Invalid WebP file format." ) );
             return false;
         }
 
-        po_colors = allocate<BGR>( numPixels );
-        po_alphas = allocate<uint8>( numPixels );
-
-#pragma omp parallel for
-        for ( int y = 0; y < static_cast<int>( bitstream->height ); y++ ) {
-            uint32 curPixel = ( y * bitstream->width );
-
-            for ( uint x = 0; x < static_cast<uint>( bitstream->width ); x++ ) {
-                ::memcpy( &po_colors[curPixel].b, &decoded_data[curPixel].b, sizeof( po_colors[curPixel].b ) );
-                ::memcpy( &po_colors[curPixel].g, &decoded_data[curPixel].g, sizeof( po_colors[curPixel].g ) );
-                ::memcpy( &po_colors[curPixel].r, &decoded_data[curPixel].r, sizeof( po_colors[curPixel].r ) );
-
-                if ( bitstream->has_alpha ) {
-                    ::memcpy( &po_alphas[curPixel], &decoded_data[curPixel].a, sizeof( po_alphas[curPixel] ) );
-                }
-                curPixel++;
-            }
-        }
-
-        WebPFree( decoded_data );
-
-        if ( po_colors ) {
-            po_size.Set( bitstream->width, bitstream->height );
-            return true;
-        }
+        auto source = PixelLayout::interleaved( decoded, static_cast<size_t>( width ) * 4, false );
+        this->convertPixels( source, p_target, width, height );
 
-        return false;
+        WebPFree( decoded );
+        return true;
     }
 
     bool ImageReader::isValidHeader( const byte* p_data, size_t p_size ) {
@@ -587,328 +1072,132 @@ namespace gw2b {
         return false;
     }
 
-    void ImageReader::processDXTColor( BGR* p_colors, uint8* p_alphas, const DXTColor& p_blockColor, bool p_isDXT1 ) const {
-        // Color 0
-        p_colors[0].r = ( p_blockColor.red1 << 3 ) | ( p_blockColor.red1 >> 2 );
-        p_colors[0].g = ( p_blockColor.green1 << 2 ) | ( p_blockColor.green1 >> 4 );
-        p_colors[0].b = ( p_blockColor.blue1 << 3 ) | ( p_blockColor.blue1 >> 2 );
-        // Color 1
-        p_colors[1].r = ( p_blockColor.red2 << 3 ) | ( p_blockColor.red2 >> 2 );
-        p_colors[1].g = ( p_blockColor.green2 << 2 ) | ( p_blockColor.green2 >> 4 );
-        p_colors[1].b = ( p_blockColor.blue2 << 3 ) | ( p_blockColor.blue2 >> 2 );
-        // Colors 2 and 3
-        if ( !p_isDXT1 || p_blockColor.color1 > p_blockColor.color2 ) {
-            p_colors[2].r = ( p_colors[0].r * 2 + p_colors[1].r ) / 3;
-            p_colors[2].g = ( p_colors[0].g * 2 + p_colors[1].g ) / 3;
-            p_colors[2].b = ( p_colors[0].b * 2 + p_colors[1].b ) / 3;
-            p_colors[3].r = ( p_colors[0].r + p_colors[1].r * 2 ) / 3;
-            p_colors[3].g = ( p_colors[0].g + p_colors[1].g * 2 ) / 3;
-            p_colors[3].b = ( p_colors[0].b + p_colors[1].b * 2 ) / 3;
-            // Alpha is only being set for DXT1
-            if ( p_alphas ) {
-                ::memset( p_alphas, 0xff, 4 );
-            }
-        } else {
-            p_colors[2].r = ( p_colors[0].r + p_colors[1].r ) >> 1;
-            p_colors[2].g = ( p_colors[0].g + p_colors[1].g ) >> 1;
-            p_colors[2].b = ( p_colors[0].b + p_colors[1].b ) >> 1;
-            ::memset( &p_colors[3], 0, sizeof( p_colors[3] ) );
-            // Alpha is only being set for DXT1
-            if ( p_alphas ) {
-                ::memset( p_alphas, 0xff, 3 );
-                p_alphas[3] = 0x0;
-            }
-        }
-    }
-
-    void ImageReader::processDXT1( const BGRA* p_data, uint p_width, uint p_height, BGR*& po_colors, uint8*& po_alphas ) const {
-        uint numPixels = ( p_width * p_height );
-
-        const DXT1Block* blocks = reinterpret_cast<const DXT1Block*>( p_data );
-
-        po_colors = allocate<BGR>( numPixels );
-        po_alphas = allocate<uint8>( numPixels );
-
-        const uint numHorizBlocks = p_width >> 2;
-        const uint numVertBlocks = p_height >> 2;
-
-#pragma omp parallel for
-        for ( int y = 0; y < static_cast<int>( numVertBlocks ); y++ ) {
-            for ( uint x = 0; x < numHorizBlocks; x++ ) {
-                const DXT1Block& block = blocks[( y * numHorizBlocks ) + x];
-                this->processDXT1Block( po_colors, po_alphas, block, x * 4, y * 4, p_width );
-            }
-        }
+    wxSize ImageReader::scaledBlocksSize( const wxSize& p_size, ImageScale p_scale ) {
+        // Every pixel averages the blocks it covers, partial ones at the edges too
+        const uint blocksPerPixel = p_scale >> 2;
+        return wxSize( ( ( p_size.x >> 2 ) + blocksPerPixel - 1 ) / blocksPerPixel, ( ( p_size.y >> 2 ) + blocksPerPixel - 1 ) / blocksPerPixel );
     }
 
-    void ImageReader::processDXT1Block( BGR* p_colors, uint8* p_alphas, const DXT1Block& p_block, uint p_blockX, uint p_blockY, uint p_width ) const {
-        uint32 indices = p_block.indices;
-        BGR colors[4];
-        uint8 alphas[4];
-
-        this->processDXTColor( colors, alphas, p_block.colors, true );
-
-        for ( uint y = 0; y < 4; y++ ) {
-            uint curPixel = ( p_blockY + y ) * p_width + p_blockX;
+    void ImageReader::processBlocks( DXTRowDecoder p_decoder, const void* p_data, uint p_blockSize, uint p_width, uint p_height,
+        bool p_hasAlpha, bool p_premultiply, ImageScale p_scale, const PixelLayout& p_target ) const {
+        auto blocks = reinterpret_cast<const byte*>( p_data );
 
-            for ( uint x = 0; x < 4; x++ ) {
-                BGR& color = p_colors[curPixel];
-                uint8& alpha = p_alphas[curPixel];
-
-                uint index = ( indices & 3 );
-                ::memcpy( &color, &colors[index], sizeof( color ) );
-                alpha = alphas[index];
-
-                curPixel++;
-                indices >>= 2;
-            }
+        if ( p_scale != IS_Full ) {
+            this->averageBlocks( p_decoder, blocks, p_blockSize, p_width, p_height, p_hasAlpha, p_premultiply, p_scale, p_target );
+            return;
         }
-    }
-
-    void ImageReader::processDXTA( const uint64* p_data, uint p_width, uint p_height, BGR*& po_colors ) const {
-        uint numPixels = ( p_width * p_height );
-
-        po_colors = allocate<BGR>( numPixels );
 
         const uint numHorizBlocks = p_width >> 2;
         const uint numVertBlocks = p_height >> 2;
+        const uint rowWidth = numHorizBlocks * 4;
 
+        // Decode straight into the target if it has the layout of the decoders
+        if ( p_target.isPlanar( p_width ) && ( p_target.alphas || !p_hasAlpha ) ) {
 #pragma omp parallel for
-        for ( int y = 0; y < static_cast<int>( numVertBlocks ); y++ ) {
-            for ( uint x = 0; x < numHorizBlocks; x++ ) {
-                uint64 block = p_data[( y * numHorizBlocks ) + x];
-                this->processDXTABlock( po_colors, block, x * 4, y * 4, p_width );
-            }
-        }
-    }
-
-    void ImageReader::processDXTABlock( BGR* p_colors, uint64 p_block, uint p_blockX, uint p_blockY, uint p_width ) const {
-        uint8  alphas[8];
-
-        // Alpha 1 and 2
-        alphas[0] = ( p_block & 0xff );
-        alphas[1] = ( p_block & 0xff00 ) >> 8;
-        p_block >>= 16;
-        // Alpha 3 to 8
-        if ( alphas[0] > alphas[1] ) {
-            for ( uint i = 2; i < 8; i++ ) {
-                alphas[i] = ( ( 8 - i ) * alphas[0] + ( i - 1 ) * alphas[1] ) / 7;
-            }
-        } else {
-            for ( uint i = 2; i < 6; i++ ) {
-                alphas[i] = ( ( 6 - i ) * alphas[0] + ( i - 1 ) * alphas[1] ) / 5;
-            }
-            alphas[6] = 0x00;
-            alphas[7] = 0xff;
-        }
-
-        for ( uint y = 0; y < 4; y++ ) {
-            uint curPixel = ( p_blockY + y ) * p_width + p_blockX;
-
-            for ( uint x = 0; x < 4; x++ ) {
-                ::memset( &p_colors[curPixel], alphas[p_block & 0x7], sizeof( p_colors[curPixel] ) );
-                curPixel++;
-                p_block >>= 3;
-            }
-        }
-    }
-
-    void ImageReader::processDXT3( const BGRA* p_data, uint p_width, uint p_height, BGR*& po_colors, uint8*& po_alphas ) const {
-        uint numPixels = ( p_width * p_height );
-        const DXT3Block* blocks = reinterpret_cast<const DXT3Block*>( p_data );
-
-        po_colors = allocate<BGR>( numPixels );
-        po_alphas = allocate<uint8>( numPixels );
-
-        const uint numHorizBlocks = p_width >> 2;
-        const uint numVertBlocks = p_height >> 2;
-
-#pragma omp parallel for
-        for ( int y = 0; y < static_cast<int>( numVertBlocks ); y++ ) {
-            for ( uint x = 0; x < numHorizBlocks; x++ ) {
-                const DXT3Block& block = blocks[( y * numHorizBlocks ) + x];
-                this->processDXT3Block( po_colors, po_alphas, block, x * 4, y * 4, p_width );
+            for ( int y = 0; y < static_cast<int>( numVertBlocks ); y++ ) {
+                auto target = p_target.row( y * 4 );
+                p_decoder( blocks + static_cast<size_t>( y ) * numHorizBlocks * p_blockSize, numHorizBlocks, target.colors, target.alphas, p_width );
+
+                if ( p_premultiply ) {
+                    for ( uint i = 0; i < 4; i++ ) {
+                        pixelConverter( ).premultiply( target.colors + i * target.colorPitch, target.alphas + i * target.alphaPitch, rowWidth );
+                    }
+                }
             }
+            return;
         }
-    }
-
-    void ImageReader::processDXT3Block( BGR* p_colors, uint8* p_alphas, const DXT3Block& p_block, uint p_blockX, uint p_blockY, uint p_width ) const {
-        uint32 indices = p_block.indices;
-        uint64 blockAlpha = p_block.alpha;
-        BGR colors[4];
-
-        this->processDXTColor( colors, nullptr, p_block.colors, false );
-
-        for ( uint y = 0; y < 4; y++ ) {
-            uint curPixel = ( p_blockY + y ) * p_width + p_blockX;
-
-            for ( uint x = 0; x < 4; x++ ) {
-                BGR& color = p_colors[curPixel];
-                uint8& alpha = p_alphas[curPixel];
 
-                uint index = ( indices & 3 );
-                ::memcpy( &color, &colors[index], sizeof( color ) );
-                alpha = ( ( blockAlpha & 0xf ) << 4 ) | ( blockAlpha & 0xf );
-
-                curPixel++;
-                indices >>= 2;
-                blockAlpha >>= 4;
+        // Otherwise decode a row of blocks at a time into a buffer small enough
+        // to stay in cache, and write it to the target from there
+#pragma omp parallel
+        {
+            Array<uint8> buffer( static_cast<size_t>( rowWidth ) * 4 * 4 );
+            auto colors = buffer.GetPointer( );
+            auto alphas = colors + rowWidth * 4 * 3;
+            auto source = PixelLayout::planar( colors, p_hasAlpha ? alphas : nullptr, rowWidth );
+
+#pragma omp for
+            for ( int y = 0; y < static_cast<int>( numVertBlocks ); y++ ) {
+                p_decoder( blocks + static_cast<size_t>( y ) * numHorizBlocks * p_blockSize, numHorizBlocks, colors, alphas, rowWidth );
+
+                for ( uint i = 0; i < 4; i++ ) {
+                    if ( p_premultiply ) {
+                        pixelConverter( ).premultiply( colors + i * rowWidth * 3, alphas + i * rowWidth, rowWidth );
+                    }
+                    p_target.row( y * 4 + i ).copyRow( source.row( i ), rowWidth );
+                }
             }
         }
     }
 
-    void ImageReader::processDXT5( const BGRA* p_data, uint p_width, uint p_height, BGR*& po_colors, uint8*& po_alphas ) const {
-        uint numPixels = ( p_width * p_height );
-        const DXT3Block* blocks = reinterpret_cast<const DXT3Block*>( p_data );
-
-        po_colors = allocate<BGR>( numPixels );
-        po_alphas = allocate<uint8>( numPixels );
-
+    void ImageReader::averageBlocks( DXTRowDecoder p_averager, const byte* p_blocks, uint p_blockSize, uint p_width, uint p_height,
+        bool p_hasAlpha, bool p_premultiply, ImageScale p_scale, const PixelLayout& p_target ) const {
         const uint numHorizBlocks = p_width >> 2;
         const uint numVertBlocks = p_height >> 2;
+        const uint blocksPerPixel = p_scale >> 2;
+        const auto size = scaledBlocksSize( wxSize( p_width, p_height ), p_scale );
+
+#pragma omp parallel
+        {
+            // A pixel per block, and the sums of the blocks of each target pixel
+            Array<uint8> buffer( static_cast<size_t>( numHorizBlocks ) * 4 + static_cast<size_t>( size.x ) * 4 );
+            Array<uint> sums( static_cast<size_t>( size.x ) * 4 );
+            auto colors = buffer.GetPointer( );
+            auto alphas = colors + numHorizBlocks * 3;
+            auto rowColors = alphas + numHorizBlocks;
+            auto rowAlphas = rowColors + size.x * 3;
+            auto source = PixelLayout::planar( rowColors, p_hasAlpha ? rowAlphas : nullptr, size.x );
+
+#pragma omp for
+            for ( int y = 0; y < size.y; y++ ) {
+                ::memset( sums.GetPointer( ), 0, sums.GetSize( ) * sizeof( uint ) );
+
+                uint firstRow = y * blocksPerPixel;
+                uint numRows = wxMin( blocksPerPixel, numVertBlocks - firstRow );
+                for ( uint i = 0; i < numRows; i++ ) {
+                    p_averager( p_blocks + static_cast<size_t>( firstRow + i ) * numHorizBlocks * p_blockSize, numHorizBlocks, colors, alphas, numHorizBlocks );
+                    if ( p_premultiply ) {
+                        pixelConverter( ).premultiply( colors, alphas, numHorizBlocks );
+                    }
+
+                    for ( uint x = 0; x < numHorizBlocks; x++ ) {
+                        auto sum = &sums[( x / blocksPerPixel ) * 4];
+                        sum[0] += colors[x * 3 + 0];
+                        sum[1] += colors[x * 3 + 1];
+                        sum[2] += colors[x * 3 + 2];
+                        sum[3] += p_hasAlpha ? alphas[x] : 0;
+                    }
+                }
 
-#pragma omp parallel for
-        for ( int y = 0; y < static_cast<int>( numVertBlocks ); y++ ) {
-            for ( uint x = 0; x < numHorizBlocks; x++ ) {
-                const DXT3Block& block = blocks[( y * numHorizBlocks ) + x];
-                this->processDXT5Block( po_colors, po_alphas, block, x * 4, y * 4, p_width );
+                for ( int x = 0; x < size.x; x++ ) {
+                    uint numBlocks = numRows * wxMin( blocksPerPixel, numHorizBlocks - x * blocksPerPixel );
+                    auto sum = &sums[x * 4];
+                    for ( uint i = 0; i < 3; i++ ) {
+                        rowColors[x * 3 + i] = static_cast<uint8>( ( sum[i] + numBlocks / 2 ) / numBlocks );
+                    }
+                    rowAlphas[x] = static_cast<uint8>( ( sum[3] + numBlocks / 2 ) / numBlocks );
+                }
+                p_target.row( y ).copyRow( source, size.x );
             }
         }
     }
 
-    void ImageReader::processDXT5Block( BGR* p_colors, uint8* p_alphas, const DXT3Block& p_block, uint p_blockX, uint p_blockY, uint p_width ) const {
-        uint32 indices = p_block.indices;
-        uint64 blockAlpha = p_block.alpha;
-        BGR    colors[4];
-        uint8  alphas[8];
-
-        this->processDXTColor( colors, nullptr, p_block.colors, false );
-
-        // Alpha 1 and 2
-        alphas[0] = ( blockAlpha & 0xff );
-        alphas[1] = ( blockAlpha & 0xff00 ) >> 8;
-        blockAlpha >>= 16;
-        // Alpha 3 to 8
-        if ( alphas[0] > alphas[1] ) {
-            for ( uint i = 2; i < 8; i++ ) {
-                alphas[i] = ( ( 8 - i ) * alphas[0] + ( i - 1 ) * alphas[1] ) / 7;
-            }
-        } else {
-            for ( uint i = 2; i < 6; i++ ) {
-                alphas[i] = ( ( 6 - i ) * alphas[0] + ( i - 1 ) * alphas[1] ) / 5;
-            }
-            alphas[6] = 0x00;
-            alphas[7] = 0xff;
-        }
-
-        for ( uint y = 0; y < 4; y++ ) {
-            uint curPixel = ( p_blockY + y ) * p_width + p_blockX;
-
-            for ( uint x = 0; x < 4; x++ ) {
-                BGR& color = p_colors[curPixel];
-                uint8& alpha = p_alphas[curPixel];
-
-                uint index = ( indices & 3 );
-                ::memcpy( &color, &colors[index], sizeof( color ) );
-                alpha = alphas[blockAlpha & 7];
-
-                curPixel++;
-                indices >>= 2;
-                blockAlpha >>= 3;
+    void ImageReader::convertPixels( const PixelLayout& p_from, const PixelLayout& p_to, uint p_width, uint p_height ) const {
+        // Same layout, plain copy
+        if ( p_from.isPlanar( p_width ) && p_to.isPlanar( p_width ) ) {
+            auto numPixels = static_cast<size_t>( p_width ) * p_height;
+            ::memcpy( p_to.colors, p_from.colors, numPixels * 3 );
+            if ( p_to.alphas && p_from.alphas ) {
+                ::memcpy( p_to.alphas, p_from.alphas, numPixels );
+            } else if ( p_to.alphas ) {
+                ::memset( p_to.alphas, 0xff, numPixels );
             }
+            return;
         }
-    }
-
-    void ImageReader::process3DCX( const RGBA* p_data, uint p_width, uint p_height, BGR*& po_colors, uint8*& po_alphas ) const {
-        uint numPixels = ( p_width * p_height );
-        const DCXBlock* blocks = reinterpret_cast<const DCXBlock*>( p_data );
-
-        po_colors = allocate<BGR>( numPixels );
-        po_alphas = nullptr; // 3DCX does not use alpha
-
-        const uint numHorizBlocks = p_width >> 2;
-        const uint numVertBlocks = p_height >> 2;
 
 #pragma omp parallel for
-        for ( int y = 0; y < static_cast<int>( numVertBlocks ); y++ ) {
-            for ( uint x = 0; x < numHorizBlocks; x++ ) {
-                const DCXBlock& block = blocks[( y * numHorizBlocks ) + x];
-                // 3DCX actually uses RGB and not BGR, so *pretend* that's what the output is
-                this->process3DCXBlock( reinterpret_cast<RGB*>( po_colors ), block, x * 4, y * 4, p_width );
-            }
-        }
-    }
-
-    void ImageReader::process3DCXBlock( RGB* p_colors, const DCXBlock& p_block, uint p_blockX, uint p_blockY, uint p_width ) const {
-        const float floatToByte = 127.5f;
-        const float byteToFloat = ( 1.0f / floatToByte );
-
-        uint64 red = p_block.red;
-        uint64 green = p_block.green;
-        uint8 reds[8];
-        uint8 greens[8];
-
-        // Reds 1 and 2
-        reds[0] = ( red & 0xff );
-        reds[1] = ( red & 0xff00 ) >> 8;
-        red >>= 16;
-        // Reds 3 to 8
-        if ( reds[0] > reds[1] ) {
-            for ( uint i = 2; i < 8; i++ ) {
-                reds[i] = ( ( 8 - i ) * reds[0] + ( i - 1 ) * reds[1] ) / 7;
-            }
-        } else {
-            for ( uint i = 2; i < 6; i++ ) {
-                reds[i] = ( ( 6 - i ) * reds[0] + ( i - 1 ) * reds[1] ) / 5;
-            }
-            reds[6] = 0x00;
-            reds[7] = 0xff;
-        }
-        // Greens 1 and 2
-        greens[0] = ( green & 0xff );
-        greens[1] = ( green & 0xff00 ) >> 8;
-        green >>= 16;
-        //Greens 3 to 8
-        if ( greens[0] > greens[1] ) {
-            for ( uint i = 2; i < 8; i++ ) {
-                greens[i] = ( ( 8 - i ) * greens[0] + ( i - 1 ) * greens[1] ) / 7;
-            }
-        } else {
-            for ( uint i = 2; i < 6; i++ ) {
-                greens[i] = ( ( 6 - i ) * greens[0] + ( i - 1 ) * greens[1] ) / 5;
-            }
-            greens[6] = 0x00;
-            greens[7] = 0xff;
-        }
-
-        struct {
-            float r; float g; float b;
-        } normal;
-        for ( uint y = 0; y < 4; y++ ) {
-            uint curPixel = ( p_blockY + y ) * p_width + p_blockX;
-
-            for ( uint x = 0; x < 4; x++ ) {
-                RGB& color = p_colors[curPixel];
-
-                // Get normal
-                normal.r = ( ( float ) reds[red & 7] * byteToFloat ) - 1.0f;
-                normal.g = ( ( float ) greens[green & 7] * byteToFloat ) - 1.0f;
-
-                // Compute blue, based on red/green
-                normal.b = ::sqrt( 1.0f - normal.r * normal.r - normal.g * normal.g );
-
-                // Store normal
-                color.r = ( ( normal.r + 1.0f ) * floatToByte );
-                color.g = ( ( normal.g + 1.0f ) * floatToByte );
-                color.b = ( ( normal.b + 1.0f ) * floatToByte );
-
-                // Invert green as that seems to be the more common format
-                color.g = 0xff - color.g;
-
-                curPixel++;
-                red >>= 3;
-                green >>= 3;
-            }
+        for ( int y = 0; y < static_cast<int>( p_height ); y++ ) {
+            p_to.row( y ).copyRow( p_from.row( y ), p_width );
         }
     }
 
@@ -28,25 +28,40 @@
 #ifndef READERS_IMAGEREADER_H_INCLUDED
 #define READERS_IMAGEREADER_H_INCLUDED
 
+#include "Compression/DXTDecoder.h"
 #include "FileReader.h"
 
-#ifdef RGB
-#  undef RGB    // GOD DAMN MICROSOFT WITH YOUR GOD DAMN MACROS
-#endif
-
 namespace gw2b {
 
     class ImageReader : public FileReader {
-        union BGRA;
-        union RGBA;
-        struct BGR;
-        struct RGB;
-        union DXTColor;
-        struct DXT1Block;
-        struct DXT3Block;
-        struct DCXBlock;
         struct DDSPixelFormat;
         struct DDSHeader;
+        struct PixelLayout;
+
+    public:
+        /** Order of the channels in a pixel, 1 byte per channel. */
+        enum PixelFormat {
+            PF_RGBA8,       /**< Red, green, blue, alpha. */
+            PF_BGRA8,       /**< Blue, green, red, alpha. */
+        };
+
+        /** Block compression of a texture, as the GPU knows it. */
+        enum BlockFormat {
+            BF_None,        /**< Not block compressed, or has to be decoded to be shown. */
+            BF_BC1,         /**< DXT1, colors with 1-bit alpha. */
+            BF_BC2,         /**< DXT2/3/N, colors with 4-bit alpha. */
+            BF_BC3,         /**< DXT4/5, colors with interpolated alpha. */
+            BF_BC4,         /**< DXTA, a single interpolated channel. */
+            BF_BC5,         /**< 3DCX, two interpolated channels. */
+        };
+
+        /** Reduction of the size of a decoded image, in both directions. */
+        enum ImageScale {
+            IS_Full = 1,        /**< All pixels. */
+            IS_Quarter = 4,     /**< A pixel per 4x4 pixels, so per block of a block compressed texture. */
+            IS_Eighth = 8,      /**< A pixel per 8x8 pixels. */
+            IS_Sixteenth = 16,  /**< A pixel per 16x16 pixels. */
+        };
 
     public:
         /** Constructor.
@@ -66,33 +81,92 @@ namespace gw2b {
         /** Gets the image contained in the data owned by this reader.
         *  \return wxImage     Newly created image. */
         wxImage getImage( ) const;
-        /** Gets the uncompressed DXT texture contained in the data owned by this reader.
-        *  \return Array<byte> Newly created DXT texture. */
-        Array<byte> getDecompressedATEX( ) const;
+        /** Gets a reduced size version of the image contained in the data owned
+        *  by this reader. Block compressed textures average their blocks and
+        *  never decode the full size image, other images are decoded and then
+        *  reduced.
+        *  \param[in]  p_scale      Reduction of the size.
+        *  \return wxImage     Newly created image. */
+        wxImage getScaledImage( ImageScale p_scale ) const;
+        /** Gets the largest reduction that keeps an image at least as big as
+        *  the given size, in either direction.
+        *  \param[in]  p_size       Size of the image.
+        *  \param[in]  p_minSize    Size to keep the image at or above.
+        *  \return ImageScale  Reduction to decode the image with. */
+        static ImageScale scaleForSize( const wxSize& p_size, const wxSize& p_minSize );
+        /** Gets the size of the image and whether it has alpha, without decoding it.
+        *  \param[out] po_size      Size of the image, in pixels.
+        *  \param[out] po_hasAlpha  true if the image has an alpha channel.
+        *  \return bool    true if the image can be decoded, false if not. */
+        bool getImageInfo( wxSize& po_size, bool& po_hasAlpha ) const;
+        /** Decodes the image straight into a buffer, 4 bytes per pixel. Images
+        *  without alpha get an alpha of 0xff.
+        *  \param[in]  p_format     Order of the channels to write.
+        *  \param[out] po_pixels    Buffer to write to, at least p_pitch * height bytes.
+        *  \param[in]  p_pitch      Bytes from one row of the buffer to the next.
+        *  \return bool    true if the image was decoded, false if not. */
+        bool getPixels( PixelFormat p_format, byte* po_pixels, size_t p_pitch ) const;
+        /** Gets the block format of the texture, without inflating it.
+        *  \return BlockFormat  Format of the blocks, BF_None if they can't be used as is. */
+        BlockFormat getBlockFormat( ) const;
+        /** Gets the number of mip levels the file stores, without reading them.
+        *  Only DDS files store more than one, ATEX levels are not read.
+        *  \return uint    Number of stored mip levels, at least 1. */
+        uint getNumLevels( ) const;
+        /** Gets the blocks of a block compressed texture without decoding them,
+        *  ready to give to the GPU.
+        *  \param[out] po_format    Format of the blocks.
+        *  \param[out] po_size      Size of the texture, in pixels.
+        *  \param[out] po_blocks    Receives the blocks, a row of blocks at a time.
+        *  \param[out] po_numLevels If given, po_blocks receives all stored mip
+        *                           levels back to back, largest first, and this
+        *                           their amount. Only DDS files store more than one,
+        *                           the inflater only gives the top level of ATEX.
+        *  \return bool    true if successful, false if the texture has no usable blocks. */
+        bool getBlocks( BlockFormat& po_format, wxSize& po_size, Array<byte>& po_blocks, uint* po_numLevels = nullptr ) const;
+        /** Gets the texture as a DDS file without decoding it. DDS entries are
+        *  returned as they are, the others get a header around the blocks of
+        *  their top level, as the inflater only gives that level. 3DCX blocks
+        *  are reordered to BC5's red before green.
+        *  \param[out] po_data      Receives the file.
+        *  \return bool    true if successful, false if the texture has no usable blocks. */
+        bool getDDS( Array<byte>& po_data ) const;
+        /** Gets the size of a block of a block format.
+        *  \param[in]  p_format     Format of the block.
+        *  \return uint    Size of a block in bytes, 0 for BF_None. */
+        static uint blockSize( BlockFormat p_format );
+        /** Gets the size of the blocks of an image, with the partial blocks at
+        *  the edges stored whole.
+        *  \param[in]  p_format     Format of the blocks.
+        *  \param[in]  p_size       Size of the image, in pixels.
+        *  \return size_t  Size of the blocks in bytes, 0 for BF_None. */
+        static size_t blockDataSize( BlockFormat p_format, const wxSize& p_size );
         /** Determines whether the header of this image is valid.
         *  \return bool    true if valid, false if not. */
         static bool isValidHeader( const byte* p_data, size_t p_size );
 
     private:
-        bool readDDS( wxSize& po_size, BGR*& po_colors, uint8*& po_alphas ) const;
+        bool decodeImage( const wxSize& p_size, bool p_hasAlpha, const PixelLayout& p_target ) const;
+        wxImage readPNGOrJPEG( ) const;
+
+        bool readDDSInfo( wxSize& po_size, bool& po_hasAlpha ) const;
+        bool readDDS( ImageScale p_scale, const PixelLayout& p_target ) const;
         size_t getUncompressedATEXSize( const uint16& p_width, const uint16& p_height, const uint32& p_format ) const;
-        bool readATEX( wxSize& po_size, BGR*& po_colors, uint8*& po_alphas ) const;
-        bool readWebP( wxSize& po_size, BGR*& po_colors, uint8*& po_alphas ) const;
-
-        bool processLuminanceDDS( const DDSHeader* p_header, RGB*& po_colors ) const;
-        bool processUncompressedDDS( const DDSHeader* p_header, RGB*& po_colors, uint8*& po_alphas ) const;
-
-        void processDXTColor( BGR* p_colors, uint8* p_alphas, const DXTColor& p_blockColor, bool p_isDXT1 ) const;
-        void processDXT1( const BGRA* p_data, uint p_width, uint p_height, BGR*& po_colors, uint8*& po_alphas ) const;
-        void processDXT1Block( BGR* p_colors, uint8* p_alphas, const DXT1Block& p_block, uint p_blockX, uint p_blockY, uint p_width ) const;
-        void processDXT3( const BGRA* p_data, uint p_width, uint p_height, BGR*& po_colors, uint8*& po_alphas ) const;
-        void processDXT3Block( BGR* p_colors, uint8* p_alphas, const DXT3Block& p_block, uint p_blockX, uint p_blockY, uint p_width ) const;
-        void processDXT5( const BGRA* p_data, uint p_width, uint p_height, BGR*& po_colors, uint8*& po_alphas ) const;
-        void processDXT5Block( BGR* p_colors, uint8* p_alphas, const DXT3Block& p_block, uint p_blockX, uint p_blockY, uint p_width ) const;
-        void processDXTA( const uint64* p_data, uint p_width, uint p_height, BGR*& po_colors ) const;
-        void processDXTABlock( BGR* p_colors, uint64 p_block, uint p_blockX, uint p_blockY, uint p_width ) const;
-        void process3DCX( const RGBA* p_data, uint p_width, uint p_height, BGR*& po_colors, uint8*& po_alphas ) const;
-        void process3DCXBlock( RGB* p_colors, const DCXBlock& p_block, uint p_blockX, uint p_blockY, uint p_width ) const;
+        Array<byte> inflateATEX( uint16 p_width, uint16 p_height ) const;
+        bool readATEXInfo( wxSize& po_size, bool& po_hasAlpha ) const;
+        bool readATEX( const wxSize& p_size, ImageScale p_scale, const PixelLayout& p_target ) const;
+        bool readWebPInfo( wxSize& po_size, bool& po_hasAlpha ) const;
+        bool readWebP( const wxSize& p_size, const PixelLayout& p_target ) const;
+
+        bool processLuminanceDDS( const DDSHeader* p_header, const PixelLayout& p_target ) const;
+        bool processUncompressedDDS( const DDSHeader* p_header, const PixelLayout& p_target ) const;
+
+        static wxSize scaledBlocksSize( const wxSize& p_size, ImageScale p_scale );
+        void processBlocks( DXTRowDecoder p_decoder, const void* p_data, uint p_blockSize, uint p_width, uint p_height,
+            bool p_hasAlpha, bool p_premultiply, ImageScale p_scale, const PixelLayout& p_target ) const;
+        void averageBlocks( DXTRowDecoder p_averager, const byte* p_blocks, uint p_blockSize, uint p_width, uint p_height,
+            bool p_hasAlpha, bool p_premultiply, ImageScale p_scale, const PixelLayout& p_target ) const;
+        void convertPixels( const PixelLayout& p_from, const PixelLayout& p_to, uint p_width, uint p_height ) const;
     }; // class ImageReader
 
 }; // namespace gw2b
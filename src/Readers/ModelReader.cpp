@@ -34,6 +34,8 @@
 
 #include "DatFile.h"
 #include "PackFile.h"
+#include "VertexDecoder.h"
+#include "VertexNormals.h"
 
 namespace gw2b {
 
@@ -41,12 +43,16 @@ namespace gw2b {
     //      GW2ModelData
     //----------------------------------------------------------------------------
 
-    GW2ModelData::GW2ModelData( ) {
+    GW2ModelData::GW2ModelData( )
+        : lodLevel( 0 )
+        , numLodLevels( 1 ) {
     }
 
     GW2ModelData::GW2ModelData( const GW2ModelData& p_other ) {
         meshes.assign( p_other.meshes.begin( ), p_other.meshes.end( ) );
         material.assign( p_other.material.begin( ), p_other.material.end( ) );
+        lodLevel = p_other.lodLevel;
+        numLodLevels = p_other.numLodLevels;
     }
 
     GW2ModelData::~GW2ModelData( ) {
@@ -94,6 +100,11 @@ namespace gw2b {
         return &( m_data->meshes[oldSize] );
     }
 
+    GW2Mesh* GW2Model::editMeshes( ) {
+        this->unShare( );
+        return m_data->meshes.empty( ) ? nullptr : &( m_data->meshes[0] );
+    }
+
     uint GW2Model::numMaterial( ) const {
         return m_data->material.size( );
     }
@@ -119,6 +130,20 @@ namespace gw2b {
         return &( m_data->material[oldSize] );
     }
 
+    uint GW2Model::lodLevel( ) const {
+        return m_data->lodLevel;
+    }
+
+    uint GW2Model::numLodLevels( ) const {
+        return m_data->numLodLevels;
+    }
+
+    void GW2Model::setLodLevel( uint p_lodLevel, uint p_numLodLevels ) {
+        this->unShare( );
+        m_data->lodLevel = p_lodLevel;
+        m_data->numLodLevels = p_numLodLevels;
+    }
+
     void GW2Model::unShare( ) {
         if ( m_data->GetRefCount( ) == 1 ) {
             return;
@@ -158,44 +183,44 @@ namespace gw2b {
     ModelReader::~ModelReader( ) {
     }
 
-    GW2Model ModelReader::getModel( ) const {
+    GW2Model ModelReader::getModel( uint p_lodLevel ) const {
         GW2Model newModel;
 
         // Bail if there is no data to read
         if ( m_data.GetSize( ) == 0 ) {
-            wxLogMessage( wxT( "No data." ) );
+            LogInfo( wxT( "No data." ) );
             return newModel;
         }
 
-        wxLogMessage( wxT( "Reading model file..." ) );
+        LogDebug( wxT( "Reading model file..." ) );
 
         gw2f::pf::ModelPackFile modelPackFile( m_data.GetPointer( ), m_data.GetSize( ) );
 
-        this->readGeometry( newModel, modelPackFile );
+        this->readGeometry( newModel, modelPackFile, p_lodLevel );
         this->readMaterial( newModel, modelPackFile );
 
-        wxLogMessage( wxT( "Finished reading model file." ) );
+        LogDebug( wxT( "Finished reading model file." ) );
 
         return newModel;
     }
 
-    void ModelReader::readGeometry( GW2Model& p_model, gw2f::pf::ModelPackFile& p_modelPackFile ) const {
-        wxLogMessage( wxT( "Reading GOEM chunk..." ) );
+    void ModelReader::readGeometry( GW2Model& p_model, gw2f::pf::ModelPackFile& p_modelPackFile, uint p_lodLevel ) const {
+        LogDebug( wxT( "Reading GOEM chunk..." ) );
 
         std::shared_ptr<gw2f::pf::chunks::ModelFileGeometryV1> geometryChunk;
         try {
             geometryChunk = p_modelPackFile.chunk<gw2f::pf::ModelChunks::Geometry>( );
         } catch ( const gw2f::exception::Exception& exception ) {
-            wxLogMessage( wxT( "Failed to read GEOM chunk using gw2formats: %s" ), wxString( exception.what( ) ) );
+            LogWarning( wxT( "Failed to read GEOM chunk using gw2formats: %s" ), wxString( exception.what( ) ) );
             return;
         } catch ( ... ) {
-            wxLogMessage( wxT( "An unknown error has occurred." ) );
+            LogWarning( wxT( "An unknown error has occurred." ) );
             return;
         }
 
         // Bail if no geometry data
         if ( !geometryChunk ) {
-            wxLogMessage( wxT( "No data." ) );
+            LogInfo( wxT( "No data." ) );
             return;
         }
 
@@ -203,28 +228,38 @@ namespace gw2b {
 
         // Bail if no meshes to read
         if ( !meshCount ) {
-            wxLogMessage( wxT( "No mesh." ) );
+            LogInfo( wxT( "No mesh." ) );
             return;
         }
 
-        wxLogMessage( wxT( "%d mesh(es)." ), meshCount );
+        // Levels of detail are extra index buffers of the meshes, over the
+        // same vertices. Meshes with fewer levels use their last one.
+        auto& meshInfoArray = geometryChunk->meshes;
+        uint numLodLevels = 1;
+        for ( uint i = 0; i < meshCount; i++ ) {
+            numLodLevels = wxMax( numLodLevels, 1 + static_cast<uint>( meshInfoArray[i].geometry->lods.size( ) ) );
+        }
+        uint lodLevel = wxMin( p_lodLevel, numLodLevels - 1 );
+        p_model.setLodLevel( lodLevel, numLodLevels );
+
+        LogInfo( wxT( "%d mesh(es), %d level(s) of detail." ), meshCount, numLodLevels );
 
         // Create storage for submeshes now, so we can parallelize the loop
         GW2Mesh* meshes = p_model.addMeshes( meshCount );
 
-        auto& meshInfoArray = geometryChunk->meshes;
-
         uint verticesCount = 0;
         uint trianglesCount = 0;
 
-#pragma omp parallel for shared( meshes )
+#pragma omp parallel for shared( meshes ) reduction( +:verticesCount, trianglesCount )
         for ( int i = 0; i < static_cast<int>( meshCount ); i++ ) {
             // Fetch mesh info
             auto& meshInfo = meshInfoArray[i];
 
-            // Fetch buffer info
-            auto& vertexInfo = meshInfo.geometry->verts;
-            auto& indicesInfo = meshInfo.geometry->indices;
+            // Fetch buffer info, the indices of the level of detail
+            auto& geometry = *meshInfo.geometry;
+            auto& vertexInfo = geometry.verts;
+            auto meshLodLevel = wxMin( lodLevel, static_cast<uint>( geometry.lods.size( ) ) );
+            auto& indicesInfo = meshLodLevel ? geometry.lods[meshLodLevel - 1] : geometry.indices;
             auto vertexCount = vertexInfo.vertexCount;
             auto indiceCount = indicesInfo.indices.size( );
 
@@ -235,18 +270,25 @@ namespace gw2b {
             mesh.materialIndex = meshInfo.materialIndex;
             mesh.materialName = wxString::FromUTF8( meshInfo.materialName.data( ) );
 
-            // Vertex data
-            if ( vertexCount ) {
-                this->readVertexBuffer( mesh, vertexInfo.mesh.vertices.data( ), vertexCount, static_cast<ANetFlexibleVertexFormat>( vertexInfo.mesh.fvf ) );
+            // Meshes whose vertices do not fit their buffer are left empty
+            auto vertexFormat = static_cast<ANetFlexibleVertexFormat>( vertexInfo.mesh.fvf );
+            if ( static_cast<uint64>( vertexCount ) * vertexSize( vertexFormat ) > vertexInfo.mesh.vertices.size( ) ) {
+                LogWarning( wxT( "Mesh %d: %d vertices do not fit in %d bytes, skipped." ), i, vertexCount,
+                    static_cast<uint>( vertexInfo.mesh.vertices.size( ) ) );
+                vertexCount = 0;
+                indiceCount = 0;
             }
 
-            // DirectX coordinate to OpenGL coordinate by rotate ZY and invert Z
-            this->rotZYinvZ( mesh );
+            // Vertex data, already in OpenGL coordinate
+            if ( vertexCount ) {
+                this->readVertexBuffer( mesh, vertexInfo.mesh.vertices.data( ), vertexCount, vertexFormat );
+            } else {
+                ::memset( &mesh.bounds, 0, sizeof( mesh.bounds ) );
+            }
 
             // Index data
             if ( indiceCount ) {
                 this->readIndexBuffer( mesh, reinterpret_cast<const byte*>( indicesInfo.indices.data( ) ), indiceCount );
-                this->computeBond( mesh, reinterpret_cast<const byte*>( indicesInfo.indices.data( ) ), indiceCount );
             }
 
             if ( mesh.hasNormal ) {
@@ -254,7 +296,7 @@ namespace gw2b {
                 this->normalizeNormals( mesh );
             } else {
                 // Calculate the vertex normal if it not exist
-                this->computeVertexNormals( mesh );
+                computeVertexNormals( mesh.triangles, mesh.vertices );
                 mesh.hasNormal = true;
             }
 
@@ -263,170 +305,17 @@ namespace gw2b {
             trianglesCount += indiceCount;
         }
 
-        wxLogMessage( wxT( "%d vertices." ), verticesCount );
-        wxLogMessage( wxT( "%d triangles." ), trianglesCount );
+        LogInfo( wxT( "%d vertices." ), verticesCount );
+        LogInfo( wxT( "%d triangles." ), trianglesCount );
     }
 
     void ModelReader::readVertexBuffer( GW2Mesh& p_mesh, const byte* p_data, uint p_vertexCount, ANetFlexibleVertexFormat p_vertexFormat ) const {
         p_mesh.vertices.resize( p_vertexCount );
-        uint vertexSize = this->vertexSize( p_vertexFormat );
 
         p_mesh.hasNormal = ( ( p_vertexFormat & ANFVF_Normal ) ? 1 : 0 );
         p_mesh.hasUV = ( ( p_vertexFormat & ( ANFVF_UV32Mask | ANFVF_UV16Mask ) ) ? 1 : 0 );
 
-#pragma omp parallel for
-        for ( int i = 0; i < static_cast<int>( p_vertexCount ); i++ ) {
-            auto pos = &p_data[i * vertexSize];
-            Vertex& vertex = p_mesh.vertices[i];
-            uint uvIndex = 0;
-
-            // Bit 0: Position
-            if ( p_vertexFormat & ANFVF_Position ) {
-                ::memcpy( &vertex.position, pos, sizeof( vertex.position ) );
-                pos += sizeof( vertex.position );
-            }
-            // Bit 1: Weights
-            if ( p_vertexFormat & ANFVF_Weights ) {
-                pos += 4;
-            }
-            // Bit 2: Group
-            if ( p_vertexFormat & ANFVF_Group ) {
-                pos += 4;
-            }
-            // Bit 3: Normal
-            if ( p_vertexFormat & ANFVF_Normal ) {
-                ::memcpy( &vertex.normal, pos, sizeof( vertex.normal ) );
-                pos += sizeof( vertex.normal );
-            }
-            // Bit 4: Color
-            if ( p_vertexFormat & ANFVF_Color ) {
-                pos += sizeof( uint32 );
-            }
-            // Bit 5: Tangent
-            if ( p_vertexFormat & ANFVF_Tangent ) {
-                pos += sizeof( glm::vec3 );
-            }
-            // Bit 6: Bitangent
-            if ( p_vertexFormat & ANFVF_Bitangent ) {
-                pos += sizeof( glm::vec3 );
-            }
-            // Bit 7: Tangent frame
-            if ( p_vertexFormat & ANFVF_TangentFrame ) {
-                pos += sizeof( glm::vec3 );
-            }
-            // Bit 8-15: 32-bit UV
-            uint uvFlag = ( p_vertexFormat & ANFVF_UV32Mask ) >> 8;
-            if ( uvFlag ) {
-                for ( uint j = 0; j < 7; j++ ) {
-                    if ( ( ( uvFlag >> j ) & 1 ) == 0 ) {
-                        continue;
-                    }
-                    if ( uvIndex < 1 ) {
-                        ::memcpy( &vertex.uv, pos, sizeof( vertex.uv ) );
-                    }
-                    pos += sizeof( vertex.uv );
-                }
-            }
-            // Bit 16-23: 16-bit UV
-            uvFlag = ( p_vertexFormat & ANFVF_UV16Mask ) >> 16;
-            if ( uvFlag ) {
-                for ( uint j = 0; j < 7; j++ ) {
-                    if ( ( ( uvFlag >> j ) & 1 ) == 0 ) {
-                        continue;
-                    }
-                    if ( uvIndex < 1 ) {
-                        auto uv = reinterpret_cast<const half*>( pos );
-                        vertex.uv.x = uv[0];
-                        vertex.uv.y = uv[1];
-                        uvIndex++;
-                    }
-                    pos += sizeof( half ) * 2;
-                }
-            }
-            // Bit 24: Unknown 48-byte value
-            if ( p_vertexFormat & ANFVF_Unknown1 ) {
-                pos += 48;
-            }
-            // Bit 25: Unknown 4-byte value
-            if ( p_vertexFormat & ANFVF_Unknown2 ) {
-                pos += 4;
-            }
-            // Bit 26: Unknown 4-byte value
-            if ( p_vertexFormat & ANFVF_Unknown3 ) {
-                pos += 4;
-            }
-            // Bit 27: Unknown 16-byte value
-            if ( p_vertexFormat & ANFVF_Unknown4 ) {
-                pos += 16;
-            }
-            // Bit 28: Compressed position
-            if ( p_vertexFormat & ANFVF_PositionCompressed ) {
-                vertex.position.x = *reinterpret_cast<const half*>( pos + 0 * sizeof( half ) );
-                vertex.position.y = *reinterpret_cast<const half*>( pos + 1 * sizeof( half ) );
-                vertex.position.z = *reinterpret_cast<const half*>( pos + 2 * sizeof( half ) );
-                pos += 3 * sizeof( half );
-            }
-            // Bit 29: Unknown 12-byte value
-            if ( p_vertexFormat & ANFVF_Unknown5 ) {
-                pos += 12;
-            }
-        }
-    }
-
-    uint ModelReader::vertexSize( ANetFlexibleVertexFormat p_vertexFormat ) const {
-        uint uvCount = 0;
-        uint uvField = ( p_vertexFormat & ANFVF_UV32Mask ) >> 0x08;
-        for ( uint i = 0; i < 7; i++ ) {
-            if ( ( ( uvField >> i ) & 1 ) != 0 )
-                uvCount++;
-        }
-
-        uvField = ( p_vertexFormat & ANFVF_UV16Mask ) >> 0x10;
-        uint uv16Count = 0;
-        for ( uint i = 0; i < 7; i++ ) {
-            if ( ( ( uvField >> i ) & 1 ) != 0 )
-                uv16Count++;
-        }
-
-        return ( ( p_vertexFormat & ANFVF_Position ) * 12 )
-            + ( ( p_vertexFormat & ANFVF_Weights ) * 2 )
-            + ( ( p_vertexFormat & ANFVF_Group ) )
-            + ( ( ( p_vertexFormat & ANFVF_Normal ) >> 3 ) * 12 )
-            + ( ( p_vertexFormat & ANFVF_Color ) >> 2 )
-            + ( ( ( p_vertexFormat & ANFVF_Tangent ) >> 5 ) * 12 )
-            + ( ( ( p_vertexFormat & ANFVF_Bitangent ) >> 6 ) * 12 )
-            + ( ( ( p_vertexFormat & ANFVF_TangentFrame ) >> 7 ) * 12 )
-            + ( uvCount * 8 )
-            + ( uv16Count * 4 )
-            + ( ( ( p_vertexFormat & ANFVF_Unknown1 ) >> 24 ) * 48 )
-            + ( ( ( p_vertexFormat & ANFVF_Unknown2 ) >> 25 ) * 4 )
-            + ( ( ( p_vertexFormat & ANFVF_Unknown3 ) >> 26 ) * 4 )
-            + ( ( ( p_vertexFormat & ANFVF_Unknown4 ) >> 27 ) * 16 )
-            + ( ( ( p_vertexFormat & ANFVF_PositionCompressed ) >> 28 ) * 6 )
-            + ( ( ( p_vertexFormat & ANFVF_Unknown5 ) >> 29 ) * 12 );
-
-    }
-
-    void ModelReader::computeBond( GW2Mesh& p_mesh, const byte* p_data, uint p_indiceCount ) const {
-        // Calculate bounds
-        float floatMin = std::numeric_limits<float>::min( );
-        float floatMax = std::numeric_limits<float>::max( );
-        p_mesh.bounds.min = glm::vec3( floatMax, floatMax, floatMax );
-        p_mesh.bounds.max = glm::vec3( floatMin, floatMin, floatMin );
-
-        glm::vec3 min = p_mesh.bounds.min;
-        glm::vec3 max = p_mesh.bounds.max;
-
-        auto indices = reinterpret_cast<const uint16*>( p_data );
-#pragma omp parallel for
-        for ( int i = 0; i < static_cast<int>( p_indiceCount ); i++ ) {
-            auto& vertex = p_mesh.vertices[indices[i]];
-            glm::vec3 position = vertex.position;
-            min = glm::min( min, position );
-            max = glm::max( max, position );
-        }
-        p_mesh.bounds.min = min;
-        p_mesh.bounds.max = max;
+        decodeVertices( p_data, p_vertexCount, p_vertexFormat, p_mesh.vertices.data( ), p_mesh.bounds );
     }
 
     void ModelReader::readIndexBuffer( GW2Mesh& p_mesh, const byte* p_data, uint p_indiceCount ) const {
@@ -450,74 +339,29 @@ namespace gw2b {
         }
     }
 
-    void ModelReader::computeVertexNormals( GW2Mesh& p_mesh ) const {
-        // Calculate vertex normals
-        // http://www.iquilezles.org/www/articles/normals/normals.htm
-
-        auto& verts = p_mesh.vertices;
-        auto& faces = p_mesh.triangles;
-
-        // verts[i].normal is already initialized with zero
-
-#pragma omp parallel for
-        for ( int i = 0; i < static_cast<int>( faces.size( ) ); i++ ) {
-            // Re-flip the order of the faces of the triangle to original order
-            const int ia = faces[i].index1;
-            const int ib = faces[i].index3;
-            const int ic = faces[i].index2;
-
-            const glm::vec3 e1 = verts[ia].position - verts[ib].position;
-            const glm::vec3 e2 = verts[ic].position - verts[ib].position;
-            const glm::vec3 no = glm::normalize(glm::cross( e1, e2 ));
-
-            verts[ia].normal += no;
-            verts[ib].normal += no;
-            verts[ic].normal += no;
-        }
-    }
-
-    void ModelReader::rotZYinvZ( GW2Mesh& p_mesh ) const {
-        // Rotate ZY and invert Z
-        const glm::mat3 transform = glm::mat3(
-            glm::vec3( 1.0f, 0.0f, 0.0f ),
-            glm::vec3( 0.0f, 0.0f, -1.0f ),
-            glm::vec3( 0.0f, -1.0f, 0.0f )
-            );
-
-#pragma omp parallel for
-        for ( int i = 0; i < static_cast<int>( p_mesh.vertices.size( ) ); i++ ) {
-            auto& vertex = p_mesh.vertices[i];
-            vertex.position = transform * vertex.position;
-            // Todo: Untested!
-            if ( p_mesh.hasNormal ) {
-                vertex.normal = transform * vertex.normal;
-            }
-        }
-    }
-
     void ModelReader::readMaterial( GW2Model& p_model, gw2f::pf::ModelPackFile& p_modelPackFile ) const {
-        wxLogMessage( wxT( "Reading MODL chunk..." ) );
+        LogDebug( wxT( "Reading MODL chunk..." ) );
 
         std::shared_ptr<gw2f::pf::chunks::ModelFileDataV65> modelChunk;
         try {
             modelChunk = p_modelPackFile.chunk<gw2f::pf::ModelChunks::Model>( );
         } catch ( const gw2f::exception::Exception& exception ) {
-            wxLogMessage( wxT( "Failed to read MODL chunk using gw2formats: %s" ), wxString( exception.what( ) ) );
+            LogWarning( wxT( "Failed to read MODL chunk using gw2formats: %s" ), wxString( exception.what( ) ) );
 
-            wxLogMessage( wxT( "Try another method..." ) );
+            LogInfo( wxT( "Try another method..." ) );
             this->readMaterialPF( p_model, p_modelPackFile );
         } catch (const std::out_of_range & outofrange) {
-            wxLogMessage(wxT("Failed to read MODL chunk using gw2formats: %s"), wxString(outofrange.what()));
+            LogWarning(wxT("Failed to read MODL chunk using gw2formats: %s"), wxString(outofrange.what()));
 
-            wxLogMessage(wxT("Try another method..."));
+            LogInfo(wxT("Try another method..."));
             this->readMaterialPF(p_model, p_modelPackFile);
         } catch (const std::invalid_argument & invalidargument) {       // Tried to load more that was maximum size.
-            wxLogMessage(wxT("Failed to read MODL chunk using gw2formats: %s"), wxString(invalidargument.what()));
+            LogWarning(wxT("Failed to read MODL chunk using gw2formats: %s"), wxString(invalidargument.what()));
 
-            wxLogMessage(wxT("Try another method..."));
+            LogInfo(wxT("Try another method..."));
             this->readMaterialPF(p_model, p_modelPackFile);
         } catch ( ... ) {
-            wxLogMessage( wxT( "An unknown error has occurred." ) );
+            LogWarning( wxT( "An unknown error has occurred." ) );
             return;
         }
 
@@ -525,7 +369,7 @@ namespace gw2b {
         if ( modelChunk ) {
             // Bail if no permutations data
             if ( !modelChunk->permutations.data( ) ) {
-                wxLogMessage( wxT( "No permutations data." ) );
+                LogInfo( wxT( "No permutations data." ) );
                 return;
             }
 
@@ -541,17 +385,17 @@ namespace gw2b {
 
             // Bail if no materials data
             if ( !materialCount ) {
-                wxLogMessage( wxT( "No material data." ) );
+                LogInfo( wxT( "No material data." ) );
                 return;
             }
-            wxLogMessage( wxT( "Have %d material(s)." ), materialCount );
+            LogInfo( wxT( "Have %d material(s)." ), materialCount );
 
             GW2Material* materials = p_model.addMaterial( materialCount );
             // Loop through each material
             for ( int i = 0; i < static_cast<int>( numMaterialInfo ); i++ ) {
                     // Bail if no material data
                     if ( !permutationsInfoArray[i].materials.data( ) ) {
-                        wxLogMessage( wxT( "No material data in material array %d." ), i );
+                        LogDebug( wxT( "No material data in material array %d." ), i );
                         continue;
                     }
 
@@ -616,7 +460,7 @@ namespace gw2b {
             }
         }
 
-        wxLogMessage( wxT( "Finished reading MODL chunk." ) );
+        LogDebug( wxT( "Finished reading MODL chunk." ) );
     }
 
     void ModelReader::readMaterialPF( GW2Model& p_model, gw2f::pf::ModelPackFile& p_modelPackFile ) const {
@@ -636,7 +480,7 @@ namespace gw2b {
 
         // Bail if no permutations
         if ( !materialCount ) {
-            wxLogMessage( wxT( "No permutations data." ) );
+            LogInfo( wxT( "No permutations data." ) );
             return;
         }
 
@@ -110,6 +110,8 @@ namespace gw2b {
     public:
         std::vector<GW2Mesh>        meshes;
         std::vector<GW2Material>    material;
+        uint                        lodLevel;       // Level of detail of the meshes
+        uint                        numLodLevels;   // Levels of detail of the model file
     public:
         GW2ModelData( );
         GW2ModelData( const GW2ModelData& p_other );
@@ -130,6 +132,7 @@ namespace gw2b {
         const GW2Mesh& mesh( uint p_index ) const;
         const std::vector<GW2Mesh>& mesh( ) const;
         GW2Mesh* addMeshes( uint p_amount );
+        GW2Mesh* editMeshes( );
 
         // Material data
         uint numMaterial( ) const;
@@ -137,6 +140,11 @@ namespace gw2b {
         const std::vector<GW2Material>& material( ) const;
         GW2Material* addMaterial( uint p_amount );
 
+        // Level of detail
+        uint lodLevel( ) const;
+        uint numLodLevels( ) const;
+        void setLodLevel( uint p_lodLevel, uint p_numLodLevels );
+
         // helpers
         Bounds bounds( ) const;
     private:
@@ -159,20 +167,21 @@ namespace gw2b {
         virtual DataType dataType( ) const override {
             return DT_Model;
         }
-        /** Gets the model represented by this data.
+        /** Gets the model represented by this data, at a level of detail.
+        *  The levels are the LOD index buffers of the meshes in the GEOM
+        *  chunk, over the same vertices. Only the indices of the requested
+        *  level are read, other levels can be gotten later with another call.
+        *  \param[in]  p_lodLevel   Level of detail, 0 being the most detailed.
+        *                           Meshes with fewer levels use their last.
         *  \return GW2Model         model. */
-        GW2Model getModel( ) const;
+        GW2Model getModel( uint p_lodLevel = 0 ) const;
 
     private:
-        void readGeometry( GW2Model& p_model, gw2f::pf::ModelPackFile& p_modelPackFile ) const;
+        void readGeometry( GW2Model& p_model, gw2f::pf::ModelPackFile& p_modelPackFile, uint p_lodLevel ) const;
+        /** Reads the vertices in OpenGL coordinate, and their bounds. */
         void readVertexBuffer( GW2Mesh& p_mesh, const byte* p_data, uint p_vertexCount, ANetFlexibleVertexFormat p_vertexFormat ) const;
-        uint vertexSize( ANetFlexibleVertexFormat p_vertexFormat ) const;
-        void computeBond( GW2Mesh& p_mesh, const byte* p_data, uint p_indiceCount ) const;
         void readIndexBuffer( GW2Mesh& p_mesh, const byte* p_data, uint p_indiceCount ) const;
         void normalizeNormals( GW2Mesh& p_mesh ) const;
-        void computeVertexNormals( GW2Mesh& p_mesh ) const;
-        /** Rotate given mesh in ZY and invert Z. */
-        void rotZYinvZ( GW2Mesh& p_mesh ) const;
         void readMaterial( GW2Model& p_model, gw2f::pf::ModelPackFile& p_modelPackFile ) const;
         void readMaterialPF( GW2Model& p_model, gw2f::pf::ModelPackFile& p_modelPackFile ) const;
 
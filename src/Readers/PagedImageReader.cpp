@@ -0,0 +1,312 @@
+/** \file       Readers/PagedImageReader.cpp
+ *  \brief      Contains the definition of the paged image reader class.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cmath>
+#include <limits>
+
+#include "DatFile.h"
+#include "PackFile.h"
+
+#include "ImageReader.h"
+#include "PagedImageReader.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Version of the page table chunk the structs are laid out for. */
+        const uint PageTableVersion = 3;
+        /** Size of the decoded pages kept, in bytes. */
+        const size_t PagedImageCacheSize = 64u << 20;
+        /** Size of the pages if no page has a texture to read it from. */
+        const int SolidPageSize = 256;
+
+        const uint NoEntry = std::numeric_limits<uint>::max( );
+
+        uint64 pageKey( int p_x, int p_y ) {
+            return ( static_cast<uint64>( static_cast<uint32>( p_y ) ) << 32 ) | static_cast<uint32>( p_x );
+        }
+
+        uint64 cacheKey( uint p_fileId, uint p_level ) {
+            return ( static_cast<uint64>( p_fileId ) << 8 ) | p_level;
+        }
+
+        /** Gets an array pointed to by an offset relative to the offset
+        *  itself, or nullptr if it does not fit in the chunk. */
+        template <typename T>
+        const T* arrayAt( const int32& p_offset, uint32 p_count, const byte* p_end ) {
+            auto pos = reinterpret_cast<const byte*>( &p_offset ) + p_offset;
+            if ( !p_count || ( p_offset <= 0 ) || ( pos >= p_end ) ) {
+                return nullptr;
+            }
+            if ( static_cast<size_t>( p_end - pos ) / sizeof( T ) < p_count ) {
+                return nullptr;
+            }
+            return reinterpret_cast<const T*>( pos );
+        }
+
+    };
+
+    PagedImageReader::PagedImageReader( const Array<byte>& p_data, DatFile& p_datFile, ANetFileType p_fileType )
+        : FileReader( p_data, p_datFile, p_fileType )
+        , m_pageSize( 0, 0 )
+        , m_cachedSize( 0 ) {
+        this->readPageTable( );
+    }
+
+    PagedImageReader::~PagedImageReader( ) {
+    }
+
+    void PagedImageReader::readPageTable( ) {
+        size_t size = 0;
+        auto pf = PackFile( m_data );
+        auto chunk = pf.findChunk( FCC_PGTB, size );
+        if ( !chunk || ( size < sizeof( ANetPfChunkHeader ) + sizeof( ANetPagedImageTableData ) ) ) {
+            LogWarning( wxT( "Paged image has no page table." ) );
+            return;
+        }
+
+        auto chunkHeader = reinterpret_cast<const ANetPfChunkHeader*>( chunk );
+        if ( chunkHeader->chunkVersion != PageTableVersion ) {
+            LogWarning( wxT( "Page table version %d is not supported." ), chunkHeader->chunkVersion );
+            return;
+        }
+
+        auto end = chunk + size;
+        auto table = reinterpret_cast<const ANetPagedImageTableData*>( chunk + sizeof( ANetPfChunkHeader ) );
+
+        // Stripped pages are only used when there are no raw ones
+        auto numPages = table->rawPagesCount;
+        auto pages = arrayAt<ANetPagedImagePageData>( table->rawPagesOffset, numPages, end );
+        if ( !pages ) {
+            numPages = table->strippedPagesCount;
+            pages = arrayAt<ANetPagedImagePageData>( table->strippedPagesOffset, numPages, end );
+        }
+        if ( !pages ) {
+            return;
+        }
+
+        m_layers.resize( wxMin( table->layersCount, 0x100u ) );
+        for ( uint i = 0; i < numPages; i++ ) {
+            auto& data = pages[i];
+
+            Page page;
+            page.x = static_cast<int>( std::lround( data.coord[0] ) );
+            page.y = static_cast<int>( std::lround( data.coord[1] ) );
+            page.fileId = 0;
+            page.entryNum = NoEntry;
+            ::memcpy( page.solidColor, data.solidColor, sizeof( page.solidColor ) );
+            if ( ( page.x < 0 ) || ( page.y < 0 ) || ( data.layer > 0xff ) ) {
+                continue;
+            }
+
+            auto reference = arrayAt<ANetFileReference>( data.offsetToFileReference, 1, end );
+            if ( reference ) {
+                page.fileId = DatFile::fileIdFromFileReference( *reference );
+            }
+
+            if ( data.layer >= m_layers.size( ) ) {
+                m_layers.resize( data.layer + 1 );
+            }
+            auto& layer = m_layers[data.layer];
+            layer.pageIndices[pageKey( page.x, page.y )] = static_cast<uint>( layer.pages.size( ) );
+            layer.pages.push_back( page );
+            layer.numPages.x = wxMax( layer.numPages.x, page.x + 1 );
+            layer.numPages.y = wxMax( layer.numPages.y, page.y + 1 );
+        }
+    }
+
+    const wxSize& PagedImageReader::pageSize( ) const {
+        if ( m_pageSize.x > 0 ) {
+            return m_pageSize;
+        }
+
+        // Every page has the size of the first texture
+        m_pageSize = wxSize( SolidPageSize, SolidPageSize );
+        for ( auto& layer : m_layers ) {
+            for ( auto& page : layer.pages ) {
+                if ( !page.fileId ) {
+                    continue;
+                }
+                auto image = this->readPage( page, 0 );
+                if ( image.IsOk( ) ) {
+                    m_pageSize = image.GetSize( );
+                    return m_pageSize;
+                }
+            }
+        }
+        return m_pageSize;
+    }
+
+    wxSize PagedImageReader::layerSize( uint p_layer ) const {
+        if ( p_layer >= m_layers.size( ) ) {
+            return wxSize( 0, 0 );
+        }
+        auto& numPages = m_layers[p_layer].numPages;
+        return wxSize( numPages.x * this->pageSize( ).x, numPages.y * this->pageSize( ).y );
+    }
+
+    wxImage PagedImageReader::getRegion( uint p_layer, uint p_level, const wxRect& p_region ) const {
+        if ( ( p_layer >= m_layers.size( ) ) || ( p_region.width <= 0 ) || ( p_region.height <= 0 ) ) {
+            return wxImage( );
+        }
+
+        auto& layer = m_layers[p_layer];
+        int pageWidth = wxMax( this->pageSize( ).x >> p_level, 1 );
+        int pageHeight = wxMax( this->pageSize( ).y >> p_level, 1 );
+
+        wxImage image( p_region.width, p_region.height );
+        int firstX = wxMax( p_region.GetLeft( ) / pageWidth, 0 );
+        int firstY = wxMax( p_region.GetTop( ) / pageHeight, 0 );
+        int lastX = wxMin( p_region.GetRight( ) / pageWidth, layer.numPages.x - 1 );
+        int lastY = wxMin( p_region.GetBottom( ) / pageHeight, layer.numPages.y - 1 );
+
+        for ( int y = firstY; y <= lastY; y++ ) {
+            for ( int x = firstX; x <= lastX; x++ ) {
+                auto index = layer.pageIndices.find( pageKey( x, y ) );
+                if ( index == layer.pageIndices.end( ) ) {
+                    continue;
+                }
+                auto page = this->readPage( layer.pages[index->second], p_level );
+                if ( !page.IsOk( ) ) {
+                    continue;
+                }
+
+                wxRect pageRect( x * pageWidth, y * pageHeight, wxMin( page.GetWidth( ), pageWidth ), wxMin( page.GetHeight( ), pageHeight ) );
+                pageRect.Intersect( p_region );
+                if ( pageRect.IsEmpty( ) ) {
+                    continue;
+                }
+                if ( page.HasAlpha( ) && !image.HasAlpha( ) ) {
+                    image.InitAlpha( );
+                }
+
+                // Copy the overlapping rows
+                int fromX = pageRect.x - x * pageWidth;
+                int fromY = pageRect.y - y * pageHeight;
+                int toX = pageRect.x - p_region.x;
+                int toY = pageRect.y - p_region.y;
+                for ( int row = 0; row < pageRect.height; row++ ) {
+                    size_t from = static_cast<size_t>( fromY + row ) * page.GetWidth( ) + fromX;
+                    size_t to = static_cast<size_t>( toY + row ) * p_region.width + toX;
+                    ::memcpy( image.GetData( ) + to * 3, page.GetData( ) + from * 3, pageRect.width * 3 );
+                    if ( image.HasAlpha( ) ) {
+                        if ( page.HasAlpha( ) ) {
+                            ::memcpy( image.GetAlpha( ) + to, page.GetAlpha( ) + from, pageRect.width );
+                        } else {
+                            ::memset( image.GetAlpha( ) + to, 0xff, pageRect.width );
+                        }
+                    }
+                }
+            }
+        }
+
+        return image;
+    }
+
+    wxImage PagedImageReader::readPage( const Page& p_page, uint p_level ) const {
+        // Solid pages are cheaper to make than to cache
+        if ( !p_page.fileId ) {
+            int width = wxMax( this->pageSize( ).x >> p_level, 1 );
+            int height = wxMax( this->pageSize( ).y >> p_level, 1 );
+            wxImage image( width, height, false );
+            image.SetRGB( wxRect( 0, 0, width, height ), p_page.solidColor[0], p_page.solidColor[1], p_page.solidColor[2] );
+            if ( p_page.solidColor[3] != 0xff ) {
+                image.InitAlpha( );
+                ::memset( image.GetAlpha( ), p_page.solidColor[3], static_cast<size_t>( width ) * height );
+            }
+            return image;
+        }
+
+        auto key = cacheKey( p_page.fileId, p_level );
+        auto cached = m_cachedPageIndices.find( key );
+        if ( cached != m_cachedPageIndices.end( ) ) {
+            // Most recently used first
+            m_cachedPages.splice( m_cachedPages.begin( ), m_cachedPages, cached->second );
+            return cached->second->image;
+        }
+
+        auto image = this->decodePage( p_page, p_level );
+        if ( !image.IsOk( ) ) {
+            return image;
+        }
+
+        CachedPage page;
+        page.key = key;
+        page.image = image;
+        m_cachedPages.push_front( page );
+        m_cachedPageIndices[key] = m_cachedPages.begin( );
+        m_cachedSize += static_cast<size_t>( image.GetWidth( ) ) * image.GetHeight( ) * ( image.HasAlpha( ) ? 4 : 3 );
+
+        // Drop the least recently used pages
+        while ( ( m_cachedSize > PagedImageCacheSize ) && ( m_cachedPages.size( ) > 1 ) ) {
+            auto& last = m_cachedPages.back( );
+            m_cachedSize -= static_cast<size_t>( last.image.GetWidth( ) ) * last.image.GetHeight( ) * ( last.image.HasAlpha( ) ? 4 : 3 );
+            m_cachedPageIndices.erase( last.key );
+            m_cachedPages.pop_back( );
+        }
+
+        return image;
+    }
+
+    wxImage PagedImageReader::decodePage( const Page& p_page, uint p_level ) const {
+        if ( p_page.entryNum == NoEntry ) {
+            p_page.entryNum = m_datFile.entryNumFromFileOrBaseId( p_page.fileId );
+        }
+        if ( p_page.entryNum == NoEntry ) {
+            LogWarning( wxT( "Page texture %d does not exist." ), p_page.fileId );
+            return wxImage( );
+        }
+
+        auto data = m_datFile.readEntry( p_page.entryNum );
+        if ( !ImageReader::isValidHeader( data.GetPointer( ), data.GetSize( ) ) ) {
+            return wxImage( );
+        }
+
+        ANetFileType fileType;
+        m_datFile.identifyFileType( data.GetPointer( ), data.GetSize( ), fileType );
+        ImageReader reader( data, m_datFile, fileType );
+
+        // Block averages cover reductions up to 16, the rest is scaled after
+        uint reduction = 1u << wxMin( p_level, 16u );
+        auto scale = ImageReader::IS_Full;
+        if ( reduction >= ImageReader::IS_Sixteenth ) {
+            scale = ImageReader::IS_Sixteenth;
+        } else if ( reduction >= ImageReader::IS_Eighth ) {
+            scale = ImageReader::IS_Eighth;
+        } else if ( reduction >= ImageReader::IS_Quarter ) {
+            scale = ImageReader::IS_Quarter;
+        }
+
+        auto image = reader.getScaledImage( scale );
+        uint rest = reduction / scale;
+        if ( image.IsOk( ) && ( rest > 1 ) ) {
+            image = image.Scale( wxMax( image.GetWidth( ) / static_cast<int>( rest ), 1 ), wxMax( image.GetHeight( ) / static_cast<int>( rest ), 1 ), wxIMAGE_QUALITY_BOX_AVERAGE );
+        }
+        return image;
+    }
+
+}; // namespace gw2b
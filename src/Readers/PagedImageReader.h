@@ -0,0 +1,112 @@
+/** \file       Readers/PagedImageReader.h
+ *  \brief      Contains the declaration of the paged image reader class.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef READERS_PAGEDIMAGEREADER_H_INCLUDED
+#define READERS_PAGEDIMAGEREADER_H_INCLUDED
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "FileReader.h"
+
+namespace gw2b {
+
+    /** Reads paged images, the huge textures of the world map that are split
+    *  in pages, each page a texture of its own.
+    *
+    *  Only the pages covering a requested region are read and decoded, and
+    *  decoded pages are kept in a cache of bounded size, so showing a part of
+    *  the image never needs the whole image in memory. */
+    class PagedImageReader : public FileReader {
+        /** Page of a layer. */
+        struct Page {
+            int         x;              /**< Column of the page in its layer. */
+            int         y;              /**< Row of the page in its layer. */
+            uint        fileId;         /**< File id of the page's texture, 0 for solid pages. */
+            mutable uint entryNum;      /**< Entry of the texture, looked up when first read. */
+            byte        solidColor[4];  /**< Color of solid pages, as RGBA. */
+        };
+        /** Layer, a grid of pages. */
+        struct Layer {
+            std::vector<Page>               pages;
+            std::unordered_map<uint64, uint> pageIndices;   /**< Page by position, see pageKey. */
+            wxSize                          numPages;       /**< Columns and rows of pages. */
+        };
+        /** Decoded page in the cache. */
+        struct CachedPage {
+            uint64      key;
+            wxImage     image;
+        };
+        typedef std::list<CachedPage>   CachedPageList;
+
+        std::vector<Layer>                                      m_layers;
+        mutable wxSize                                          m_pageSize;
+        mutable CachedPageList                                  m_cachedPages;      /**< Most recently used first. */
+        mutable std::unordered_map<uint64, CachedPageList::iterator>    m_cachedPageIndices;
+        mutable size_t                                          m_cachedSize;
+    public:
+        /** Constructor. Reads the page table.
+        *  \param[in]  p_data       Data to be handled by this reader.
+        *  \param[in]  p_datFile    Reference to an instance of DatFile.
+        *  \param[in]  p_fileType   File type of the given data. */
+        PagedImageReader( const Array<byte>& p_data, DatFile& p_datFile, ANetFileType p_fileType );
+        /** Destructor. Clears all data. */
+        virtual ~PagedImageReader( );
+
+        /** Gets the type of data contained in this file. Not to be confused with
+        *  file type.
+        *  \return DataType    type of data. */
+        virtual DataType dataType( ) const override {
+            return DT_PagedImage;
+        }
+        /** Gets the amount of layers of the image.
+        *  \return uint    Amount of layers. */
+        uint numLayers( ) const {
+            return static_cast<uint>( m_layers.size( ) );
+        }
+        /** Gets the size of a layer, without decoding any page.
+        *  \param[in]  p_layer      Layer to get the size of.
+        *  \return wxSize  Size in pixels, 0 by 0 if unknown. */
+        wxSize layerSize( uint p_layer ) const;
+        /** Gets a region of a layer, reduced by a power of two. Only the pages
+        *  covering the region are decoded, the parts without pages are black.
+        *  \param[in]  p_layer      Layer to get the region of.
+        *  \param[in]  p_level      Reduction, the layer is halved p_level times.
+        *  \param[in]  p_region     Region to get, in pixels of the reduced layer.
+        *  \return wxImage     Newly created image, not ok on failure. */
+        wxImage getRegion( uint p_layer, uint p_level, const wxRect& p_region ) const;
+
+    private:
+        void readPageTable( );
+        const wxSize& pageSize( ) const;
+        wxImage readPage( const Page& p_page, uint p_level ) const;
+        wxImage decodePage( const Page& p_page, uint p_level ) const;
+    }; // class PagedImageReader
+
+}; // namespace gw2b
+
+#endif // READERS_PAGEDIMAGEREADER_H_INCLUDED
@@ -0,0 +1,325 @@
+/** \file       Readers/VertexDecoder.cpp
+ *  \brief      Decodes the vertex buffers of model files.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE__) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 1 )
+#   define GW2B_BOUNDS_SSE      1
+#   include <xmmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   define GW2B_BOUNDS_NEON     1
+#   include <arm_neon.h>
+#endif
+
+#include "VertexDecoder.h"
+
+#include "Util/HalfConverter.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Offsets of the fields the reader uses in a vertex, or -1 for the
+        *  fields a vertex does not have. The 16-bit UVs are the first set, the
+        *  32-bit ones the last set, as the reader always took them. */
+        struct VertexLayout {
+            int32 size;
+            int32 position;
+            int32 normal;
+            int32 uv32;
+            int32 uv16;
+            int32 positionCompressed;
+        };
+
+        /** Gets the size of the field of a format bit, see ANetFlexibleVertexFormat.
+        *  Only the first 7 bits of each UV mask are counted, the last one
+        *  is neither read nor part of the vertex. */
+        constexpr int32 fieldSize( uint p_bit ) {
+            return ( p_bit == 0 ) ? 12 :    // Position
+                ( p_bit <= 2 ) ? 4 :        // Weights, group
+                ( p_bit == 3 ) ? 12 :       // Normal
+                ( p_bit == 4 ) ? 4 :        // Color
+                ( p_bit <= 7 ) ? 12 :       // Tangent, bitangent, tangent frame
+                ( p_bit <= 14 ) ? 8 :       // 32-bit UV
+                ( p_bit == 15 ) ? 0 :
+                ( p_bit <= 22 ) ? 4 :       // 16-bit UV
+                ( p_bit == 23 ) ? 0 :
+                ( p_bit == 24 ) ? 48 :
+                ( p_bit <= 26 ) ? 4 :
+                ( p_bit == 27 ) ? 16 :
+                ( p_bit == 28 ) ? 6 :       // Compressed position
+                ( p_bit == 29 ) ? 12 : 0;
+        }
+
+        /** Works out the layout of a vertex format. Fields are stored in the
+        *  order of their bits. */
+        constexpr VertexLayout vertexLayout( uint32 p_vertexFormat ) {
+            VertexLayout layout = { 0, -1, -1, -1, -1, -1 };
+            for ( uint bit = 0; bit < 32; bit++ ) {
+                const uint32 flag = 1u << bit;
+                if ( !( p_vertexFormat & flag ) || !fieldSize( bit ) ) {
+                    continue;
+                }
+                if ( flag == ANFVF_Position ) {
+                    layout.position = layout.size;
+                } else if ( flag == ANFVF_Normal ) {
+                    layout.normal = layout.size;
+                } else if ( flag & ANFVF_UV32Mask ) {
+                    layout.uv32 = layout.size;
+                } else if ( ( flag & ANFVF_UV16Mask ) && layout.uv16 < 0 ) {
+                    layout.uv16 = layout.size;
+                } else if ( flag == ANFVF_PositionCompressed ) {
+                    layout.positionCompressed = layout.size;
+                }
+                layout.size += fieldSize( bit );
+            }
+            return layout;
+        }
+
+        /** Smallest and largest of a set of positions. */
+        class BoundsAccumulator {
+        public:
+            BoundsAccumulator( ) {
+                const float floatMax = std::numeric_limits<float>::max( );
+#if GW2B_BOUNDS_SSE
+                m_min = _mm_set1_ps( floatMax );
+                m_max = _mm_set1_ps( -floatMax );
+#elif GW2B_BOUNDS_NEON
+                m_min = vdupq_n_f32( floatMax );
+                m_max = vdupq_n_f32( -floatMax );
+#else
+                m_min = glm::vec3( floatMax );
+                m_max = glm::vec3( -floatMax );
+#endif
+            }
+
+            /** Grows the bounds by a position. NaNs are skipped. */
+            void add( const glm::vec3& p_position ) {
+#if GW2B_BOUNDS_SSE
+                auto position = _mm_set_ps( 0.0f, p_position.z, p_position.y, p_position.x );
+                // Gives the second operand if either is NaN
+                m_min = _mm_min_ps( position, m_min );
+                m_max = _mm_max_ps( position, m_max );
+#elif GW2B_BOUNDS_NEON
+                const float lanes[4] = { p_position.x, p_position.y, p_position.z, 0.0f };
+                auto position = vld1q_f32( lanes );
+                m_min = vminnmq_f32( m_min, position );
+                m_max = vmaxnmq_f32( m_max, position );
+#else
+                m_min = glm::min( m_min, p_position );
+                m_max = glm::max( m_max, p_position );
+#endif
+            }
+
+            /** Grows the bounds by other bounds. */
+            void merge( const BoundsAccumulator& p_other ) {
+#if GW2B_BOUNDS_SSE
+                m_min = _mm_min_ps( p_other.m_min, m_min );
+                m_max = _mm_max_ps( p_other.m_max, m_max );
+#elif GW2B_BOUNDS_NEON
+                m_min = vminnmq_f32( m_min, p_other.m_min );
+                m_max = vmaxnmq_f32( m_max, p_other.m_max );
+#else
+                m_min = glm::min( m_min, p_other.m_min );
+                m_max = glm::max( m_max, p_other.m_max );
+#endif
+            }
+
+            /** Gets the bounds. Only valid once a position was added. */
+            Bounds bounds( ) const {
+                Bounds retval;
+#if GW2B_BOUNDS_SSE || GW2B_BOUNDS_NEON
+                float min[4];
+                float max[4];
+#   if GW2B_BOUNDS_SSE
+                _mm_storeu_ps( min, m_min );
+                _mm_storeu_ps( max, m_max );
+#   else
+                vst1q_f32( min, m_min );
+                vst1q_f32( max, m_max );
+#   endif
+                retval.min = glm::vec3( min[0], min[1], min[2] );
+                retval.max = glm::vec3( max[0], max[1], max[2] );
+#else
+                retval.min = m_min;
+                retval.max = m_max;
+#endif
+                return retval;
+            }
+
+        private:
+#if GW2B_BOUNDS_SSE
+            __m128 m_min;
+            __m128 m_max;
+#elif GW2B_BOUNDS_NEON
+            float32x4_t m_min;
+            float32x4_t m_max;
+#else
+            glm::vec3 m_min;
+            glm::vec3 m_max;
+#endif
+        };
+
+        /** Amount of vertices decoded at a time, so their 16-bit floats can be
+        *  converted in one go while still in the cache. */
+        const uint VertexChunkSize = 256;
+
+        /** Decodes vertices to OpenGL coordinates, by rotating ZY and inverting
+        *  Z, and grows the bounds by their positions.
+        *  \tparam     FVF          Format the compiler lays out at compile time,
+        *                           or 0 to read p_layout instead.
+        *  \param[in]  p_layout     Layout of the vertices.
+        *  \param[in]  p_data       Vertices to decode.
+        *  \param[in]  p_count      Amount of vertices, at most VertexChunkSize.
+        *  \param[out] po_vertices  Receives the vertices.
+        *  \param[in,out] po_bounds Bounds to grow. */
+        template <uint32 FVF>
+        void decodeChunk( const VertexLayout& p_layout, const byte* p_data, uint p_count, Vertex* po_vertices, BoundsAccumulator& po_bounds ) {
+            constexpr VertexLayout fixedLayout = vertexLayout( FVF );
+            const VertexLayout& layout = FVF ? fixedLayout : p_layout;
+            const uint numHalves = ( ( layout.uv16 >= 0 ) ? 2 : 0 ) + ( ( layout.positionCompressed >= 0 ) ? 3 : 0 );
+
+            uint16 halves[VertexChunkSize * 5];
+            float floats[VertexChunkSize * 5];
+
+            // Copy the 32-bit fields, gather the 16-bit ones
+            for ( uint i = 0; i < p_count; i++ ) {
+                auto pos = &p_data[i * layout.size];
+                Vertex& vertex = po_vertices[i];
+
+                vertex.position = glm::vec3( 0.0f );
+                vertex.normal = glm::vec3( 0.0f );
+                vertex.uv = glm::vec2( 0.0f );
+                if ( layout.position >= 0 ) {
+                    ::memcpy( &vertex.position, pos + layout.position, sizeof( vertex.position ) );
+                }
+                if ( layout.normal >= 0 ) {
+                    ::memcpy( &vertex.normal, pos + layout.normal, sizeof( vertex.normal ) );
+                }
+                if ( layout.uv32 >= 0 ) {
+                    ::memcpy( &vertex.uv, pos + layout.uv32, sizeof( vertex.uv ) );
+                }
+
+                auto half = &halves[i * numHalves];
+                if ( layout.uv16 >= 0 ) {
+                    ::memcpy( half, pos + layout.uv16, 2 * sizeof( uint16 ) );
+                    half += 2;
+                }
+                if ( layout.positionCompressed >= 0 ) {
+                    ::memcpy( half, pos + layout.positionCompressed, 3 * sizeof( uint16 ) );
+                }
+            }
+
+            if ( numHalves ) {
+                halfConverter( ).toFloat( halves, floats, p_count * numHalves );
+            }
+
+            for ( uint i = 0; i < p_count; i++ ) {
+                Vertex& vertex = po_vertices[i];
+
+                // 16-bit UVs and compressed positions win over the 32-bit ones
+                auto value = &floats[i * numHalves];
+                if ( layout.uv16 >= 0 ) {
+                    vertex.uv = glm::vec2( value[0], value[1] );
+                    value += 2;
+                }
+                if ( layout.positionCompressed >= 0 ) {
+                    vertex.position = glm::vec3( value[0], value[1], value[2] );
+                }
+
+                // DirectX coordinate to OpenGL coordinate by rotate ZY and invert Z
+                vertex.position = glm::vec3( vertex.position.x, -vertex.position.z, -vertex.position.y );
+                vertex.normal = glm::vec3( vertex.normal.x, -vertex.normal.z, -vertex.normal.y );
+
+                po_bounds.add( vertex.position );
+            }
+        }
+
+        typedef void ( *ChunkDecoder )( const VertexLayout& p_layout, const byte* p_data, uint p_count, Vertex* po_vertices, BoundsAccumulator& po_bounds );
+
+        /** Gets the decoder of a vertex format, one laid out at compile time
+        *  for the common formats. */
+        ChunkDecoder chunkDecoder( uint32 p_vertexFormat ) {
+            switch ( p_vertexFormat ) {
+            case CVF_PositionUV16:
+                return &decodeChunk<CVF_PositionUV16>;
+            case CVF_PositionNormalUV16:
+                return &decodeChunk<CVF_PositionNormalUV16>;
+            case CVF_PositionNormalUV16x2:
+                return &decodeChunk<CVF_PositionNormalUV16x2>;
+            case CVF_PositionNormalUV32:
+                return &decodeChunk<CVF_PositionNormalUV32>;
+            case CVF_PositionNormalColorUV16:
+                return &decodeChunk<CVF_PositionNormalColorUV16>;
+            case CVF_PositionNormalTangentUV16:
+                return &decodeChunk<CVF_PositionNormalTangentUV16>;
+            case CVF_SkinnedPositionNormalUV16:
+                return &decodeChunk<CVF_SkinnedPositionNormalUV16>;
+            default:
+                return &decodeChunk<0>;
+            }
+        }
+
+        /** Decodes vertices in chunks on all cores, see decodeVertices. */
+        void decodeAll( ChunkDecoder p_decode, const byte* p_data, uint p_vertexCount, uint32 p_vertexFormat, Vertex* po_vertices, Bounds& po_bounds ) {
+            const VertexLayout layout = vertexLayout( p_vertexFormat );
+
+            const int numChunks = static_cast<int>( ( p_vertexCount + VertexChunkSize - 1 ) / VertexChunkSize );
+            BoundsAccumulator meshBounds;
+
+#pragma omp parallel
+            {
+                // Each thread keeps its own bounds, merged once it is done
+                BoundsAccumulator bounds;
+#pragma omp for
+                for ( int i = 0; i < numChunks; i++ ) {
+                    const uint first = i * VertexChunkSize;
+                    const uint count = std::min( VertexChunkSize, p_vertexCount - first );
+                    p_decode( layout, &p_data[first * layout.size], count, &po_vertices[first], bounds );
+                }
+#pragma omp critical
+                meshBounds.merge( bounds );
+            }
+
+            po_bounds = meshBounds.bounds( );
+        }
+
+    };
+
+    uint vertexSize( uint32 p_vertexFormat ) {
+        return vertexLayout( p_vertexFormat ).size;
+    }
+
+    void decodeVertices( const byte* p_data, uint p_vertexCount, uint32 p_vertexFormat, Vertex* po_vertices, Bounds& po_bounds ) {
+        decodeAll( chunkDecoder( p_vertexFormat ), p_data, p_vertexCount, p_vertexFormat, po_vertices, po_bounds );
+    }
+
+    void decodeVerticesGeneric( const byte* p_data, uint p_vertexCount, uint32 p_vertexFormat, Vertex* po_vertices, Bounds& po_bounds ) {
+        decodeAll( &decodeChunk<0>, p_data, p_vertexCount, p_vertexFormat, po_vertices, po_bounds );
+    }
+
+}; // namespace gw2b
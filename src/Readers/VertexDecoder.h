@@ -0,0 +1,71 @@
+/** \file       Readers/VertexDecoder.h
+ *  \brief      Decodes the vertex buffers of model files.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef READERS_VERTEXDECODER_H_INCLUDED
+#define READERS_VERTEXDECODER_H_INCLUDED
+
+#include "ModelReader.h"
+
+namespace gw2b {
+
+    /** Vertex formats common enough to get a decoder of their own. */
+    enum CommonVertexFormat : uint32 {
+        CVF_PositionUV16 = ANFVF_Position | ( 1 << 16 ),
+        CVF_PositionNormalUV16 = ANFVF_Position | ANFVF_Normal | ( 1 << 16 ),
+        CVF_PositionNormalUV16x2 = ANFVF_Position | ANFVF_Normal | ( 3 << 16 ),
+        CVF_PositionNormalUV32 = ANFVF_Position | ANFVF_Normal | ( 1 << 8 ),
+        CVF_PositionNormalColorUV16 = ANFVF_Position | ANFVF_Normal | ANFVF_Color | ( 1 << 16 ),
+        CVF_PositionNormalTangentUV16 = ANFVF_Position | ANFVF_Normal | ANFVF_Tangent | ( 1 << 16 ),
+        CVF_SkinnedPositionNormalUV16 = ANFVF_Position | ANFVF_Weights | ANFVF_Group | ANFVF_Normal | ( 1 << 16 ),
+    };
+
+    /** Gets the size of a vertex of a format, as stored in model files.
+    *  \param[in]  p_vertexFormat   Format of the vertex, see ANetFlexibleVertexFormat.
+    *  \return uint                 Size of the vertex, in bytes. */
+    uint vertexSize( uint32 p_vertexFormat );
+
+    /** Decodes vertices to OpenGL coordinates, by rotating ZY and inverting
+    *  Z, on all cores. Only positions, normals and the UVs of one set are
+    *  kept, missing fields are zero.
+    *  \param[in]  p_data           Vertices to decode, p_vertexCount * vertexSize( p_vertexFormat ) bytes.
+    *  \param[in]  p_vertexCount    Amount of vertices, at least 1.
+    *  \param[in]  p_vertexFormat   Format of the vertices, see ANetFlexibleVertexFormat.
+    *  \param[out] po_vertices      Receives the vertices.
+    *  \param[out] po_bounds        Receives the bounds of the positions. */
+    void decodeVertices( const byte* p_data, uint p_vertexCount, uint32 p_vertexFormat, Vertex* po_vertices, Bounds& po_bounds );
+    /** Decodes vertices as decodeVertices does, but always with the decoder
+    *  that reads the layout at run time, even for the common formats. The
+    *  reference for the decoders of the common formats.
+    *  \param[in]  p_data           Vertices to decode, p_vertexCount * vertexSize( p_vertexFormat ) bytes.
+    *  \param[in]  p_vertexCount    Amount of vertices, at least 1.
+    *  \param[in]  p_vertexFormat   Format of the vertices, see ANetFlexibleVertexFormat.
+    *  \param[out] po_vertices      Receives the vertices.
+    *  \param[out] po_bounds        Receives the bounds of the positions. */
+    void decodeVerticesGeneric( const byte* p_data, uint p_vertexCount, uint32 p_vertexFormat, Vertex* po_vertices, Bounds& po_bounds );
+
+}; // namespace gw2b
+
+#endif // READERS_VERTEXDECODER_H_INCLUDED
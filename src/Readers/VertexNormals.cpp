@@ -0,0 +1,97 @@
+/** \file       Readers/VertexNormals.cpp
+ *  \brief      Computes the normals of meshes without stored ones.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "stdafx.h"
+
+#include "VertexNormals.h"
+
+namespace gw2b {
+
+    void computeVertexNormals( const std::vector<Triangle>& p_triangles, std::vector<Vertex>& po_vertices ) {
+        // Calculate vertex normals
+        // http://www.iquilezles.org/www/articles/normals/normals.htm
+
+        auto& verts = po_vertices;
+        auto& faces = p_triangles;
+        const int numVerts = static_cast<int>( verts.size( ) );
+        const int numFaces = static_cast<int>( faces.size( ) );
+
+        // Normal of each face
+        std::vector<glm::vec3> faceNormals( numFaces, glm::vec3( 0.0f, 0.0f, 0.0f ) );
+#pragma omp parallel for
+        for ( int i = 0; i < numFaces; i++ ) {
+            // Re-flip the order of the faces of the triangle to original order
+            const int ia = faces[i].index1;
+            const int ib = faces[i].index3;
+            const int ic = faces[i].index2;
+            if ( ia >= numVerts || ib >= numVerts || ic >= numVerts ) {
+                continue;
+            }
+
+            const glm::vec3 e1 = verts[ia].position - verts[ib].position;
+            const glm::vec3 e2 = verts[ic].position - verts[ib].position;
+            const glm::vec3 no = glm::cross( e1, e2 );
+            // Degenerate faces add nothing
+            if ( glm::length( no ) > 0.0f ) {
+                faceNormals[i] = glm::normalize( no );
+            }
+        }
+
+        // Faces of each vertex, in face order: faceOffsets[v] to faceOffsets[v + 1]
+        // in vertexFaces. Built serially, it is only counting.
+        std::vector<int> faceOffsets( numVerts + 1, 0 );
+        for ( auto& face : faces ) {
+            for ( auto index : face.indices ) {
+                if ( index < numVerts ) {
+                    faceOffsets[index + 1]++;
+                }
+            }
+        }
+        for ( int v = 0; v < numVerts; v++ ) {
+            faceOffsets[v + 1] += faceOffsets[v];
+        }
+        std::vector<int> vertexFaces( faceOffsets[numVerts] );
+        std::vector<int> fill( faceOffsets.begin( ), faceOffsets.end( ) - 1 );
+        for ( int i = 0; i < numFaces; i++ ) {
+            for ( auto index : faces[i].indices ) {
+                if ( index < numVerts ) {
+                    vertexFaces[fill[index]++] = i;
+                }
+            }
+        }
+
+        // Each vertex sums the normals of its faces in face order, so the
+        // result does not depend on the amount of threads
+#pragma omp parallel for
+        for ( int v = 0; v < numVerts; v++ ) {
+            glm::vec3 normal = verts[v].normal;
+            for ( int f = faceOffsets[v]; f < faceOffsets[v + 1]; f++ ) {
+                normal += faceNormals[vertexFaces[f]];
+            }
+            verts[v].normal = normal;
+        }
+    }
+
+}; // namespace gw2b
@@ -0,0 +1,46 @@
+/** \file       Readers/VertexNormals.h
+ *  \brief      Computes the normals of meshes without stored ones.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#ifndef READERS_VERTEXNORMALS_H_INCLUDED
+#define READERS_VERTEXNORMALS_H_INCLUDED
+
+#include "ModelReader.h"
+
+namespace gw2b {
+
+    /** Adds the face normals of a mesh to the normals of their vertices, on
+    *  all cores. The faces of each vertex are summed in face order, so the
+    *  result does not depend on the amount of threads. Degenerate faces and
+    *  faces with out of range indices add nothing. The normals are not
+    *  normalized.
+    *  \param[in]  p_triangles      Faces of the mesh, flipped as read by ModelReader.
+    *  \param[in,out] po_vertices   Vertices of the mesh, their normals receive the sums. */
+    void computeVertexNormals( const std::vector<Triangle>& p_triangles, std::vector<Vertex>& po_vertices );
+
+}; // namespace gw2b
+
+#endif // READERS_VERTEXNORMALS_H_INCLUDED
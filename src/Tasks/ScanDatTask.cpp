@@ -28,19 +28,34 @@
 #include "ScanDatTask.h"
 
 #include "DatFile.h"
+#include "DatHeaderCache.h"
 #include "DatIndex.h"
 #include "FileReader.h"
 
 namespace gw2b {
 
-    ScanDatTask::ScanDatTask( const std::shared_ptr<DatIndex>& p_index, DatFile& p_datFile )
+    namespace {
+        /** Time between two index checkpoints while scanning. */
+        const auto CheckpointInterval = std::chrono::seconds( 60 );
+        /** Amount of categories/entries the checkpoint thread writes per cycle. */
+        const uint CheckpointWriteAmount = 1024;
+    };
+
+    ScanDatTask::ScanDatTask( const std::shared_ptr<DatIndex>& p_index, DatFile& p_datFile, DatHeaderCache& p_headerCache, const wxFileName& p_indexFilename )
         : m_index( p_index )
-        , m_datFile( p_datFile ) {
+        , m_datFile( p_datFile )
+        , m_headerCache( p_headerCache )
+        , m_indexFilename( p_indexFilename )
+        , m_checkpointRunning( false )
+        , m_checkpointAbort( false )
+        , m_lastCheckpoint( std::chrono::steady_clock::now( ) ) {
         Ensure::notNull( p_index.get( ) );
         Ensure::notNull( &p_datFile );
+        Ensure::notNull( &p_headerCache );
     }
 
     ScanDatTask::~ScanDatTask( ) {
+        this->finishCheckpoint( true );
     }
 
     bool ScanDatTask::init( ) {
@@ -54,13 +69,20 @@ namespace gw2b {
     }
 
     void ScanDatTask::perform( ) {
-        uint bytetoread = 32;
-        // Make sure the output buffer is big enough
-        this->ensureBufferSize( bytetoread );
+        // The final index gets written once done, the checkpoint must not race it
+        if ( this->currentProgress( ) + 1 >= this->maxProgress( ) ) {
+            this->finishCheckpoint( false );
+        } else {
+            this->checkpoint( );
+        }
 
-        // Read file
+        // Read enough to fill the header cache, most files are identified from it
+        uint bytetoread = DatHeaderCache_PrefixSize;
+
+        // Read file, or its cached header
         uint32 entryNumber = this->currentProgress( );
-        uint size = m_datFile.peekFile( entryNumber, bytetoread, m_outputBuffer.GetPointer( ) );
+        uint fileSize = 0;
+        uint size = this->readHeader( entryNumber, bytetoread, fileSize );
 
         // Skip if empty
         if ( !size ) {
@@ -68,9 +90,6 @@ namespace gw2b {
             return;
         }
         
-        // Get the full file size first - we'll need this for filtering
-        uint fileSize = m_datFile.fileSize(entryNumber);
-        
         // Define minimum size threshold - 5KB
         const uint MIN_SIZE_THRESHOLD = 5 * 1024; // 5KB in bytes
 
@@ -90,8 +109,7 @@ namespace gw2b {
             lastRequestedSize = sizeRequired;
 
             // Re-read with the newly asked-for size
-            this->ensureBufferSize( sizeRequired );
-            size = m_datFile.peekFile( entryNumber, sizeRequired, m_outputBuffer.GetPointer( ) );
+            size = this->readHeader( entryNumber, sizeRequired, fileSize );
             results = m_datFile.identifyFileType( m_outputBuffer.GetPointer( ), size, fileType );
         }
 
@@ -100,6 +118,9 @@ namespace gw2b {
             this->setCurrentProgress( entryNumber + 1 );
             return;
         }
+
+        // Keep the header, so re-categorizing later won't need to read the .dat
+        m_headerCache.add( entryNumber, fileSize, m_outputBuffer.GetPointer( ), size );
         
         // Check if it's a model or texture file that should be filtered
         bool isModel = (fileType == ANFT_Model);
@@ -123,14 +144,13 @@ namespace gw2b {
         
         // Debug log for model files to understand size determination
         if (isModel) {
-            uint baseId = m_datFile.baseIdFromFileNum(entryNumber);
-            wxLogMessage(wxT("Model file detected - ID: %d, Size: %d bytes"), baseId, fileSize);
+            LogDebug(wxT("Model file detected - ID: %d, Size: %d bytes"), m_datFile.baseIdFromFileNum(entryNumber), fileSize);
         }
         
         // Skip small model and texture files
         if ((isModel || isTexture) && fileSize < MIN_SIZE_THRESHOLD) {
             // Log skipped file for debugging
-            wxLogMessage(wxT("Skipping small %s file: %d (size: %d bytes)"), 
+            LogDebug(wxT("Skipping small %s file: %d (size: %d bytes)"),
                         isModel ? wxT("model") : wxT("texture"),
                         m_datFile.baseIdFromFileNum(entryNumber),
                         fileSize);
@@ -164,6 +184,74 @@ namespace gw2b {
         this->setCurrentProgress( entryNumber + 1 );
     }
 
+    void ScanDatTask::abort( ) {
+        this->finishCheckpoint( true );
+    }
+
+    void ScanDatTask::checkpoint( ) {
+        if ( m_checkpointRunning ) {
+            return;
+        }
+        if ( m_checkpointThread.joinable( ) ) {
+            m_checkpointThread.join( );
+        }
+
+        auto now = std::chrono::steady_clock::now( );
+        if ( now - m_lastCheckpoint < CheckpointInterval ) {
+            return;
+        }
+        m_lastCheckpoint = now;
+
+        if ( !m_indexFilename.DirExists( ) ) {
+            m_indexFilename.Mkdir( 511, wxPATH_MKDIR_FULL );
+        }
+
+        // The writer takes its snapshot here, everything added later is left for
+        // the next checkpoint
+        m_checkpointWriter.reset( new DatIndexWriter( *m_index ) );
+        if ( !m_checkpointWriter->open( m_indexFilename.GetFullPath( ) ) ) {
+            m_checkpointWriter.reset( );
+            return;
+        }
+
+        m_checkpointRunning = true;
+        m_checkpointAbort = false;
+        m_checkpointThread = std::thread( [this] ( ) {
+            while ( !m_checkpointAbort && !m_checkpointWriter->isDone( ) ) {
+                if ( !m_checkpointWriter->write( CheckpointWriteAmount ) ) {
+                    break;
+                }
+            }
+            // Drops the temporary file if it wasn't committed
+            m_checkpointWriter->close( );
+            m_checkpointRunning = false;
+        } );
+    }
+
+    void ScanDatTask::finishCheckpoint( bool p_abort ) {
+        if ( m_checkpointThread.joinable( ) ) {
+            m_checkpointAbort = p_abort;
+            m_checkpointThread.join( );
+        }
+        m_checkpointWriter.reset( );
+    }
+
+    uint ScanDatTask::readHeader( uint32 p_entryNumber, uint p_size, uint& po_fileSize ) {
+        this->ensureBufferSize( p_size );
+
+        // Use the cached header if it has the asked-for size, or the whole file
+        uint cachedSize = 0;
+        auto cached = m_headerCache.find( p_entryNumber, cachedSize, po_fileSize );
+        if ( cached && ( cachedSize >= p_size || cachedSize == po_fileSize ) ) {
+            auto size = std::min( cachedSize, p_size );
+            ::memcpy( m_outputBuffer.GetPointer( ), cached, size );
+            return size;
+        }
+
+        po_fileSize = m_datFile.fileSize( p_entryNumber );
+        return m_datFile.peekFile( p_entryNumber, p_size, m_outputBuffer.GetPointer( ) );
+    }
+
     uint ScanDatTask::requiredIdentificationSize( const byte* p_data, size_t p_size, ANetFileType p_fileType ) {
         switch ( p_fileType ) {
         case ANFT_Binary:
@@ -28,11 +28,18 @@
 #ifndef TASKS_SCANDATTASK_H_INCLUDED
 #define TASKS_SCANDATTASK_H_INCLUDED
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <wx/filename.h>
+
 #include "ANetStructs.h"
+#include "DatIndexIO.h"
 #include "Task.h"
 
 namespace gw2b {
     class DatFile;
+    class DatHeaderCache;
     class DatIndex;
     class DatIndexCategory;
 
@@ -40,16 +47,28 @@ namespace gw2b {
         std::shared_ptr<DatIndex>   m_index;
         Array<byte>                 m_outputBuffer;
         DatFile&                    m_datFile;
+        DatHeaderCache&             m_headerCache;
+        wxFileName                  m_indexFilename;
+        // Checkpointing
+        std::unique_ptr<DatIndexWriter>         m_checkpointWriter;
+        std::thread                             m_checkpointThread;
+        std::atomic<bool>                       m_checkpointRunning;
+        std::atomic<bool>                       m_checkpointAbort;
+        std::chrono::steady_clock::time_point   m_lastCheckpoint;
     public:
-        ScanDatTask( const std::shared_ptr<DatIndex>& p_index, DatFile& p_datFile );
+        ScanDatTask( const std::shared_ptr<DatIndex>& p_index, DatFile& p_datFile, DatHeaderCache& p_headerCache, const wxFileName& p_indexFilename );
         virtual ~ScanDatTask( );
 
         virtual bool init( ) override;
         virtual void perform( ) override;
+        virtual void abort( ) override;
     private:
+        void checkpoint( );
+        void finishCheckpoint( bool p_abort );
         uint requiredIdentificationSize( const byte* p_data, size_t p_size, ANetFileType p_fileType );
         bool isBitmapFontChunk(uint p_baseId);
         DatIndexCategory* categorize( ANetFileType p_fileType, const byte* p_data, size_t p_size );
+        uint readHeader( uint32 p_entryNumber, uint p_size, uint& po_fileSize );
         void ensureBufferSize( size_t p_size );
     }; // class ScanDatTask
 
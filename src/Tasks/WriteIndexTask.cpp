@@ -56,10 +56,9 @@ namespace gw2b {
             uint progress = m_writer.currentEntry( ) + m_writer.currentCategory( );
             this->setCurrentProgress( progress );
             this->setText( wxT( "Saving .dat index..." ) );
-            // If something went wrong, we should delete the file again since it's half-complete
-            auto path = m_filename.GetFullPath( );
-            if ( m_errorOccured && wxFile::Exists( path ) ) {
-                wxRemoveFile( path );
+            // If something went wrong, drop the half-complete file, the old index is kept
+            if ( m_errorOccured ) {
+                m_writer.close( );
             }
             // If done, remove the dirty flag from the index
             if ( this->isDone( ) ) {
@@ -69,12 +68,8 @@ namespace gw2b {
     }
 
     void WriteIndexTask::abort( ) {
+        // Removes the half-complete file, the old index is kept
         m_writer.close( );
-        // Remove the file again
-        auto path = m_filename.GetFullPath( );
-        if ( wxFile::Exists( path ) ) {
-            wxRemoveFile( path );
-        }
     }
 
     void WriteIndexTask::clean( ) {
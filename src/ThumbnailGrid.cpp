@@ -0,0 +1,338 @@
+/** \file       ThumbnailGrid.cpp
+ *  \brief      Contains definition of the thumbnail grid control.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <wx/dcclient.h>
+
+#include "EventId.h"
+
+#include "ThumbnailGrid.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Max width and height of the thumbnails, in pixels. */
+        const uint ThumbnailSize = 64;
+        /** Space around a thumbnail, in pixels. */
+        const int CellPadding = 6;
+        /** Max amount of thumbnails kept as bitmaps, those far away from the
+        *  visible rows are dropped past this. */
+        const size_t MaxBitmaps = 1024;
+
+        /** Appends the image entries of a category and its sub-categories. */
+        void collectImages( const DatIndexCategory& p_category, std::vector<const DatIndexEntry*>& po_entries ) {
+            for ( uint i = 0; i < p_category.numEntries( ); i++ ) {
+                auto entry = p_category.entry( i );
+                auto type = entry->fileType( );
+                if ( ( type > ANFT_TextureStart ) && ( type < ANFT_TextureEnd ) && ( type != ANFT_CTEX ) ) {
+                    po_entries.push_back( entry );
+                }
+            }
+            for ( uint i = 0; i < p_category.numSubCategories( ); i++ ) {
+                collectImages( *p_category.subCategory( i ), po_entries );
+            }
+        }
+
+    };
+
+    ThumbnailGrid::ThumbnailGrid( wxWindow* p_parent, const wxPoint& p_location, const wxSize& p_size )
+        : wxScrolledWindow( p_parent, wxID_ANY, p_location, p_size, wxVSCROLL | wxFULL_REPAINT_ON_RESIZE )
+        , m_loader( this, ID_ThumbnailsLoaded, ThumbnailSize )
+        , m_columns( 1 )
+        , m_selection( -1 )
+        , m_requestedFirst( -1 )
+        , m_requestedLast( -1 ) {
+        this->SetBackgroundColour( wxSystemSettings::GetColour( wxSYS_COLOUR_WINDOW ) );
+        this->SetScrollRate( 0, this->cellSize( ).y / 4 );
+
+        this->Bind( wxEVT_THREAD, &ThumbnailGrid::onThumbnailsLoaded, this, ID_ThumbnailsLoaded );
+        this->Bind( wxEVT_SIZE, &ThumbnailGrid::onSizeEvt, this );
+        this->Bind( wxEVT_LEFT_DOWN, &ThumbnailGrid::onLeftDownEvt, this );
+        this->Bind( wxEVT_LEFT_DCLICK, &ThumbnailGrid::onLeftDClickEvt, this );
+    }
+
+    //============================================================================/
+
+    ThumbnailGrid::~ThumbnailGrid( ) {
+        m_loader.close( );
+    }
+
+    //============================================================================/
+
+    bool ThumbnailGrid::open( const wxString& p_datPath, DatEntryCache* p_cache ) {
+        this->clear( );
+        return m_loader.open( p_datPath, p_cache );
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::close( ) {
+        this->clear( );
+        m_loader.close( );
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::setCategory( const DatIndexCategory& p_category ) {
+        this->clear( );
+
+        collectImages( p_category, m_entries );
+        for ( uint i = 0; i < m_entries.size( ); i++ ) {
+            m_indices[m_entries[i]->mftEntry( )] = i;
+        }
+
+        this->updateLayout( );
+        this->Scroll( 0, 0 );
+        this->Refresh( );
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::clear( ) {
+        m_loader.cancel( );
+        m_entries.clear( );
+        m_indices.clear( );
+        m_bitmaps.clear( );
+        m_selection = -1;
+        m_requestedFirst = -1;
+        m_requestedLast = -1;
+
+        this->updateLayout( );
+        this->Refresh( );
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::cancel( ) {
+        m_loader.cancel( );
+        m_requestedFirst = -1;
+        m_requestedLast = -1;
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::addListener( IThumbnailGridListener* p_listener ) {
+        m_listeners.insert( p_listener );
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::removeListener( IThumbnailGridListener* p_listener ) {
+        m_listeners.erase( p_listener );
+    }
+
+    //============================================================================/
+
+    wxSize ThumbnailGrid::cellSize( ) const {
+        return wxSize( ThumbnailSize + CellPadding * 2, ThumbnailSize + this->GetCharHeight( ) + CellPadding * 3 );
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::updateLayout( ) {
+        auto cell = this->cellSize( );
+        m_columns = wxMax( this->GetClientSize( ).x / cell.x, 1 );
+
+        int rows = ( static_cast<int>( m_entries.size( ) ) + m_columns - 1 ) / m_columns;
+        this->SetVirtualSize( m_columns * cell.x, rows * cell.y );
+    }
+
+    //============================================================================/
+
+    int ThumbnailGrid::hitTest( const wxPoint& p_position ) const {
+        auto cell = this->cellSize( );
+        auto position = this->CalcUnscrolledPosition( p_position );
+
+        int column = position.x / cell.x;
+        if ( ( position.x < 0 ) || ( position.y < 0 ) || ( column >= m_columns ) ) {
+            return -1;
+        }
+
+        int index = ( position.y / cell.y ) * m_columns + column;
+        return ( index < static_cast<int>( m_entries.size( ) ) ) ? index : -1;
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::OnDraw( wxDC& p_dc ) {
+        if ( m_entries.empty( ) ) {
+            return;
+        }
+
+        auto cell = this->cellSize( );
+        auto top = this->CalcUnscrolledPosition( wxPoint( 0, 0 ) ).y;
+        int firstRow = top / cell.y;
+        int lastRow = ( top + this->GetClientSize( ).y ) / cell.y;
+
+        if ( ( firstRow != m_requestedFirst ) || ( lastRow != m_requestedLast ) ) {
+            this->requestThumbnails( firstRow, lastRow );
+        }
+
+        auto selectionColour = wxSystemSettings::GetColour( wxSYS_COLOUR_HIGHLIGHT );
+        auto placeholderColour = wxSystemSettings::GetColour( wxSYS_COLOUR_3DLIGHT );
+        p_dc.SetFont( this->GetFont( ) );
+
+        int numEntries = static_cast<int>( m_entries.size( ) );
+        for ( int row = firstRow; row <= lastRow; row++ ) {
+            for ( int column = 0; column < m_columns; column++ ) {
+                int index = row * m_columns + column;
+                if ( index >= numEntries ) {
+                    return;
+                }
+
+                wxRect rect( column * cell.x, row * cell.y, cell.x, cell.y );
+                if ( index == m_selection ) {
+                    p_dc.SetPen( *wxTRANSPARENT_PEN );
+                    p_dc.SetBrush( wxBrush( selectionColour ) );
+                    p_dc.DrawRectangle( rect );
+                }
+
+                auto bitmap = m_bitmaps.find( index );
+                if ( bitmap != m_bitmaps.end( ) ) {
+                    // Center the thumbnail in its box
+                    auto size = bitmap->second.GetSize( );
+                    p_dc.DrawBitmap( bitmap->second,
+                        rect.x + CellPadding + ( ThumbnailSize - size.x ) / 2,
+                        rect.y + CellPadding + ( ThumbnailSize - size.y ) / 2, true );
+                } else {
+                    p_dc.SetPen( wxPen( placeholderColour ) );
+                    p_dc.SetBrush( *wxTRANSPARENT_BRUSH );
+                    p_dc.DrawRectangle( rect.x + CellPadding, rect.y + CellPadding, ThumbnailSize, ThumbnailSize );
+                }
+
+                auto label = wxControl::Ellipsize( m_entries[index]->name( ), p_dc, wxELLIPSIZE_END, cell.x - 2 );
+                p_dc.SetTextForeground( wxSystemSettings::GetColour( ( index == m_selection ) ? wxSYS_COLOUR_HIGHLIGHTTEXT : wxSYS_COLOUR_WINDOWTEXT ) );
+                p_dc.DrawLabel( label, wxRect( rect.x, rect.y + ThumbnailSize + CellPadding * 2, cell.x, this->GetCharHeight( ) ), wxALIGN_CENTER_HORIZONTAL );
+            }
+        }
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::requestThumbnails( int p_firstRow, int p_lastRow ) {
+        m_requestedFirst = p_firstRow;
+        m_requestedLast = p_lastRow;
+
+        int numEntries = static_cast<int>( m_entries.size( ) );
+        int pageSize = ( p_lastRow - p_firstRow + 1 ) * m_columns;
+        int first = p_firstRow * m_columns;
+        int last = wxMin( ( p_lastRow + 1 ) * m_columns, numEntries ) - 1;
+
+        std::vector<ThumbnailLoader::Request> requests;
+        auto addRequest = [&] ( int p_index ) {
+            if ( ( p_index < 0 ) || ( p_index >= numEntries ) || m_bitmaps.count( p_index ) ) {
+                return;
+            }
+            auto entry = m_entries[p_index];
+            requests.push_back( ThumbnailLoader::Request{ entry->mftEntry( ), entry->fileId( ), entry->fileType( ) } );
+        };
+
+        // Visible ones first, then a page below since that's where users
+        // usually scroll to, then a page above
+        for ( int i = first; i <= last; i++ ) {
+            addRequest( i );
+        }
+        for ( int i = last + 1; i <= last + pageSize; i++ ) {
+            addRequest( i );
+        }
+        for ( int i = first - 1; i >= first - pageSize; i-- ) {
+            addRequest( i );
+        }
+        m_loader.request( requests );
+
+        // Drop the bitmaps furthest away
+        if ( m_bitmaps.size( ) > MaxBitmaps ) {
+            int keep = static_cast<int>( MaxBitmaps / 2 );
+            for ( auto it = m_bitmaps.begin( ); it != m_bitmaps.end( ); ) {
+                int index = static_cast<int>( it->first );
+                if ( ( index < first - keep ) || ( index > last + keep ) ) {
+                    it = m_bitmaps.erase( it );
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::onThumbnailsLoaded( wxThreadEvent& WXUNUSED( p_event ) ) {
+        std::vector<ThumbnailLoader::Thumbnail> thumbnails;
+        if ( !m_loader.fetchThumbnails( thumbnails ) ) {
+            return;
+        }
+
+        for ( auto& it : thumbnails ) {
+            auto index = m_indices.find( it.entryNumber );
+            if ( index == m_indices.end( ) ) {
+                continue;
+            }
+
+            wxImage image( it.size.x, it.size.y, false );
+            ::memcpy( image.GetData( ), it.colors.GetPointer( ), it.colors.GetSize( ) );
+            if ( it.alphas.GetSize( ) ) {
+                image.SetAlpha( );
+                ::memcpy( image.GetAlpha( ), it.alphas.GetPointer( ), it.alphas.GetSize( ) );
+            }
+            m_bitmaps[index->second] = wxBitmap( image );
+        }
+        this->Refresh( );
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::onSizeEvt( wxSizeEvent& p_event ) {
+        this->updateLayout( );
+        this->Refresh( );
+        p_event.Skip( );
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::onLeftDownEvt( wxMouseEvent& p_event ) {
+        m_selection = this->hitTest( p_event.GetPosition( ) );
+        this->Refresh( );
+        this->SetFocus( );
+        p_event.Skip( );
+    }
+
+    //============================================================================/
+
+    void ThumbnailGrid::onLeftDClickEvt( wxMouseEvent& p_event ) {
+        auto index = this->hitTest( p_event.GetPosition( ) );
+        if ( index < 0 ) {
+            return;
+        }
+
+        // Copy the listeners and entry, activating may clear the grid
+        auto entry = m_entries[index];
+        auto listeners = m_listeners;
+        for ( auto const& it : listeners ) {
+            it->onThumbnailActivated( *this, *entry );
+        }
+    }
+
+}; // namespace gw2b
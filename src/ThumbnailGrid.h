@@ -0,0 +1,140 @@
+/** \file       ThumbnailGrid.h
+ *  \brief      Contains declaration of the thumbnail grid control.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef THUMBNAILGRID_H_INCLUDED
+#define THUMBNAILGRID_H_INCLUDED
+
+#include <wx/scrolwin.h>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "DatIndex.h"
+#include "ThumbnailLoader.h"
+
+namespace gw2b {
+    class ThumbnailGrid;
+
+    /** \interface  IThumbnailGridListener
+    *  Receives events from the thumbnail grid. */
+    class IThumbnailGridListener {
+    public:
+        /** Raised whenever an entry is double clicked in the thumbnail grid.
+        *  \param[in]  p_grid   thumbnail grid invoking the callback.
+        *  \param[in]  p_entry  reference to the activated entry. */
+        virtual void onThumbnailActivated( ThumbnailGrid& p_grid, const DatIndexEntry& p_entry ) {
+        }
+    };
+
+    /** Scrolled grid showing thumbnails of the images in a category. Only the
+    *  visible thumbnails and a page around them are loaded, by a
+    *  ThumbnailLoader in the background. */
+    class ThumbnailGrid : public wxScrolledWindow {
+        typedef std::set<IThumbnailGridListener*>   ListenerSet;
+    private:
+        ThumbnailLoader                     m_loader;
+        std::vector<const DatIndexEntry*>   m_entries;
+        std::unordered_map<uint, uint>      m_indices;          /**< MFT entry number to grid index. */
+        std::unordered_map<uint, wxBitmap>  m_bitmaps;          /**< Loaded thumbnails, by grid index. */
+        ListenerSet                         m_listeners;
+        int                                 m_columns;
+        int                                 m_selection;
+        int                                 m_requestedFirst;   /**< First row of the last request, -1 if none. */
+        int                                 m_requestedLast;    /**< Last row of the last request, -1 if none. */
+    public:
+        /** Constructor. Creates the grid with the given parent.
+        *  \param[in]  p_parent     Parent of the control.
+        *  \param[in]  p_location   Optional location of the control.
+        *  \param[in]  p_size       Optional size of the control. */
+        ThumbnailGrid( wxWindow* p_parent, const wxPoint& p_location = wxDefaultPosition, const wxSize& p_size = wxDefaultSize );
+        /** Destructor. */
+        virtual ~ThumbnailGrid( );
+
+        /** Opens the .dat file to load thumbnails from, clearing the grid.
+        *  \param[in]  p_datPath    Path to the .dat file.
+        *  \param[in]  p_cache      Cache keeping the thumbnails, nullptr for none.
+        *  \return bool    true if opened, false if not. */
+        bool open( const wxString& p_datPath, DatEntryCache* p_cache );
+        /** Stops loading and closes the .dat file, clearing the grid. */
+        void close( );
+
+        /** Shows the images of the given category and its sub-categories.
+        *  \param[in]  p_category   Category to show. */
+        void setCategory( const DatIndexCategory& p_category );
+        /** Removes all entries from the grid. */
+        void clear( );
+        /** Stops loading thumbnails until the grid is painted again. */
+        void cancel( );
+        /** Gets the amount of entries shown in the grid.
+        *  \return size_t  Amount of entries. */
+        size_t numEntries( ) const {
+            return m_entries.size( );
+        }
+
+        /** Adds a listener that will receive events from the grid.
+        *  \param[in]  p_listener   Listener to add. */
+        void addListener( IThumbnailGridListener* p_listener );
+        /** Removes a listener from the grid.
+        *  \param[in]  p_listener   Listener to remove. */
+        void removeListener( IThumbnailGridListener* p_listener );
+    protected:
+        /** Paints the visible cells, requesting their thumbnails when the
+        *  visible rows changed.
+        *  \param[in]  p_dc     Device context, already prepared for scrolling. */
+        virtual void OnDraw( wxDC& p_dc ) override;
+    private:
+        /** Gets the size of a cell, thumbnail and label.
+        *  \return wxSize  Size of a cell, in pixels. */
+        wxSize cellSize( ) const;
+        /** Recomputes the amount of columns and the virtual size of the grid. */
+        void updateLayout( );
+        /** Gets the entry at the given position.
+        *  \param[in]  p_position   Position in client coordinates.
+        *  \return int     Grid index of the entry, -1 if none. */
+        int hitTest( const wxPoint& p_position ) const;
+        /** Requests the thumbnails of the given rows, then a page below and
+        *  above them. Drops loaded thumbnails far away from them.
+        *  \param[in]  p_firstRow   First visible row.
+        *  \param[in]  p_lastRow    Last visible row. */
+        void requestThumbnails( int p_firstRow, int p_lastRow );
+
+        /** Event raised by the loader when new thumbnails are available.
+        *  \param[in]  p_event  Unused event object handed to us by wxWidgets. */
+        void onThumbnailsLoaded( wxThreadEvent& p_event );
+        /** Executed when the grid is resized.
+        *  \param[in]  p_event  Event object handed to us by wxWidgets. */
+        void onSizeEvt( wxSizeEvent& p_event );
+        /** Executed when the user clicks the grid.
+        *  \param[in]  p_event  Event object handed to us by wxWidgets. */
+        void onLeftDownEvt( wxMouseEvent& p_event );
+        /** Executed when the user double clicks the grid.
+        *  \param[in]  p_event  Event object handed to us by wxWidgets. */
+        void onLeftDClickEvt( wxMouseEvent& p_event );
+    }; // class ThumbnailGrid
+
+}; // namespace gw2b
+
+#endif // THUMBNAILGRID_H_INCLUDED
@@ -0,0 +1,316 @@
+/** \file       ThumbnailLoader.cpp
+ *  \brief      Contains definition of the background thumbnail loader.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <iterator>
+
+#include "DatEntryCache.h"
+#include "FileReader.h"
+#include "Readers/ImageReader.h"
+
+#include "ThumbnailLoader.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Max amount of workers. They take turns reading the .dat, so more
+        *  than this mostly wait. */
+        const uint MaxWorkers = 8;
+
+        /** Head of a cached thumbnail, followed by the colors and, if any, the
+        *  alphas. */
+        struct CachedThumbnailHead {
+            uint32  width;
+            uint32  height;
+            uint32  hasAlpha;
+        };
+
+        /** Gets the size of an image shrunk to fit a square, keeping its aspect
+        *  ratio. Images already fitting keep their size. */
+        wxSize fitSize( const wxSize& p_size, uint p_maxSize ) {
+            const int maxSize = static_cast<int>( p_maxSize );
+            if ( ( p_size.x <= maxSize ) && ( p_size.y <= maxSize ) ) {
+                return p_size;
+            }
+            if ( p_size.x >= p_size.y ) {
+                return wxSize( maxSize, wxMax( p_size.y * maxSize / p_size.x, 1 ) );
+            }
+            return wxSize( wxMax( p_size.x * maxSize / p_size.y, 1 ), maxSize );
+        }
+
+    };
+
+    ThumbnailLoader::ThumbnailLoader( wxEvtHandler* p_handler, int p_eventId, uint p_thumbnailSize )
+        : m_handler( p_handler )
+        , m_eventId( p_eventId )
+        , m_thumbnailSize( p_thumbnailSize )
+        , m_cache( nullptr )
+        , m_notified( false )
+        , m_stop( false ) {
+        Ensure::notNull( p_handler );
+    }
+
+    ThumbnailLoader::~ThumbnailLoader( ) {
+        this->close( );
+    }
+
+    //============================================================================/
+
+    bool ThumbnailLoader::open( const wxString& p_datPath, DatEntryCache* p_cache ) {
+        this->close( );
+
+        if ( !m_datFile.open( p_datPath ) ) {
+            return false;
+        }
+        m_cache = p_cache;
+
+        // Leave a core to the UI thread
+        auto numThreads = wxMin( wxMax( std::thread::hardware_concurrency( ), 2u ) - 1, MaxWorkers );
+        for ( uint i = 0; i < numThreads; i++ ) {
+            m_threads.push_back( std::thread( &ThumbnailLoader::workerThread, this ) );
+        }
+        return true;
+    }
+
+    //============================================================================/
+
+    void ThumbnailLoader::close( ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+            m_queue.clear( );
+            m_wanted.clear( );
+        }
+        m_wakeUp.notify_all( );
+        for ( auto& it : m_threads ) {
+            it.join( );
+        }
+        m_threads.clear( );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_results.clear( );
+        m_loading.clear( );
+        m_notified = false;
+        m_stop = false;
+        m_cache = nullptr;
+        m_datFile.close( );
+    }
+
+    //============================================================================/
+
+    void ThumbnailLoader::request( const std::vector<Request>& p_requests ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_queue.clear( );
+            m_wanted.clear( );
+
+            for ( auto const& it : p_requests ) {
+                m_wanted.insert( it.entryNumber );
+                // Already being decoded ones stay wanted, but aren't queued again
+                if ( !m_loading.count( it.entryNumber ) ) {
+                    m_queue.push_back( it );
+                }
+            }
+        }
+        m_wakeUp.notify_all( );
+    }
+
+    //============================================================================/
+
+    void ThumbnailLoader::cancel( ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_queue.clear( );
+        m_wanted.clear( );
+        m_results.clear( );
+    }
+
+    //============================================================================/
+
+    bool ThumbnailLoader::fetchThumbnails( std::vector<Thumbnail>& po_thumbnails ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_notified = false;
+
+        if ( m_results.empty( ) ) {
+            return false;
+        }
+        std::move( m_results.begin( ), m_results.end( ), std::back_inserter( po_thumbnails ) );
+        m_results.clear( );
+        return true;
+    }
+
+    //============================================================================/
+
+    void ThumbnailLoader::workerThread( ) {
+        for ( ;; ) {
+            Request request;
+
+            {
+                std::unique_lock<std::mutex> lock( m_mutex );
+                m_wakeUp.wait( lock, [this] ( ) { return m_stop || !m_queue.empty( ); } );
+                if ( m_stop ) {
+                    return;
+                }
+
+                request = m_queue.front( );
+                m_queue.pop_front( );
+                m_loading.insert( request.entryNumber );
+            }
+
+            Thumbnail thumbnail;
+            bool isLoaded = this->loadThumbnail( request, thumbnail );
+
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_loading.erase( request.entryNumber );
+            if ( isLoaded ) {
+                this->publish( thumbnail );
+            }
+            m_wanted.erase( request.entryNumber );
+        }
+    }
+
+    //============================================================================/
+
+    bool ThumbnailLoader::loadThumbnail( const Request& p_request, Thumbnail& po_thumbnail ) {
+        po_thumbnail.entryNumber = p_request.entryNumber;
+
+        DatEntryCacheKey cacheKey;
+        cacheKey.kind = DECK_Thumbnail;
+        cacheKey.mftEntry = p_request.fileId;
+        cacheKey.size = m_thumbnailSize;
+        cacheKey.offset = 0;
+        {
+            std::lock_guard<std::mutex> lock( m_datMutex );
+            cacheKey.crc = m_datFile.entryCrc( p_request.entryNumber + m_datFile.mftFileOffset( ) );
+        }
+
+        // Decoded in this or an earlier session?
+        if ( m_cache ) {
+            auto cached = m_cache->read( cacheKey );
+            if ( cached.GetSize( ) >= sizeof( CachedThumbnailHead ) ) {
+                auto head = reinterpret_cast<const CachedThumbnailHead*>( cached.GetPointer( ) );
+                auto numPixels = static_cast<size_t>( head->width ) * head->height;
+                if ( cached.GetSize( ) == sizeof( *head ) + numPixels * ( head->hasAlpha ? 4 : 3 ) ) {
+                    auto colors = cached.GetPointer( ) + sizeof( *head );
+                    po_thumbnail.size.Set( head->width, head->height );
+                    po_thumbnail.colors = Array<byte>( numPixels * 3 );
+                    ::memcpy( po_thumbnail.colors.GetPointer( ), colors, numPixels * 3 );
+                    if ( head->hasAlpha ) {
+                        po_thumbnail.alphas = Array<byte>( numPixels );
+                        ::memcpy( po_thumbnail.alphas.GetPointer( ), colors + numPixels * 3, numPixels );
+                    }
+                    return true;
+                }
+            }
+        }
+
+        if ( !this->isWanted( p_request.entryNumber ) ) {
+            return false;
+        }
+
+        Array<byte> data;
+        {
+            std::lock_guard<std::mutex> lock( m_datMutex );
+            data = m_datFile.readFile( p_request.entryNumber );
+        }
+        if ( !data.GetSize( ) || !this->isWanted( p_request.entryNumber ) ) {
+            return false;
+        }
+
+        auto reader = FileReader::readerForData( data, m_datFile, p_request.fileType, p_request.entryNumber + m_datFile.mftFileOffset( ) );
+        auto imgReader = dynamic_cast<ImageReader*>( reader );
+        if ( !imgReader ) {
+            deletePointer( reader );
+            return false;
+        }
+
+        // Decode no more pixels than the thumbnail needs
+        wxImage image;
+        wxSize size;
+        bool hasAlpha;
+        if ( imgReader->getImageInfo( size, hasAlpha ) && ( size.x > 0 ) && ( size.y > 0 ) ) {
+            auto thumbnailSize = fitSize( size, m_thumbnailSize );
+            image = imgReader->getScaledImage( ImageReader::scaleForSize( size, thumbnailSize ) );
+            if ( image.IsOk( ) && ( image.GetSize( ) != thumbnailSize ) ) {
+                image.Rescale( thumbnailSize.x, thumbnailSize.y, wxIMAGE_QUALITY_BOX_AVERAGE );
+            }
+        }
+        deletePointer( reader );
+
+        if ( !image.IsOk( ) ) {
+            return false;
+        }
+
+        auto numPixels = static_cast<size_t>( image.GetWidth( ) ) * image.GetHeight( );
+        po_thumbnail.size = image.GetSize( );
+        po_thumbnail.colors = Array<byte>( numPixels * 3 );
+        ::memcpy( po_thumbnail.colors.GetPointer( ), image.GetData( ), numPixels * 3 );
+        if ( image.HasAlpha( ) ) {
+            po_thumbnail.alphas = Array<byte>( numPixels );
+            ::memcpy( po_thumbnail.alphas.GetPointer( ), image.GetAlpha( ), numPixels );
+        }
+
+        if ( m_cache ) {
+            auto alphaSize = po_thumbnail.alphas.GetSize( );
+            Array<byte> payload( sizeof( CachedThumbnailHead ) + numPixels * 3 + alphaSize );
+            auto head = reinterpret_cast<CachedThumbnailHead*>( payload.GetPointer( ) );
+            head->width = po_thumbnail.size.x;
+            head->height = po_thumbnail.size.y;
+            head->hasAlpha = alphaSize ? 1 : 0;
+
+            auto colors = payload.GetPointer( ) + sizeof( *head );
+            ::memcpy( colors, po_thumbnail.colors.GetPointer( ), numPixels * 3 );
+            if ( alphaSize ) {
+                ::memcpy( colors + numPixels * 3, po_thumbnail.alphas.GetPointer( ), alphaSize );
+            }
+            m_cache->add( cacheKey, payload.GetPointer( ), payload.GetSize( ) );
+        }
+
+        return true;
+    }
+
+    //============================================================================/
+
+    void ThumbnailLoader::publish( Thumbnail& p_thumbnail ) {
+        if ( !m_wanted.count( p_thumbnail.entryNumber ) ) {
+            return;
+        }
+        m_results.push_back( std::move( p_thumbnail ) );
+
+        // Only one notification in flight, the handler fetches everything
+        if ( !m_notified ) {
+            m_notified = true;
+            wxQueueEvent( m_handler, new wxThreadEvent( wxEVT_THREAD, m_eventId ) );
+        }
+    }
+
+    //============================================================================/
+
+    bool ThumbnailLoader::isWanted( uint p_entryNumber ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return !m_stop && m_wanted.count( p_entryNumber );
+    }
+
+}; // namespace gw2b
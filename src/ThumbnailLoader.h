@@ -0,0 +1,140 @@
+/** \file       ThumbnailLoader.h
+ *  \brief      Contains declaration of the background thumbnail loader.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef THUMBNAILLOADER_H_INCLUDED
+#define THUMBNAILLOADER_H_INCLUDED
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "DatFile.h"
+
+namespace gw2b {
+    class DatEntryCache;
+
+    /** Decodes thumbnails of image entries on a pool of worker threads,
+    *  streaming them back to an event handler as they are done.
+    *
+    *  The workers read the .dat through their own handle, so the UI thread can
+    *  keep using its DatFile. Thumbnails are kept in a DatEntryCache, keyed by
+    *  the file ID and MFT crc of their entry, so they only ever get decoded
+    *  once per version of the file.
+    *
+    *  Every call to request() replaces the queue: entries no longer requested
+    *  are cancelled, even while being decoded. */
+    class ThumbnailLoader {
+    public:
+        /** Entry to make a thumbnail of. */
+        struct Request {
+            uint            entryNumber;    /**< File number of the file, as in DatIndexEntry::mftEntry(). */
+            uint            fileId;         /**< File ID of the file. */
+            ANetFileType    fileType;       /**< Type of the file. */
+        };
+        /** A decoded thumbnail, in the layout of wxImage. */
+        struct Thumbnail {
+            uint            entryNumber;    /**< File number of the file, as in DatIndexEntry::mftEntry(). */
+            wxSize          size;           /**< Size of the thumbnail, in pixels. */
+            Array<byte>     colors;         /**< 3 bytes per pixel, red first. */
+            Array<byte>     alphas;         /**< 1 byte per pixel, empty if the image has no alpha. */
+        };
+    private:
+        wxEvtHandler*               m_handler;
+        int                         m_eventId;
+        uint                        m_thumbnailSize;
+        DatEntryCache*              m_cache;
+
+        // The workers' handle on the .dat, guarded by m_datMutex
+        std::mutex                  m_datMutex;
+        DatFile                     m_datFile;
+
+        // Shared between the UI and the worker threads, guarded by m_mutex
+        std::mutex                  m_mutex;
+        std::condition_variable     m_wakeUp;
+        std::deque<Request>         m_queue;
+        std::unordered_set<uint>    m_wanted;
+        std::unordered_set<uint>    m_loading;
+        std::vector<Thumbnail>      m_results;
+        bool                        m_notified;
+        bool                        m_stop;
+        std::vector<std::thread>    m_threads;
+    public:
+        /** Constructor. No workers run until open() is called.
+        *  \param[in]  p_handler        Handler receiving a wxThreadEvent whenever
+        *                               new thumbnails are available.
+        *  \param[in]  p_eventId        Id of the posted wxThreadEvent.
+        *  \param[in]  p_thumbnailSize  Max width and height of the thumbnails. */
+        ThumbnailLoader( wxEvtHandler* p_handler, int p_eventId, uint p_thumbnailSize );
+        /** Destructor. Stops the workers. */
+        ~ThumbnailLoader( );
+
+        /** Opens the .dat file to load from and starts the workers, closing the
+        *  previous one.
+        *  \param[in]  p_datPath    Path to the .dat file.
+        *  \param[in]  p_cache      Cache keeping the thumbnails, nullptr for none.
+        *  \return bool    true if opened, false if not. */
+        bool open( const wxString& p_datPath, DatEntryCache* p_cache );
+        /** Stops the workers and closes the .dat file. Once this returns, the
+        *  cache is no longer used. */
+        void close( );
+
+        /** Replaces the queue, cancelling the entries not in it.
+        *  \param[in]  p_requests   Entries to load, the most wanted first. */
+        void request( const std::vector<Request>& p_requests );
+        /** Cancels all requests. */
+        void cancel( );
+        /** Moves the thumbnails loaded since the last call to the given array.
+        *  \param[in]  po_thumbnails    Array to append the thumbnails to.
+        *  \return bool    true if thumbnails were appended, false if not. */
+        bool fetchThumbnails( std::vector<Thumbnail>& po_thumbnails );
+        /** Gets the max width and height of the thumbnails.
+        *  \return uint    Size, in pixels. */
+        uint thumbnailSize( ) const {
+            return m_thumbnailSize;
+        }
+
+    private:
+        /** Main loop of the worker threads. */
+        void workerThread( );
+        /** Loads a thumbnail from the cache, or decodes it if not cached.
+        *  \param[in]  p_request    Entry to load.
+        *  \param[out] po_thumbnail Receives the thumbnail.
+        *  \return bool    true if loaded, false if not an image or cancelled. */
+        bool loadThumbnail( const Request& p_request, Thumbnail& po_thumbnail );
+        /** Hands a thumbnail to the UI thread if it's still wanted. Must be
+        *  called with m_mutex locked.
+        *  \param[in]  p_thumbnail  Thumbnail to publish. */
+        void publish( Thumbnail& p_thumbnail );
+        /** Checks whether the given entry is still requested. */
+        bool isWanted( uint p_entryNumber );
+    }; // class ThumbnailLoader
+
+}; // namespace gw2b
+
+#endif // THUMBNAILLOADER_H_INCLUDED
@@ -0,0 +1,118 @@
+/** \file       Util/BoundedQueue.h
+ *  \brief      Contains the declaration of a blocking queue of limited size.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef UTIL_BOUNDEDQUEUE_H_INCLUDED
+#define UTIL_BOUNDEDQUEUE_H_INCLUDED
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace gw2b {
+
+    /** Queue passing work between threads. Push() blocks while the queue is
+    *  full, so a fast producer waits for its consumers instead of piling up
+    *  work in memory.
+    *
+    *  Once closed, pushes fail and pops drain what is left. Aborting also
+    *  drops what is left.
+    *  \tparam T   Type of the queued items, moved in and out. */
+    template <typename T>
+    class BoundedQueue {
+        std::mutex                  mMutex;
+        std::condition_variable     mNotFull;
+        std::condition_variable     mNotEmpty;
+        std::deque<T>               mItems;
+        size_t                      mCapacity;
+        bool                        mIsClosed;
+    public:
+        /** Constructor.
+        *  \param[in]  pCapacity    Max amount of queued items, at least 1. */
+        explicit BoundedQueue( size_t pCapacity )
+            : mCapacity( pCapacity ? pCapacity : 1 )
+            , mIsClosed( false ) {
+        }
+
+        BoundedQueue( const BoundedQueue& ) = delete;
+        BoundedQueue& operator=( const BoundedQueue& ) = delete;
+
+        /** Adds an item, waiting for room if the queue is full.
+        *  \param[in]  pItem    Item to add.
+        *  \return bool    true if added, false if the queue was closed. */
+        bool Push( T&& pItem ) {
+            std::unique_lock<std::mutex> lock( mMutex );
+            mNotFull.wait( lock, [this] ( ) { return mIsClosed || mItems.size( ) < mCapacity; } );
+            if ( mIsClosed ) {
+                return false;
+            }
+            mItems.push_back( std::move( pItem ) );
+            lock.unlock( );
+            mNotEmpty.notify_one( );
+            return true;
+        }
+
+        /** Takes the oldest item, waiting for one if the queue is empty.
+        *  \param[out] poItem   Receives the item.
+        *  \return bool    true if an item was taken, false if the queue is
+        *                  closed and empty. */
+        bool Pop( T& poItem ) {
+            std::unique_lock<std::mutex> lock( mMutex );
+            mNotEmpty.wait( lock, [this] ( ) { return mIsClosed || !mItems.empty( ); } );
+            if ( mItems.empty( ) ) {
+                return false;
+            }
+            poItem = std::move( mItems.front( ) );
+            mItems.pop_front( );
+            lock.unlock( );
+            mNotFull.notify_one( );
+            return true;
+        }
+
+        /** Closes the queue: pushes fail from now on, pops take what is left. */
+        void Close( ) {
+            {
+                std::lock_guard<std::mutex> lock( mMutex );
+                mIsClosed = true;
+            }
+            mNotFull.notify_all( );
+            mNotEmpty.notify_all( );
+        }
+
+        /** Closes the queue and drops the items left in it. */
+        void Abort( ) {
+            {
+                std::lock_guard<std::mutex> lock( mMutex );
+                mIsClosed = true;
+                mItems.clear( );
+            }
+            mNotFull.notify_all( );
+            mNotEmpty.notify_all( );
+        }
+    }; // class BoundedQueue
+
+}; // namespace gw2b
+
+#endif // UTIL_BOUNDEDQUEUE_H_INCLUDED
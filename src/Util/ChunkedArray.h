@@ -0,0 +1,207 @@
+/** \file       ChunkedArray.h
+ *  \brief      Contains the declaration for the append-only chunked array class.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef UTIL_CHUNKEDARRAY_H_INCLUDED
+#define UTIL_CHUNKEDARRAY_H_INCLUDED
+
+#include <atomic>
+#include <vector>
+
+namespace gw2b {
+
+    /** Append-only array storing its elements in fixed-size chunks that never
+    *  move once allocated.
+    *
+    *  One thread appends, any number of threads read. Appended elements stay
+    *  invisible to readers until published, after which readers see them
+    *  without taking any lock: GetSize() returns the published count, and
+    *  every element below it is fully written. Directories outgrown by the
+    *  writer are kept alive until Clear(), so a reader holding an old one
+    *  stays valid.
+    *
+    *  Clear() is the only operation that frees memory and must not run while
+    *  other threads read from the array.
+    *  \tparam T           Type of elements stored in the array.
+    *  \tparam ChunkBits   Log2 of the amount of elements per chunk. */
+    template <typename T, uint ChunkBits = 10>
+    class ChunkedArray {
+        static const uint ChunkSize = 1 << ChunkBits;
+        static const uint ChunkMask = ChunkSize - 1;
+
+        struct Directory {
+            uint    mCapacity;
+            T**     mChunks;
+        };
+
+        std::atomic<Directory*>     mDirectory;
+        std::atomic<uint>           mPublished;
+        uint                        mSize;
+        std::vector<Directory*>     mRetired;
+    public:
+        /** Default constructor. */
+        ChunkedArray( )
+            : mDirectory( nullptr )
+            , mPublished( 0 )
+            , mSize( 0 ) {
+        }
+
+        /** Destructor. */
+        ~ChunkedArray( ) {
+            this->Clear( );
+        }
+
+        ChunkedArray( const ChunkedArray& ) = delete;
+        ChunkedArray& operator=( const ChunkedArray& ) = delete;
+
+        /** Gets the amount of published elements. Safe to call from any thread.
+        *  \return uint    Amount of elements visible to readers. */
+        uint GetSize( ) const {
+            return mPublished.load( std::memory_order_acquire );
+        }
+
+        /** Gets the amount of appended elements, published or not. Writer only.
+        *  \return uint    Amount of elements appended. */
+        uint GetPendingSize( ) const {
+            return mSize;
+        }
+
+        /** Gets the element at the given index. Readers may only access indices
+        *  below GetSize().
+        *  \param[in]  pIndex  Index of the element.
+        *  \return T&  Reference to the element. */
+        T& operator[]( uint pIndex ) {
+            return mDirectory.load( std::memory_order_acquire )->mChunks[pIndex >> ChunkBits][pIndex & ChunkMask];
+        }
+
+        /** Gets the element at the given index. Readers may only access indices
+        *  below GetSize().
+        *  \param[in]  pIndex  Index of the element.
+        *  \return T&  Const reference to the element. */
+        const T& operator[]( uint pIndex ) const {
+            return mDirectory.load( std::memory_order_acquire )->mChunks[pIndex >> ChunkBits][pIndex & ChunkMask];
+        }
+
+        /** Appends an item without publishing it. Writer only.
+        *  \param[in]  pItem   Item to append.
+        *  \return uint    Index of the appended item. */
+        uint Push( const T& pItem ) {
+            auto index = mSize;
+            this->EnsureChunk( index >> ChunkBits );
+
+            mDirectory.load( std::memory_order_relaxed )->mChunks[index >> ChunkBits][index & ChunkMask] = pItem;
+            mSize++;
+            return index;
+        }
+
+        /** Makes every appended item visible to readers. Writer only. */
+        void Publish( ) {
+            mPublished.store( mSize, std::memory_order_release );
+        }
+
+        /** Appends an item and publishes it. Writer only.
+        *  \param[in]  pItem   Item to append.
+        *  \return uint    Index of the appended item. */
+        uint Add( const T& pItem ) {
+            auto index = this->Push( pItem );
+            this->Publish( );
+            return index;
+        }
+
+        /** Makes room in the chunk directory for the given amount of elements,
+        *  so it does not need to grow while appending them. Writer only.
+        *  \param[in]  pSize   Amount of elements to make room for. */
+        void Reserve( uint pSize ) {
+            auto chunks = ( pSize + ChunkMask ) >> ChunkBits;
+            auto directory = mDirectory.load( std::memory_order_relaxed );
+            if ( !directory || directory->mCapacity < chunks ) {
+                this->GrowDirectory( chunks );
+            }
+        }
+
+        /** Frees every element. Not safe while other threads read the array. */
+        void Clear( ) {
+            auto directory = mDirectory.load( std::memory_order_relaxed );
+            if ( directory ) {
+                auto chunks = ( mSize + ChunkMask ) >> ChunkBits;
+                for ( uint i = 0; i < chunks; i++ ) {
+                    delete[] directory->mChunks[i];
+                }
+                FreeDirectory( directory );
+            }
+            for ( auto const& it : mRetired ) {
+                FreeDirectory( it );
+            }
+            mRetired.clear( );
+
+            mDirectory.store( nullptr, std::memory_order_relaxed );
+            mPublished.store( 0, std::memory_order_relaxed );
+            mSize = 0;
+        }
+
+    private:
+        void EnsureChunk( uint pChunk ) {
+            auto directory = mDirectory.load( std::memory_order_relaxed );
+            if ( !directory || pChunk >= directory->mCapacity ) {
+                directory = this->GrowDirectory( pChunk + 1 );
+            }
+            // Chunks are filled in order, so a new one is needed at the start of each
+            if ( ( mSize & ChunkMask ) == 0 ) {
+                directory->mChunks[pChunk] = new T[ChunkSize];
+            }
+        }
+
+        Directory* GrowDirectory( uint pMinCapacity ) {
+            auto old = mDirectory.load( std::memory_order_relaxed );
+
+            auto capacity = old ? old->mCapacity : 4u;
+            while ( capacity < pMinCapacity ) {
+                capacity *= 2;
+            }
+
+            auto directory = new Directory;
+            directory->mCapacity = capacity;
+            directory->mChunks = new T*[capacity]( );
+            if ( old ) {
+                for ( uint i = 0; i < old->mCapacity; i++ ) {
+                    directory->mChunks[i] = old->mChunks[i];
+                }
+                // Readers may still hold the old directory
+                mRetired.push_back( old );
+            }
+
+            mDirectory.store( directory, std::memory_order_release );
+            return directory;
+        }
+
+        static void FreeDirectory( Directory* pDirectory ) {
+            delete[] pDirectory->mChunks;
+            delete pDirectory;
+        }
+    }; // class ChunkedArray
+
+}; // namespace gw2b
+
+#endif // UTIL_CHUNKEDARRAY_H_INCLUDED
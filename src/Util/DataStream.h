@@ -0,0 +1,77 @@
+/** \file       Util/DataStream.h
+ *  \brief      Contains the declaration of the data source and sink interfaces.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef UTIL_DATASTREAM_H_INCLUDED
+#define UTIL_DATASTREAM_H_INCLUDED
+
+#include <wx/file.h>
+
+namespace gw2b {
+
+    /** Supplies data piece by piece. */
+    class IDataSource {
+    public:
+        virtual ~IDataSource( ) {}
+        /** Reads the next piece of data.
+        *  \param[out] po_buffer    Buffer receiving the data.
+        *  \param[in]  p_size       Size of the buffer, in bytes.
+        *  \return uint32  Amount of bytes read, 0 at the end of the data. */
+        virtual uint32 read( byte* po_buffer, uint32 p_size ) = 0;
+    }; // class IDataSource
+
+    //============================================================================/
+
+    /** Receives data piece by piece, such as a file writer or a hasher. */
+    class IDataSink {
+    public:
+        virtual ~IDataSink( ) {}
+        /** Receives the next piece of data. The data is only valid during the call.
+        *  \param[in]  p_data   Data to receive.
+        *  \param[in]  p_size   Size of the data, in bytes.
+        *  \return bool    true to continue, false to abort. */
+        virtual bool write( const byte* p_data, uint32 p_size ) = 0;
+    }; // class IDataSink
+
+    //============================================================================/
+
+    /** Sink writing the data to a file. */
+    class FileDataSink : public IDataSink {
+        wxFile&     m_file;
+    public:
+        /** Constructor.
+        *  \param[in]  p_file   File to write to, opened for writing. */
+        FileDataSink( wxFile& p_file )
+            : m_file( p_file ) {
+        }
+
+        virtual bool write( const byte* p_data, uint32 p_size ) override {
+            return m_file.Write( p_data, p_size ) == p_size;
+        }
+    }; // class FileDataSink
+
+}; // namespace gw2b
+
+#endif // UTIL_DATASTREAM_H_INCLUDED
@@ -0,0 +1,152 @@
+/** \file       Util/HalfConverter.cpp
+ *  \brief      Contains the definition of the half float conversion kernels.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#   define GW2B_HALF_F16C       1
+#   include <immintrin.h>
+#   if defined(_MSC_VER)
+#       define GW2B_TARGET_F16C
+#   else
+#       define GW2B_TARGET_F16C     __attribute__( ( target( "avx,f16c" ) ) )
+#   endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   define GW2B_HALF_NEON       1
+#   include <arm_neon.h>
+#endif
+
+#include "HalfConverter.h"
+
+namespace gw2b {
+
+    namespace {
+
+        //============================================================================/
+        //      C++, also finishes what the others leave
+        //============================================================================/
+
+        /** Converts a 16-bit float. NaNs come out quiet, as the hardware
+        *  conversions give them. */
+        float halfToFloat( uint16 p_half ) {
+            uint32 sign = static_cast<uint32>( p_half & 0x8000 ) << 16;
+            uint32 exponent = ( p_half >> 10 ) & 0x1f;
+            uint32 mantissa = p_half & 0x3ff;
+            uint32 bits;
+
+            if ( exponent == 0x1f ) {
+                // Infinity or NaN
+                bits = sign | 0x7f800000 | ( mantissa << 13 ) | ( mantissa ? 0x00400000 : 0 );
+            } else if ( exponent ) {
+                bits = sign | ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 );
+            } else if ( mantissa ) {
+                // Subnormal, shift the mantissa up until it is normal
+                exponent = 113;
+                while ( !( mantissa & 0x400 ) ) {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                bits = sign | ( exponent << 23 ) | ( ( mantissa & 0x3ff ) << 13 );
+            } else {
+                bits = sign;
+            }
+
+            float value;
+            ::memcpy( &value, &bits, sizeof( value ) );
+            return value;
+        }
+
+        void toFloatScalar( const uint16* p_halves, float* po_floats, uint p_count ) {
+            for ( uint i = 0; i < p_count; i++ ) {
+                po_floats[i] = halfToFloat( p_halves[i] );
+            }
+        }
+
+        //============================================================================/
+        //      F16C
+        //============================================================================/
+
+#if GW2B_HALF_F16C
+
+        GW2B_TARGET_F16C void toFloatF16C( const uint16* p_halves, float* po_floats, uint p_count ) {
+            uint i = 0;
+            for ( ; i + 8 <= p_count; i += 8 ) {
+                auto halves = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p_halves + i ) );
+                _mm256_storeu_ps( po_floats + i, _mm256_cvtph_ps( halves ) );
+            }
+            toFloatScalar( p_halves + i, po_floats + i, p_count - i );
+        }
+
+#endif
+
+        //============================================================================/
+        //      NEON
+        //============================================================================/
+
+#if GW2B_HALF_NEON
+
+        void toFloatNEON( const uint16* p_halves, float* po_floats, uint p_count ) {
+            uint i = 0;
+            for ( ; i + 8 <= p_count; i += 8 ) {
+                auto halves = vreinterpretq_f16_u16( vld1q_u16( p_halves + i ) );
+                vst1q_f32( po_floats + i, vcvt_f32_f16( vget_low_f16( halves ) ) );
+                vst1q_f32( po_floats + i + 4, vcvt_f32_f16( vget_high_f16( halves ) ) );
+            }
+            toFloatScalar( p_halves + i, po_floats + i, p_count - i );
+        }
+
+#endif
+
+        HalfConverter pickConverter( ) {
+#if GW2B_HALF_F16C
+            if ( hasF16C( ) ) {
+                HalfConverter converter = { "F16C", &toFloatF16C };
+                return converter;
+            }
+#elif GW2B_HALF_NEON
+            HalfConverter converter = { "NEON", &toFloatNEON };
+            return converter;
+#endif
+            return halfReferenceConverter( );
+        }
+
+    };
+
+    //============================================================================/
+
+    const HalfConverter& halfConverter( ) {
+        static const HalfConverter s_converter = pickConverter( );
+        return s_converter;
+    }
+
+    //============================================================================/
+
+    const HalfConverter& halfReferenceConverter( ) {
+        static const HalfConverter s_converter = { "C++", &toFloatScalar };
+        return s_converter;
+    }
+
+}; // namespace gw2b
@@ -0,0 +1,53 @@
+/** \file       Util/HalfConverter.h
+ *  \brief      Contains the declaration of the half float conversion kernels.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef UTIL_HALFCONVERTER_H_INCLUDED
+#define UTIL_HALFCONVERTER_H_INCLUDED
+
+namespace gw2b {
+
+    /** Set of kernels converting runs of 16-bit floats. All sets give exactly
+    *  the same output, subnormals, infinities and NaNs included. */
+    struct HalfConverter {
+        const char* name;   /**< Name of the instruction set used. */
+
+        /** Converts 16-bit floats to 32-bit floats.
+        *  \param[in]  p_halves     16-bit floats to convert.
+        *  \param[out] po_floats    Receives the 32-bit floats.
+        *  \param[in]  p_count      Amount of floats. */
+        void ( *toFloat )( const uint16* p_halves, float* po_floats, uint p_count );
+    };
+
+    /** Gets the fastest kernels the CPU supports, picked on first use.
+    *  \return HalfConverter&   The kernels. */
+    const HalfConverter& halfConverter( );
+    /** Gets the plain C++ kernels, the reference for all others.
+    *  \return HalfConverter&   The kernels. */
+    const HalfConverter& halfReferenceConverter( );
+
+}; // namespace gw2b
+
+#endif // UTIL_HALFCONVERTER_H_INCLUDED
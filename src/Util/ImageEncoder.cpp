@@ -0,0 +1,521 @@
+/** \file       Util/ImageEncoder.cpp
+ *  \brief      Contains the definition of the image file encoders.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <wx/mstream.h>
+#include <wx/zstream.h>
+
+#include "Util/PixelConverter.h"
+
+#include "Util/ImageEncoder.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** PNG filter types, see the PNG specification. */
+        enum PngFilter {
+            PF_None,
+            PF_Sub,
+            PF_Up,
+            PF_Average,
+            PF_Paeth,
+            PF_Count,
+        };
+
+        /** Levels up to this use the Up filter for every row. */
+        const int PngFixedFilterMaxLevel = 5;
+
+        /** Gets the table of the CRC-32 used by PNG chunks. */
+        const uint32* pngCrcTable( ) {
+            static const std::vector<uint32> table = [] ( ) {
+                std::vector<uint32> result( 256 );
+                for ( uint32 i = 0; i < 256; i++ ) {
+                    uint32 crc = i;
+                    for ( uint bit = 0; bit < 8; bit++ ) {
+                        crc = ( crc & 1 ) ? ( 0xedb88320 ^ ( crc >> 1 ) ) : ( crc >> 1 );
+                    }
+                    result[i] = crc;
+                }
+                return result;
+            }( );
+            return table.data( );
+        }
+
+        uint32 pngCrc( uint32 p_crc, const byte* p_data, size_t p_size ) {
+            auto table = pngCrcTable( );
+            for ( size_t i = 0; i < p_size; i++ ) {
+                p_crc = table[( p_crc ^ p_data[i] ) & 0xff] ^ ( p_crc >> 8 );
+            }
+            return p_crc;
+        }
+
+        void writeBigEndian( byte* po_data, uint32 p_value ) {
+            po_data[0] = static_cast<byte>( p_value >> 24 );
+            po_data[1] = static_cast<byte>( p_value >> 16 );
+            po_data[2] = static_cast<byte>( p_value >> 8 );
+            po_data[3] = static_cast<byte>( p_value );
+        }
+
+        /** Appends a PNG chunk: length, type, data and CRC of type and data. */
+        void appendPngChunk( std::vector<byte>& po_file, const char* p_type, const byte* p_data, size_t p_size ) {
+            auto start = po_file.size( );
+            po_file.resize( start + 12 + p_size );
+
+            auto chunk = po_file.data( ) + start;
+            writeBigEndian( chunk, static_cast<uint32>( p_size ) );
+            ::memcpy( chunk + 4, p_type, 4 );
+            if ( p_size ) {
+                ::memcpy( chunk + 8, p_data, p_size );
+            }
+            writeBigEndian( chunk + 8 + p_size, pngCrc( 0xffffffff, chunk + 4, 4 + p_size ) ^ 0xffffffff );
+        }
+
+        byte paethPredictor( int p_left, int p_up, int p_upLeft ) {
+            int estimate = p_left + p_up - p_upLeft;
+            int distLeft = std::abs( estimate - p_left );
+            int distUp = std::abs( estimate - p_up );
+            int distUpLeft = std::abs( estimate - p_upLeft );
+            if ( ( distLeft <= distUp ) && ( distLeft <= distUpLeft ) ) {
+                return static_cast<byte>( p_left );
+            }
+            return static_cast<byte>( ( distUp <= distUpLeft ) ? p_up : p_upLeft );
+        }
+
+        /** Filters a row. po_row receives the filter type, then the filtered bytes. */
+        void filterPngRow( PngFilter p_filter, const byte* p_row, const byte* p_previous, size_t p_size, uint p_pixelSize, byte* po_row ) {
+            po_row[0] = static_cast<byte>( p_filter );
+            auto output = po_row + 1;
+
+            switch ( p_filter ) {
+            case PF_None:
+                ::memcpy( output, p_row, p_size );
+                break;
+            case PF_Sub:
+                for ( size_t i = 0; i < p_size; i++ ) {
+                    output[i] = p_row[i] - ( ( i >= p_pixelSize ) ? p_row[i - p_pixelSize] : 0 );
+                }
+                break;
+            case PF_Up:
+                for ( size_t i = 0; i < p_size; i++ ) {
+                    output[i] = p_row[i] - p_previous[i];
+                }
+                break;
+            case PF_Average:
+                for ( size_t i = 0; i < p_size; i++ ) {
+                    int left = ( i >= p_pixelSize ) ? p_row[i - p_pixelSize] : 0;
+                    output[i] = p_row[i] - static_cast<byte>( ( left + p_previous[i] ) >> 1 );
+                }
+                break;
+            case PF_Paeth:
+                for ( size_t i = 0; i < p_size; i++ ) {
+                    int left = ( i >= p_pixelSize ) ? p_row[i - p_pixelSize] : 0;
+                    int upLeft = ( i >= p_pixelSize ) ? p_previous[i - p_pixelSize] : 0;
+                    output[i] = p_row[i] - paethPredictor( left, p_previous[i], upLeft );
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        /** Sum of the filtered bytes as signed values, smaller usually deflates better. */
+        uint64 pngRowCost( const byte* p_row, size_t p_size ) {
+            uint64 cost = 0;
+            for ( size_t i = 0; i < p_size; i++ ) {
+                cost += std::abs( static_cast<int>( static_cast<int8>( p_row[i] ) ) );
+            }
+            return cost;
+        }
+
+        /** Fields of the DDS header, as 32-bit values after the magic. */
+        enum DdsField {
+            DF_Magic,
+            DF_Size,
+            DF_Flags,
+            DF_Height,
+            DF_Width,
+            DF_PitchOrLinearSize,
+            DF_MipMapCount = 7,
+            DF_PixelFormatSize = 19,
+            DF_PixelFormatFlags,
+            DF_PixelFormatFourCC,
+            DF_PixelFormatBitCount,
+            DF_PixelFormatRedMask,
+            DF_PixelFormatGreenMask,
+            DF_PixelFormatBlueMask,
+            DF_PixelFormatAlphaMask,
+            DF_Caps,
+            DF_Count = 32,
+        };
+
+        /** Fields of the DX10 header, which follows the DDS header. */
+        enum DdsDx10Field {
+            DDF_DxgiFormat,
+            DDF_ResourceDimension,
+            DDF_MiscFlag,
+            DDF_ArraySize,
+            DDF_MiscFlags2,
+            DDF_Count,
+        };
+
+        const uint32 DdsMagic = 0x20534444;            // "DDS "
+        const uint32 DdsFourCCDx10 = 0x30315844;       // "DX10"
+        const uint32 DdsFlagsTexture = 0x1 | 0x2 | 0x4 | 0x1000;  // Caps, height, width, pixel format
+        const uint32 DdsFlagPitch = 0x8;
+        const uint32 DdsFlagLinearSize = 0x80000;
+        const uint32 DdsPixelFlagAlphaPixels = 0x1;
+        const uint32 DdsPixelFlagFourCC = 0x4;
+        const uint32 DdsPixelFlagRGB = 0x40;
+        const uint32 DdsCapsTexture = 0x1000;
+        const uint32 DdsDimensionTexture2D = 3;
+
+        /** Fills a DDS header with the fields every texture has. */
+        void initDdsHeader( uint32* po_header, const wxSize& p_size, uint32 p_flags, uint32 p_pitchOrLinearSize ) {
+            ::memset( po_header, 0, DF_Count * sizeof( uint32 ) );
+            po_header[DF_Magic] = DdsMagic;
+            po_header[DF_Size] = ( DF_Count - 1 ) * sizeof( uint32 );
+            po_header[DF_Flags] = DdsFlagsTexture | p_flags;
+            po_header[DF_Height] = p_size.y;
+            po_header[DF_Width] = p_size.x;
+            po_header[DF_PitchOrLinearSize] = p_pitchOrLinearSize;
+            po_header[DF_MipMapCount] = 1;
+            po_header[DF_PixelFormatSize] = 8 * sizeof( uint32 );
+            po_header[DF_Caps] = DdsCapsTexture;
+        }
+
+        /** Hash of a pixel in the QOI color index. */
+        uint qoiHash( const byte* p_pixel ) {
+            return ( p_pixel[0] * 3 + p_pixel[1] * 5 + p_pixel[2] * 7 + p_pixel[3] * 11 ) & 63;
+        }
+
+    };
+
+    //============================================================================/
+
+    bool ImageEncoder::encode( const wxSize& p_size, const byte* p_colors, const byte* p_alphas, ImageFileFormat p_format, int p_level, Array<byte>& po_data ) {
+        if ( ( p_size.x <= 0 ) || ( p_size.y <= 0 ) || !p_colors ) {
+            return false;
+        }
+
+        switch ( p_format ) {
+        case IFF_PNG:
+            return encodePng( p_size, p_colors, p_alphas, p_level, po_data );
+        case IFF_QOI:
+            return encodeQoi( p_size, p_colors, p_alphas, po_data );
+        case IFF_TGA:
+            return encodeTga( p_size, p_colors, p_alphas, po_data );
+        case IFF_DDS:
+            return encodeDds( p_size, p_colors, p_alphas, po_data );
+        default:
+            return false;
+        }
+    }
+
+    //============================================================================/
+
+    bool ImageEncoder::encode( const wxImage& p_image, ImageFileFormat p_format, int p_level, Array<byte>& po_data ) {
+        if ( !p_image.IsOk( ) ) {
+            return false;
+        }
+
+        // Masks become alpha, like wxImage's own PNG handler does
+        if ( p_image.HasMask( ) && !p_image.HasAlpha( ) ) {
+            auto image = p_image.Copy( );
+            image.InitAlpha( );
+            return encode( image.GetSize( ), image.GetData( ), image.GetAlpha( ), p_format, p_level, po_data );
+        }
+        return encode( p_image.GetSize( ), p_image.GetData( ), p_image.HasAlpha( ) ? p_image.GetAlpha( ) : nullptr, p_format, p_level, po_data );
+    }
+
+    //============================================================================/
+
+    bool ImageEncoder::wrapBlocks( const wxSize& p_size, uint32 p_fourCC, uint32 p_dxgiFormat, const byte* p_blocks, size_t p_blocksSize, Array<byte>& po_data ) {
+        if ( ( p_size.x <= 0 ) || ( p_size.y <= 0 ) || !p_blocks || !p_blocksSize || ( p_blocksSize > 0xffffffff ) ) {
+            return false;
+        }
+
+        uint32 header[DF_Count];
+        initDdsHeader( header, p_size, DdsFlagLinearSize, static_cast<uint32>( p_blocksSize ) );
+        header[DF_PixelFormatFlags] = DdsPixelFlagFourCC;
+        header[DF_PixelFormatFourCC] = p_dxgiFormat ? DdsFourCCDx10 : p_fourCC;
+
+        uint32 dx10Header[DDF_Count] = { p_dxgiFormat, DdsDimensionTexture2D, 0, 1, 0 };
+        size_t headerSize = sizeof( header ) + ( p_dxgiFormat ? sizeof( dx10Header ) : 0 );
+
+        Array<byte> data( headerSize + p_blocksSize );
+        auto output = data.GetPointer( );
+        ::memcpy( output, header, sizeof( header ) );
+        if ( p_dxgiFormat ) {
+            ::memcpy( output + sizeof( header ), dx10Header, sizeof( dx10Header ) );
+        }
+        ::memcpy( output + headerSize, p_blocks, p_blocksSize );
+
+        po_data = data;
+        return true;
+    }
+
+    //============================================================================/
+
+    const wxChar* ImageEncoder::extension( ImageFileFormat p_format ) {
+        switch ( p_format ) {
+        case IFF_DDS:
+            return wxT( "dds" );
+        case IFF_QOI:
+            return wxT( "qoi" );
+        case IFF_TGA:
+            return wxT( "tga" );
+        default:
+            return wxT( "png" );
+        }
+    }
+
+    //============================================================================/
+
+    bool ImageEncoder::encodePng( const wxSize& p_size, const byte* p_colors, const byte* p_alphas, int p_level, Array<byte>& po_data ) {
+        const uint pixelSize = p_alphas ? 4 : 3;
+        const size_t width = p_size.x;
+        const size_t rowSize = width * pixelSize;
+        const int level = wxMin( wxMax( p_level, 0 ), 9 );
+
+        // Deflate the filtered rows, a row at a time
+        wxMemoryOutputStream memory;
+        {
+            wxZlibOutputStream stream( memory, level, wxZLIB_ZLIB );
+
+            std::vector<byte> rows( rowSize * 2 );
+            std::vector<byte> filtered( ( rowSize + 1 ) * PF_Count );
+            auto row = rows.data( );
+            auto previous = rows.data( ) + rowSize;
+            ::memset( previous, 0, rowSize );
+
+            for ( int y = 0; y < p_size.y; y++ ) {
+                if ( p_alphas ) {
+                    pixelConverter( ).mergeAlpha( p_colors + y * width * 3, p_alphas + y * width, row, p_size.x, false );
+                } else {
+                    ::memcpy( row, p_colors + y * rowSize, rowSize );
+                }
+
+                auto output = filtered.data( );
+                if ( level == 0 ) {
+                    filterPngRow( PF_None, row, previous, rowSize, pixelSize, output );
+                } else if ( level <= PngFixedFilterMaxLevel ) {
+                    filterPngRow( PF_Up, row, previous, rowSize, pixelSize, output );
+                } else {
+                    uint64 bestCost = std::numeric_limits<uint64>::max( );
+                    for ( uint filter = PF_None; filter < PF_Count; filter++ ) {
+                        auto candidate = filtered.data( ) + filter * ( rowSize + 1 );
+                        filterPngRow( static_cast<PngFilter>( filter ), row, previous, rowSize, pixelSize, candidate );
+                        auto cost = pngRowCost( candidate + 1, rowSize );
+                        if ( cost < bestCost ) {
+                            bestCost = cost;
+                            output = candidate;
+                        }
+                    }
+                }
+
+                stream.Write( output, rowSize + 1 );
+                if ( !stream.IsOk( ) ) {
+                    return false;
+                }
+                std::swap( row, previous );
+            }
+
+            if ( !stream.Close( ) ) {
+                return false;
+            }
+        }
+
+        byte header[13];
+        writeBigEndian( header, p_size.x );
+        writeBigEndian( header + 4, p_size.y );
+        header[8] = 8;                      // Bit depth
+        header[9] = p_alphas ? 6 : 2;       // Color type, RGBA or RGB
+        header[10] = 0;                     // Deflate
+        header[11] = 0;                     // Adaptive filtering
+        header[12] = 0;                     // Not interlaced
+
+        std::vector<byte> deflated( memory.GetSize( ) );
+        memory.CopyTo( deflated.data( ), deflated.size( ) );
+
+        static const byte signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        std::vector<byte> file( signature, signature + sizeof( signature ) );
+        file.reserve( sizeof( signature ) + 12 * 3 + sizeof( header ) + deflated.size( ) );
+        appendPngChunk( file, "IHDR", header, sizeof( header ) );
+        appendPngChunk( file, "IDAT", deflated.data( ), deflated.size( ) );
+        appendPngChunk( file, "IEND", nullptr, 0 );
+
+        po_data = Array<byte>( file.size( ) );
+        ::memcpy( po_data.GetPointer( ), file.data( ), file.size( ) );
+        return true;
+    }
+
+    //============================================================================/
+
+    bool ImageEncoder::encodeQoi( const wxSize& p_size, const byte* p_colors, const byte* p_alphas, Array<byte>& po_data ) {
+        const uint channels = p_alphas ? 4 : 3;
+        const size_t numPixels = static_cast<size_t>( p_size.x ) * p_size.y;
+
+        // Worst case is a tag and all channels for every pixel
+        Array<byte> data( 14 + numPixels * ( channels + 1 ) + 8 );
+        auto output = data.GetPointer( );
+
+        ::memcpy( output, "qoif", 4 );
+        writeBigEndian( output + 4, p_size.x );
+        writeBigEndian( output + 8, p_size.y );
+        output[12] = static_cast<byte>( channels );
+        output[13] = 0;                     // sRGB with linear alpha
+        size_t position = 14;
+
+        byte index[64][4];
+        ::memset( index, 0, sizeof( index ) );
+        byte previous[4] = { 0, 0, 0, 0xff };
+        uint run = 0;
+
+        for ( size_t i = 0; i < numPixels; i++ ) {
+            byte pixel[4] = { p_colors[i * 3], p_colors[i * 3 + 1], p_colors[i * 3 + 2], p_alphas ? p_alphas[i] : static_cast<byte>( 0xff ) };
+
+            if ( ::memcmp( pixel, previous, 4 ) == 0 ) {
+                run++;
+                if ( ( run == 62 ) || ( i + 1 == numPixels ) ) {
+                    output[position++] = static_cast<byte>( 0xc0 | ( run - 1 ) );
+                    run = 0;
+                }
+                continue;
+            }
+
+            if ( run ) {
+                output[position++] = static_cast<byte>( 0xc0 | ( run - 1 ) );
+                run = 0;
+            }
+
+            auto hash = qoiHash( pixel );
+            if ( ::memcmp( index[hash], pixel, 4 ) == 0 ) {
+                output[position++] = static_cast<byte>( hash );
+            } else {
+                ::memcpy( index[hash], pixel, 4 );
+
+                if ( pixel[3] == previous[3] ) {
+                    int dr = static_cast<int8>( pixel[0] - previous[0] );
+                    int dg = static_cast<int8>( pixel[1] - previous[1] );
+                    int db = static_cast<int8>( pixel[2] - previous[2] );
+                    int drg = dr - dg;
+                    int dbg = db - dg;
+
+                    if ( ( dr >= -2 ) && ( dr <= 1 ) && ( dg >= -2 ) && ( dg <= 1 ) && ( db >= -2 ) && ( db <= 1 ) ) {
+                        output[position++] = static_cast<byte>( 0x40 | ( ( dr + 2 ) << 4 ) | ( ( dg + 2 ) << 2 ) | ( db + 2 ) );
+                    } else if ( ( dg >= -32 ) && ( dg <= 31 ) && ( drg >= -8 ) && ( drg <= 7 ) && ( dbg >= -8 ) && ( dbg <= 7 ) ) {
+                        output[position++] = static_cast<byte>( 0x80 | ( dg + 32 ) );
+                        output[position++] = static_cast<byte>( ( ( drg + 8 ) << 4 ) | ( dbg + 8 ) );
+                    } else {
+                        output[position++] = 0xfe;
+                        output[position++] = pixel[0];
+                        output[position++] = pixel[1];
+                        output[position++] = pixel[2];
+                    }
+                } else {
+                    output[position++] = 0xff;
+                    ::memcpy( output + position, pixel, 4 );
+                    position += 4;
+                }
+            }
+            ::memcpy( previous, pixel, 4 );
+        }
+
+        static const byte padding[] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+        ::memcpy( output + position, padding, sizeof( padding ) );
+        position += sizeof( padding );
+
+        data.SetSize( position );
+        po_data = data;
+        return true;
+    }
+
+    //============================================================================/
+
+    bool ImageEncoder::encodeTga( const wxSize& p_size, const byte* p_colors, const byte* p_alphas, Array<byte>& po_data ) {
+        if ( ( p_size.x > 0xffff ) || ( p_size.y > 0xffff ) ) {
+            return false;
+        }
+
+        const uint pixelSize = p_alphas ? 4 : 3;
+        const size_t numPixels = static_cast<size_t>( p_size.x ) * p_size.y;
+
+        Array<byte> data( 18 + numPixels * pixelSize );
+        auto output = data.GetPointer( );
+        ::memset( output, 0, 18 );
+        output[2] = 2;                                      // Uncompressed true-color
+        output[12] = static_cast<byte>( p_size.x );
+        output[13] = static_cast<byte>( p_size.x >> 8 );
+        output[14] = static_cast<byte>( p_size.y );
+        output[15] = static_cast<byte>( p_size.y >> 8 );
+        output[16] = static_cast<byte>( pixelSize * 8 );
+        output[17] = ( p_alphas ? 8 : 0 ) | 0x20;           // Alpha bits, top-left origin
+
+        auto pixels = output + 18;
+        if ( p_alphas ) {
+            // Targa stores BGRA
+            pixelConverter( ).mergeAlpha( p_colors, p_alphas, pixels, static_cast<uint>( numPixels ), true );
+        } else {
+            for ( size_t i = 0; i < numPixels; i++ ) {
+                pixels[i * 3] = p_colors[i * 3 + 2];
+                pixels[i * 3 + 1] = p_colors[i * 3 + 1];
+                pixels[i * 3 + 2] = p_colors[i * 3];
+            }
+        }
+
+        po_data = data;
+        return true;
+    }
+
+    //============================================================================/
+
+    bool ImageEncoder::encodeDds( const wxSize& p_size, const byte* p_colors, const byte* p_alphas, Array<byte>& po_data ) {
+        const size_t numPixels = static_cast<size_t>( p_size.x ) * p_size.y;
+
+        // Always 32-bit, few tools read 24-bit DDS
+        uint32 header[DF_Count];
+        initDdsHeader( header, p_size, DdsFlagPitch, p_size.x * 4 );
+        header[DF_PixelFormatFlags] = DdsPixelFlagRGB | ( p_alphas ? DdsPixelFlagAlphaPixels : 0 );
+        header[DF_PixelFormatBitCount] = 32;
+        header[DF_PixelFormatRedMask] = 0x00ff0000;
+        header[DF_PixelFormatGreenMask] = 0x0000ff00;
+        header[DF_PixelFormatBlueMask] = 0x000000ff;
+        header[DF_PixelFormatAlphaMask] = p_alphas ? 0xff000000 : 0;
+
+        Array<byte> data( sizeof( header ) + numPixels * 4 );
+        auto output = data.GetPointer( );
+        ::memcpy( output, header, sizeof( header ) );
+        // Stored as BGRA, images without alpha get 0xff
+        pixelConverter( ).mergeAlpha( p_colors, p_alphas, output + sizeof( header ), static_cast<uint>( numPixels ), true );
+
+        po_data = data;
+        return true;
+    }
+
+}; // namespace gw2b
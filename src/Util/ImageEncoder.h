@@ -0,0 +1,100 @@
+/** \file       Util/ImageEncoder.h
+ *  \brief      Contains the declaration of the image file encoders.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef UTIL_IMAGEENCODER_H_INCLUDED
+#define UTIL_IMAGEENCODER_H_INCLUDED
+
+namespace gw2b {
+
+    /** File formats images can be encoded to. */
+    enum ImageFileFormat {
+        IFF_PNG,        /**< PNG, deflated at the given level. */
+        IFF_QOI,        /**< Quite OK Image, a lot faster to write than PNG, files a bit bigger. */
+        IFF_TGA,        /**< Uncompressed Targa, fastest to write, biggest on disk. */
+        IFF_DDS,        /**< DirectDraw Surface of uncompressed 32-bit pixels. Block
+                        *    compressed textures are better kept as blocks, see
+                        *    ImageEncoder::wrapBlocks. */
+    };
+
+    /** Compression levels of PNG, see ImageEncoder::encode. */
+    enum ImageEncoderPngLevel {
+        IEPL_Fastest = 1,   /**< Fastest deflate, one filter for every row. */
+        IEPL_Default = 3,   /**< Still fast deflate, one filter for every row. */
+        IEPL_Smallest = 9,  /**< Best deflate, filter picked per row. */
+    };
+
+    /** Encodes 8-bit images to image files, without going through wxImage's
+    *  handlers. Safe to use from any thread.
+    *
+    *  PNG is written by hand so the filters and deflate level can be traded
+    *  for speed: up to level 5 every row uses the Up filter, which costs a
+    *  subtraction per byte and suits textures well. From level 6 on the filter
+    *  of each row is picked like libpng does, by the smallest sum of absolute
+    *  differences. */
+    class ImageEncoder {
+    public:
+        /** Encodes an image.
+        *  \param[in]  p_size       Size of the image, in pixels.
+        *  \param[in]  p_colors     3 bytes per pixel, red first, as wxImage stores them.
+        *  \param[in]  p_alphas     1 byte per pixel, or nullptr if the image has no alpha.
+        *  \param[in]  p_format     File format to encode to.
+        *  \param[in]  p_level      Deflate level for PNG, 0 to 9. Ignored by other formats.
+        *  \param[out] po_data      Receives the file.
+        *  \return bool    true if encoded, false if not. */
+        static bool encode( const wxSize& p_size, const byte* p_colors, const byte* p_alphas, ImageFileFormat p_format, int p_level, Array<byte>& po_data );
+        /** Encodes a wxImage. Masks are written as alpha.
+        *  \param[in]  p_image      Image to encode.
+        *  \param[in]  p_format     File format to encode to.
+        *  \param[in]  p_level      Deflate level for PNG, 0 to 9. Ignored by other formats.
+        *  \param[out] po_data      Receives the file.
+        *  \return bool    true if encoded, false if not. */
+        static bool encode( const wxImage& p_image, ImageFileFormat p_format, int p_level, Array<byte>& po_data );
+        /** Wraps block compressed data in a DDS file, without touching the
+        *  blocks. A DXGI format writes the DX10 header, which tools need to
+        *  tell BC4 and BC5 apart from other formats.
+        *  \param[in]  p_size       Size of the texture, in pixels.
+        *  \param[in]  p_fourCC     FourCC of the blocks, used if p_dxgiFormat is 0.
+        *  \param[in]  p_dxgiFormat DXGI format of the blocks, or 0 for the classic header.
+        *  \param[in]  p_blocks     Blocks of the top level, a row of blocks at a time.
+        *  \param[in]  p_blocksSize Size of the blocks, in bytes.
+        *  \param[out] po_data      Receives the file.
+        *  \return bool    true if wrapped, false if not. */
+        static bool wrapBlocks( const wxSize& p_size, uint32 p_fourCC, uint32 p_dxgiFormat, const byte* p_blocks, size_t p_blocksSize, Array<byte>& po_data );
+        /** Gets the file extension of a format.
+        *  \param[in]  p_format     Format to get the extension of.
+        *  \return wxChar*  Extension, without the dot. */
+        static const wxChar* extension( ImageFileFormat p_format );
+
+    private:
+        static bool encodePng( const wxSize& p_size, const byte* p_colors, const byte* p_alphas, int p_level, Array<byte>& po_data );
+        static bool encodeQoi( const wxSize& p_size, const byte* p_colors, const byte* p_alphas, Array<byte>& po_data );
+        static bool encodeTga( const wxSize& p_size, const byte* p_colors, const byte* p_alphas, Array<byte>& po_data );
+        static bool encodeDds( const wxSize& p_size, const byte* p_colors, const byte* p_alphas, Array<byte>& po_data );
+    }; // class ImageEncoder
+
+}; // namespace gw2b
+
+#endif // UTIL_IMAGEENCODER_H_INCLUDED
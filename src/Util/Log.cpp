@@ -0,0 +1,233 @@
+/** \file       Util/Log.cpp
+ *  \brief      Contains the definition of the buffered, rate-limited log.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "Log.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Amount of records a call site may log per second. */
+        const uint LogSiteBurst = 8;
+        /** Amount of records the ring buffer holds, must be a power of two. */
+        const uint LogBufferSize = 4096;
+        /** Time the draining thread sleeps when the buffer is empty. */
+        const auto LogDrainInterval = std::chrono::milliseconds( 100 );
+
+        /** A slot of the ring buffer. The sequence number tells producers and
+        *  the consumer whose turn it is to use the slot. */
+        struct LogSlot {
+            std::atomic<uint>   sequence;
+            LogLevel            level;
+            wxString            message;
+        };
+
+        /** Bounded multi-producer ring buffer, see
+        *  http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue */
+        class LogBuffer {
+            LogSlot             m_slots[LogBufferSize];
+            std::atomic<uint>   m_head;
+            std::atomic<uint>   m_tail;
+        public:
+            LogBuffer( ) : m_head( 0 ), m_tail( 0 ) {
+                for ( uint i = 0; i < LogBufferSize; i++ ) {
+                    m_slots[i].sequence.store( i, std::memory_order_relaxed );
+                }
+            }
+
+            bool push( LogLevel p_level, const wxString& p_message ) {
+                auto position = m_tail.load( std::memory_order_relaxed );
+                for ( ;; ) {
+                    auto& slot = m_slots[position & ( LogBufferSize - 1 )];
+                    auto sequence = slot.sequence.load( std::memory_order_acquire );
+                    auto difference = static_cast<int>( sequence - position );
+                    if ( difference == 0 ) {
+                        if ( m_tail.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) ) {
+                            slot.level = p_level;
+                            slot.message = p_message;
+                            slot.sequence.store( position + 1, std::memory_order_release );
+                            return true;
+                        }
+                    } else if ( difference < 0 ) {
+                        // Full
+                        return false;
+                    } else {
+                        position = m_tail.load( std::memory_order_relaxed );
+                    }
+                }
+            }
+
+            bool pop( LogLevel& po_level, wxString& po_message ) {
+                auto position = m_head.load( std::memory_order_relaxed );
+                auto& slot = m_slots[position & ( LogBufferSize - 1 )];
+                auto sequence = slot.sequence.load( std::memory_order_acquire );
+                if ( static_cast<int>( sequence - ( position + 1 ) ) < 0 ) {
+                    // Empty
+                    return false;
+                }
+
+                // Only the draining thread pops, so no need for a CAS here
+                m_head.store( position + 1, std::memory_order_relaxed );
+                po_level = slot.level;
+                po_message.swap( slot.message );
+                slot.sequence.store( position + LogBufferSize, std::memory_order_release );
+                return true;
+            }
+        };
+
+        LogBuffer                   s_buffer;
+        std::atomic<uint>           s_dropped( 0 );
+        std::atomic<uint>           s_suppressed( 0 );
+        uint                        s_lostReported = 0;
+        std::atomic<bool>           s_running( false );
+        std::thread                 s_thread;
+        std::mutex                  s_mutex;
+        std::condition_variable     s_wakeUp;
+        bool                        s_stop = false;
+
+        void forward( LogLevel p_level, const wxString& p_message ) {
+            switch ( p_level ) {
+            case LL_Warning:
+                wxLogWarning( wxT( "%s" ), p_message );
+                break;
+            case LL_Error:
+                wxLogError( wxT( "%s" ), p_message );
+                break;
+            default:
+                wxLogMessage( wxT( "%s" ), p_message );
+            }
+        }
+
+        void drain( ) {
+            LogLevel level;
+            wxString message;
+            while ( s_buffer.pop( level, message ) ) {
+                forward( level, message );
+            }
+
+            // Report lost records once in a while, rather than each one
+            auto lost = s_dropped.load( std::memory_order_relaxed ) + s_suppressed.load( std::memory_order_relaxed );
+            if ( lost != s_lostReported ) {
+                wxLogMessage( wxT( "%u log message(s) suppressed or dropped." ), lost - s_lostReported );
+                s_lostReported = lost;
+            }
+        }
+
+        void drainThread( ) {
+            std::unique_lock<std::mutex> lock( s_mutex );
+            while ( !s_stop ) {
+                lock.unlock( );
+                drain( );
+                lock.lock( );
+                s_wakeUp.wait_for( lock, LogDrainInterval );
+            }
+        }
+
+    };
+
+    //============================================================================/
+
+    bool LogSite::allow( ) {
+        auto now = static_cast<uint64>( std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now( ).time_since_epoch( ) ).count( ) );
+
+        // New window, start counting again
+        auto window = m_window.load( std::memory_order_relaxed );
+        if ( window != now && m_window.compare_exchange_strong( window, now, std::memory_order_relaxed ) ) {
+            m_count.store( 0, std::memory_order_relaxed );
+        }
+
+        if ( m_count.fetch_add( 1, std::memory_order_relaxed ) < LogSiteBurst ) {
+            return true;
+        }
+        Log::addSuppressed( );
+        return false;
+    }
+
+    //============================================================================/
+
+    void Log::start( ) {
+        if ( s_running.exchange( true ) ) {
+            return;
+        }
+        s_stop = false;
+        s_thread = std::thread( drainThread );
+    }
+
+    //============================================================================/
+
+    void Log::stop( ) {
+        if ( !s_running.exchange( false ) ) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( s_mutex );
+            s_stop = true;
+        }
+        s_wakeUp.notify_one( );
+        s_thread.join( );
+
+        // Anything written from now on goes straight through
+        drain( );
+    }
+
+    //============================================================================/
+
+    void Log::write( LogLevel p_level, const wxString& p_message ) {
+        if ( !s_running.load( std::memory_order_relaxed ) ) {
+            forward( p_level, p_message );
+            return;
+        }
+        if ( !s_buffer.push( p_level, p_message ) ) {
+            s_dropped.fetch_add( 1, std::memory_order_relaxed );
+        }
+    }
+
+    //============================================================================/
+
+    uint Log::numDropped( ) {
+        return s_dropped.load( std::memory_order_relaxed );
+    }
+
+    //============================================================================/
+
+    uint Log::numSuppressed( ) {
+        return s_suppressed.load( std::memory_order_relaxed );
+    }
+
+    //============================================================================/
+
+    void Log::addSuppressed( ) {
+        s_suppressed.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+}; // namespace gw2b
@@ -0,0 +1,112 @@
+/** \file       Util/Log.h
+ *  \brief      Contains the declaration of the buffered, rate-limited log.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef UTIL_LOG_H_INCLUDED
+#define UTIL_LOG_H_INCLUDED
+
+#include <atomic>
+
+/** Records below this level are compiled out. 0 is debug, 1 info, 2 warning
+ *  and 3 error, see gw2b::LogLevel. */
+#ifndef GW2B_LOG_LEVEL
+#   ifdef _DEBUG
+#       define GW2B_LOG_LEVEL   0
+#   else
+#       define GW2B_LOG_LEVEL   1
+#   endif
+#endif
+
+namespace gw2b {
+
+    /** Severity of a log record. */
+    enum LogLevel {
+        LL_Debug,
+        LL_Info,
+        LL_Warning,
+        LL_Error,
+    };
+
+    /** Rate limiter of a single logging call site. Lets a burst of records
+    *  through every second and suppresses the rest. */
+    class LogSite {
+        std::atomic<uint64>     m_window;
+        std::atomic<uint>       m_count;
+    public:
+        /** Constructor. */
+        LogSite( ) : m_window( 0 ), m_count( 0 ) {
+        }
+        /** Determines whether this site may log another record right now.
+        *  \return bool    true if allowed, false if the record is suppressed. */
+        bool allow( );
+    }; // class LogSite
+
+    /** Log taking records from any thread without blocking. Records go into
+    *  a fixed-size lock-free ring buffer that a background thread drains into
+    *  the wxWidgets log. Records that don't fit are dropped and counted.
+    *
+    *  Use the LogDebug, LogInfo, LogWarning and LogError macros rather than
+    *  calling write() directly: they filter by level at compile time, rate
+    *  limit every call site, and only format the message when it is kept. */
+    class Log {
+    public:
+        /** Starts the thread draining the log into the active wxLog target. */
+        static void start( );
+        /** Stops the draining thread and flushes the remaining records. */
+        static void stop( );
+        /** Adds a record to the log. If the log is not started, the record goes
+        *  directly to the active wxLog target.
+        *  \param[in]  p_level      Severity of the record.
+        *  \param[in]  p_message    Message of the record. */
+        static void write( LogLevel p_level, const wxString& p_message );
+        /** Gets the amount of records dropped because the buffer was full.
+        *  \return uint    Amount of dropped records. */
+        static uint numDropped( );
+        /** Gets the amount of records suppressed by call site rate limits.
+        *  \return uint    Amount of suppressed records. */
+        static uint numSuppressed( );
+        /** Counts a record suppressed by a call site rate limit. */
+        static void addSuppressed( );
+    }; // class Log
+
+}; // namespace gw2b
+
+/** Logs a formatted message with the given level, see gw2b::Log. */
+#define GW2B_LOG( level, ... )                                                  \
+    do {                                                                        \
+        if ( ( level ) >= GW2B_LOG_LEVEL ) {                                    \
+            static ::gw2b::LogSite logSite;                                     \
+            if ( logSite.allow( ) ) {                                           \
+                ::gw2b::Log::write( ( level ), wxString::Format( __VA_ARGS__ ) );   \
+            }                                                                   \
+        }                                                                       \
+    } while ( false )
+
+#define LogDebug( ... )             GW2B_LOG( ::gw2b::LL_Debug, __VA_ARGS__ )
+#define LogInfo( ... )              GW2B_LOG( ::gw2b::LL_Info, __VA_ARGS__ )
+#define LogWarning( ... )           GW2B_LOG( ::gw2b::LL_Warning, __VA_ARGS__ )
+#define LogError( ... )             GW2B_LOG( ::gw2b::LL_Error, __VA_ARGS__ )
+
+#endif // UTIL_LOG_H_INCLUDED
@@ -24,6 +24,13 @@
  */
 
 #include "stdafx.h"
+
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+#   include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#   include <cpuid.h>
+#endif
+
 #include "Misc.h"
 
 namespace gw2b {
@@ -55,4 +62,35 @@ namespace gw2b {
 #pragma warning( pop )
 #endif
 
+    bool hasSSE41( ) {
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+        int info[4];
+        __cpuid( info, 1 );
+        return ( info[2] & ( 1 << 19 ) ) != 0;
+#elif defined(__x86_64__) || defined(__i386__)
+        return __builtin_cpu_supports( "sse4.1" ) != 0;
+#else
+        return false;
+#endif
+    }
+
+    bool hasF16C( ) {
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+        int info[4];
+        __cpuid( info, 1 );
+        // F16C is VEX encoded, so the OS has to save the AVX registers too
+        const int needed = ( 1 << 29 ) | ( 1 << 28 ) | ( 1 << 27 );
+        return ( info[2] & needed ) == needed && ( _xgetbv( 0 ) & 6 ) == 6;
+#elif defined(__x86_64__) || defined(__i386__)
+        unsigned int eax, ebx, ecx, edx;
+        if ( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) ) {
+            return false;
+        }
+        // F16C is VEX encoded, so the OS has to save the AVX registers too
+        return ( ecx & bit_F16C ) && __builtin_cpu_supports( "avx" );
+#else
+        return false;
+#endif
+    }
+
 }; // namespace gw2b
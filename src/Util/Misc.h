@@ -129,6 +129,20 @@ namespace gw2b {
 
     //============================================================================/
 
+    /** Determines whether the CPU supports SSE4.1. Always false on CPUs that
+    *  are not x86.
+    *  \return bool    true if supported, false if not. */
+    bool hasSSE41( );
+
+    //============================================================================/
+
+    /** Determines whether the CPU and the OS support F16C, the half float
+    *  conversions. Always false on CPUs that are not x86.
+    *  \return bool    true if supported, false if not. */
+    bool hasF16C( );
+
+    //============================================================================/
+
     /** Check if the given object is the same type of the given type.
     *  \param[in]  p_object    Object to check type.
     *  \tparam     T           Type the object that to check. */
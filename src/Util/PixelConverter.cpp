@@ -0,0 +1,425 @@
+/** \file       Util/PixelConverter.cpp
+ *  \brief      Contains the definition of the pixel format conversion kernels.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#   define GW2B_PIXEL_SSE41     1
+#   include <smmintrin.h>
+#   if defined(_MSC_VER)
+#       define GW2B_TARGET_SSE41
+#   else
+#       define GW2B_TARGET_SSE41    __attribute__( ( target( "sse4.1" ) ) )
+#   endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   define GW2B_PIXEL_NEON      1
+#   include <arm_neon.h>
+#endif
+
+#include "PixelConverter.h"
+
+namespace gw2b {
+
+    namespace {
+
+        //============================================================================/
+        //      C++, also finishes what the others leave
+        //============================================================================/
+
+        /** Picks a byte of a pixel as an order says. */
+        uint8 pickByte( const uint8* p_pixel, uint8 p_index ) {
+            return ( p_index < 4 ) ? p_pixel[p_index] : 0xff;
+        }
+
+        /** Divides a product of two bytes by 255, rounding down. */
+        uint8 divide255( uint p_value ) {
+            return static_cast<uint8>( ( p_value + 1 + ( p_value >> 8 ) ) >> 8 );
+        }
+
+        void swizzleScalar( const uint8* p_pixels, uint8* po_pixels, uint p_count, const uint8* p_order ) {
+            for ( uint i = 0; i < p_count; i++ ) {
+                auto pixel = p_pixels + i * 4;
+                po_pixels[i * 4 + 0] = pickByte( pixel, p_order[0] );
+                po_pixels[i * 4 + 1] = pickByte( pixel, p_order[1] );
+                po_pixels[i * 4 + 2] = pickByte( pixel, p_order[2] );
+                po_pixels[i * 4 + 3] = pickByte( pixel, p_order[3] );
+            }
+        }
+
+        void splitAlphaScalar( const uint8* p_pixels, uint8* po_colors, uint8* po_alphas, uint p_count, const uint8* p_order ) {
+            for ( uint i = 0; i < p_count; i++ ) {
+                auto pixel = p_pixels + i * 4;
+                po_colors[i * 3 + 0] = pickByte( pixel, p_order[0] );
+                po_colors[i * 3 + 1] = pickByte( pixel, p_order[1] );
+                po_colors[i * 3 + 2] = pickByte( pixel, p_order[2] );
+                if ( po_alphas ) {
+                    po_alphas[i] = pickByte( pixel, p_order[3] );
+                }
+            }
+        }
+
+        void mergeAlphaScalar( const uint8* p_colors, const uint8* p_alphas, uint8* po_pixels, uint p_count, bool p_swapRedBlue ) {
+            const uint red = p_swapRedBlue ? 2 : 0;
+            for ( uint i = 0; i < p_count; i++ ) {
+                po_pixels[i * 4 + 0] = p_colors[i * 3 + red];
+                po_pixels[i * 4 + 1] = p_colors[i * 3 + 1];
+                po_pixels[i * 4 + 2] = p_colors[i * 3 + 2 - red];
+                po_pixels[i * 4 + 3] = p_alphas ? p_alphas[i] : 0xff;
+            }
+        }
+
+        void expandGrayScalar( const uint8* p_grays, uint8* po_pixels, uint p_count, uint p_pixelSize ) {
+            for ( uint i = 0; i < p_count; i++ ) {
+                auto pixel = po_pixels + i * p_pixelSize;
+                pixel[0] = pixel[1] = pixel[2] = p_grays[i];
+                if ( p_pixelSize == 4 ) {
+                    pixel[3] = 0xff;
+                }
+            }
+        }
+
+        void premultiplyScalar( uint8* po_colors, const uint8* p_alphas, uint p_count ) {
+            for ( uint i = 0; i < p_count; i++ ) {
+                po_colors[i * 3 + 0] = divide255( po_colors[i * 3 + 0] * p_alphas[i] );
+                po_colors[i * 3 + 1] = divide255( po_colors[i * 3 + 1] * p_alphas[i] );
+                po_colors[i * 3 + 2] = divide255( po_colors[i * 3 + 2] * p_alphas[i] );
+            }
+        }
+
+        /** Builds the shuffle mask and the 0xff fill taking 4 pixels through an
+        *  order, with p_size output bytes per pixel. Out of range indices pick
+        *  0 in both SSE and NEON shuffles. */
+        void orderMask( const uint8* p_order, uint p_size, uint8* po_mask, uint8* po_fill ) {
+            ::memset( po_mask, 0x80, 16 );
+            ::memset( po_fill, 0, 16 );
+            for ( uint i = 0; i < 4; i++ ) {
+                for ( uint c = 0; c < p_size; c++ ) {
+                    if ( p_order[c] < 4 ) {
+                        po_mask[i * p_size + c] = static_cast<uint8>( i * 4 + p_order[c] );
+                    } else {
+                        po_fill[i * p_size + c] = 0xff;
+                    }
+                }
+            }
+        }
+
+        //============================================================================/
+        //      SSE4.1
+        //============================================================================/
+
+#if GW2B_PIXEL_SSE41
+
+        /** Shuffle masks spreading 16 bytes over 3 byte colors. */
+        const uint8 SpreadMasks[3][16] = {
+            { 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5 },
+            { 5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10 },
+            { 10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15 },
+        };
+        /** Shuffle masks spreading 16 bytes over the colors of 4 byte pixels. */
+        const uint8 SpreadPixelMasks[4][16] = {
+            { 0, 0, 0, 0x80, 1, 1, 1, 0x80, 2, 2, 2, 0x80, 3, 3, 3, 0x80 },
+            { 4, 4, 4, 0x80, 5, 5, 5, 0x80, 6, 6, 6, 0x80, 7, 7, 7, 0x80 },
+            { 8, 8, 8, 0x80, 9, 9, 9, 0x80, 10, 10, 10, 0x80, 11, 11, 11, 0x80 },
+            { 12, 12, 12, 0x80, 13, 13, 13, 0x80, 14, 14, 14, 0x80, 15, 15, 15, 0x80 },
+        };
+        /** 0xff in the alpha of 4 byte pixels. */
+        const uint8 AlphaFill[16] = { 0, 0, 0, 0xff, 0, 0, 0, 0xff, 0, 0, 0, 0xff, 0, 0, 0, 0xff };
+
+        GW2B_TARGET_SSE41 __m128i load( const uint8* p_data ) {
+            return _mm_loadu_si128( reinterpret_cast<const __m128i*>( p_data ) );
+        }
+
+        GW2B_TARGET_SSE41 void store( uint8* po_data, __m128i p_value ) {
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( po_data ), p_value );
+        }
+
+        /** Divides 8 products of two bytes by 255, rounding down. */
+        GW2B_TARGET_SSE41 __m128i divide255( __m128i p_values ) {
+            auto sum = _mm_add_epi16( _mm_add_epi16( p_values, _mm_set1_epi16( 1 ) ), _mm_srli_epi16( p_values, 8 ) );
+            return _mm_srli_epi16( sum, 8 );
+        }
+
+        GW2B_TARGET_SSE41 void swizzleSSE41( const uint8* p_pixels, uint8* po_pixels, uint p_count, const uint8* p_order ) {
+            uint8 mask[16];
+            uint8 fill[16];
+            orderMask( p_order, 4, mask, fill );
+            auto maskVector = load( mask );
+            auto fillVector = load( fill );
+
+            uint i = 0;
+            for ( ; i + 4 <= p_count; i += 4 ) {
+                store( po_pixels + i * 4, _mm_or_si128( _mm_shuffle_epi8( load( p_pixels + i * 4 ), maskVector ), fillVector ) );
+            }
+            swizzleScalar( p_pixels + i * 4, po_pixels + i * 4, p_count - i, p_order );
+        }
+
+        GW2B_TARGET_SSE41 void splitAlphaSSE41( const uint8* p_pixels, uint8* po_colors, uint8* po_alphas, uint p_count, const uint8* p_order ) {
+            uint8 mask[16];
+            uint8 fill[16];
+            orderMask( p_order, 3, mask, fill );
+            auto colorMask = load( mask );
+            auto colorFill = load( fill );
+
+            // Each group of 4 pixels places its alphas 4 bytes further
+            __m128i alphaMasks[4];
+            ::memset( mask, 0x80, sizeof( mask ) );
+            for ( uint k = 0; k < 4; k++ ) {
+                for ( uint j = 0; j < 4; j++ ) {
+                    mask[k * 4 + j] = static_cast<uint8>( j * 4 + p_order[3] );
+                }
+                alphaMasks[k] = load( mask );
+                ::memset( mask + k * 4, 0x80, 4 );
+            }
+            const bool isAlphaFilled = ( p_order[3] >= 4 );
+
+            uint i = 0;
+            for ( ; i + 16 <= p_count; i += 16 ) {
+                __m128i colors[4];
+                auto alphas = _mm_setzero_si128( );
+                for ( uint k = 0; k < 4; k++ ) {
+                    auto pixels = load( p_pixels + ( i + k * 4 ) * 4 );
+                    colors[k] = _mm_or_si128( _mm_shuffle_epi8( pixels, colorMask ), colorFill );
+                    alphas = _mm_or_si128( alphas, _mm_shuffle_epi8( pixels, alphaMasks[k] ) );
+                }
+
+                // Pack the 12 bytes of colors of each group back to back
+                store( po_colors + i * 3, _mm_or_si128( colors[0], _mm_slli_si128( colors[1], 12 ) ) );
+                store( po_colors + i * 3 + 16, _mm_or_si128( _mm_srli_si128( colors[1], 4 ), _mm_slli_si128( colors[2], 8 ) ) );
+                store( po_colors + i * 3 + 32, _mm_or_si128( _mm_srli_si128( colors[2], 8 ), _mm_slli_si128( colors[3], 4 ) ) );
+
+                if ( po_alphas ) {
+                    store( po_alphas + i, isAlphaFilled ? _mm_set1_epi8( -1 ) : alphas );
+                }
+            }
+            splitAlphaScalar( p_pixels + i * 4, po_colors + i * 3, po_alphas ? po_alphas + i : nullptr, p_count - i, p_order );
+        }
+
+        GW2B_TARGET_SSE41 void mergeAlphaSSE41( const uint8* p_colors, const uint8* p_alphas, uint8* po_pixels, uint p_count, bool p_swapRedBlue ) {
+            uint8 mask[16];
+            const uint red = p_swapRedBlue ? 2 : 0;
+            for ( uint j = 0; j < 4; j++ ) {
+                mask[j * 4 + 0] = static_cast<uint8>( j * 3 + red );
+                mask[j * 4 + 1] = static_cast<uint8>( j * 3 + 1 );
+                mask[j * 4 + 2] = static_cast<uint8>( j * 3 + 2 - red );
+                mask[j * 4 + 3] = 0x80;
+            }
+            auto colorMask = load( mask );
+            auto alphaFill = load( AlphaFill );
+
+            // Alphas of each group of 4 pixels, at the last byte of the pixel
+            __m128i alphaMasks[4];
+            for ( uint k = 0; k < 4; k++ ) {
+                ::memset( mask, 0x80, sizeof( mask ) );
+                for ( uint j = 0; j < 4; j++ ) {
+                    mask[j * 4 + 3] = static_cast<uint8>( k * 4 + j );
+                }
+                alphaMasks[k] = load( mask );
+            }
+
+            uint i = 0;
+            for ( ; i + 16 <= p_count; i += 16 ) {
+                auto first = load( p_colors + i * 3 );
+                auto second = load( p_colors + i * 3 + 16 );
+                auto third = load( p_colors + i * 3 + 32 );
+
+                // Line up the 12 bytes of colors of each group
+                __m128i colors[4] = {
+                    first,
+                    _mm_alignr_epi8( second, first, 12 ),
+                    _mm_alignr_epi8( third, second, 8 ),
+                    _mm_srli_si128( third, 4 ),
+                };
+                auto alphas = p_alphas ? load( p_alphas + i ) : _mm_setzero_si128( );
+
+                for ( uint k = 0; k < 4; k++ ) {
+                    auto pixels = _mm_shuffle_epi8( colors[k], colorMask );
+                    pixels = _mm_or_si128( pixels, p_alphas ? _mm_shuffle_epi8( alphas, alphaMasks[k] ) : alphaFill );
+                    store( po_pixels + ( i + k * 4 ) * 4, pixels );
+                }
+            }
+            mergeAlphaScalar( p_colors + i * 3, p_alphas ? p_alphas + i : nullptr, po_pixels + i * 4, p_count - i, p_swapRedBlue );
+        }
+
+        GW2B_TARGET_SSE41 void expandGraySSE41( const uint8* p_grays, uint8* po_pixels, uint p_count, uint p_pixelSize ) {
+            auto alphaFill = load( AlphaFill );
+
+            uint i = 0;
+            for ( ; i + 16 <= p_count; i += 16 ) {
+                auto grays = load( p_grays + i );
+                if ( p_pixelSize == 3 ) {
+                    for ( uint k = 0; k < 3; k++ ) {
+                        store( po_pixels + i * 3 + k * 16, _mm_shuffle_epi8( grays, load( SpreadMasks[k] ) ) );
+                    }
+                } else {
+                    for ( uint k = 0; k < 4; k++ ) {
+                        store( po_pixels + i * 4 + k * 16, _mm_or_si128( _mm_shuffle_epi8( grays, load( SpreadPixelMasks[k] ) ), alphaFill ) );
+                    }
+                }
+            }
+            expandGrayScalar( p_grays + i, po_pixels + i * p_pixelSize, p_count - i, p_pixelSize );
+        }
+
+        GW2B_TARGET_SSE41 void premultiplySSE41( uint8* po_colors, const uint8* p_alphas, uint p_count ) {
+            auto zero = _mm_setzero_si128( );
+
+            uint i = 0;
+            for ( ; i + 16 <= p_count; i += 16 ) {
+                auto alphas = load( p_alphas + i );
+                for ( uint k = 0; k < 3; k++ ) {
+                    auto colors = load( po_colors + i * 3 + k * 16 );
+                    auto spread = _mm_shuffle_epi8( alphas, load( SpreadMasks[k] ) );
+                    auto low = _mm_mullo_epi16( _mm_unpacklo_epi8( colors, zero ), _mm_unpacklo_epi8( spread, zero ) );
+                    auto high = _mm_mullo_epi16( _mm_unpackhi_epi8( colors, zero ), _mm_unpackhi_epi8( spread, zero ) );
+                    store( po_colors + i * 3 + k * 16, _mm_packus_epi16( divide255( low ), divide255( high ) ) );
+                }
+            }
+            premultiplyScalar( po_colors + i * 3, p_alphas + i, p_count - i );
+        }
+
+#endif
+
+        //============================================================================/
+        //      NEON
+        //============================================================================/
+
+#if GW2B_PIXEL_NEON
+
+        /** Divides 8 products of two bytes by 255, rounding down. */
+        uint8x8_t divide255( uint16x8_t p_values ) {
+            auto sum = vaddq_u16( vaddq_u16( p_values, vdupq_n_u16( 1 ) ), vshrq_n_u16( p_values, 8 ) );
+            return vmovn_u16( vshrq_n_u16( sum, 8 ) );
+        }
+
+        void swizzleNEON( const uint8* p_pixels, uint8* po_pixels, uint p_count, const uint8* p_order ) {
+            uint8 mask[16];
+            uint8 fill[16];
+            orderMask( p_order, 4, mask, fill );
+            auto maskVector = vld1q_u8( mask );
+            auto fillVector = vld1q_u8( fill );
+
+            uint i = 0;
+            for ( ; i + 4 <= p_count; i += 4 ) {
+                vst1q_u8( po_pixels + i * 4, vorrq_u8( vqtbl1q_u8( vld1q_u8( p_pixels + i * 4 ), maskVector ), fillVector ) );
+            }
+            swizzleScalar( p_pixels + i * 4, po_pixels + i * 4, p_count - i, p_order );
+        }
+
+        void splitAlphaNEON( const uint8* p_pixels, uint8* po_colors, uint8* po_alphas, uint p_count, const uint8* p_order ) {
+            auto filled = vdupq_n_u8( 0xff );
+
+            uint i = 0;
+            for ( ; i + 16 <= p_count; i += 16 ) {
+                auto pixels = vld4q_u8( p_pixels + i * 4 );
+                uint8x16x3_t colors;
+                for ( uint c = 0; c < 3; c++ ) {
+                    colors.val[c] = ( p_order[c] < 4 ) ? pixels.val[p_order[c]] : filled;
+                }
+                vst3q_u8( po_colors + i * 3, colors );
+                if ( po_alphas ) {
+                    vst1q_u8( po_alphas + i, ( p_order[3] < 4 ) ? pixels.val[p_order[3]] : filled );
+                }
+            }
+            splitAlphaScalar( p_pixels + i * 4, po_colors + i * 3, po_alphas ? po_alphas + i : nullptr, p_count - i, p_order );
+        }
+
+        void mergeAlphaNEON( const uint8* p_colors, const uint8* p_alphas, uint8* po_pixels, uint p_count, bool p_swapRedBlue ) {
+            const uint red = p_swapRedBlue ? 2 : 0;
+
+            uint i = 0;
+            for ( ; i + 16 <= p_count; i += 16 ) {
+                auto colors = vld3q_u8( p_colors + i * 3 );
+                uint8x16x4_t pixels;
+                pixels.val[0] = colors.val[red];
+                pixels.val[1] = colors.val[1];
+                pixels.val[2] = colors.val[2 - red];
+                pixels.val[3] = p_alphas ? vld1q_u8( p_alphas + i ) : vdupq_n_u8( 0xff );
+                vst4q_u8( po_pixels + i * 4, pixels );
+            }
+            mergeAlphaScalar( p_colors + i * 3, p_alphas ? p_alphas + i : nullptr, po_pixels + i * 4, p_count - i, p_swapRedBlue );
+        }
+
+        void expandGrayNEON( const uint8* p_grays, uint8* po_pixels, uint p_count, uint p_pixelSize ) {
+            uint i = 0;
+            for ( ; i + 16 <= p_count; i += 16 ) {
+                auto grays = vld1q_u8( p_grays + i );
+                if ( p_pixelSize == 3 ) {
+                    uint8x16x3_t colors = { { grays, grays, grays } };
+                    vst3q_u8( po_pixels + i * 3, colors );
+                } else {
+                    uint8x16x4_t pixels = { { grays, grays, grays, vdupq_n_u8( 0xff ) } };
+                    vst4q_u8( po_pixels + i * 4, pixels );
+                }
+            }
+            expandGrayScalar( p_grays + i, po_pixels + i * p_pixelSize, p_count - i, p_pixelSize );
+        }
+
+        void premultiplyNEON( uint8* po_colors, const uint8* p_alphas, uint p_count ) {
+            uint i = 0;
+            for ( ; i + 16 <= p_count; i += 16 ) {
+                auto colors = vld3q_u8( po_colors + i * 3 );
+                auto alphas = vld1q_u8( p_alphas + i );
+                for ( uint c = 0; c < 3; c++ ) {
+                    auto low = vmull_u8( vget_low_u8( colors.val[c] ), vget_low_u8( alphas ) );
+                    auto high = vmull_u8( vget_high_u8( colors.val[c] ), vget_high_u8( alphas ) );
+                    colors.val[c] = vcombine_u8( divide255( low ), divide255( high ) );
+                }
+                vst3q_u8( po_colors + i * 3, colors );
+            }
+            premultiplyScalar( po_colors + i * 3, p_alphas + i, p_count - i );
+        }
+
+#endif
+
+        PixelConverter pickConverter( ) {
+#if GW2B_PIXEL_SSE41
+            if ( hasSSE41( ) ) {
+                PixelConverter converter = { "SSE4.1", &swizzleSSE41, &splitAlphaSSE41, &mergeAlphaSSE41, &expandGraySSE41, &premultiplySSE41 };
+                return converter;
+            }
+#elif GW2B_PIXEL_NEON
+            PixelConverter converter = { "NEON", &swizzleNEON, &splitAlphaNEON, &mergeAlphaNEON, &expandGrayNEON, &premultiplyNEON };
+            return converter;
+#endif
+            return pixelReferenceConverter( );
+        }
+
+    };
+
+    //============================================================================/
+
+    const PixelConverter& pixelConverter( ) {
+        static const PixelConverter s_converter = pickConverter( );
+        return s_converter;
+    }
+
+    //============================================================================/
+
+    const PixelConverter& pixelReferenceConverter( ) {
+        static const PixelConverter s_converter = { "C++", &swizzleScalar, &splitAlphaScalar, &mergeAlphaScalar, &expandGrayScalar, &premultiplyScalar };
+        return s_converter;
+    }
+
+}; // namespace gw2b
@@ -0,0 +1,83 @@
+/** \file       Util/PixelConverter.h
+ *  \brief      Contains the declaration of the pixel format conversion kernels.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef UTIL_PIXELCONVERTER_H_INCLUDED
+#define UTIL_PIXELCONVERTER_H_INCLUDED
+
+namespace gw2b {
+
+    /** Set of kernels converting runs of 8-bit pixels between layouts. Colors
+    *  are 3 bytes, pixels 4 bytes and alphas 1 byte. All sets give exactly the
+    *  same output.
+    *
+    *  An order picks, for each output byte of a pixel, the input byte to copy.
+    *  Entries of 4 or more give 0xff instead. */
+    struct PixelConverter {
+        const char* name;   /**< Name of the instruction set used. */
+
+        /** Reorders the bytes of pixels.
+        *  \param[in]  p_pixels     Pixels to reorder.
+        *  \param[out] po_pixels    Receives the reordered pixels.
+        *  \param[in]  p_count      Amount of pixels.
+        *  \param[in]  p_order      Input byte of each output byte. */
+        void ( *swizzle )( const uint8* p_pixels, uint8* po_pixels, uint p_count, const uint8* p_order );
+        /** Splits pixels into colors and alphas.
+        *  \param[in]  p_pixels     Pixels to split.
+        *  \param[out] po_colors    Receives the colors.
+        *  \param[out] po_alphas    Receives the alphas, may be nullptr.
+        *  \param[in]  p_count      Amount of pixels.
+        *  \param[in]  p_order      Input byte of each color byte, then of the alpha. */
+        void ( *splitAlpha )( const uint8* p_pixels, uint8* po_colors, uint8* po_alphas, uint p_count, const uint8* p_order );
+        /** Merges colors and alphas into pixels.
+        *  \param[in]  p_colors     Colors to merge.
+        *  \param[in]  p_alphas     Alphas to merge, or nullptr for 0xff.
+        *  \param[out] po_pixels    Receives the pixels.
+        *  \param[in]  p_count      Amount of pixels.
+        *  \param[in]  p_swapRedBlue   Swap the first and last byte of each color? */
+        void ( *mergeAlpha )( const uint8* p_colors, const uint8* p_alphas, uint8* po_pixels, uint p_count, bool p_swapRedBlue );
+        /** Expands grays to colors, or to pixels with an alpha of 0xff.
+        *  \param[in]  p_grays      Grays to expand.
+        *  \param[out] po_pixels    Receives the colors or pixels.
+        *  \param[in]  p_count      Amount of pixels.
+        *  \param[in]  p_pixelSize  3 for colors, 4 for pixels. */
+        void ( *expandGray )( const uint8* p_grays, uint8* po_pixels, uint p_count, uint p_pixelSize );
+        /** Multiplies colors by their alphas, as color * alpha / 255 rounded down.
+        *  \param[in,out] po_colors Colors to multiply.
+        *  \param[in]  p_alphas     Alphas to multiply by.
+        *  \param[in]  p_count      Amount of pixels. */
+        void ( *premultiply )( uint8* po_colors, const uint8* p_alphas, uint p_count );
+    };
+
+    /** Gets the fastest kernels the CPU supports, picked on first use.
+    *  \return PixelConverter&  The kernels. */
+    const PixelConverter& pixelConverter( );
+    /** Gets the plain C++ kernels, the reference for all others.
+    *  \return PixelConverter&  The kernels. */
+    const PixelConverter& pixelReferenceConverter( );
+
+}; // namespace gw2b
+
+#endif // UTIL_PIXELCONVERTER_H_INCLUDED
@@ -24,6 +24,7 @@
  */
 
 #include "stdafx.h"
+#include <cmath>
 #include <wx/dcbuffer.h>
 
 #include "Data.h"
@@ -31,112 +32,187 @@
 
 namespace gw2b {
 
+    namespace {
+
+        /** Width and height of a tile, in pixels of its level. A multiple of
+        *  the backdrop's size, so the checkers line up across tiles. */
+        const int TileSize = 256;
+        /** Built tiles kept before the ones not drawn lately are dropped. */
+        const size_t MaxTiles = 128;
+        const double MinZoom = 1.0 / 32;
+        const double MaxZoom = 32.0;
+        const int ScrollRate = 0x20;
+
+        uint64 tileKey( uint p_level, int p_tileX, int p_tileY ) {
+            return ( static_cast<uint64>( p_level ) << 48 ) | ( static_cast<uint64>( p_tileY ) << 24 ) | static_cast<uint64>( p_tileX );
+        }
+
+    };
+
     ImageControl::ImageControl( wxWindow* p_parent, const wxPoint& p_position, const wxSize& p_size )
         : wxScrolledWindow( p_parent, wxID_ANY, p_position, p_size )
-        , m_channels( IC_All ) {
+        , m_source( nullptr )
+        , m_channels( IC_All )
+        , m_zoom( 1.0 )
+        , m_scale( 1.0 )
+        , m_fitToWindow( false )
+        , m_paintCount( 0 ) {
         m_backdrop = loadImage(getPath("interface/ui/checkers.png"));
         this->SetBackgroundStyle( wxBG_STYLE_CUSTOM );
         this->SetBackgroundColour( wxSystemSettings::GetColour( wxSYS_COLOUR_APPWORKSPACE ) );
         this->Bind( wxEVT_PAINT, &ImageControl::OnPaintEvt, this );
+        this->Bind( wxEVT_SIZE, &ImageControl::OnSizeEvt, this );
+        this->Bind( wxEVT_MOUSEWHEEL, &ImageControl::OnMouseWheelEvt, this );
     }
 
     ImageControl::~ImageControl( ) {
     }
 
     void ImageControl::SetImage( wxImage p_image ) {
-        m_image = p_image;
-        this->UpdateBitmap( );
+        m_levels.clear( );
+        m_source = nullptr;
+        this->ClearTiles( );
+
+        // The smaller levels are made when a zoom first needs them
+        if ( p_image.IsOk( ) ) {
+            m_levels.push_back( p_image );
+        }
+
+        this->UpdateZoom( );
+        this->Refresh( );
+    }
+
+    void ImageControl::SetImageSource( IImageSource* p_source ) {
+        m_levels.clear( );
+        m_source = p_source;
+        this->ClearTiles( );
+
+        this->UpdateZoom( );
+        this->Refresh( );
+    }
+
+    void ImageControl::SetZoom( double p_zoom ) {
+        m_zoom = wxMax( MinZoom, wxMin( p_zoom, MaxZoom ) );
+        if ( !m_fitToWindow ) {
+            this->UpdateZoom( );
+            this->Refresh( );
+        }
+    }
+
+    void ImageControl::SetFitToWindow( bool p_fitToWindow ) {
+        m_fitToWindow = p_fitToWindow;
+        this->UpdateZoom( );
+        this->Refresh( );
     }
 
-    void ImageControl::UpdateBitmap( ) {
-        m_bitmap = wxBitmap( );
+    bool ImageControl::HasImage( ) const {
+        if ( m_source ) {
+            auto size = m_source->imageSize( );
+            return ( size.x > 0 ) && ( size.y > 0 );
+        }
+        return !m_levels.empty( );
+    }
 
-        if ( m_image.IsOk( ) ) {
-            m_bitmap.Create( m_image.GetWidth( ), m_image.GetHeight( ) );
-            wxMemoryDC dc( m_bitmap );
+    wxSize ImageControl::GetImageSize( ) const {
+        if ( m_source ) {
+            return m_source->imageSize( );
+        }
+        return m_levels.empty( ) ? wxSize( 0, 0 ) : m_levels[0].GetSize( );
+    }
 
-            // New image so we don't mess with the actual image
-            wxImage image( m_image );
-            bool imageHasAlpha = image.HasAlpha( );
+    wxSize ImageControl::GetLevelSize( uint p_level ) const {
+        // Halved like wxImage::ShrinkBy does
+        auto size = this->GetImageSize( );
+        return wxSize( wxMax( size.x >> p_level, 1 ), wxMax( size.y >> p_level, 1 ) );
+    }
 
-            // Skip backdrop if image has no alpha, or if it's not visible
-            if ( imageHasAlpha && !!( m_channels & IC_Alpha ) ) {
-                for ( uint y = 0; y < ( uint ) m_bitmap.GetHeight( ); y += m_backdrop.GetHeight( ) ) {
-                    for ( uint x = 0; x < ( uint ) m_bitmap.GetWidth( ); x += m_backdrop.GetWidth( ) ) {
-                        dc.DrawBitmap( m_backdrop, x, y );
-                    }
+    const wxImage& ImageControl::GetLevel( uint p_level ) {
+        while ( m_levels.size( ) <= p_level ) {
+            m_levels.push_back( m_levels.back( ).ShrinkBy( 2, 2 ) );
+        }
+        return m_levels[p_level];
+    }
+
+    const wxBitmap& ImageControl::GetTile( uint p_level, int p_tileX, int p_tileY ) {
+        auto key = tileKey( p_level, p_tileX, p_tileY );
+        auto tile = m_tiles.find( key );
+        if ( tile != m_tiles.end( ) ) {
+            tile->second.lastDrawn = m_paintCount;
+            return tile->second.bitmap;
+        }
+
+        wxRect rect( p_tileX * TileSize, p_tileY * TileSize, TileSize, TileSize );
+        rect.Intersect( wxRect( this->GetLevelSize( p_level ) ) );
+
+        // Only the pixels of this tile get masked
+        wxImage image = m_source ? m_source->imageRegion( p_level, rect ) : this->GetLevel( p_level ).GetSubImage( rect );
+        if ( !image.IsOk( ) ) {
+            image = wxImage( rect.width, rect.height );
+        }
+        bool hasAlpha = image.HasAlpha( );
+        this->MaskChannels( image );
+
+        auto& built = m_tiles[key];
+        built.lastDrawn = m_paintCount;
+        built.bitmap.Create( rect.width, rect.height );
+
+        wxMemoryDC dc( built.bitmap );
+        // Skip backdrop if image has no alpha, or if it's not visible
+        if ( hasAlpha && !!( m_channels & IC_Alpha ) ) {
+            for ( int y = 0; y < rect.height; y += m_backdrop.GetHeight( ) ) {
+                for ( int x = 0; x < rect.width; x += m_backdrop.GetWidth( ) ) {
+                    dc.DrawBitmap( m_backdrop, x, y );
                 }
             }
+        }
+        dc.DrawBitmap( wxBitmap( image ), 0, 0 );
+        dc.SelectObject( wxNullBitmap );
 
-            // Check if any channels have been toggled off
-            if ( m_channels != IC_All ) {
-                uint numPixels = image.GetWidth( ) * image.GetHeight( );
-                uint8* alphaCache = nullptr;
-
-                // Any colors toggled off?
-                if ( !( m_channels & IC_Red ) || !( m_channels & IC_Green ) || !( m_channels & IC_Blue ) ) {
-                    uint8* colors = allocate<uint8>( numPixels * 3 );
-                    ::memcpy( colors, image.GetData( ), numPixels * 3 );
-
-                    // Setting colors clears the alpha, so cache it for restoration later,
-                    // if the image has an alpha channel and it's visible
-                    if ( imageHasAlpha && ( m_channels & IC_Alpha ) ) {
-                        alphaCache = allocate<uint8>( numPixels );
-                        ::memcpy( alphaCache, image.GetAlpha( ), numPixels );
-                    }
-
-                    // If all colors are off, but alpha is on, alpha should be made white
-                    bool noColors = !( ( m_channels & IC_Red ) || ( m_channels & IC_Green ) || ( m_channels & IC_Blue ) );
-                    bool whiteAlpha = noColors && !!( m_channels & IC_Alpha );
-
-                    // Loop through the pixels
-                    for ( uint i = 0; i < numPixels; i++ ) {
-                        if ( whiteAlpha ) {
-                            if ( alphaCache ) {
-                                ::memset( &colors[i * 3], alphaCache[i], sizeof( uint8 ) * 3 );
-                            } else {
-                                ::memset( &colors[i * 3], 0xff, sizeof( uint8 ) * 3 );
-                            }
-                        } else {
-                            // Red turned off?
-                            if ( !( m_channels & IC_Red ) ) {
-                                colors[i * 3 + 0] = 0x00;
-                            }
-                            // Green turned off?
-                            if ( !( m_channels & IC_Green ) ) {
-                                colors[i * 3 + 1] = 0x00;
-                            }
-                            // Blue turned off?
-                            if ( !( m_channels & IC_Blue ) ) {
-                                colors[i * 3 + 2] = 0x00;
-                            }
-                        }
-                    }
-
-                    // If alpha should be white, it should not be alpha too
-                    if ( whiteAlpha ) {
-                        freePointer( alphaCache );
-                    }
-
-                    // Update colors
-                    image.SetData( colors );
-                }
+        return built.bitmap;
+    }
 
-                // Was alpha turned off?
-                if ( imageHasAlpha && !( m_channels & IC_Alpha ) ) {
-                    uint8* alpha = allocate<uint8>( numPixels );
-                    ::memset( alpha, 0xff, numPixels );
-                    image.SetAlpha( alpha );
-                } else if ( alphaCache ) {
-                    image.SetAlpha( alphaCache );
+    void ImageControl::MaskChannels( wxImage& p_image ) const {
+        if ( m_channels == IC_All ) {
+            return;
+        }
+
+        uint numPixels = p_image.GetWidth( ) * p_image.GetHeight( );
+        uint8* colors = p_image.GetData( );
+        uint8* alphas = p_image.HasAlpha( ) ? p_image.GetAlpha( ) : nullptr;
+
+        bool noColors = !( m_channels & ( IC_Red | IC_Green | IC_Blue ) );
+        if ( noColors && !!( m_channels & IC_Alpha ) ) {
+            // If all colors are off, but alpha is on, alpha should be made white
+            for ( uint i = 0; i < numPixels; i++ ) {
+                ::memset( &colors[i * 3], alphas ? alphas[i] : 0xff, sizeof( uint8 ) * 3 );
+            }
+            // If alpha should be white, it should not be alpha too
+            alphas = nullptr;
+        } else if ( !( m_channels & IC_Red ) || !( m_channels & IC_Green ) || !( m_channels & IC_Blue ) ) {
+            for ( uint i = 0; i < numPixels; i++ ) {
+                // Red turned off?
+                if ( !( m_channels & IC_Red ) ) {
+                    colors[i * 3 + 0] = 0x00;
+                }
+                // Green turned off?
+                if ( !( m_channels & IC_Green ) ) {
+                    colors[i * 3 + 1] = 0x00;
+                }
+                // Blue turned off?
+                if ( !( m_channels & IC_Blue ) ) {
+                    colors[i * 3 + 2] = 0x00;
                 }
             }
+        }
 
-            // Draw the image
-            dc.DrawBitmap( wxBitmap( image ), 0, 0 );
+        // Was alpha turned off, or made white?
+        if ( p_image.HasAlpha( ) && ( !alphas || !( m_channels & IC_Alpha ) ) ) {
+            p_image.ClearAlpha( );
         }
+    }
 
-        this->Refresh( );
+    void ImageControl::ClearTiles( ) {
+        m_tiles.clear( );
     }
 
     void ImageControl::ToggleChannel( ImageChannels p_channel, bool p_toggled ) {
@@ -163,22 +239,77 @@ namespace gw2b {
             isDirty = true;
         }
 
+        // Tiles get masked again as they are drawn
         if ( isDirty ) {
-            this->UpdateBitmap( );
+            this->ClearTiles( );
+            this->Refresh( );
         }
     }
 
     void ImageControl::OnDraw( wxDC& p_DC, wxRect& p_region ) {
-        this->UpdateScrollbars( p_DC );
-        if ( m_bitmap.IsOk( ) ) {
-            p_DC.DrawBitmap( m_bitmap, 0, 0 );
+        if ( this->HasImage( ) ) {
+            this->DrawTiles( p_DC, p_region );
         }
     }
 
-    void ImageControl::UpdateScrollbars( wxDC& p_DC ) {
-        if ( m_bitmap.IsOk( ) ) {
-            this->SetVirtualSize( m_bitmap.GetWidth( ), m_bitmap.GetHeight( ) );
-            this->SetScrollRate( 0x20, 0x20 );
+    void ImageControl::DrawTiles( wxDC& p_DC, const wxRect& p_region ) {
+        // Smallest level with at least a pixel per screen pixel
+        wxSize size = this->GetImageSize( );
+        uint levelIndex = 0;
+        while ( ( m_scale * ( 2 << levelIndex ) <= 1.0 ) && ( ( size.x >> ( levelIndex + 1 ) ) > 0 ) && ( ( size.y >> ( levelIndex + 1 ) ) > 0 ) ) {
+            levelIndex++;
+        }
+        auto levelSize = this->GetLevelSize( levelIndex );
+
+        // Screen pixels per pixel of the level
+        double factor = m_scale * ( 1 << levelIndex );
+        double tileExtent = TileSize * factor;
+        int numTilesX = ( levelSize.x + TileSize - 1 ) / TileSize;
+        int numTilesY = ( levelSize.y + TileSize - 1 ) / TileSize;
+        int firstX = wxMax( static_cast<int>( p_region.GetLeft( ) / tileExtent ), 0 );
+        int firstY = wxMax( static_cast<int>( p_region.GetTop( ) / tileExtent ), 0 );
+        int lastX = wxMin( static_cast<int>( p_region.GetRight( ) / tileExtent ), numTilesX - 1 );
+        int lastY = wxMin( static_cast<int>( p_region.GetBottom( ) / tileExtent ), numTilesY - 1 );
+
+        for ( int tileY = firstY; tileY <= lastY; tileY++ ) {
+            for ( int tileX = firstX; tileX <= lastX; tileX++ ) {
+                const wxBitmap& tile = this->GetTile( levelIndex, tileX, tileY );
+
+                // Round both edges so neighbouring tiles leave no gaps
+                int left = static_cast<int>( std::lround( tileX * tileExtent ) );
+                int top = static_cast<int>( std::lround( tileY * tileExtent ) );
+                int right = static_cast<int>( std::lround( ( tileX * TileSize + tile.GetWidth( ) ) * factor ) );
+                int bottom = static_cast<int>( std::lround( ( tileY * TileSize + tile.GetHeight( ) ) * factor ) );
+
+                if ( ( right - left == tile.GetWidth( ) ) && ( bottom - top == tile.GetHeight( ) ) ) {
+                    p_DC.DrawBitmap( tile, left, top );
+                } else {
+                    wxMemoryDC source;
+                    source.SelectObjectAsSource( tile );
+                    p_DC.StretchBlit( left, top, right - left, bottom - top, &source, 0, 0, tile.GetWidth( ), tile.GetHeight( ) );
+                }
+            }
+        }
+    }
+
+    void ImageControl::UpdateZoom( ) {
+        m_scale = m_zoom;
+
+        // Fitting only shrinks, smaller images are shown as they are
+        auto clientSize = this->GetClientSize( );
+        if ( m_fitToWindow && this->HasImage( ) && ( clientSize.x > 0 ) && ( clientSize.y > 0 ) ) {
+            wxSize size = this->GetImageSize( );
+            m_scale = wxMin( 1.0, wxMin( static_cast<double>( clientSize.x ) / size.x, static_cast<double>( clientSize.y ) / size.y ) );
+        }
+
+        this->UpdateScrollbars( );
+    }
+
+    void ImageControl::UpdateScrollbars( ) {
+        if ( this->HasImage( ) ) {
+            wxSize size = this->GetImageSize( );
+            this->SetVirtualSize( wxMax( static_cast<int>( size.x * m_scale ), 1 ), wxMax( static_cast<int>( size.y * m_scale ), 1 ) );
+            this->SetScrollRate( ScrollRate, ScrollRate );
         } else {
             this->SetVirtualSize( 0, 0 );
         }
@@ -187,6 +318,7 @@ namespace gw2b {
     void ImageControl::OnPaintEvt( wxPaintEvent& p_event ) {
         wxAutoBufferedPaintDC dc( this );
         dc.Clear( );
+        m_paintCount++;
 
         int vX, vY, pX, pY;
         this->GetViewStart( &vX, &vY );
@@ -204,6 +336,45 @@ namespace gw2b {
             updRect.y += vY;
             this->OnDraw( dc, updRect );
         }
+
+        // Drop the tiles that were not drawn this time
+        if ( m_tiles.size( ) > MaxTiles ) {
+            for ( auto it = m_tiles.begin( ); it != m_tiles.end( ); ) {
+                if ( it->second.lastDrawn != m_paintCount ) {
+                    it = m_tiles.erase( it );
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void ImageControl::OnSizeEvt( wxSizeEvent& p_event ) {
+        p_event.Skip( );
+        if ( m_fitToWindow ) {
+            this->UpdateZoom( );
+            this->Refresh( );
+        }
+    }
+
+    void ImageControl::OnMouseWheelEvt( wxMouseEvent& p_event ) {
+        // Plain wheel scrolls, ctrl + wheel zooms
+        if ( !p_event.ControlDown( ) || m_fitToWindow || !this->HasImage( ) || !p_event.GetWheelRotation( ) ) {
+            p_event.Skip( );
+            return;
+        }
+
+        // Keep the pixel under the mouse where it is
+        auto mouse = p_event.GetPosition( );
+        auto position = this->CalcUnscrolledPosition( mouse );
+        double imageX = position.x / m_scale;
+        double imageY = position.y / m_scale;
+
+        this->SetZoom( ( p_event.GetWheelRotation( ) > 0 ) ? m_zoom * 2 : m_zoom / 2 );
+
+        int viewX = static_cast<int>( imageX * m_scale ) - mouse.x;
+        int viewY = static_cast<int>( imageY * m_scale ) - mouse.y;
+        this->Scroll( wxMax( viewX, 0 ) / ScrollRate, wxMax( viewY, 0 ) / ScrollRate );
     }
 
 }; // namespace gw2b
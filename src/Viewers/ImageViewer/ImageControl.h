@@ -27,10 +27,30 @@
 #ifndef VIEWERS_IMAGEVIEWER_IMAGECONTROL_H_INCLUDED
 #define VIEWERS_IMAGEVIEWER_IMAGECONTROL_H_INCLUDED
 
+#include <unordered_map>
+#include <vector>
 #include <wx/scrolwin.h>
 
 namespace gw2b {
 
+    /** Gives the pixels of an image too big to keep whole, a region at a time. */
+    class IImageSource {
+    public:
+        /** Gets the size of the image.
+        *  \return wxSize  Size in pixels. */
+        virtual wxSize imageSize( ) const = 0;
+        /** Gets a region of the image, reduced by a power of two.
+        *  \param[in]  p_level      Reduction, the image is halved p_level times.
+        *  \param[in]  p_region     Region to get, in pixels of the reduced image.
+        *  \return wxImage     The region. */
+        virtual wxImage imageRegion( uint p_level, const wxRect& p_region ) = 0;
+    }; // class IImageSource
+
+    /** Shows an image, zoomable and with channels that can be toggled.
+    *
+    *  The image is drawn in tiles from a pyramid of halved copies, so only the
+    *  visible tiles are built, channel masked and drawn. Toggling a channel
+    *  or zooming only drops the built tiles, never touches the whole image. */
     class ImageControl : public wxScrolledWindow {
     public:
         enum ImageChannels {
@@ -42,20 +62,49 @@ namespace gw2b {
             IC_All = 15,
         };
     private:
-        wxImage         m_image;
-        wxBitmap        m_bitmap;
+        /** Tile of a level, built with the current channels. */
+        struct Tile {
+            wxBitmap    bitmap;
+            uint        lastDrawn;      /**< Paint the tile was last drawn in. */
+        };
+        std::vector<wxImage>                m_levels;       /**< Image, then each level half the size of the previous. Built when first drawn. */
+        std::unordered_map<uint64, Tile>    m_tiles;        /**< Built tiles, by level and position. */
+        IImageSource*   m_source;       /**< Gives the tiles instead of m_levels if set. */
         wxBitmap        m_backdrop;
         ImageChannels   m_channels;
+        double          m_zoom;         /**< Zoom set with SetZoom. */
+        double          m_scale;        /**< Zoom shown, differs from m_zoom while fitting. */
+        bool            m_fitToWindow;
+        uint            m_paintCount;
     public:
         ImageControl( wxWindow* p_parent, const wxPoint& p_position = wxDefaultPosition, const wxSize& p_size = wxDefaultSize );
         virtual ~ImageControl( );
         void SetImage( wxImage p_image );
+        /** Shows an image read a tile at a time, for images too big to keep
+        *  whole. The source must outlive the control, or be replaced first. */
+        void SetImageSource( IImageSource* p_source );
         void OnDraw( wxDC& p_DC, wxRect& p_region );
         void ToggleChannel( ImageChannels p_channel, bool p_toggled );
+        /** Sets the zoom, 1 being a screen pixel per image pixel. Ignored
+        *  while fitting the image to the window. */
+        void SetZoom( double p_zoom );
+        /** Shrinks images bigger than the window to fit it, or shows them at
+        *  the zoom set before. */
+        void SetFitToWindow( bool p_fitToWindow );
     private:
-        void UpdateBitmap( );
-        void UpdateScrollbars( wxDC& p_DC );
+        bool HasImage( ) const;
+        wxSize GetImageSize( ) const;
+        wxSize GetLevelSize( uint p_level ) const;
+        const wxImage& GetLevel( uint p_level );
+        const wxBitmap& GetTile( uint p_level, int p_tileX, int p_tileY );
+        void DrawTiles( wxDC& p_DC, const wxRect& p_region );
+        void MaskChannels( wxImage& p_image ) const;
+        void ClearTiles( );
+        void UpdateZoom( );
+        void UpdateScrollbars( );
         void OnPaintEvt( wxPaintEvent& p_event );
+        void OnSizeEvt( wxSizeEvent& p_event );
+        void OnMouseWheelEvt( wxMouseEvent& p_event );
     };
 
 }; // namespace gw2b
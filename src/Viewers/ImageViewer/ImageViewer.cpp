@@ -35,7 +35,9 @@ namespace gw2b {
 
     ImageViewer::ImageViewer( wxWindow* p_parent, const wxPoint& p_pos, const wxSize& p_size )
         : Viewer( p_parent, p_pos, p_size )
-        , m_imageControl( nullptr ) {
+        , m_imageControl( nullptr )
+        , m_imageScale( ImageReader::IS_Full )
+        , m_fitToWindow( false ) {
         auto sizer = new wxBoxSizer( wxVERTICAL );
 
         // Toolbar
@@ -44,6 +46,7 @@ namespace gw2b {
 
         // Image control
         m_imageControl = new ImageControl( this );
+        m_imageControl->Bind( wxEVT_SIZE, &ImageViewer::onImageResizeEvt, this );
         sizer->Add( m_imageControl, wxSizerFlags( ).Expand( ).Proportion( 1 ) );
 
         // Layout
@@ -55,27 +58,64 @@ namespace gw2b {
     }
 
     void ImageViewer::clear( ) {
+        m_image = wxImage( );
         m_imageControl->SetImage( wxImage( ) );
         Viewer::clear( );
     }
 
     void ImageViewer::setReader( FileReader* p_reader ) {
-        Ensure::isOfType<ImageReader>( p_reader );
+        if ( !dynamic_cast<PagedImageReader*>( p_reader ) ) {
+            Ensure::isOfType<ImageReader>( p_reader );
+        }
         Viewer::setReader( p_reader );
 
-        if ( p_reader ) {
-            m_image = imageReader( )->getImage( );
+        m_image = wxImage( );
+        if ( this->pagedImageReader( ) ) {
+            // Paged images are too big to decode whole, the control reads them a tile at a time
+            m_imageControl->SetImageSource( this );
+        } else if ( p_reader ) {
+            this->updateImage( );
+        }
+    }
+
+    wxSize ImageViewer::imageSize( ) const {
+        auto reader = dynamic_cast<const PagedImageReader*>( this->reader( ) );
+        return reader ? reader->layerSize( 0 ) : wxSize( 0, 0 );
+    }
+
+    wxImage ImageViewer::imageRegion( uint p_level, const wxRect& p_region ) {
+        auto reader = this->pagedImageReader( );
+        return reader ? reader->getRegion( 0, p_level, p_region ) : wxImage( );
+    }
+
+    void ImageViewer::updateImage( ) {
+        if ( !this->reader( ) || this->pagedImageReader( ) ) {
+            return;
+        }
+
+        // Big textures shown fit to the window don't need all their pixels
+        auto scale = ImageReader::IS_Full;
+        wxSize size;
+        bool hasAlpha;
+        if ( m_fitToWindow && imageReader( )->getImageInfo( size, hasAlpha ) ) {
+            scale = ImageReader::scaleForSize( size, m_imageControl->GetClientSize( ) );
+        }
+
+        // The control shrinks the image to the window itself
+        if ( !m_image.IsOk( ) || ( scale != m_imageScale ) ) {
+            m_image = imageReader( )->getScaledImage( scale );
+            m_imageScale = scale;
             m_imageControl->SetImage( m_image );
         }
     }
 
     wxPanel* ImageViewer::buildToolbar( ) {
-        auto toolbar = new wxPanel( this, wxID_ANY, wxDefaultPosition, wxSize( 170, 40 ), wxBORDER_SIMPLE );
-        auto flex = new wxFlexGridSizer( 1, 4, 0, 0 );
-        auto id = this->NewControlId( 4 );
+        auto toolbar = new wxPanel( this, wxID_ANY, wxDefaultPosition, wxSize( 215, 40 ), wxBORDER_SIMPLE );
+        auto flex = new wxFlexGridSizer( 1, 5, 0, 0 );
+        auto id = this->NewControlId( 5 );
 
         // Add the newly generated IDs
-        for ( uint i = 0; i < 4; i++ ) {
+        for ( uint i = 0; i < 5; i++ ) {
             m_toolbarButtonIds.Add( id++ );
         }
 
@@ -95,6 +135,13 @@ namespace gw2b {
             this->Bind( wxEVT_TOGGLEBUTTON, &ImageViewer::onToolbarClickedEvt, this, m_toolbarButtonIds[i] );
         }
 
+        // Fit to window button
+        wxToggleButton* fitButton = new wxToggleButton( toolbar, m_toolbarButtonIds[4], wxT( "Fit" ), wxDefaultPosition, wxSize( 35, 25 ) );
+        fitButton->SetValue( m_fitToWindow );
+        flex->Add( fitButton, 1, wxALL | wxALIGN_CENTRE, 5 );
+        m_toolbarButtons.Add( fitButton );
+        this->Bind( wxEVT_TOGGLEBUTTON, &ImageViewer::onToolbarClickedEvt, this, m_toolbarButtonIds[4] );
+
         toolbar->SetSizer( flex );
 
         return toolbar;
@@ -115,9 +162,21 @@ namespace gw2b {
             // Toggle alpha
         } else if ( id == m_toolbarButtonIds[3] ) {
             m_imageControl->ToggleChannel( ImageControl::IC_Alpha, m_toolbarButtons[3]->GetValue( ) );
+            // Toggle fit to window
+        } else if ( id == m_toolbarButtonIds[4] ) {
+            m_fitToWindow = m_toolbarButtons[4]->GetValue( );
+            m_imageControl->SetFitToWindow( m_fitToWindow );
+            this->updateImage( );
         } else {
             p_event.Skip( );
         }
     }
 
+    void ImageViewer::onImageResizeEvt( wxSizeEvent& p_event ) {
+        p_event.Skip( );
+        if ( m_fitToWindow ) {
+            this->updateImage( );
+        }
+    }
+
 }; // namespace gw2b
@@ -30,15 +30,18 @@
 #include <vector>
 #include <wx/tglbtn.h>
 
+#include "Readers/ImageReader.h"
+#include "Readers/PagedImageReader.h"
 #include "Viewer.h"
+#include "ImageControl.h"
 
 namespace gw2b {
-    class ImageControl;
-    class ImageReader;
 
-    class ImageViewer : public Viewer {
+    class ImageViewer : public Viewer, public IImageSource {
         ImageControl*               m_imageControl;
         wxImage                     m_image;
+        ImageReader::ImageScale     m_imageScale;
+        bool                        m_fitToWindow;
         Array<wxWindowID>           m_toolbarButtonIds;
         std::vector<wxBitmap>       m_toolbarButtonIcons;
         Array<wxToggleButton*>      m_toolbarButtons;
@@ -58,9 +61,23 @@ namespace gw2b {
         const ImageReader* imageReader( ) const {
             return reinterpret_cast<const ImageReader*>( this->reader( ) );
         } // already asserted with a dynamic_cast
+        /** Gets the paged image reader containing the data displayed by this viewer.
+        *  \return PagedImageReader*   Reader containing the data, nullptr if not a paged image. */
+        PagedImageReader* pagedImageReader( ) {
+            return dynamic_cast<PagedImageReader*>( this->reader( ) );
+        }
+
+        /** Gets the size of the first layer of the paged image. */
+        virtual wxSize imageSize( ) const override;
+        /** Gets a region of the first layer of the paged image. */
+        virtual wxImage imageRegion( uint p_level, const wxRect& p_region ) override;
     private:
         wxPanel* buildToolbar( );
+        /** Decodes the image again if fitting it to the window needs another
+        *  reduction, and shows it. */
+        void updateImage( );
         void onToolbarClickedEvt( wxCommandEvent& p_event );
+        void onImageResizeEvt( wxSizeEvent& p_event );
     }; // class ImageViewer
 
 }; // namespace gw2b
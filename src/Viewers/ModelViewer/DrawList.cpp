@@ -0,0 +1,76 @@
+/** \file       Viewers/ModelViewer/DrawList.cpp
+ *  \brief      Draw calls and texture binds of models, worked out without GL.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+
+#include "DrawList.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Name of a texture unit no texture was bound to yet. */
+        const uint UnknownTexture = ~0u;
+
+    };
+
+    std::vector<uint> DrawList::packingOrder( const std::vector<TextureSet>& p_meshTextures ) {
+        std::vector<uint> order( p_meshTextures.size( ) );
+        for ( uint i = 0; i < order.size( ); i++ ) {
+            order[i] = i;
+        }
+        std::stable_sort( order.begin( ), order.end( ), [&p_meshTextures]( uint p_a, uint p_b ) {
+            return p_meshTextures[p_a] < p_meshTextures[p_b];
+        } );
+        return order;
+    }
+
+    void DrawList::add( const TextureSet& p_textures, uint p_indexCount ) {
+        if ( !p_indexCount ) {
+            return;
+        }
+
+        if ( !m_commands.empty( ) && m_commands.back( ).textures == p_textures ) {
+            m_commands.back( ).indexCount += p_indexCount;
+        } else {
+            DrawCommand command = { p_textures, m_numIndices, p_indexCount };
+            m_commands.push_back( command );
+        }
+        m_numIndices += p_indexCount;
+    }
+
+    void DrawList::clear( ) {
+        m_commands.clear( );
+        m_numIndices = 0;
+    }
+
+    TextureBindings::TextureBindings( ) {
+        for ( uint unit = 0; unit < NumUnits; unit++ ) {
+            m_bound[unit] = UnknownTexture;
+        }
+    }
+
+}; // namespace gw2b
@@ -0,0 +1,152 @@
+/** \file       Viewers/ModelViewer/DrawList.h
+ *  \brief      Draw calls and texture binds of models, worked out without GL.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef VIEWERS_MODELVIEWER_DRAWLIST_H_INCLUDED
+#define VIEWERS_MODELVIEWER_DRAWLIST_H_INCLUDED
+
+#include <tuple>
+#include <vector>
+
+namespace gw2b {
+
+    /** GL calls issued to draw, counted on the CPU so it needs no GPU query. */
+    struct DrawStats {
+        uint                        drawCalls = 0;      /**< glDrawElements calls. */
+        uint                        textureBinds = 0;   /**< Textures bound, the state changes between draws. */
+
+        DrawStats& operator+=( const DrawStats& p_other ) {
+            drawCalls += p_other.drawCalls;
+            textureBinds += p_other.textureBinds;
+            return *this;
+        }
+    };
+
+    /** Textures of a material, as file ids, 0 for none. */
+    struct TextureSet {
+        uint                        diffuseMap;
+        uint                        normalMap;
+        uint                        lightMap;
+
+        bool operator==( const TextureSet& p_other ) const {
+            return diffuseMap == p_other.diffuseMap && normalMap == p_other.normalMap && lightMap == p_other.lightMap;
+        }
+        bool operator<( const TextureSet& p_other ) const {
+            return std::tie( diffuseMap, normalMap, lightMap ) < std::tie( p_other.diffuseMap, p_other.normalMap, p_other.lightMap );
+        }
+    };
+
+    /** Range of the index buffer drawn with one texture set. */
+    struct DrawCommand {
+        TextureSet                  textures;           // Textures of all meshes in the range
+        uint                        firstIndex;
+        uint                        indexCount;
+    };
+
+    /** Draw calls of meshes packed one after the other in one index buffer.
+    *  Meshes packed in packingOrder() share a call with the meshes next to
+    *  them that use the same textures. */
+    class DrawList {
+        std::vector<DrawCommand>    m_commands;
+        uint                        m_numIndices = 0;   // Indices packed so far
+    public:
+        /** Gets the order to pack meshes in, by texture set so each set is
+        *  bound and drawn once. Meshes with the same set keep their order.
+        *  \param[in]  p_meshTextures   Texture set of each mesh.
+        *  \return std::vector<uint>    Meshes in the order to pack them. */
+        static std::vector<uint> packingOrder( const std::vector<TextureSet>& p_meshTextures );
+
+        /** Adds the indices of the next packed mesh. They are drawn with the
+        *  last call if it uses the same textures. Meshes without indices
+        *  add nothing.
+        *  \param[in]  p_textures   Textures of the mesh.
+        *  \param[in]  p_indexCount Indices of the mesh. */
+        void add( const TextureSet& p_textures, uint p_indexCount );
+        /** Removes all draw calls. */
+        void clear( );
+
+        /** Gets the draw calls, in the order to issue them. */
+        const std::vector<DrawCommand>& commands( ) const {
+            return m_commands;
+        }
+        /** Gets the number of draw calls. */
+        size_t size( ) const {
+            return m_commands.size( );
+        }
+        /** Checks whether there is nothing to draw. */
+        bool empty( ) const {
+            return m_commands.empty( );
+        }
+    }; // class DrawList
+
+    /** Textures bound to the texture units during a draw, so textures still
+    *  bound from the previous call are not bound again. Units 0, 1 and 2
+    *  hold the diffuse, normal and light map. */
+    class TextureBindings {
+    public:
+        /** Texture units used. */
+        static const uint NumUnits = 3;
+        /** Unit of the light map, which is unbound when there is none. */
+        static const uint LightMapUnit = 2;
+
+        /** Constructor. No unit is known to hold a texture. */
+        TextureBindings( );
+
+        /** Binds the textures of a draw call. Units whose texture is not set
+        *  or not loaded keep what they hold, except the light map unit,
+        *  which gets texture 0 (black) when no light map is set.
+        *  \param[in]  p_textures   Textures to bind.
+        *  \param[in]  p_getTexture Gets the GL texture of a file id, 0 if it is not loaded.
+        *  \param[in]  p_bind       Binds a GL texture to a unit.
+        *  \param[out] po_stats     Counts the binds. */
+        template <typename GetTexture, typename Bind>
+        void bind( const TextureSet& p_textures, GetTexture p_getTexture, Bind p_bind, DrawStats& po_stats ) {
+            const uint fileIds[NumUnits] = { p_textures.diffuseMap, p_textures.normalMap, p_textures.lightMap };
+            for ( uint unit = 0; unit < NumUnits; unit++ ) {
+                uint textureId = 0;
+                if ( fileIds[unit] ) {
+                    textureId = p_getTexture( fileIds[unit] );
+                    if ( !textureId ) {
+                        continue;
+                    }
+                } else if ( unit != LightMapUnit ) {
+                    continue;
+                }
+
+                if ( m_bound[unit] != textureId ) {
+                    p_bind( unit, textureId );
+                    m_bound[unit] = textureId;
+                    po_stats.textureBinds++;
+                }
+            }
+        }
+
+    private:
+        uint                        m_bound[NumUnits];  // Texture held by each unit
+    }; // class TextureBindings
+
+}; // namespace gw2b
+
+#endif // VIEWERS_MODELVIEWER_DRAWLIST_H_INCLUDED
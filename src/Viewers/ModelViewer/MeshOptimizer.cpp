@@ -0,0 +1,355 @@
+/** \file       Viewers/ModelViewer/MeshOptimizer.cpp
+ *  \brief      Contains the definition of the mesh optimizer.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "MeshOptimizer.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Clusters may cost this much more cache misses to draw outside in. */
+        const double OverdrawThreshold = 1.05;
+
+        /** Simulates the cache on triangles. A vertex stays cached until
+        *  CacheSize other vertices were transformed after it. */
+        VertexCacheStats simulate( const std::vector<Triangle>& p_triangles, uint p_numVertices ) {
+            VertexCacheStats stats;
+            std::vector<uint64> cacheTime( p_numVertices, 0 );
+            std::vector<bool> isUsed( p_numVertices, false );
+            uint64 time = MeshOptimizer::CacheSize + 1;
+
+            for ( auto& triangle : p_triangles ) {
+                stats.numTriangles++;
+                for ( auto index : triangle.indices ) {
+                    if ( index >= p_numVertices ) {
+                        continue;
+                    }
+                    if ( !isUsed[index] ) {
+                        isUsed[index] = true;
+                        stats.numVertices++;
+                    }
+                    if ( time - cacheTime[index] > MeshOptimizer::CacheSize ) {
+                        cacheTime[index] = time++;
+                        stats.numTransforms++;
+                    }
+                }
+            }
+            return stats;
+        }
+
+        /** Checks whether a triangle uses a vertex more than once. */
+        bool isDegenerate( const Triangle& p_triangle ) {
+            return p_triangle.index1 == p_triangle.index2 || p_triangle.index2 == p_triangle.index3 || p_triangle.index1 == p_triangle.index3;
+        }
+
+        /** Orders triangles with Tipsify, fanning around the vertex that is
+        *  still cached and would be evicted first.
+        *  \param[in]  p_triangles  Triangles to order, none degenerate.
+        *  \param[in]  p_numVertices    Amount of vertices.
+        *  \param[out] po_clusters  Receives the first triangle of each cluster,
+        *                           started where no cached vertex was left to fan around.
+        *  \return std::vector<uint>    Triangles in drawing order. */
+        std::vector<uint> tipsify( const std::vector<Triangle>& p_triangles, uint p_numVertices, std::vector<uint>& po_clusters ) {
+            const uint numTriangles = static_cast<uint>( p_triangles.size( ) );
+
+            // Triangles of each vertex, offsets[v] to offsets[v + 1] in adjacency
+            std::vector<uint> offsets( p_numVertices + 1, 0 );
+            for ( auto& triangle : p_triangles ) {
+                for ( auto index : triangle.indices ) {
+                    offsets[index + 1]++;
+                }
+            }
+            for ( uint v = 0; v < p_numVertices; v++ ) {
+                offsets[v + 1] += offsets[v];
+            }
+            std::vector<uint> adjacency( offsets[p_numVertices] );
+            std::vector<uint> fill( offsets.begin( ), offsets.end( ) - 1 );
+            for ( uint t = 0; t < numTriangles; t++ ) {
+                for ( auto index : p_triangles[t].indices ) {
+                    adjacency[fill[index]++] = t;
+                }
+            }
+
+            // Triangles left to draw of each vertex
+            std::vector<uint> live( p_numVertices );
+            for ( uint v = 0; v < p_numVertices; v++ ) {
+                live[v] = offsets[v + 1] - offsets[v];
+            }
+
+            std::vector<uint64> cacheTime( p_numVertices, 0 );
+            std::vector<bool> isEmitted( numTriangles, false );
+            std::vector<uint> deadEnds;
+            std::vector<uint> candidates;
+            std::vector<uint> order;
+            order.reserve( numTriangles );
+            uint64 time = MeshOptimizer::CacheSize + 1;
+            uint cursor = 0;
+
+            // Vertex to carry on from when the cache has nothing to offer:
+            // the last one used that has triangles left, else the next in the buffer
+            auto skipDeadEnd = [&] ( ) -> int {
+                while ( !deadEnds.empty( ) ) {
+                    auto vertex = deadEnds.back( );
+                    deadEnds.pop_back( );
+                    if ( live[vertex] ) {
+                        return static_cast<int>( vertex );
+                    }
+                }
+                for ( ; cursor < p_numVertices; cursor++ ) {
+                    if ( live[cursor] ) {
+                        return static_cast<int>( cursor );
+                    }
+                }
+                return -1;
+            };
+
+            int fanning = skipDeadEnd( );
+            po_clusters.push_back( 0 );
+            while ( fanning >= 0 ) {
+                // Draw all triangles left around the fanning vertex
+                candidates.clear( );
+                for ( uint i = offsets[fanning]; i < offsets[fanning + 1]; i++ ) {
+                    auto t = adjacency[i];
+                    if ( isEmitted[t] ) {
+                        continue;
+                    }
+                    for ( auto index : p_triangles[t].indices ) {
+                        deadEnds.push_back( index );
+                        candidates.push_back( index );
+                        live[index]--;
+                        if ( time - cacheTime[index] > MeshOptimizer::CacheSize ) {
+                            cacheTime[index] = time++;
+                        }
+                    }
+                    isEmitted[t] = true;
+                    order.push_back( t );
+                }
+
+                // Next is the oldest cached vertex that stays cached while
+                // fanning around it
+                int next = -1;
+                int64 best = -1;
+                for ( auto vertex : candidates ) {
+                    if ( !live[vertex] ) {
+                        continue;
+                    }
+                    int64 priority = 0;
+                    auto age = time - cacheTime[vertex];
+                    if ( age + 2 * live[vertex] <= MeshOptimizer::CacheSize ) {
+                        priority = static_cast<int64>( age );
+                    }
+                    if ( priority > best ) {
+                        best = priority;
+                        next = static_cast<int>( vertex );
+                    }
+                }
+                if ( next < 0 ) {
+                    next = skipDeadEnd( );
+                    if ( next >= 0 ) {
+                        po_clusters.push_back( static_cast<uint>( order.size( ) ) );
+                    }
+                }
+                fanning = next;
+            }
+            return order;
+        }
+
+        /** Sorts clusters so the ones facing away from the center of the mesh,
+        *  the outside, are drawn first.
+        *  \param[in]  p_vertices   Vertices of the mesh.
+        *  \param[in]  p_triangles  Triangles of the mesh.
+        *  \param[in]  p_order      Triangles in drawing order.
+        *  \param[in]  p_clusters   First entry in p_order of each cluster.
+        *  \return std::vector<uint>    Triangles in the new drawing order. */
+        std::vector<uint> sortClusters( const std::vector<Vertex>& p_vertices, const std::vector<Triangle>& p_triangles, const std::vector<uint>& p_order, const std::vector<uint>& p_clusters ) {
+            const uint numClusters = static_cast<uint>( p_clusters.size( ) );
+
+            // Area weighted centroid and normal of each cluster
+            std::vector<glm::vec3> centroids( numClusters, glm::vec3( 0.0f ) );
+            std::vector<glm::vec3> normals( numClusters, glm::vec3( 0.0f ) );
+            std::vector<float> areas( numClusters, 0.0f );
+            glm::vec3 meshCentroid( 0.0f );
+            float meshArea = 0.0f;
+
+            for ( uint i = 0; i < numClusters; i++ ) {
+                uint end = ( i + 1 < numClusters ) ? p_clusters[i + 1] : static_cast<uint>( p_order.size( ) );
+                for ( uint t = p_clusters[i]; t < end; t++ ) {
+                    auto& triangle = p_triangles[p_order[t]];
+                    auto& a = p_vertices[triangle.index1].position;
+                    auto& b = p_vertices[triangle.index2].position;
+                    auto& c = p_vertices[triangle.index3].position;
+                    auto normal = glm::cross( b - a, c - a );
+                    auto area = glm::length( normal );
+
+                    centroids[i] += ( a + b + c ) / 3.0f * area;
+                    normals[i] += normal;
+                    areas[i] += area;
+                }
+                meshCentroid += centroids[i];
+                meshArea += areas[i];
+            }
+            if ( !( meshArea > 0.0f ) ) {
+                return p_order;
+            }
+            meshCentroid /= meshArea;
+
+            std::vector<float> keys( numClusters, 0.0f );
+            for ( uint c = 0; c < numClusters; c++ ) {
+                if ( areas[c] > 0.0f ) {
+                    keys[c] = glm::dot( centroids[c] / areas[c] - meshCentroid, glm::normalize( normals[c] ) );
+                }
+            }
+
+            std::vector<uint> clusters( numClusters );
+            for ( uint c = 0; c < numClusters; c++ ) {
+                clusters[c] = c;
+            }
+            std::stable_sort( clusters.begin( ), clusters.end( ), [&] ( uint p_a, uint p_b ) {
+                return keys[p_a] > keys[p_b];
+            } );
+
+            std::vector<uint> order;
+            order.reserve( p_order.size( ) );
+            for ( auto c : clusters ) {
+                uint end = ( c + 1 < numClusters ) ? p_clusters[c + 1] : static_cast<uint>( p_order.size( ) );
+                order.insert( order.end( ), p_order.begin( ) + p_clusters[c], p_order.begin( ) + end );
+            }
+            return order;
+        }
+
+        /** Gathers triangles in an order. */
+        std::vector<Triangle> reorder( const std::vector<Triangle>& p_triangles, const std::vector<uint>& p_order ) {
+            std::vector<Triangle> triangles( p_order.size( ) );
+            for ( size_t i = 0; i < p_order.size( ); i++ ) {
+                triangles[i] = p_triangles[p_order[i]];
+            }
+            return triangles;
+        }
+
+    };
+
+    VertexCacheStats MeshOptimizer::analyze( const GW2Mesh& p_mesh ) {
+        return simulate( p_mesh.triangles, static_cast<uint>( p_mesh.vertices.size( ) ) );
+    }
+
+    void MeshOptimizer::optimize( GW2Mesh& po_mesh ) {
+        const uint numVertices = static_cast<uint>( po_mesh.vertices.size( ) );
+        if ( po_mesh.triangles.empty( ) ) {
+            return;
+        }
+
+        // Degenerate triangles draw nothing, they go last as they are
+        std::vector<Triangle> triangles;
+        std::vector<Triangle> degenerates;
+        triangles.reserve( po_mesh.triangles.size( ) );
+        for ( auto& triangle : po_mesh.triangles ) {
+            for ( auto index : triangle.indices ) {
+                if ( index >= numVertices ) {
+                    return;
+                }
+            }
+            if ( isDegenerate( triangle ) ) {
+                degenerates.push_back( triangle );
+            } else {
+                triangles.push_back( triangle );
+            }
+        }
+
+        // Vertex cache, then overdraw if the cache does not suffer much from it
+        std::vector<uint> clusters;
+        auto order = tipsify( triangles, numVertices, clusters );
+        auto optimized = reorder( triangles, order );
+        auto optimizedMisses = simulate( optimized, numVertices ).numTransforms;
+
+        if ( clusters.size( ) > 1 ) {
+            auto sorted = reorder( triangles, sortClusters( po_mesh.vertices, triangles, order, clusters ) );
+            auto sortedMisses = simulate( sorted, numVertices ).numTransforms;
+            if ( sortedMisses <= optimizedMisses * OverdrawThreshold ) {
+                optimized.swap( sorted );
+                optimizedMisses = sortedMisses;
+            }
+        }
+
+        // Some meshes come already optimized for a different cache, keep those
+        if ( optimizedMisses > simulate( triangles, numVertices ).numTransforms ) {
+            optimized.swap( triangles );
+        }
+        optimized.insert( optimized.end( ), degenerates.begin( ), degenerates.end( ) );
+
+        // Vertices in order of first use, unused ones last
+        std::vector<int> remap( numVertices, -1 );
+        int next = 0;
+        for ( auto& triangle : optimized ) {
+            for ( auto index : triangle.indices ) {
+                if ( remap[index] < 0 ) {
+                    remap[index] = next++;
+                }
+            }
+        }
+        for ( uint v = 0; v < numVertices; v++ ) {
+            if ( remap[v] < 0 ) {
+                remap[v] = next++;
+            }
+        }
+
+        std::vector<Vertex> vertices( numVertices );
+        for ( uint v = 0; v < numVertices; v++ ) {
+            vertices[remap[v]] = po_mesh.vertices[v];
+        }
+        for ( auto& triangle : optimized ) {
+            for ( auto& index : triangle.indices ) {
+                index = static_cast<uint16>( remap[index] );
+            }
+        }
+
+        po_mesh.vertices.swap( vertices );
+        po_mesh.triangles.swap( optimized );
+    }
+
+    void MeshOptimizer::optimize( GW2Mesh* po_meshes, uint p_numMeshes, VertexCacheStats& po_before, VertexCacheStats& po_after ) {
+        const int numMeshes = static_cast<int>( p_numMeshes );
+        std::vector<VertexCacheStats> before( numMeshes );
+        std::vector<VertexCacheStats> after( numMeshes );
+
+#pragma omp parallel for schedule( dynamic )
+        for ( int i = 0; i < numMeshes; i++ ) {
+            before[i] = analyze( po_meshes[i] );
+            optimize( po_meshes[i] );
+            after[i] = analyze( po_meshes[i] );
+        }
+
+        po_before = VertexCacheStats( );
+        po_after = VertexCacheStats( );
+        for ( int i = 0; i < numMeshes; i++ ) {
+            po_before += before[i];
+            po_after += after[i];
+        }
+    }
+
+}; // namespace gw2b
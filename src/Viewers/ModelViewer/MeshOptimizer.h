@@ -0,0 +1,92 @@
+/** \file       Viewers/ModelViewer/MeshOptimizer.h
+ *  \brief      Contains the declaration of the mesh optimizer.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef VIEWERS_MODELVIEWER_MESHOPTIMIZER_H_INCLUDED
+#define VIEWERS_MODELVIEWER_MESHOPTIMIZER_H_INCLUDED
+
+#include "Readers/ModelReader.h"
+
+namespace gw2b {
+
+    /** How well triangles reuse the post-transform vertex cache, as simulated
+    *  by a FIFO cache of MeshOptimizer::CacheSize vertices. */
+    struct VertexCacheStats {
+        uint64 numTriangles = 0;    /**< Triangles drawn. */
+        uint64 numVertices = 0;     /**< Vertices used by the triangles. */
+        uint64 numTransforms = 0;   /**< Vertices transformed, the cache misses. */
+
+        /** Average cache miss ratio, transforms per triangle. 0.5 is the best
+        *  possible, 3 means no reuse at all. */
+        double acmr( ) const {
+            return numTriangles ? static_cast<double>( numTransforms ) / numTriangles : 0.0;
+        }
+        /** Average transform to vertex ratio. 1 is the best possible. */
+        double atvr( ) const {
+            return numVertices ? static_cast<double>( numTransforms ) / numVertices : 0.0;
+        }
+
+        VertexCacheStats& operator+=( const VertexCacheStats& p_other ) {
+            numTriangles += p_other.numTriangles;
+            numVertices += p_other.numVertices;
+            numTransforms += p_other.numTransforms;
+            return *this;
+        }
+    };
+
+    /** Reorders the triangles and vertices of meshes for the GPU, without
+    *  changing what is drawn:
+    *  - Triangles are ordered with Tipsify (Sander et al. 2007) so vertices
+    *    are reused while still in the post-transform cache.
+    *  - The clusters Tipsify leaves are sorted outside in, so front faces
+    *    tend to be drawn first and hide the rest, as long as the cache does
+    *    not suffer for it.
+    *  - Vertices are stored in the order the triangles first use them, so
+    *    vertex fetches read memory in order.
+    *
+    *  All of it runs on the CPU, stats included. */
+    class MeshOptimizer {
+    public:
+        /** Size of the simulated post-transform cache, in vertices. */
+        static const uint CacheSize = 16;
+
+        /** Simulates the post-transform cache on a mesh.
+        *  \param[in]  p_mesh       Mesh to simulate.
+        *  \return VertexCacheStats How well the mesh reuses the cache. */
+        static VertexCacheStats analyze( const GW2Mesh& p_mesh );
+        /** Optimizes a mesh. Meshes with out of range indices are left as they are.
+        *  \param[in,out] po_mesh   Mesh to optimize. */
+        static void optimize( GW2Mesh& po_mesh );
+        /** Optimizes meshes, on all cores.
+        *  \param[in,out] po_meshes Meshes to optimize, such as the ones of GW2Model::editMeshes.
+        *  \param[in]  p_numMeshes  Amount of meshes.
+        *  \param[out] po_before    Receives the stats of all meshes before.
+        *  \param[out] po_after     Receives the stats of all meshes after. */
+        static void optimize( GW2Mesh* po_meshes, uint p_numMeshes, VertexCacheStats& po_before, VertexCacheStats& po_after );
+    }; // class MeshOptimizer
+
+}; // namespace gw2b
+
+#endif // VIEWERS_MODELVIEWER_MESHOPTIMIZER_H_INCLUDED
@@ -27,6 +27,7 @@
 #include "Exception.h"
 
 #include "Model.h"
+#include "Tangents.h"
 
 namespace gw2b {
 
@@ -35,8 +36,9 @@ namespace gw2b {
         , m_numVertices( 0 )
         , m_numTriangles( 0 )
         , m_bounds( p_model.bounds( ) ) {
-        this->loadModel( p_model );
+        // The draw list is sorted by texture set, so materials come first
         this->loadMaterial( p_model );
+        this->loadModel( p_model );
     }
 
     Model::~Model( ) {
@@ -46,48 +48,38 @@ namespace gw2b {
         m_meshCache.clear( );
     }
 
-    void Model::draw( TextureManager& p_textureManager ) {
-        for ( uint i = 0; i < static_cast<uint>( m_numMeshes ); i++ ) {
-            auto materialIndex = m_meshCache[i].materialIndex;
+    void Model::draw( TextureManager& p_textureManager, DrawStats& po_stats ) {
+        if ( m_drawList.empty( ) ) {
+            return;
+        }
 
+        // Textures bound to unit 0, 1 and 2 by this draw
+        TextureBindings bindings;
+        auto getTexture = [&p_textureManager]( uint p_fileId ) -> uint {
+            auto texture = p_textureManager.get( p_fileId );
+            return ( texture != nullptr ) ? texture->getTextureId( ) : 0;
+        };
+        auto bindTexture = []( uint p_unit, uint p_textureId ) {
+            glActiveTexture( GL_TEXTURE0 + p_unit );
+            glBindTexture( GL_TEXTURE_2D, p_textureId );
+        };
+
+        // Bind Vertex Array Object, it holds the Index Buffer Object too
+        m_vertexBuffer->bind( );
+
+        for ( auto& command : m_drawList.commands( ) ) {
             // Texture Maping
             if ( !m_textureList.empty( ) ) {
-
-                if ( materialIndex >= 0 && m_textureList[materialIndex].diffuseMap ) {
-                    auto texture = p_textureManager.get( m_textureList[materialIndex].diffuseMap );
-                    if ( texture != nullptr ) {
-                        // Use Texture Unit 0
-                        glActiveTexture( GL_TEXTURE0 );
-                        texture->bind( );
-                    }
-                }
-
-                if ( materialIndex >= 0 && m_textureList[materialIndex].normalMap ) {
-                    auto texture = p_textureManager.get( m_textureList[materialIndex].normalMap );
-                    if ( texture != nullptr ) {
-                        // Bind our normal texture in Texture Unit 1
-                        glActiveTexture( GL_TEXTURE1 );
-                        texture->bind( );
-                    }
-                }
-
-                if ( materialIndex >= 0 && m_textureList[materialIndex].lightMap ) {
-                    auto texture = p_textureManager.get( m_textureList[materialIndex].lightMap );
-                    if ( texture != nullptr ) {
-                        // Bind our lightmap texture in Texture Unit 2
-                        glActiveTexture( GL_TEXTURE2 );
-                        texture->bind( );
-                    }
-                } else {
-                    glActiveTexture( GL_TEXTURE2 );
-                    // Bind default (black) texture if no lightmap
-                    glBindTexture( GL_TEXTURE_2D, 0 );
-                }
+                bindings.bind( command.textures, getTexture, bindTexture, po_stats );
             }
 
-            // Draw mesh
-            this->drawMesh( i );
+            // Draw all meshes using these textures
+            glDrawElements( GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, ( GLvoid* ) ( command.firstIndex * sizeof( uint ) ) );
+            po_stats.drawCalls++;
         }
+
+        // Unbind Vertex Array Object
+        m_vertexBuffer->unbind( );
     }
 
     size_t Model::getNumMeshes( ) const {
@@ -106,29 +98,14 @@ namespace gw2b {
         return m_bounds;
     }
 
-    void Model::clearBuffer( ) {
-        m_vertexBuffer.clear( );
-        m_indexBuffer.clear( );
+    size_t Model::getNumDrawCalls( ) const {
+        return m_drawList.size( );
     }
 
-    void Model::drawMesh( const uint p_meshIndex ) {
-        auto& vbo = m_vertexBuffer[p_meshIndex];
-        auto& cache = m_meshCache[p_meshIndex];
-        auto& index = m_indexBuffer[p_meshIndex];
-
-        // Bind Vertex Array Object
-        vbo->bind( );
-        vbo->setVertexAttribPointer( );
-        // Bind Index Buffer Object
-        index->bind( );
-
-        // Draw the triangles!
-        glDrawElements( GL_TRIANGLES, cache.indices.size( ), GL_UNSIGNED_INT, ( GLvoid* ) 0 );
-
-        // Unbind Index Buffer Object
-        index->unbind( );
-        // Unbind Vertex Array Object
-        vbo->unbind( );
+    void Model::clearBuffer( ) {
+        m_vertexBuffer.reset( );
+        m_indexBuffer.reset( );
+        m_drawList.clear( );
     }
 
     void Model::loadModel( const GW2Model& p_model ) {
@@ -137,143 +114,117 @@ namespace gw2b {
         // Create mesh cache
         m_meshCache.resize( m_numMeshes );
 
-        // Load mesh to mesh cache
-#pragma omp parallel for
+        // Load mesh to mesh cache, counting into per-thread sums
+        size_t numVertices = 0;
+        size_t numTriangles = 0;
+#pragma omp parallel for reduction( +:numVertices, numTriangles )
         for ( int i = 0; i < static_cast<int>( m_numMeshes ); i++ ) {
             auto& mesh = p_model.mesh( i );
             auto& cache = m_meshCache[i];
 
-            m_numVertices += mesh.vertices.size( );
-            m_numTriangles += mesh.triangles.size( );
+            numVertices += mesh.vertices.size( );
+            numTriangles += mesh.triangles.size( );
 
             cache.materialIndex = mesh.materialIndex;
 
             this->loadMesh( cache, mesh );
         }
+        m_numVertices += numVertices;
+        m_numTriangles += numTriangles;
 
         // Populate Buffer Object
-        for ( uint i = 0; i < m_meshCache.size( ); i++ ) {
-            auto& cache = m_meshCache[i];
-
-            m_vertexBuffer.push_back( VBO( new VertexBuffer( cache.vertices, cache.normals, cache.uvs, cache.tangents ) ) );
-            m_indexBuffer.push_back( IBO( new IndexBuffer( cache.indices ) ) );
-        }
+        this->buildDrawList( );
 
+        // Everything is on the GPU now
+        m_meshCache.clear( );
     }
 
-    void Model::loadMesh( MeshCache& p_cache, const GW2Mesh& p_mesh ) {
-        // Tempoarary buffers
-        MeshCache temp;
+    void Model::buildDrawList( ) {
+        // Order the meshes by texture set, so each set is bound and drawn once
+        std::vector<TextureSet> meshTextures;
+        meshTextures.reserve( m_meshCache.size( ) );
+        for ( auto& cache : m_meshCache ) {
+            meshTextures.push_back( this->textureSet( cache.materialIndex ) );
+        }
+        auto order = DrawList::packingOrder( meshTextures );
 
-        // Read faces
-        for ( auto& it : p_mesh.triangles ) {
-            temp.indices.push_back( it.index1 );
-            temp.indices.push_back( it.index2 );
-            temp.indices.push_back( it.index3 );
+        size_t numVertices = 0;
+        size_t numIndices = 0;
+        for ( auto& cache : m_meshCache ) {
+            numVertices += cache.vertices.size( );
+            numIndices += cache.indices.size( );
         }
 
-        // For each vertex of each triangle
-        for ( auto& it : temp.indices ) {
-            auto& vertex = p_mesh.vertices[it].position;
-            temp.vertices.push_back( vertex );
+        std::vector<InterleavedVertex> vertices;
+        std::vector<uint> indices;
+        vertices.reserve( numVertices );
+        indices.reserve( numIndices );
+        m_drawList.clear( );
 
-            if ( p_mesh.hasNormal ) {
-                auto& normal = p_mesh.vertices[it].normal;
-                temp.normals.push_back( normal );
+        for ( auto meshIndex : order ) {
+            auto& cache = m_meshCache[meshIndex];
+            if ( cache.indices.empty( ) ) {
+                continue;
             }
 
-            if ( p_mesh.hasUV ) {
-                auto& uv = p_mesh.vertices[it].uv;
-                temp.uvs.push_back( uv );
-            } else {
-                temp.uvs.push_back( glm::vec2( 0.0f, 0.0f ) );
+            // Indices point into the whole buffer, so meshes next to each
+            // other can be drawn as one
+            auto baseVertex = static_cast<uint>( vertices.size( ) );
+
+            for ( size_t i = 0; i < cache.vertices.size( ); i++ ) {
+                InterleavedVertex vertex = { cache.vertices[i], cache.normals[i], cache.uvs[i], cache.tangents[i] };
+                vertices.push_back( vertex );
+            }
+            for ( auto index : cache.indices ) {
+                indices.push_back( baseVertex + index );
             }
+
+            m_drawList.add( meshTextures[meshIndex], static_cast<uint>( cache.indices.size( ) ) );
         }
 
-        this->computeTangent( temp );
-        this->indexVBO( temp, p_cache );
+        m_vertexBuffer = VBO( new VertexBuffer( vertices ) );
+        m_indexBuffer = IBO( new IndexBuffer( std::move( indices ) ) );
+
+        // Let the Vertex Array Object keep the Index Buffer Object
+        m_vertexBuffer->bind( );
+        m_indexBuffer->bind( );
+        m_vertexBuffer->unbind( );
     }
 
-    void Model::computeTangent( MeshCache& p_mesh ) {
-        for ( uint i = 0; i < p_mesh.vertices.size( ); i += 3 ) {
-            // Shortcuts for vertices
-            glm::vec3& v0 = p_mesh.vertices[i + 0];
-            glm::vec3& v1 = p_mesh.vertices[i + 1];
-            glm::vec3& v2 = p_mesh.vertices[i + 2];
-
-            // Shortcuts for UVs
-            glm::vec2& uv0 = p_mesh.uvs[i + 0];
-            glm::vec2& uv1 = p_mesh.uvs[i + 1];
-            glm::vec2& uv2 = p_mesh.uvs[i + 2];
-
-            // Edges of the triangle : postion delta
-            glm::vec3 deltaPos1 = v1 - v0;
-            glm::vec3 deltaPos2 = v2 - v0;
-
-            // UV delta
-            glm::vec2 deltaUV1 = uv1 - uv0;
-            glm::vec2 deltaUV2 = uv2 - uv0;
-
-            GLfloat f = 1.0f / ( deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y );
-
-            glm::vec3 tangent;
-            tangent.x = f * ( deltaUV2.y * deltaPos1.x - deltaUV1.y * deltaPos2.x );
-            tangent.y = f * ( deltaUV2.y * deltaPos1.y - deltaUV1.y * deltaPos2.y );
-            tangent.z = f * ( deltaUV2.y * deltaPos1.z - deltaUV1.y * deltaPos2.z );
-            tangent = glm::normalize( tangent );
-
-            // Set the same tangent for all three vertices of the triangle.
-            // They will be merged later in VBO indexer.
-            p_mesh.tangents.push_back( tangent );
-            p_mesh.tangents.push_back( tangent );
-            p_mesh.tangents.push_back( tangent );
+    TextureSet Model::textureSet( int p_materialIndex ) const {
+        if ( p_materialIndex < 0 || static_cast<size_t>( p_materialIndex ) >= m_textureList.size( ) ) {
+            TextureSet none = { 0, 0, 0 };
+            return none;
         }
+        return m_textureList[p_materialIndex];
     }
 
-    bool Model::getSimilarVertexIndex( PackedVertex& p_packed, std::map<PackedVertex, uint>& p_vertexToOutIndex, uint& p_result ) {
-        auto it = p_vertexToOutIndex.find( p_packed );
-        if ( it == p_vertexToOutIndex.end( ) ) {
-            return false;
-        } else {
-            p_result = it->second;
-            return true;
+    void Model::loadMesh( MeshCache& p_cache, const GW2Mesh& p_mesh ) {
+        auto numVertices = p_mesh.vertices.size( );
+
+        // The mesh is already indexed, so vertices and indices are used as they are
+        p_cache.vertices.resize( numVertices );
+        p_cache.normals.resize( numVertices );
+        p_cache.uvs.resize( numVertices );
+        for ( size_t i = 0; i < numVertices; i++ ) {
+            auto& vertex = p_mesh.vertices[i];
+            p_cache.vertices[i] = vertex.position;
+            p_cache.normals[i] = p_mesh.hasNormal ? vertex.normal : glm::vec3( 0.0f, 0.0f, 0.0f );
+            p_cache.uvs[i] = p_mesh.hasUV ? vertex.uv : glm::vec2( 0.0f, 0.0f );
         }
-    }
 
-    void Model::indexVBO( const MeshCache& p_inMesh, MeshCache& p_outMesh ) {
-        std::map<PackedVertex, uint> VertexToOutIndex;
-
-        // For each input vertex
-        for ( uint i = 0; i < p_inMesh.vertices.size( ); i++ ) {
-            glm::vec3 vertices;
-            glm::vec3 normals;
-            glm::vec2 uvs;
-
-            vertices = p_inMesh.vertices[i];
-            normals = p_inMesh.normals[i];
-            uvs = p_inMesh.uvs[i];
-
-            PackedVertex packed = { vertices, normals, uvs };
-
-            // Try to find a similar vertex in p_outMesh
-            uint index;
-            bool found = getSimilarVertexIndex( packed, VertexToOutIndex, index );
-            if ( found ) { // A similar vertex is already in the VBO, use it instead !
-                p_outMesh.indices.push_back( index );
-
-                // Average the tangents
-                p_outMesh.tangents[index] += p_inMesh.tangents[i];
-            } else { // If not, it needs to be added in the output data.
-                p_outMesh.vertices.push_back( p_inMesh.vertices[i] );
-                p_outMesh.normals.push_back( p_inMesh.normals[i] );
-                p_outMesh.uvs.push_back( p_inMesh.uvs[i] );
-                p_outMesh.tangents.push_back( p_inMesh.tangents[i] );
-
-                uint newindex = ( uint ) p_outMesh.vertices.size( ) - 1;
-                p_outMesh.indices.push_back( newindex );
-                VertexToOutIndex[packed] = newindex;
+        // Read faces
+        p_cache.indices.reserve( p_mesh.triangles.size( ) * 3 );
+        for ( auto& it : p_mesh.triangles ) {
+            if ( ( it.index1 >= numVertices ) || ( it.index2 >= numVertices ) || ( it.index3 >= numVertices ) ) {
+                continue;
             }
+            p_cache.indices.push_back( it.index1 );
+            p_cache.indices.push_back( it.index2 );
+            p_cache.indices.push_back( it.index3 );
         }
+
+        computeTangents( p_cache.vertices, p_cache.normals, p_cache.uvs, p_cache.indices, p_cache.tangents );
     }
 
     void Model::loadMaterial( const GW2Model& p_model ) {
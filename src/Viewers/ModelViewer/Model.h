@@ -27,9 +27,9 @@
 #ifndef VIEWERS_MODELVIEWER_MODEL_H_INCLUDED
 #define VIEWERS_MODELVIEWER_MODEL_H_INCLUDED
 
-#include <map>
 #include <vector>
 
+#include "DrawList.h"
 #include "IndexBuffer.h"
 #include "VertexBuffer.h"
 #include "TextureManager.h"
@@ -50,29 +50,14 @@ namespace gw2b {
             int                     materialIndex;
         };
 
-        struct TextureList {
-            uint                    diffuseMap;
-            uint                    normalMap;
-            uint                    lightMap;
-        };
-
-        struct PackedVertex {
-            glm::vec3 position;
-            glm::vec3 normal;
-            glm::vec2 uv;
-
-            bool operator < ( const PackedVertex& that ) const {
-                return memcmp( ( void* )this, ( void* ) &that, sizeof( PackedVertex ) ) > 0;
-            };
-        };
-
         // Mesh
         std::vector<MeshCache>      m_meshCache;
-        std::vector<VBO>            m_vertexBuffer;     // Vertex Buffer Object
-        std::vector<IBO>            m_indexBuffer;      // Index Buffer Object
+        VBO                         m_vertexBuffer;     // Vertex Buffer Object, all meshes interleaved
+        IBO                         m_indexBuffer;      // Index Buffer Object, all meshes in draw list order
+        DrawList                    m_drawList;         // Sorted by texture set
 
         // Textures
-        std::vector<TextureList>    m_textureList;      // Texture List, store texture list from material of GW2Model
+        std::vector<TextureSet>     m_textureList;      // Texture List, store texture list from material of GW2Model
 
         size_t                      m_numMeshes;
         size_t                      m_numVertices;
@@ -85,8 +70,10 @@ namespace gw2b {
         /** Destructor. Clears all data. */
         ~Model( );
 
-        /** Draw the model. */
-        void draw( TextureManager& p_textureManager );
+        /** Draw the model, binding only the textures that change between draws.
+        *  \param[in]  p_textureManager   Textures of the materials.
+        *  \param[out] po_stats    Receives the GL calls issued. */
+        void draw( TextureManager& p_textureManager, DrawStats& po_stats );
         /** Get number of mesh. */
         size_t getNumMeshes( ) const;
         /** Get number of vertices. */
@@ -95,15 +82,19 @@ namespace gw2b {
         size_t getTriSize( ) const;
         /** Get model bounds. */
         Bounds getBounds( ) const;
+        /** Get number of draw calls per draw of the model. */
+        size_t getNumDrawCalls( ) const;
 
     private:
         void clearBuffer( );
-        void drawMesh( const uint p_meshIndex );
         void loadModel( const GW2Model& p_model );
+        /** Packs all meshes into one vertex buffer and one index buffer, and
+        *  builds the draw list. Meshes with the same texture set are placed
+        *  next to each other and drawn with a single call. */
+        void buildDrawList( );
+        /** Gets the texture set of a material, the one of no material if none. */
+        TextureSet textureSet( int p_materialIndex ) const;
         void loadMesh( MeshCache& p_cache, const GW2Mesh& p_mesh );
-        void computeTangent( MeshCache& p_mesh );
-        bool getSimilarVertexIndex( PackedVertex& p_packed, std::map<PackedVertex, uint>& p_vertexToOutIndex, uint& p_result );
-        void indexVBO( const MeshCache& p_inMesh, MeshCache& p_outMesh );
         void loadMaterial( const GW2Model& p_model );
 
     }; // class Model
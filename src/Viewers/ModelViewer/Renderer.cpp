@@ -48,6 +48,9 @@ namespace gw2b {
         if( m_IsModelLoaded ) {
             m_model.clear();
             m_texture.clear();
+            m_cacheBefore = VertexCacheStats( );
+            m_cacheAfter = VertexCacheStats( );
+            m_drawStats = DrawStats( );
             m_IsModelLoaded = false;
         }
     }
@@ -67,7 +70,7 @@ namespace gw2b {
         try {
             m_text = std::unique_ptr<Text2D>( new Text2D( ) );
         } catch ( const exception::Exception& err ) {
-            wxLogMessage( wxT( "m_text : %s" ), wxString( err.what( ) ) );
+            LogError( wxT( "m_text : %s" ), wxString( err.what( ) ) );
             throw exception::Exception( "Failed to initialize text renderer." );
         }
 
@@ -75,7 +78,7 @@ namespace gw2b {
         try {
             m_lightBox = std::unique_ptr<LightBox>( new LightBox( ) );
         } catch ( const exception::Exception& err ) {
-            wxLogMessage( wxT( "m_lightBox : %s" ), wxString( err.what( ) ) );
+            LogError( wxT( "m_lightBox : %s" ), wxString( err.what( ) ) );
             throw exception::Exception( "Failed to initialize lightbox renderer." );
         }
 
@@ -167,7 +170,7 @@ namespace gw2b {
         this->clearShader( );
         if ( !this->loadShader( ) ) {
             this->clearShader( );
-            wxLogMessage( wxT( "SHADER ERROR!!! FIX IT AND PRESS = KEY TO RELOAD SHADER!" ) );
+            LogError( wxT( "SHADER ERROR!!! FIX IT AND PRESS = KEY TO RELOAD SHADER!" ) );
         }
     }
 
@@ -192,11 +195,44 @@ namespace gw2b {
     void Renderer::loadModel(DatFile& p_datFile, const GW2Model& p_model) {
         auto& material = p_model.material( );
 
+        // Reorder the meshes for the vertex cache, on a copy of the model
+        GW2Model model = p_model;
+        VertexCacheStats before;
+        VertexCacheStats after;
+        if ( m_statusOptimizeMeshes ) {
+            MeshOptimizer::optimize( model.editMeshes( ), model.numMeshes( ), before, after );
+            LogInfo( wxT( "Vertex cache ACMR %.3f -> %.3f, ATVR %.3f -> %.3f." ), before.acmr( ), after.acmr( ), before.atvr( ), after.atvr( ) );
+        } else {
+            for ( auto& mesh : model.mesh( ) ) {
+                before += MeshOptimizer::analyze( mesh );
+            }
+            after = before;
+        }
+        m_cacheBefore += before;
+        m_cacheAfter += after;
+
         // load model to m_model
-        m_model.push_back( std::unique_ptr<Model>( new Model( p_model ) ) );
+        m_model.push_back( std::unique_ptr<Model>( new Model( model ) ) );
+        LogInfo( wxT( "%u meshes drawn with %u draw calls." ), static_cast<uint>( m_model.back( )->getNumMeshes( ) ), static_cast<uint>( m_model.back( )->getNumDrawCalls( ) ) );
+
+        m_lodLevel = p_model.lodLevel( );
+        m_numLodLevels = p_model.numLodLevels( );
+
+        // Only the materials of the loaded meshes need textures, the other
+        // levels of detail use their own
+        std::vector<bool> isMaterialUsed( material.size( ), false );
+        for ( auto& mesh : p_model.mesh( ) ) {
+            if ( mesh.materialIndex >= 0 && static_cast<size_t>( mesh.materialIndex ) < material.size( ) ) {
+                isMaterialUsed[mesh.materialIndex] = true;
+            }
+        }
 
         // load texture into texture manager
-        for ( auto& mat : material ) {
+        for ( size_t i = 0; i < material.size( ); i++ ) {
+            if ( !isMaterialUsed[i] ) {
+                continue;
+            }
+            auto& mat = material[i];
             // Load diffuse texture
             if ( mat.diffuseMap ) {
                 m_texture.load( p_datFile, mat.diffuseMap );
@@ -268,6 +304,7 @@ namespace gw2b {
         // Model scale
         //trans = glm::scale( trans, glm::vec3( 0.5f ) );
 
+        m_drawStats = DrawStats( );
         if ( !m_statusVisualizeZbuffer ) {
             // Draw normally
             this->drawModel( m_shaders.get( "main" ), trans );
@@ -352,7 +389,7 @@ namespace gw2b {
             // View matrix
             p_shader->setMat4( "view", m_camera.calculateViewMatrix( ) );
 
-            it->draw( m_texture );
+            it->draw( m_texture, m_drawStats );
         }
 
         if ( m_statusWireframe ) {
@@ -381,6 +418,9 @@ namespace gw2b {
         m_text->drawText( wxString::Format( wxT( "Meshes: %d" ), numMeshes ), 0.0f, m_clientSize.y - 12.0f, scale, color );
         m_text->drawText( wxString::Format( wxT( "Vertices: %d" ), vertexCount ), 0.0f, m_clientSize.y - 24.0f, scale, color );
         m_text->drawText( wxString::Format( wxT( "Triangles: %d" ), triangleCount ), 0.0f, m_clientSize.y - 36.0f, scale, color );
+        m_text->drawText( wxString::Format( wxT( "ACMR: %.2f (%.2f as read), ATVR: %.2f (%.2f as read)" ), m_cacheAfter.acmr( ), m_cacheBefore.acmr( ), m_cacheAfter.atvr( ), m_cacheBefore.atvr( ) ), 0.0f, m_clientSize.y - 60.0f, scale, color );
+        m_text->drawText( wxString::Format( wxT( "Level of detail: %u of %u (press 9 for next)" ), m_lodLevel + 1, m_numLodLevels ), 0.0f, m_clientSize.y - 72.0f, scale, color );
+        m_text->drawText( wxString::Format( wxT( "Draw calls: %u, texture binds: %u" ), m_drawStats.drawCalls, m_drawStats.textureBinds ), 0.0f, m_clientSize.y - 84.0f, scale, color );
 
         // Bottom-left text
         m_text->drawText( wxT( "Zoom: Scroll wheel" ), 0.0f, 0.0f + 2.0f, scale, color );
@@ -394,11 +434,18 @@ namespace gw2b {
         m_text->drawText( wxT( "Toggle back-face culling: press 3" ), 25.0f, 96.0f + 2.0f, scale, color );
         m_text->drawText( wxT( "Toggle wireframe: press 2" ), 25.0f, 108.0f + 2.0f, scale, color );
         m_text->drawText( wxT( "Toggle status text: press 1" ), 25.0f, 120.0f + 2.0f, scale, color );
+        m_text->drawText( wxT( "Optimize meshes on load: press 8" ), 25.0f, 132.0f + 2.0f, scale, color );
 
         // Status text
         auto gray = glm::vec3( 0.5f, 0.5f, 0.5f );
         auto green = glm::vec3( 0.0f, 1.0f, 0.0f );
 
+        if ( m_statusOptimizeMeshes ) {
+            m_text->drawText( wxT( "ON" ), 0.0f, 132.0f + 2.0f, scale, green );
+        } else {
+            m_text->drawText( wxT( "OFF" ), 0.0f, 132.0f + 2.0f, scale, gray );
+        }
+
         if ( m_statusAntiAlising ) {
             m_text->drawText( wxT( "ON" ), 0.0f, 48.0f + 2.0f, scale, green );
         } else {
@@ -34,6 +34,7 @@
 #include "Viewers/ModelViewer/FrameBuffer.h"
 #include "Viewers/ModelViewer/Light.h"
 #include "Viewers/ModelViewer/LightBox.h"
+#include "Viewers/ModelViewer/MeshOptimizer.h"
 #include "Viewers/ModelViewer/Model.h"
 #include "Viewers/ModelViewer/ShaderManager.h"
 #include "Viewers/ModelViewer/Text2D.h"
@@ -54,6 +55,7 @@ namespace gw2b {
         bool                        m_statusNormalMapping = true;       // Toggle normal maping
         bool                        m_statusLighting = true;            // Toggle lighting
         bool                        m_statusAntiAlising = true;         // Toggle anti alising
+        bool                        m_statusOptimizeMeshes = true;      // Toggle mesh optimization of models loaded from now on
         bool                        m_statusRenderLightSource = false;  // Toggle visualization of light source
         bool                        m_statusVisualizeNormal = false;    // Toggle visualization of normal
         bool                        m_statusVisualizeZbuffer = false;   // Toggle visualization of z-buffer
@@ -63,6 +65,11 @@ namespace gw2b {
 
         std::unique_ptr<FrameBuffer> m_framebuffer;
         std::vector<std::unique_ptr<Model>> m_model;
+        VertexCacheStats            m_cacheBefore;      // Vertex cache stats of the loaded models, as read
+        VertexCacheStats            m_cacheAfter;       // Vertex cache stats of the loaded models, as drawn
+        uint                        m_lodLevel = 0;     // Level of detail of the last loaded model
+        uint                        m_numLodLevels = 1; // Levels of detail of the last loaded model
+        DrawStats                   m_drawStats;        // GL calls issued to draw the models in the last frame
         TextureManager              m_texture;
         Light                       m_light;
         std::unique_ptr<LightBox>   m_lightBox;         // For render cube at light position
@@ -126,6 +133,7 @@ namespace gw2b {
         void toggleStatusLighting() { m_statusLighting = !m_statusLighting; }
         void toggleStatusNormalMapping() { m_statusNormalMapping = !m_statusNormalMapping; }
         void toggleStatusAntiAlising() { m_statusAntiAlising = !m_statusAntiAlising; }
+        void toggleStatusOptimizeMeshes() { m_statusOptimizeMeshes = !m_statusOptimizeMeshes; }
         void toggleStatusVisualizeNormal() { m_statusVisualizeNormal = !m_statusVisualizeNormal; }
         void toggleStatusVisualizeZbuffer() {  m_statusVisualizeZbuffer = !m_statusVisualizeZbuffer; }
         void toggleStatusRenderLightSource() { m_statusRenderLightSource = !m_statusRenderLightSource; }
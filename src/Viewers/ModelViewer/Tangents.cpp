@@ -0,0 +1,89 @@
+/** \file       Viewers/ModelViewer/Tangents.cpp
+ *  \brief      Tangents of indexed meshes, for normal mapping.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cmath>
+
+#include "Tangents.h"
+
+namespace gw2b {
+
+    void computeTangents( const std::vector<glm::vec3>& p_positions, const std::vector<glm::vec3>& p_normals,
+        const std::vector<glm::vec2>& p_uvs, const std::vector<uint>& p_indices, std::vector<glm::vec3>& po_tangents ) {
+        po_tangents.assign( p_positions.size( ), glm::vec3( 0.0f, 0.0f, 0.0f ) );
+
+        for ( size_t i = 0; i + 2 < p_indices.size( ); i += 3 ) {
+            auto i0 = p_indices[i + 0];
+            auto i1 = p_indices[i + 1];
+            auto i2 = p_indices[i + 2];
+
+            // Edges of the triangle : postion delta
+            glm::vec3 deltaPos1 = p_positions[i1] - p_positions[i0];
+            glm::vec3 deltaPos2 = p_positions[i2] - p_positions[i0];
+
+            // UV delta
+            glm::vec2 deltaUV1 = p_uvs[i1] - p_uvs[i0];
+            glm::vec2 deltaUV2 = p_uvs[i2] - p_uvs[i0];
+
+            // Triangles without UV area have no tangent to give
+            float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+            if ( std::abs( determinant ) < 1e-12f ) {
+                continue;
+            }
+            float f = 1.0f / determinant;
+
+            glm::vec3 tangent;
+            tangent.x = f * ( deltaUV2.y * deltaPos1.x - deltaUV1.y * deltaPos2.x );
+            tangent.y = f * ( deltaUV2.y * deltaPos1.y - deltaUV1.y * deltaPos2.y );
+            tangent.z = f * ( deltaUV2.y * deltaPos1.z - deltaUV1.y * deltaPos2.z );
+
+            float length = glm::length( tangent );
+            if ( !( length > 0.0f ) ) {
+                continue;
+            }
+            tangent /= length;
+
+            // Each triangle adds its tangent to its three vertices
+            po_tangents[i0] += tangent;
+            po_tangents[i1] += tangent;
+            po_tangents[i2] += tangent;
+        }
+
+        for ( size_t i = 0; i < po_tangents.size( ); i++ ) {
+            auto& tangent = po_tangents[i];
+            float length = glm::length( tangent );
+            if ( length > 0.0f ) {
+                tangent /= length;
+                continue;
+            }
+
+            // No tangent from the triangles, take any direction across the normal
+            auto& normal = p_normals[i];
+            tangent = ( std::abs( normal.x ) < 0.9f ) ? glm::vec3( 1.0f, 0.0f, 0.0f ) : glm::vec3( 0.0f, 1.0f, 0.0f );
+            tangent = glm::normalize( tangent - normal * glm::dot( normal, tangent ) );
+        }
+    }
+
+}; // namespace gw2b
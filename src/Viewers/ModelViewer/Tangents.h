@@ -0,0 +1,48 @@
+/** \file       Viewers/ModelViewer/Tangents.h
+ *  \brief      Tangents of indexed meshes, for normal mapping.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef VIEWERS_MODELVIEWER_TANGENTS_H_INCLUDED
+#define VIEWERS_MODELVIEWER_TANGENTS_H_INCLUDED
+
+#include <vector>
+
+namespace gw2b {
+
+    /** Computes the tangent of each vertex of an indexed mesh, as the
+    *  normalized sum of the tangents of the triangles using it. Triangles
+    *  without UV area are skipped, and vertices left without a tangent get
+    *  any direction perpendicular to their normal. Needs no GL context.
+    *  \param[in]  p_positions  Positions of the vertices.
+    *  \param[in]  p_normals    Normals of the vertices, same count as p_positions.
+    *  \param[in]  p_uvs        UVs of the vertices, same count as p_positions.
+    *  \param[in]  p_indices    Triangle list, all indices in range.
+    *  \param[out] po_tangents  Receives one unit tangent per vertex. */
+    void computeTangents( const std::vector<glm::vec3>& p_positions, const std::vector<glm::vec3>& p_normals,
+        const std::vector<glm::vec2>& p_uvs, const std::vector<uint>& p_indices, std::vector<glm::vec3>& po_tangents );
+
+}; // namespace gw2b
+
+#endif // VIEWERS_MODELVIEWER_TANGENTS_H_INCLUDED
@@ -45,7 +45,7 @@ namespace gw2b {
         // Convert to image
         ANetFileType fileType;
         p_datFile.identifyFileType( fileData.GetPointer( ), fileData.GetSize( ), fileType );
-        auto reader = FileReader::readerForData( fileData, p_datFile, fileType );
+        auto reader = FileReader::readerForData( fileData, p_datFile, fileType, entryNumber );
 
         // Bail if not an image
         auto imgReader = dynamic_cast<ImageReader*>( reader );
@@ -63,62 +63,48 @@ namespace gw2b {
         // Set texture filtering
         this->setFiltering( p_anisotropic );
 
-        auto atex = reinterpret_cast<const ANetAtexHeader*>( fileData.GetPointer( ) );
-        if ( ( fileType == ANFT_ATEX ) && ( atex->formatInteger == FCC_DXT5 ) ) {
-            auto textureData = imgReader->getDecompressedATEX( );
-            if ( textureData.GetSize( ) == 0 ) {
-                deletePointer( reader );
-                throw exception::Exception( "Failed to get decompressed ATEX texture from ImageReader." );
+        // Upload block compressed textures as they are when they store their
+        // mip levels and the GPU can decode them. GL can't generate the levels
+        // of compressed textures, so the others, ATEX included, are decoded
+        // and get generated levels
+        auto blockFormat = imgReader->getBlockFormat( );
+        auto compressedFormat = ( imgReader->getNumLevels( ) > 1 ) ? this->compressedFormat( blockFormat ) : 0;
+        wxSize blocksSize;
+        Array<byte> blocks;
+        uint numLevels = 0;
+        if ( compressedFormat && imgReader->getBlocks( blockFormat, blocksSize, blocks, &numLevels ) && numLevels > 1 ) {
+            auto levelBlocks = blocks.GetPointer( );
+            wxSize levelSize = blocksSize;
+            for ( uint level = 0; level < numLevels; level++ ) {
+                auto dataSize = ImageReader::blockDataSize( blockFormat, levelSize );
+                glCompressedTexImage2D( m_textureType, level, compressedFormat, levelSize.x, levelSize.y, 0, dataSize, levelBlocks );
+                levelBlocks += dataSize;
+                levelSize.Set( wxMax( 1, levelSize.x >> 1 ), wxMax( 1, levelSize.y >> 1 ) );
             }
-
-            int width = atex->width;
-            int height = atex->height;
-
-            // Upload compressed texture to OpenGL
-            glCompressedTexImage2D( m_textureType, 0, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, width, height, 0, textureData.GetSize( ), textureData.GetPointer( ) );
-
+            glTexParameteri( m_textureType, GL_TEXTURE_MAX_LEVEL, numLevels - 1 );
         } else {
-            // Get image in wxImage
-            auto imageData = imgReader->getImage( );
-            if ( !imageData.IsOk( ) ) {
+            wxSize size;
+            bool hasAlpha;
+            if ( !imgReader->getImageInfo( size, hasAlpha ) ) {
                 deletePointer( reader );
-                throw exception::Exception( "Failed to get image in wxImage." );
+                throw exception::Exception( "Failed to get image size." );
             }
 
-            int imageWidth = imageData.GetWidth( );
-            int imageHeight = imageData.GetHeight( );
-
-            // Get color data
-            GLubyte* bitmapData = imageData.GetData( );
-
-            if ( imageData.HasAlpha( ) ) {
-                // wxImage store seperate alpha channel if present
-                GLubyte* alphaData = imageData.GetAlpha( );
-
-                int bytesPerPixel = 4;
-                int imageSize = imageWidth * imageHeight * bytesPerPixel;
-                Array<GLubyte> image( imageSize );
+            // Decode straight into the RGBA buffer to upload
+            Array<GLubyte> image( static_cast<size_t>( size.x ) * size.y * 4 );
+            if ( !imgReader->getPixels( ImageReader::PF_RGBA8, image.GetPointer( ), size.x * 4 ) ) {
+                deletePointer( reader );
+                throw exception::Exception( "Failed to decode image." );
+            }
 
-                // Merge wxImage alpha channel to RGBA
-#pragma omp parallel for
-                for ( int y = 0; y < imageHeight; y++ ) {
-                    for ( int x = 0; x < imageWidth; x++ ) {
-                        ::memcpy( &image[( x + y * imageWidth ) * bytesPerPixel], &bitmapData[( x + y * imageWidth ) * 3], 3 );
-                        image[( x + y * imageWidth ) * bytesPerPixel + 3] = alphaData[x + y * imageWidth];
-                    }
-                }
-                glTexImage2D( m_textureType, 0, GL_RGBA8, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.GetPointer( ) );
+            glTexImage2D( m_textureType, 0, hasAlpha ? GL_RGBA8 : GL_RGB8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.GetPointer( ) );
 
-            } else {
-                glTexImage2D( m_textureType, 0, GL_RGB8, imageWidth, imageHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, bitmapData );
-            }
+            // Generate Mipmaps
+            glGenerateMipmap( m_textureType );
         }
 
         deletePointer( reader );
 
-        // Generate Mipmaps
-        glGenerateMipmap( m_textureType );
-
         this->unbind( );
     }
 
@@ -153,6 +139,24 @@ namespace gw2b {
         glTexParameteri( m_textureType, GL_TEXTURE_WRAP_T, p_wrapT );
     }
 
+    GLenum Texture2D::compressedFormat( const ImageReader::BlockFormat p_format ) const {
+        bool hasS3TC = !!GLEW_EXT_texture_compression_s3tc;
+
+        switch ( p_format ) {
+        case ImageReader::BF_BC1:
+            return hasS3TC ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : 0;
+        case ImageReader::BF_BC2:
+            return hasS3TC ? GL_COMPRESSED_RGBA_S3TC_DXT3_EXT : 0;
+        case ImageReader::BF_BC3:
+            return hasS3TC ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+        default:
+            // Only DDS files store mip levels, and their blocks are DXT1/3/5.
+            // 3DCX normals also need their blue computed and green inverted,
+            // which only decoding does
+            return 0;
+        }
+    }
+
     void Texture2D::setFiltering( const bool p_anisotropic ) {
         // Trilinear texture filtering
         glTexParameteri( m_textureType, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
@@ -28,6 +28,7 @@
 #define VIEWERS_MODELVIEWER_TEXTURE2D_H_INCLUDED
 
 #include "DatFile.h"
+#include "Readers/ImageReader.h"
 
 namespace gw2b {
 
@@ -74,6 +75,10 @@ namespace gw2b {
         /** Set texture filtering.
         *  \param[in]  p_anisotropic   Anisotropic texture filtering? */
         void setFiltering( const bool p_anisotropic );
+        /** Get the OpenGL format to upload blocks of the given format with.
+        *  \param[in]  p_format     Format of the blocks.
+        *  \return GLenum          Compressed texture format, 0 if the GPU can't use the blocks. */
+        GLenum compressedFormat( const ImageReader::BlockFormat p_format ) const;
 
     }; // class Texture2D
 
@@ -53,12 +53,12 @@ namespace gw2b {
             try {
                 m_texture.insert( std::pair<uint32, Texture2D*>( p_id, new Texture2D( p_datFile, p_id ) ) );
             } catch ( const exception::Exception& err ) {
-                wxLogMessage( wxT( "Failed to load texture %d : %s" ), p_id, wxString( err.what( ) ) );
+                LogWarning( wxT( "Failed to load texture %d : %s" ), p_id, wxString( err.what( ) ) );
                 return false;
             }
             return true;
         } else {
-            wxLogMessage( wxT( "Texture %d is already loaded." ), p_id );
+            LogDebug( wxT( "Texture %d is already loaded." ), p_id );
             return false;
         }
     }
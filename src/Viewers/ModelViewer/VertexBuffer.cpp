@@ -24,6 +24,8 @@
 
 #include "stdafx.h"
 
+#include <cstddef>
+
 #include "VertexBuffer.h"
 
 namespace gw2b {
@@ -156,7 +158,33 @@ namespace gw2b {
         this->unbind( );
     }
 
+    VertexBuffer::VertexBuffer( const std::vector<InterleavedVertex>& p_vertices )
+        : m_stride( sizeof( InterleavedVertex ) ) {
+        // Generate Vertex Array Object
+        glGenVertexArrays( 1, &m_vao );
+        // Bind Vertex Array Object
+        this->bind( );
+
+        // Generate buffer
+        glGenBuffers( 1, &m_vertexBuffer );
+
+        // Load all attributes into the one buffer
+        glBindBuffer( GL_ARRAY_BUFFER, m_vertexBuffer );
+        glBufferData( GL_ARRAY_BUFFER, p_vertices.size( ) * sizeof( InterleavedVertex ), p_vertices.data( ), GL_STATIC_DRAW );
+
+        // The Vertex Array Object keeps the pointers, no need to set them again when drawing
+        this->setVertexAttribPointer( );
+
+        // Unbind Buffer Object
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+        // Unbind Vertex Array Object
+        this->unbind( );
+    }
+
     VertexBuffer::~VertexBuffer( ) {
+        if ( m_vao ) {
+            glDeleteVertexArrays( 1, &m_vao );
+        }
         if ( m_vertexBuffer ) {
             glDeleteBuffers( 1, &m_vertexBuffer );
         }
@@ -180,6 +208,20 @@ namespace gw2b {
     }
 
     void VertexBuffer::setVertexAttribPointer( ) {
+        if ( m_stride ) {
+            // All attributes in one buffer, at their offset in the vertex
+            glBindBuffer( GL_ARRAY_BUFFER, m_vertexBuffer );
+            glEnableVertexAttribArray( 0 );
+            glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, m_stride, ( GLvoid* ) offsetof( InterleavedVertex, position ) );
+            glEnableVertexAttribArray( 1 );
+            glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, m_stride, ( GLvoid* ) offsetof( InterleavedVertex, normal ) );
+            glEnableVertexAttribArray( 2 );
+            glVertexAttribPointer( 2, 2, GL_FLOAT, GL_FALSE, m_stride, ( GLvoid* ) offsetof( InterleavedVertex, uv ) );
+            glEnableVertexAttribArray( 3 );
+            glVertexAttribPointer( 3, 3, GL_FLOAT, GL_FALSE, m_stride, ( GLvoid* ) offsetof( InterleavedVertex, tangent ) );
+            return;
+        }
+
         // Set the vertex attribute pointers
         // positions
         glEnableVertexAttribArray( 0 );
@@ -29,12 +29,22 @@
 
 namespace gw2b {
 
+    /** Vertex with all attributes next to each other, as read from an
+    *  interleaved vertex buffer. */
+    struct InterleavedVertex {
+        glm::vec3                   position;
+        glm::vec3                   normal;
+        glm::vec2                   uv;
+        glm::vec3                   tangent;
+    };
+
     class VertexBuffer {
-        GLuint                      m_vao;              // Vertex Array Object
-        GLuint                      m_vertexBuffer;
-        GLuint                      m_normalBuffer;
-        GLuint                      m_uvBuffer;
-        GLuint                      m_tangentBuffer;
+        GLuint                      m_vao = 0;          // Vertex Array Object
+        GLuint                      m_vertexBuffer = 0;
+        GLuint                      m_normalBuffer = 0;
+        GLuint                      m_uvBuffer = 0;
+        GLuint                      m_tangentBuffer = 0;
+        GLsizei                     m_stride = 0;       // Size of an interleaved vertex, 0 if each attribute has its own buffer
 
     public:
         /** Constructor. Create Index Buffer Object.
@@ -59,6 +69,10 @@ namespace gw2b {
         *  \param[in]  p_uvs        Vertex Texture Coords.
         *  \param[in]  p_tangents   Vertex Tangents. */
         VertexBuffer( std::vector<glm::vec3> p_vertices, std::vector<glm::vec3> p_normals, std::vector<glm::vec2> p_uvs, std::vector<glm::vec3> p_tangents );
+        /** Constructor. Create one buffer holding all attributes, interleaved.
+        *  The vertex attribute pointers are set up once, in the Vertex Array Object.
+        *  \param[in]  p_vertices   Vertices. */
+        VertexBuffer( const std::vector<InterleavedVertex>& p_vertices );
         /** Destructor. Clears all data. */
         ~VertexBuffer( );
 
@@ -100,6 +100,7 @@ namespace gw2b
 // Gw2Browser includes
 #include "Util/Array.h"
 #include "Util/Ensure.h"
+#include "Util/Log.h"
 #include "Util/Misc.h"
 
 // Version information
@@ -0,0 +1,188 @@
+/** \file       test/BlockUploadTest.cpp
+ *  \brief      Checks that uploaded texture blocks decode to the pixels the image reader decodes.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "Compression/DXTDecoder.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Largest difference allowed per channel. The GL specs leave the rounding
+    *  of interpolated colors to the implementation. */
+    const int Tolerance = 1;
+    /** Random blocks checked per format. */
+    const uint NumBlocks = 16384;
+
+    /** Block formats uploaded by Texture2D, and the row decoder the image
+    *  reader decodes them with. */
+    struct Format {
+        const char*     name;
+        uint            blockSize;
+        DXTRowDecoder   DXTDecoder::*decoder;
+    };
+
+    const Format Formats[] = {
+        { "BC1 (COMPRESSED_RGBA_S3TC_DXT1)", 8, &DXTDecoder::dxt1 },
+        { "BC2 (COMPRESSED_RGBA_S3TC_DXT3)", 16, &DXTDecoder::dxt3 },
+        { "BC3 (COMPRESSED_RGBA_S3TC_DXT5)", 16, &DXTDecoder::dxt5 },
+    };
+
+    uint8 toByte( float p_value ) {
+        return static_cast<uint8>( std::floor( p_value * 255.0f + 0.5f ) );
+    }
+
+    /** Decodes the colors of a block as EXT_texture_compression_s3tc does. */
+    void decodeS3TCColors( const byte* p_block, bool p_isDXT1, float po_rgba[16][4] ) {
+        uint16 colors[2];
+        uint32 indices;
+        ::memcpy( colors, p_block, sizeof( colors ) );
+        ::memcpy( &indices, p_block + 4, sizeof( indices ) );
+
+        float palette[4][4];
+        for ( uint i = 0; i < 2; i++ ) {
+            palette[i][0] = ( colors[i] >> 11 ) / 31.0f;
+            palette[i][1] = ( ( colors[i] >> 5 ) & 0x3f ) / 63.0f;
+            palette[i][2] = ( colors[i] & 0x1f ) / 31.0f;
+            palette[i][3] = 1.0f;
+        }
+        for ( uint c = 0; c < 4; c++ ) {
+            if ( !p_isDXT1 || colors[0] > colors[1] ) {
+                palette[2][c] = ( 2.0f * palette[0][c] + palette[1][c] ) / 3.0f;
+                palette[3][c] = ( palette[0][c] + 2.0f * palette[1][c] ) / 3.0f;
+            } else {
+                palette[2][c] = ( palette[0][c] + palette[1][c] ) / 2.0f;
+                palette[3][c] = 0.0f;
+            }
+        }
+        for ( uint i = 0; i < 16; i++ ) {
+            ::memcpy( po_rgba[i], palette[( indices >> ( i * 2 ) ) & 3], sizeof( po_rgba[i] ) );
+        }
+    }
+
+    /** Decodes an interpolated channel as the DXT5 alpha is. */
+    void decodeChannel( const byte* p_block, float po_values[16] ) {
+        uint64 bits;
+        ::memcpy( &bits, p_block, sizeof( bits ) );
+        float palette[8];
+        palette[0] = ( bits & 0xff ) / 255.0f;
+        palette[1] = ( ( bits >> 8 ) & 0xff ) / 255.0f;
+        if ( palette[0] > palette[1] ) {
+            for ( uint i = 2; i < 8; i++ ) {
+                palette[i] = ( ( 8 - i ) * palette[0] + ( i - 1 ) * palette[1] ) / 7.0f;
+            }
+        } else {
+            for ( uint i = 2; i < 6; i++ ) {
+                palette[i] = ( ( 6 - i ) * palette[0] + ( i - 1 ) * palette[1] ) / 5.0f;
+            }
+            palette[6] = 0.0f;
+            palette[7] = 1.0f;
+        }
+        for ( uint i = 0; i < 16; i++ ) {
+            po_values[i] = palette[( bits >> ( 16 + i * 3 ) ) & 7];
+        }
+    }
+
+    /** Decodes a block as the GPU would, to RGBA. */
+    void decodeUploaded( const Format& p_format, const byte* p_block, uint8 po_rgba[16][4] ) {
+        float rgba[16][4];
+        if ( p_format.decoder == &DXTDecoder::dxt1 ) {
+            decodeS3TCColors( p_block, true, rgba );
+        } else if ( p_format.decoder == &DXTDecoder::dxt3 ) {
+            decodeS3TCColors( p_block + 8, false, rgba );
+            for ( uint i = 0; i < 16; i++ ) {
+                rgba[i][3] = ( ( p_block[i / 2] >> ( ( i & 1 ) * 4 ) ) & 0xf ) / 15.0f;
+            }
+        } else {
+            float alphas[16];
+            decodeS3TCColors( p_block + 8, false, rgba );
+            decodeChannel( p_block, alphas );
+            for ( uint i = 0; i < 16; i++ ) {
+                rgba[i][3] = alphas[i];
+            }
+        }
+
+        for ( uint i = 0; i < 16; i++ ) {
+            for ( uint c = 0; c < 4; c++ ) {
+                po_rgba[i][c] = toByte( rgba[i][c] );
+            }
+        }
+    }
+
+    /** Decodes a block as the image reader does, to RGBA. */
+    void decodeCPU( const Format& p_format, const byte* p_block, uint8 po_rgba[16][4] ) {
+        uint8 colors[16 * 3];
+        uint8 alphas[16];
+        ( dxtDecoder( ).*p_format.decoder )( p_block, 1, colors, alphas, 4 );
+        for ( uint i = 0; i < 16; i++ ) {
+            ::memcpy( po_rgba[i], colors + i * 3, 3 );
+            po_rgba[i][3] = alphas[i];
+        }
+    }
+
+};
+
+int main( ) {
+    TestResult result;
+    std::mt19937 random( 0x47505530 );
+    byte block[16];
+
+    for ( auto const& format : Formats ) {
+        int maxDifference = 0;
+        for ( uint i = 0; i < NumBlocks; i++ ) {
+            for ( auto& it : block ) {
+                it = static_cast<byte>( random( ) );
+            }
+            // Equal endpoints now and then
+            if ( !( i % 8 ) ) {
+                block[format.blockSize - 7] = block[format.blockSize - 8];
+                block[format.blockSize - 5] = block[format.blockSize - 6];
+            }
+
+            uint8 expected[16][4];
+            uint8 actual[16][4];
+            decodeUploaded( format, block, expected );
+            decodeCPU( format, block, actual );
+            for ( uint p = 0; p < 16; p++ ) {
+                for ( uint c = 0; c < 4; c++ ) {
+                    maxDifference = std::max( maxDifference, std::abs( expected[p][c] - actual[p][c] ) );
+                }
+            }
+        }
+
+        ::printf( "%s: largest difference %d\n", format.name, maxDifference );
+        TEST_CHECK( result, maxDifference <= Tolerance );
+    }
+
+    return result.exitCode( );
+}
@@ -0,0 +1,110 @@
+/** \file       test/DXTDecoderBenchmark.cpp
+ *  \brief      Times the reference and dispatched DXT decoders.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "stdafx.h"
+
+#include <random>
+#include <vector>
+
+#include "Compression/DXTDecoder.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Width and height of the decoded image, in pixels. */
+    const uint ImageSize = 4096;
+    /** Pixels decoded per run. */
+    const uint NumPixels = ImageSize * ImageSize;
+    /** Each decoder runs this many times, the fastest run counts. */
+    const uint NumRuns = 5;
+
+    /** Decodes a whole image of blocks, a row of blocks at a time. */
+    void decodeImage( DXTRowDecoder p_decoder, uint p_blockSize, const byte* p_blocks, uint8* po_colors, uint8* po_alphas ) {
+        const uint numBlocks = ImageSize / 4;
+        for ( uint row = 0; row < numBlocks; row++ ) {
+            p_decoder( p_blocks + static_cast<size_t>( row ) * numBlocks * p_blockSize, numBlocks,
+                po_colors + static_cast<size_t>( row ) * 4 * ImageSize * 3, po_alphas + static_cast<size_t>( row ) * 4 * ImageSize, ImageSize );
+        }
+    }
+
+    /** Times a decoder of a set, returns the fastest run in seconds. */
+    double bestTime( const DXTDecoder& p_decoders, DXTRowDecoder DXTDecoder::*p_decoder, uint p_blockSize,
+        const byte* p_blocks, uint8* po_colors, uint8* po_alphas ) {
+        double best = 0.0;
+        for ( uint run = 0; run < NumRuns; run++ ) {
+            Stopwatch stopwatch;
+            decodeImage( p_decoders.*p_decoder, p_blockSize, p_blocks, po_colors, po_alphas );
+            auto time = stopwatch.seconds( );
+            if ( !run || time < best ) {
+                best = time;
+            }
+        }
+        return best;
+    }
+
+};
+
+int main( ) {
+    auto& decoder = dxtDecoder( );
+    auto& reference = dxtReferenceDecoder( );
+
+    // Random blocks use every mode of every format: both DXT1 color orders,
+    // and both DXT5 and DXTA alpha orders
+    std::mt19937 random( 0x44585442 );
+    std::vector<byte> blocks( static_cast<size_t>( NumPixels ) );
+    for ( auto& it : blocks ) {
+        it = static_cast<byte>( random( ) );
+    }
+    std::vector<uint8> colors( static_cast<size_t>( NumPixels ) * 3 );
+    std::vector<uint8> alphas( NumPixels );
+
+    struct Format {
+        const char*     name;
+        DXTRowDecoder   DXTDecoder::*decoder;
+        uint            blockSize;
+    };
+    const Format formats[] = {
+        { "DXT1", &DXTDecoder::dxt1, 8 },
+        { "DXT3", &DXTDecoder::dxt3, 16 },
+        { "DXT5", &DXTDecoder::dxt5, 16 },
+        { "DXTA", &DXTDecoder::dxta, 8 },
+        { "3DCX", &DXTDecoder::dcx, 16 },
+    };
+
+    ::printf( "%ux%u pixels per run, best of %u runs\n", ImageSize, ImageSize, NumRuns );
+    ::printf( "format  %s Mpixels/s   %s Mpixels/s   speedup\n", reference.name, decoder.name );
+    for ( auto const& format : formats ) {
+        auto referenceTime = bestTime( reference, format.decoder, format.blockSize, blocks.data( ), colors.data( ), alphas.data( ) );
+        auto decoderTime = bestTime( decoder, format.decoder, format.blockSize, blocks.data( ), colors.data( ), alphas.data( ) );
+        ::printf( "%-6s  %14.1f   %17.1f   %6.2fx\n", format.name,
+            referenceTime > 0.0 ? NumPixels / referenceTime / 1e6 : 0.0,
+            decoderTime > 0.0 ? NumPixels / decoderTime / 1e6 : 0.0,
+            decoderTime > 0.0 ? referenceTime / decoderTime : 0.0 );
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+/** \file       test/DXTDecoderTest.cpp
+ *  \brief      Checks that the vector DXT decoders match the plain C++ ones bit for bit.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Compression/DXTDecoder.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Format decoded by one of the row decoders. */
+    struct Format {
+        const char*     name;
+        uint            blockSize;
+        DXTRowDecoder   DXTDecoder::*decoder;
+    };
+
+    const Format Formats[] = {
+        { "DXT1", 8, &DXTDecoder::dxt1 },
+        { "DXT3", 16, &DXTDecoder::dxt3 },
+        { "DXT5", 16, &DXTDecoder::dxt5 },
+        { "DXTA", 8, &DXTDecoder::dxta },
+        { "3DCX", 16, &DXTDecoder::dcx },
+    };
+
+    /** Rows of blocks decoded per format and row width. */
+    const uint NumRows = 256;
+
+    /** Fills blocks with random bytes, with a share of the blocks having equal
+    *  or swapped endpoints, so every palette mode is hit. */
+    void fillBlocks( std::mt19937& p_random, std::vector<byte>& po_blocks, uint p_blockSize ) {
+        for ( auto& it : po_blocks ) {
+            it = static_cast<byte>( p_random( ) );
+        }
+        for ( size_t i = 0; i + p_blockSize <= po_blocks.size( ); i += p_blockSize * 7 ) {
+            // Equal endpoints, in every half of the block
+            for ( uint half = 0; half < p_blockSize; half += 8 ) {
+                po_blocks[i + half + 1] = po_blocks[i + half];
+                po_blocks[i + half + 3] = po_blocks[i + half + 2];
+            }
+        }
+    }
+
+    /** Decodes the rows with a set of decoders. The buffers are padded with a
+    *  marker past the blocks, which must stay untouched. */
+    void decodeRows( const DXTDecoder& p_decoder, const Format& p_format, const std::vector<byte>& p_blocks, uint p_numBlocks,
+        uint p_width, std::vector<uint8>& po_colors, std::vector<uint8>& po_alphas ) {
+        po_colors.assign( static_cast<size_t>( p_width ) * 4 * 3 + 16, 0xcd );
+        po_alphas.assign( static_cast<size_t>( p_width ) * 4 + 16, 0xcd );
+
+        std::vector<uint8> colors( po_colors.size( ) );
+        std::vector<uint8> alphas( po_alphas.size( ) );
+        for ( uint y = 0; y < NumRows; y++ ) {
+            colors.assign( colors.size( ), 0xcd );
+            alphas.assign( alphas.size( ), 0xcd );
+            ( p_decoder.*p_format.decoder )( p_blocks.data( ) + static_cast<size_t>( y ) * p_numBlocks * p_format.blockSize, p_numBlocks,
+                colors.data( ), alphas.data( ), p_width );
+
+            // Fold the rows together, so a difference in any of them shows
+            for ( size_t i = 0; i < colors.size( ); i++ ) {
+                po_colors[i] = static_cast<uint8>( po_colors[i] * 31 + colors[i] );
+            }
+            for ( size_t i = 0; i < alphas.size( ); i++ ) {
+                po_alphas[i] = static_cast<uint8>( po_alphas[i] * 31 + alphas[i] );
+            }
+        }
+    }
+
+};
+
+int main( ) {
+    auto& decoder = dxtDecoder( );
+    auto& reference = dxtReferenceDecoder( );
+    ::printf( "Comparing %s decoders with %s\n", decoder.name, reference.name );
+
+    TestResult result;
+    std::mt19937 random( 0x4458543f );
+    std::vector<byte> blocks;
+    std::vector<uint8> expectedColors;
+    std::vector<uint8> expectedAlphas;
+    std::vector<uint8> actualColors;
+    std::vector<uint8> actualAlphas;
+
+    // Odd amounts of blocks, and widths padded past the blocks
+    const uint numBlocks[] = { 1, 3, 16, 61 };
+    const uint paddings[] = { 0, 3 };
+
+    for ( auto const& format : Formats ) {
+        for ( auto blockCount : numBlocks ) {
+            blocks.resize( static_cast<size_t>( blockCount ) * NumRows * format.blockSize );
+            fillBlocks( random, blocks, format.blockSize );
+
+            for ( auto padding : paddings ) {
+                auto width = blockCount * 4 + padding;
+                decodeRows( reference, format, blocks, blockCount, width, expectedColors, expectedAlphas );
+                decodeRows( decoder, format, blocks, blockCount, width, actualColors, actualAlphas );
+
+                auto isSame = TEST_CHECK( result, expectedColors == actualColors );
+                isSame = TEST_CHECK( result, expectedAlphas == actualAlphas ) && isSame;
+                if ( !isSame ) {
+                    ::fprintf( stderr, "  %s: %u blocks, width %u differ\n", format.name, blockCount, width );
+                }
+            }
+        }
+    }
+
+    return result.exitCode( );
+}
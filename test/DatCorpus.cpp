@@ -0,0 +1,486 @@
+/** \file       test/DatCorpus.cpp
+ *  \brief      Contains the definition of the synthetic compressed .dat entries.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+#include "DatCorpus.h"
+#include "HuffmanWriter.h"
+#include "TestUtil.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Symbols of the literal/length tree below this are literals. */
+        const uint LiteralCount = 0x100;
+        /** Length symbol with a fixed size of 0xff. */
+        const uint MaxLengthSymbol = 28;
+        /** Amount of symbols of the literal/length tree. */
+        const uint NumSymbols = LiteralCount + MaxLengthSymbol + 1;
+        /** Amount of symbols of the offset tree. */
+        const uint NumCopySymbols = 34;
+        /** Longest code written, well below what the inflaters accept. */
+        const uint MaxCodeBits = 16;
+        /** Farthest a match can reach back, in bytes. */
+        const uint32 HistorySize = 0x20000;
+        /** Amount of candidates tried per match. */
+        const uint MaxChain = 32;
+        const uint HashBits = 16;
+
+        /** Code lengths of the static dictionary used to write the trees of
+        *  every block, indexed by length - 3. Missing symbols are 16 bits long. */
+        const uint8 DictionaryBits3[] = { 0x0A, 0x09, 0x08 };
+        const uint8 DictionaryBits4[] = { 0x0C, 0x0B, 0x07, 0x00 };
+        const uint8 DictionaryBits5[] = { 0xE0, 0x2A, 0x29, 0x06 };
+        const uint8 DictionaryBits6[] = { 0x4A, 0x40, 0x2C, 0x2B, 0x28, 0x20, 0x05, 0x04 };
+        const uint8 DictionaryBits7[] = { 0x49, 0x48, 0x27, 0x26, 0x25, 0x0D, 0x03 };
+        const uint8 DictionaryBits8[] = { 0x6A, 0x69, 0x4C, 0x4B, 0x47, 0x24 };
+        const uint8 DictionaryBits9[] = { 0xE8, 0xA0, 0x89, 0x88, 0x68, 0x67, 0x63, 0x60, 0x46, 0x23 };
+        const uint8 DictionaryBits10[] = { 0xE9, 0xC9, 0xC0, 0xA9, 0xA8, 0x8A, 0x87, 0x80, 0x66, 0x65, 0x45, 0x44, 0x43, 0x2D, 0x02, 0x01 };
+        const uint8 DictionaryBits11[] = { 0xE5, 0xC8, 0xAA, 0xA5, 0xA4, 0x8B, 0x85, 0x84, 0x6C, 0x6B, 0x64, 0x4D, 0x0E };
+        const uint8 DictionaryBits12[] = { 0xE7, 0xCA, 0xC7, 0xA7, 0xA6, 0x86, 0x83 };
+        const uint8 DictionaryBits13[] = { 0xE6, 0xE4, 0xC4, 0x8C, 0x2E, 0x22 };
+        const uint8 DictionaryBits14[] = { 0xEC, 0xC6, 0x6D, 0x4E };
+        const uint8 DictionaryBits15[] = { 0xEA, 0xCC, 0xAC, 0xAB, 0x8D, 0x11, 0x10, 0x0F };
+
+        /** Code lengths and codes of the static dictionary. */
+        struct Dictionary {
+            uint8                   bits[0x100];
+            std::vector<uint32>     codes;
+
+            Dictionary( ) {
+                const struct {
+                    const uint8*    symbols;
+                    uint            count;
+                } lengths[] = {
+                    { DictionaryBits3, sizeof( DictionaryBits3 ) },
+                    { DictionaryBits4, sizeof( DictionaryBits4 ) },
+                    { DictionaryBits5, sizeof( DictionaryBits5 ) },
+                    { DictionaryBits6, sizeof( DictionaryBits6 ) },
+                    { DictionaryBits7, sizeof( DictionaryBits7 ) },
+                    { DictionaryBits8, sizeof( DictionaryBits8 ) },
+                    { DictionaryBits9, sizeof( DictionaryBits9 ) },
+                    { DictionaryBits10, sizeof( DictionaryBits10 ) },
+                    { DictionaryBits11, sizeof( DictionaryBits11 ) },
+                    { DictionaryBits12, sizeof( DictionaryBits12 ) },
+                    { DictionaryBits13, sizeof( DictionaryBits13 ) },
+                    { DictionaryBits14, sizeof( DictionaryBits14 ) },
+                    { DictionaryBits15, sizeof( DictionaryBits15 ) },
+                };
+
+                ::memset( bits, 16, sizeof( bits ) );
+                for ( uint i = 0; i < sizeof( lengths ) / sizeof( lengths[0] ); i++ ) {
+                    for ( uint j = 0; j < lengths[i].count; j++ ) {
+                        bits[lengths[i].symbols[j]] = i + 3;
+                    }
+                }
+                codes = huffmanCodes( bits, 0x100 );
+            }
+        };
+
+        /** Symbol of a code, and the extra bits following it. */
+        struct Code {
+            uint16                  symbol;         /**< Literal, or LiteralCount + length symbol. */
+            uint16                  copySymbol;     /**< Offset symbol of a match. */
+            uint8                   sizeBits;
+            uint8                   copyBits;
+            uint32                  sizeExtra;
+            uint32                  copyExtra;
+        };
+
+        uint bitLength( uint32 p_value ) {
+            uint bits = 0;
+            while ( p_value ) {
+                p_value >>= 1;
+                bits++;
+            }
+            return bits;
+        }
+
+        /** Gets Huffman code lengths of the given symbol counts, no longer
+        *  than p_maxBits. Counts are halved until the code fits. */
+        std::vector<uint8> huffmanLengths( std::vector<uint32> p_counts, uint p_maxBits ) {
+            typedef std::pair<uint64, uint> Node;
+            auto numSymbols = static_cast<uint>( p_counts.size( ) );
+            std::vector<uint8> bits( numSymbols, 0 );
+
+            for ( ;; ) {
+                std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+                std::vector<int> parents( numSymbols, -1 );
+                for ( uint i = 0; i < numSymbols; i++ ) {
+                    if ( p_counts[i] ) {
+                        queue.push( Node( p_counts[i], i ) );
+                    }
+                }
+                if ( queue.size( ) == 1 ) {
+                    bits[queue.top( ).second] = 1;
+                    return bits;
+                }
+
+                while ( queue.size( ) > 1 ) {
+                    auto first = queue.top( );
+                    queue.pop( );
+                    auto second = queue.top( );
+                    queue.pop( );
+                    parents[first.second] = parents.size( );
+                    parents[second.second] = parents.size( );
+                    queue.push( Node( first.first + second.first, parents.size( ) ) );
+                    parents.push_back( -1 );
+                }
+
+                uint maxBits = 0;
+                for ( uint i = 0; i < numSymbols; i++ ) {
+                    if ( !p_counts[i] ) {
+                        continue;
+                    }
+                    uint depth = 0;
+                    for ( auto node = parents[i]; node >= 0; node = parents[node] ) {
+                        depth++;
+                    }
+                    bits[i] = depth;
+                    maxBits = std::max( maxBits, depth );
+                }
+                if ( maxBits <= p_maxBits ) {
+                    return bits;
+                }
+
+                for ( auto& it : p_counts ) {
+                    it = ( it + 1 ) / 2;
+                }
+            }
+        }
+
+        /** Writes the code lengths of a tree, from the highest symbol down, in
+        *  runs of up to 8 equal lengths. */
+        void writeTree( BitWriter& p_writer, const std::vector<uint8>& p_bits ) {
+            static const Dictionary s_dictionary;
+
+            auto numSymbols = static_cast<int>( p_bits.size( ) );
+            while ( numSymbols > 1 && !p_bits[numSymbols - 1] ) {
+                numSymbols--;
+            }
+            p_writer.write( numSymbols, 16 );
+
+            for ( auto i = numSymbols - 1; i >= 0; ) {
+                int count = 1;
+                while ( count < 8 && i - count >= 0 && p_bits[i - count] == p_bits[i] ) {
+                    count++;
+                }
+                auto symbol = ( ( count - 1 ) << 5 ) | p_bits[i];
+                p_writer.write( s_dictionary.codes[symbol], s_dictionary.bits[symbol] );
+                i -= count;
+            }
+        }
+
+        Code literalCode( byte p_value ) {
+            Code code = { p_value, 0, 0, 0, 0, 0 };
+            return code;
+        }
+
+        Code matchCode( uint32 p_length, uint32 p_distance, uint p_sizeAdd ) {
+            Code code = { 0, 0, 0, 0, 0, 0 };
+
+            // Length
+            auto size = p_length - p_sizeAdd;
+            if ( size == 0xff ) {
+                code.symbol = MaxLengthSymbol;
+            } else if ( size < 8 ) {
+                code.symbol = size;
+            } else {
+                auto group = bitLength( size ) - 2;
+                code.sizeBits = group - 1;
+                code.symbol = group * 4 + ( size >> code.sizeBits ) - 4;
+                code.sizeExtra = size & ( ( 1u << code.sizeBits ) - 1 );
+            }
+            code.symbol += LiteralCount;
+
+            // Offset
+            auto offset = p_distance - 1;
+            if ( offset < 2 ) {
+                code.copySymbol = offset;
+            } else {
+                auto group = bitLength( offset ) - 1;
+                code.copyBits = group - 1;
+                code.copySymbol = group * 2 + ( offset >> code.copyBits ) - 2;
+                code.copyExtra = offset & ( ( 1u << code.copyBits ) - 1 );
+            }
+            return code;
+        }
+
+        /** Splits the data into literals and greedily found matches. */
+        std::vector<Code> findCodes( const std::vector<byte>& p_data, uint p_sizeAdd ) {
+            auto size = static_cast<uint32>( p_data.size( ) );
+            auto minLength = std::max( 3u, p_sizeAdd );
+            auto maxLength = 0xffu + p_sizeAdd;
+
+            std::vector<int32> heads( 1u << HashBits, -1 );
+            std::vector<int32> previous( size, -1 );
+            auto insert = [&]( uint32 p_position ) {
+                if ( p_position + 3 > size ) {
+                    return;
+                }
+                auto hash = ( ( p_data[p_position] | ( p_data[p_position + 1] << 8 ) | ( p_data[p_position + 2] << 16 ) ) * 2654435761u ) >> ( 32 - HashBits );
+                previous[p_position] = heads[hash];
+                heads[hash] = p_position;
+            };
+
+            std::vector<Code> codes;
+            uint32 position = 0;
+            while ( position < size ) {
+                uint32 bestLength = 0;
+                uint32 bestDistance = 0;
+                if ( position + 3 <= size ) {
+                    auto limit = std::min( maxLength, size - position );
+                    auto hash = ( ( p_data[position] | ( p_data[position + 1] << 8 ) | ( p_data[position + 2] << 16 ) ) * 2654435761u ) >> ( 32 - HashBits );
+                    auto candidate = heads[hash];
+                    for ( uint i = 0; i < MaxChain && candidate >= 0 && position - candidate <= HistorySize; i++ ) {
+                        uint32 length = 0;
+                        while ( length < limit && p_data[candidate + length] == p_data[position + length] ) {
+                            length++;
+                        }
+                        if ( length > bestLength ) {
+                            bestLength = length;
+                            bestDistance = position - candidate;
+                            if ( length == limit ) {
+                                break;
+                            }
+                        }
+                        candidate = previous[candidate];
+                    }
+                }
+
+                if ( bestLength >= minLength ) {
+                    codes.push_back( matchCode( bestLength, bestDistance, p_sizeAdd ) );
+                    for ( uint32 i = 0; i < bestLength; i++ ) {
+                        insert( position + i );
+                    }
+                    position += bestLength;
+                } else {
+                    codes.push_back( literalCode( p_data[position] ) );
+                    insert( position );
+                    position++;
+                }
+            }
+            return codes;
+        }
+
+        /** Appends a copy of earlier data, byte by byte as it may overlap. */
+        void appendCopy( std::vector<byte>& po_data, uint32 p_distance, uint32 p_length ) {
+            p_distance = std::min<uint32>( p_distance, po_data.size( ) );
+            for ( uint32 i = 0; i < p_length; i++ ) {
+                auto value = po_data[po_data.size( ) - p_distance];
+                po_data.push_back( value );
+            }
+        }
+
+        std::vector<byte> literalsData( ) {
+            TestRandom random( 1 );
+            std::vector<byte> data( 3000 );
+            for ( auto& it : data ) {
+                it = random.next( ) & 0xff;
+            }
+            return data;
+        }
+
+        /** Words, runs of a byte and short periods, for matches of a few
+        *  bytes that often overlap their source. */
+        std::vector<byte> shortMatchesData( ) {
+            static const char* const words[] = { "model ", "texture ", "the ", "of ", "mesh ", "a ", "entry ", "file ", "sound ", "map " };
+            TestRandom random( 2 );
+            std::vector<byte> data;
+            while ( data.size( ) < 40000 ) {
+                auto kind = random.range( 0, 7 );
+                if ( kind < 5 ) {
+                    auto word = words[random.range( 0, sizeof( words ) / sizeof( words[0] ) - 1 )];
+                    data.insert( data.end( ), word, word + ::strlen( word ) );
+                } else if ( kind == 5 || data.size( ) < 8 ) {
+                    data.insert( data.end( ), random.range( 3, 40 ), random.next( ) & 0xff );
+                } else if ( kind == 6 ) {
+                    auto period = random.range( 2, 7 );
+                    for ( uint i = 0; i < period; i++ ) {
+                        data.push_back( random.next( ) & 0xff );
+                    }
+                    appendCopy( data, period, random.range( 8, 60 ) );
+                } else {
+                    for ( auto count = random.range( 1, 4 ); count; count-- ) {
+                        data.push_back( random.next( ) & 0xff );
+                    }
+                }
+            }
+            return data;
+        }
+
+        /** Random data, then copies of it from up to 128 KiB back, longer than
+        *  a single match can be. */
+        std::vector<byte> longMatchesData( ) {
+            TestRandom random( 3 );
+            std::vector<byte> data( 96 * 1024 );
+            for ( auto& it : data ) {
+                it = random.next( ) & 0xff;
+            }
+            while ( data.size( ) < 256 * 1024 ) {
+                auto distance = ( random.next( ) & 1 ) ? random.range( 0x10000, HistorySize ) : random.range( 1, HistorySize );
+                appendCopy( data, distance, random.range( 200, 700 ) );
+                for ( auto count = random.range( 1, 8 ); count; count-- ) {
+                    data.push_back( random.next( ) & 0xff );
+                }
+            }
+            return data;
+        }
+
+        /** Larger than the window of inflateDatStream, with matches reaching
+        *  back over its flushes. */
+        std::vector<byte> windowWrapData( ) {
+            TestRandom random( 4 );
+            std::vector<byte> data;
+            while ( data.size( ) < 1536 * 1024 ) {
+                auto kind = random.range( 0, 3 );
+                if ( kind == 0 || data.size( ) < 1024 ) {
+                    for ( auto count = random.range( 1, 64 ); count; count-- ) {
+                        data.push_back( random.next( ) & 0xff );
+                    }
+                } else if ( kind == 1 ) {
+                    data.insert( data.end( ), random.range( 100, 5000 ), random.next( ) & 0xff );
+                } else {
+                    appendCopy( data, random.range( 1, HistorySize ), random.range( 4, 1000 ) );
+                }
+            }
+            return data;
+        }
+
+        /** Mostly literals: compressed, it spans many blocks, 64 KiB checksum
+        *  blocks and input pieces of inflateDatStream. Rare bytes get codes
+        *  longer than the lookup table. */
+        std::vector<byte> multiBlockData( ) {
+            TestRandom random( 5 );
+            std::vector<byte> data;
+            while ( data.size( ) < 1536 * 1024 ) {
+                auto kind = random.range( 0, 999 );
+                if ( kind < 5 ) {
+                    data.push_back( random.range( 192, 255 ) );
+                } else if ( kind < 250 ) {
+                    byte value = 0;
+                    while ( value < 16 && ( random.next( ) & 1 ) ) {
+                        value++;
+                    }
+                    data.push_back( value );
+                } else if ( kind < 252 && data.size( ) > 64 ) {
+                    appendCopy( data, random.range( 1, 64 ), random.range( 3, 20 ) );
+                } else {
+                    data.push_back( random.range( 0, 191 ) );
+                }
+            }
+            return data;
+        }
+
+    };
+
+    //============================================================================/
+
+    std::vector<byte> deflateDatBuffer( const std::vector<byte>& p_data, uint p_sizeAdd, uint p_blockCodes ) {
+        auto codes = findCodes( p_data, p_sizeAdd );
+
+        BitWriter writer;
+        writer.write( 0, 32 );
+        writer.write( static_cast<uint32>( p_data.size( ) ), 32 );
+        writer.write( 0, 4 );
+        writer.write( p_sizeAdd - 1, 4 );
+
+        for ( size_t start = 0; start < codes.size( ); start += p_blockCodes ) {
+            auto end = std::min( codes.size( ), start + p_blockCodes );
+
+            // Trees of this block only
+            std::vector<uint32> counts( NumSymbols, 0 );
+            std::vector<uint32> copyCounts( NumCopySymbols, 0 );
+            for ( auto i = start; i < end; i++ ) {
+                counts[codes[i].symbol]++;
+                if ( codes[i].symbol >= LiteralCount ) {
+                    copyCounts[codes[i].copySymbol]++;
+                }
+            }
+            // An empty tree would end the data
+            if ( std::find_if( copyCounts.begin( ), copyCounts.end( ), [] ( uint32 p_count ) { return p_count != 0; } ) == copyCounts.end( ) ) {
+                copyCounts[0] = 1;
+            }
+
+            auto bits = huffmanLengths( counts, MaxCodeBits );
+            auto copyBits = huffmanLengths( copyCounts, MaxCodeBits );
+            writeTree( writer, bits );
+            writeTree( writer, copyBits );
+            writer.write( ( p_blockCodes >> 12 ) - 1, 4 );
+
+            auto symbolCodes = huffmanCodes( bits.data( ), NumSymbols );
+            auto copyCodes = huffmanCodes( copyBits.data( ), NumCopySymbols );
+            for ( auto i = start; i < end; i++ ) {
+                auto& code = codes[i];
+                writer.write( symbolCodes[code.symbol], bits[code.symbol] );
+                if ( code.symbol < LiteralCount ) {
+                    continue;
+                }
+                writer.write( code.sizeExtra, code.sizeBits );
+                writer.write( copyCodes[code.copySymbol], copyBits[code.copySymbol] );
+                writer.write( code.copyExtra, code.copyBits );
+            }
+        }
+
+        // The inflaters read a word or two ahead
+        writer.flush( );
+        writer.write( 0, 32 );
+        writer.write( 0, 32 );
+        return writer.data( );
+    }
+
+    //============================================================================/
+
+    std::vector<DatCorpusEntry> datCorpus( ) {
+        struct Fixture {
+            const char*             name;
+            std::vector<byte>       ( *data )( );
+            uint                    sizeAdd;
+            uint                    blockCodes;
+        };
+        const Fixture fixtures[] = {
+            { "literals", literalsData, 1, 0x1000 },
+            { "short matches", shortMatchesData, 2, 0x2000 },
+            { "long matches", longMatchesData, 16, 0x4000 },
+            { "window wrap", windowWrapData, 3, 0x10000 },
+            { "multi-block", multiBlockData, 1, 0x1000 },
+        };
+
+        std::vector<DatCorpusEntry> corpus;
+        for ( auto const& it : fixtures ) {
+            DatCorpusEntry entry;
+            entry.name = it.name;
+            entry.output = it.data( );
+            entry.input = deflateDatBuffer( entry.output, it.sizeAdd, it.blockCodes );
+            corpus.push_back( std::move( entry ) );
+        }
+        return corpus;
+    }
+
+}; // namespace gw2b
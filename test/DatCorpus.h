@@ -0,0 +1,60 @@
+/** \file       test/DatCorpus.h
+ *  \brief      Contains the declaration of the synthetic compressed .dat entries.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef TEST_DATCORPUS_H_INCLUDED
+#define TEST_DATCORPUS_H_INCLUDED
+
+#include <vector>
+
+namespace gw2b {
+
+    /** A synthetic compressed .dat entry and what it inflates to. */
+    struct DatCorpusEntry {
+        const char*                 name;       /**< What the entry covers. */
+        std::vector<byte>           input;      /**< Compressed entry, as stored in the .dat. */
+        std::vector<byte>           output;     /**< Inflated entry. */
+    };
+
+    /** Compresses data the way .dat entries are: LZ matches of up to 128 KiB
+    *  back, coded with Huffman trees sent per block of codes. Matches are
+    *  found greedily, so the result is valid rather than small.
+    *  \param[in]  p_data       Data to compress.
+    *  \param[in]  p_sizeAdd    Length of the shortest match, 1 to 16.
+    *  \param[in]  p_blockCodes Amount of codes per block, a multiple of 4096 up to 65536.
+    *  \return std::vector<byte>    The compressed entry. */
+    std::vector<byte> deflateDatBuffer( const std::vector<byte>& p_data, uint p_sizeAdd, uint p_blockCodes );
+
+    /** Builds the synthetic corpus the inflaters are checked against when no
+    *  .dat is at hand. Covers literals only, short and overlapping matches,
+    *  long and far matches, output larger than the stream window, and
+    *  entries of many blocks with long codes and block checksums. The
+    *  entries are the same on every run.
+    *  \return std::vector<DatCorpusEntry>  The entries. */
+    std::vector<DatCorpusEntry> datCorpus( );
+
+}; // namespace gw2b
+
+#endif // TEST_DATCORPUS_H_INCLUDED
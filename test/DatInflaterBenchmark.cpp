@@ -0,0 +1,121 @@
+/** \file       test/DatInflaterBenchmark.cpp
+ *  \brief      Measures the throughput of the .dat inflaters.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <gw2dattools/compression/inflateDatFileBuffer.h>
+#include <gw2dattools/exception/Exception.h>
+
+#include "Compression/DatInflater.h"
+
+#include "TestDatFile.h"
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Amount of entries inflated, spread over the whole .dat. */
+    const uint MaxEntries = 2000;
+    /** Max amount of compressed bytes kept in memory. */
+    const uint64 MaxInputBytes = 256 * 1024 * 1024;
+    /** Each inflater runs this many times, the fastest run counts. */
+    const uint NumRuns = 3;
+
+    struct Entry {
+        std::vector<byte>           input;
+        uint32                      outputSize;
+    };
+
+    /** Inflates all entries, returns the time taken in seconds. */
+    template <typename Inflate>
+    double bestTime( const std::vector<Entry>& p_entries, std::vector<byte>& po_output, Inflate p_inflate ) {
+        double best = 0.0;
+        for ( uint run = 0; run < NumRuns; run++ ) {
+            Stopwatch stopwatch;
+            for ( auto& entry : p_entries ) {
+                p_inflate( entry, po_output.data( ) );
+            }
+            auto time = stopwatch.seconds( );
+            if ( !run || time < best ) {
+                best = time;
+            }
+        }
+        return best;
+    }
+
+};
+
+int main( int p_argc, char** p_argv ) {
+    auto path = TestDatFile::path( p_argc, p_argv );
+    TestDatFile datFile;
+    if ( !path || !datFile.open( path ) ) {
+        ::printf( "No .dat given, set GW2_DAT to run this benchmark.\n" );
+        return TestSkipped;
+    }
+
+    // Read the entries up front, so only inflating is timed
+    std::vector<Entry> entries;
+    uint64 inputBytes = 0;
+    uint64 outputBytes = 0;
+    uint32 maxOutputSize = 0;
+    for ( auto entryNum : datFile.compressedEntries( MaxEntries ) ) {
+        Entry entry;
+        if ( !datFile.readRaw( entryNum, entry.input ) ) {
+            continue;
+        }
+        entry.outputSize = TestDatFile::inflatedSize( entry.input );
+        if ( !entry.outputSize ) {
+            continue;
+        }
+
+        inputBytes += entry.input.size( );
+        outputBytes += entry.outputSize;
+        maxOutputSize = std::max( maxOutputSize, entry.outputSize );
+        entries.push_back( std::move( entry ) );
+        if ( inputBytes >= MaxInputBytes ) {
+            break;
+        }
+    }
+    std::vector<byte> output( maxOutputSize );
+
+    auto reference = bestTime( entries, output, [] ( const Entry& p_entry, byte* po_output ) {
+        uint32 size = p_entry.outputSize;
+        try {
+            gw2dt::compression::inflateDatFileBuffer( p_entry.input.size( ), p_entry.input.data( ), size, po_output );
+        } catch ( const gw2dt::exception::Exception& ) {
+        }
+    } );
+    auto inTree = bestTime( entries, output, [] ( const Entry& p_entry, byte* po_output ) {
+        uint32 size = p_entry.outputSize;
+        inflateDatBuffer( p_entry.input.size( ), p_entry.input.data( ), size, po_output );
+    } );
+
+    ::printf( "%u entries, %.1f MB compressed, %.1f MB inflated\n", static_cast<uint>( entries.size( ) ),
+        inputBytes / ( 1024.0 * 1024.0 ), outputBytes / ( 1024.0 * 1024.0 ) );
+    ::printf( "gw2dattools: %8.1f MB/s\n", megabytesPerSecond( outputBytes, reference ) );
+    ::printf( "in-tree:     %8.1f MB/s (%.2fx)\n", megabytesPerSecond( outputBytes, inTree ), inTree > 0.0 ? reference / inTree : 0.0 );
+    return EXIT_SUCCESS;
+}
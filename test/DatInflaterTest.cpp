@@ -0,0 +1,182 @@
+/** \file       test/DatInflaterTest.cpp
+ *  \brief      Checks the in-tree .dat inflater against gw2dattools.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cstring>
+#include <gw2dattools/compression/inflateDatFileBuffer.h>
+#include <gw2dattools/exception/Exception.h>
+
+#include "Compression/DatInflater.h"
+
+#include "DatCorpus.h"
+#include "TestDatFile.h"
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Amount of entries compared, spread over the whole .dat. */
+    const uint MaxEntries = 4000;
+    /** Amount of bytes DatFile peeks to identify entries. */
+    const uint PeekSize = 64;
+
+    /** Serves a buffer as the reads ask for it, filling each read like a
+    *  file does. */
+    class BufferDataSource : public IDataSource {
+        const std::vector<byte>&    m_data;
+        size_t                      m_offset = 0;
+    public:
+        BufferDataSource( const std::vector<byte>& p_data )
+            : m_data( p_data ) {
+        }
+
+        virtual uint32 read( byte* po_buffer, uint32 p_size ) override {
+            auto size = static_cast<uint32>( std::min<size_t>( p_size, m_data.size( ) - m_offset ) );
+            ::memcpy( po_buffer, m_data.data( ) + m_offset, size );
+            m_offset += size;
+            return size;
+        }
+    }; // class BufferDataSource
+
+    /** Collects everything written to it. */
+    class BufferDataSink : public IDataSink {
+    public:
+        std::vector<byte>           data;
+
+        virtual bool write( const byte* p_data, uint32 p_size ) override {
+            data.insert( data.end( ), p_data, p_data + p_size );
+            return true;
+        }
+    }; // class BufferDataSink
+
+    /** Inflates with gw2dattools.
+    *  \return bool    true if inflated, false if gw2dattools threw. */
+    bool inflateReference( const std::vector<byte>& p_input, uint32& po_outputSize, byte* po_output ) {
+        try {
+            gw2dt::compression::inflateDatFileBuffer( p_input.size( ), p_input.data( ), po_outputSize, po_output );
+            return true;
+        } catch ( const gw2dt::exception::Exception& ) {
+            return false;
+        }
+    }
+
+    /** Inflates an entry whole, peeked and streamed, comparing each with
+    *  gw2dattools and, if known, with what the entry inflates to.
+    *  \param[in,out] p_result  Result of the test.
+    *  \param[in]  p_name       Name of the entry, for the failures.
+    *  \param[in]  p_input      Compressed entry.
+    *  \param[in]  p_original   What the entry inflates to, nullptr if unknown.
+    *  \return bool             true if compared, false if the entry has no known size. */
+    bool compareEntry( TestResult& p_result, const char* p_name, const std::vector<byte>& p_input, const std::vector<byte>* p_original ) {
+        auto size = TestDatFile::inflatedSize( p_input );
+        if ( !size ) {
+            return false;
+        }
+
+        // Whole entry
+        std::vector<byte> expected( size, 0 );
+        std::vector<byte> actual( size, 0xcd );
+        uint32 expectedSize = size;
+        uint32 actualSize = size;
+        auto isExpectedOk = inflateReference( p_input, expectedSize, expected.data( ) );
+        auto isActualOk = inflateDatBuffer( p_input.size( ), p_input.data( ), actualSize, actual.data( ) );
+        if ( !TEST_CHECK( p_result, isExpectedOk == isActualOk ) ) {
+            ::fprintf( stderr, "  %s: gw2dattools %s, in-tree %s\n", p_name, isExpectedOk ? "inflated" : "failed", isActualOk ? "inflated" : "failed" );
+            return true;
+        }
+        if ( p_original ) {
+            TEST_CHECK( p_result, isActualOk );
+            if ( !TEST_CHECK( p_result, expectedSize == p_original->size( ) && expected == *p_original ) ) {
+                ::fprintf( stderr, "  %s: gw2dattools output differs from the original\n", p_name );
+            }
+        }
+        if ( !isExpectedOk ) {
+            return true;
+        }
+        TEST_CHECK( p_result, expectedSize == actualSize );
+        if ( !TEST_CHECK( p_result, ::memcmp( expected.data( ), actual.data( ), std::min( expectedSize, actualSize ) ) == 0 ) ) {
+            ::fprintf( stderr, "  %s: output differs\n", p_name );
+        }
+
+        // Leading bytes only, as peeked while scanning
+        uint32 peekSize = std::min( PeekSize, size );
+        actual.assign( peekSize, 0xcd );
+        if ( TEST_CHECK( p_result, inflateDatBuffer( p_input.size( ), p_input.data( ), peekSize, actual.data( ) ) ) ) {
+            TEST_CHECK( p_result, peekSize == std::min( PeekSize, expectedSize ) );
+            TEST_CHECK( p_result, ::memcmp( expected.data( ), actual.data( ), std::min( peekSize, expectedSize ) ) == 0 );
+        }
+
+        // Streamed, as exported
+        BufferDataSource source( p_input );
+        BufferDataSink sink;
+        uint32 streamedSize = 0;
+        if ( TEST_CHECK( p_result, inflateDatStream( source, sink, &streamedSize ) ) ) {
+            TEST_CHECK( p_result, streamedSize == expectedSize );
+            TEST_CHECK( p_result, sink.data.size( ) == expectedSize );
+            if ( !TEST_CHECK( p_result, ::memcmp( expected.data( ), sink.data.data( ), std::min<size_t>( sink.data.size( ), expectedSize ) ) == 0 ) ) {
+                ::fprintf( stderr, "  %s: streamed output differs\n", p_name );
+            }
+        }
+        return true;
+    }
+
+};
+
+int main( int p_argc, char** p_argv ) {
+    TestResult result;
+
+    // Synthetic entries, always at hand
+    uint numFixtures = 0;
+    for ( auto const& it : datCorpus( ) ) {
+        numFixtures += compareEntry( result, it.name, it.input, &it.output ) ? 1 : 0;
+    }
+    ::printf( "%u synthetic entries compared\n", numFixtures );
+    TEST_CHECK( result, numFixtures > 0 );
+
+    // Entries of a real .dat, if given
+    auto path = TestDatFile::path( p_argc, p_argv );
+    TestDatFile datFile;
+    if ( !path || !datFile.open( path ) ) {
+        ::printf( "No .dat given, set GW2_DAT to also compare its entries.\n" );
+        return result.exitCode( );
+    }
+
+    std::vector<byte> input;
+    uint numCompared = 0;
+    for ( auto entryNum : datFile.compressedEntries( MaxEntries ) ) {
+        if ( !datFile.readRaw( entryNum, input ) ) {
+            continue;
+        }
+        char name[32];
+        ::snprintf( name, sizeof( name ), "entry %u", entryNum );
+        numCompared += compareEntry( result, name, input, nullptr ) ? 1 : 0;
+    }
+
+    ::printf( "%u entries compared\n", numCompared );
+    TEST_CHECK( result, numCompared > 0 );
+    return result.exitCode( );
+}
@@ -0,0 +1,176 @@
+/** \file       test/DrawListTest.cpp
+ *  \brief      Counts the draw calls and texture binds of a model frame, before and after the draw list.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Viewers/ModelViewer/DrawList.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Mesh of the test model. */
+    struct TestMesh {
+        TextureSet                  textures;
+        uint                        indexCount;
+    };
+
+    /** File ids of textures that failed to load. */
+    const uint MissingTexture = 666;
+
+    /** Gets the GL texture of a file id, as the texture manager would. */
+    uint getTexture( uint p_fileId ) {
+        return ( p_fileId == MissingTexture ) ? 0 : p_fileId + 1000;
+    }
+
+    /** Counts a frame the way models were drawn before the draw list: one
+    *  call per mesh, in file order, binding all of its textures each time. */
+    DrawStats countBefore( const std::vector<TestMesh>& p_meshes ) {
+        DrawStats stats;
+        for ( auto& mesh : p_meshes ) {
+            if ( mesh.textures.diffuseMap && getTexture( mesh.textures.diffuseMap ) ) {
+                stats.textureBinds++;
+            }
+            if ( mesh.textures.normalMap && getTexture( mesh.textures.normalMap ) ) {
+                stats.textureBinds++;
+            }
+            if ( !mesh.textures.lightMap || getTexture( mesh.textures.lightMap ) ) {
+                stats.textureBinds++;
+            }
+            stats.drawCalls++;
+        }
+        return stats;
+    }
+
+};
+
+int main( ) {
+    TestResult result;
+    std::mt19937 random( 0x44524157 );
+
+    // Materials sharing normal maps, some without light map, one with a
+    // texture that failed to load, and no material at all
+    const TextureSet materials[] = {
+        { 1, 2, 3 }, { 4, 2, 3 }, { 5, 6, 0 }, { 7, 6, 0 },
+        { 8, 9, 10 }, { 11, MissingTexture, 0 }, { 12, 2, 0 }, { 0, 0, 0 },
+    };
+    std::vector<TestMesh> meshes;
+    for ( uint i = 0; i < 64; i++ ) {
+        TestMesh mesh = { materials[random( ) % ArraySize( materials )], static_cast<uint>( random( ) % 100 ) * 3 };
+        meshes.push_back( mesh );
+    }
+    meshes[5].indexCount = 0;
+
+    // After: packed by texture set, then drawn from the list
+    std::vector<TextureSet> meshTextures;
+    for ( auto& mesh : meshes ) {
+        meshTextures.push_back( mesh.textures );
+    }
+    auto order = DrawList::packingOrder( meshTextures );
+    DrawList drawList;
+    std::vector<uint> firstIndices( meshes.size( ) );
+    uint numIndices = 0;
+    for ( auto meshIndex : order ) {
+        firstIndices[meshIndex] = numIndices;
+        numIndices += meshes[meshIndex].indexCount;
+        drawList.add( meshes[meshIndex].textures, meshes[meshIndex].indexCount );
+    }
+
+    std::vector<uint> bound( TextureBindings::NumUnits, ~0u );
+    uint numBinds = 0;
+    uint numRedundant = 0;
+    DrawStats after;
+    TextureBindings bindings;
+    std::vector<TextureSet> drawnWith( numIndices );
+    for ( auto& command : drawList.commands( ) ) {
+        bindings.bind( command.textures, &getTexture, [&]( uint p_unit, uint p_textureId ) {
+            numRedundant += ( bound[p_unit] == p_textureId ) ? 1 : 0;
+            bound[p_unit] = p_textureId;
+            numBinds++;
+        }, after );
+        after.drawCalls++;
+
+        // What a shader would sample with the bound textures
+        for ( uint i = command.firstIndex; i < command.firstIndex + command.indexCount && i < numIndices; i++ ) {
+            drawnWith[i] = { bound[0], bound[1], bound[2] };
+        }
+    }
+
+    DrawStats before = countBefore( meshes );
+    ::printf( "Per frame, %u meshes: %u -> %u draw calls, %u -> %u texture binds\n", static_cast<uint>( meshes.size( ) ),
+        before.drawCalls, after.drawCalls, before.textureBinds, after.textureBinds );
+
+    // One call per texture set of the meshes with indices
+    std::vector<TextureSet> usedSets;
+    for ( auto& mesh : meshes ) {
+        if ( mesh.indexCount && std::find( usedSets.begin( ), usedSets.end( ), mesh.textures ) == usedSets.end( ) ) {
+            usedSets.push_back( mesh.textures );
+        }
+    }
+    TEST_CHECK( result, after.drawCalls == usedSets.size( ) );
+    TEST_CHECK( result, after.drawCalls < before.drawCalls );
+    TEST_CHECK( result, after.textureBinds < before.textureBinds );
+    TEST_CHECK( result, after.textureBinds == numBinds && numRedundant == 0 );
+
+    // Calls cover all indices once, in order
+    uint next = 0;
+    for ( auto& command : drawList.commands( ) ) {
+        TEST_CHECK( result, command.firstIndex == next && command.indexCount > 0 );
+        next = command.firstIndex + command.indexCount;
+    }
+    TEST_CHECK( result, next == numIndices );
+
+    // Each mesh is drawn with its own textures, or with what the units held
+    // for those that did not load
+    uint numWrong = 0;
+    for ( uint i = 0; i < meshes.size( ); i++ ) {
+        auto& textures = meshes[i].textures;
+        for ( uint j = firstIndices[i]; j < firstIndices[i] + meshes[i].indexCount; j++ ) {
+            auto& drawn = drawnWith[j];
+            if ( ( textures.diffuseMap && getTexture( textures.diffuseMap ) && drawn.diffuseMap != getTexture( textures.diffuseMap ) )
+                || ( textures.normalMap && getTexture( textures.normalMap ) && drawn.normalMap != getTexture( textures.normalMap ) )
+                || drawn.lightMap != ( textures.lightMap ? getTexture( textures.lightMap ) : 0 ) ) {
+                numWrong++;
+            }
+        }
+    }
+    TEST_CHECK( result, numWrong == 0 );
+
+    // The same frame again binds as much, each frame starts unbound
+    DrawStats again;
+    TextureBindings nextFrame;
+    for ( auto& command : drawList.commands( ) ) {
+        nextFrame.bind( command.textures, &getTexture, []( uint, uint ) { }, again );
+        again.drawCalls++;
+    }
+    TEST_CHECK( result, again.drawCalls == after.drawCalls && again.textureBinds == after.textureBinds );
+
+    return result.exitCode( );
+}
@@ -0,0 +1,118 @@
+/** \file       test/HuffmanWriter.h
+ *  \brief      Contains the bit writer and Huffman codes of the test encoders.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef TEST_HUFFMANWRITER_H_INCLUDED
+#define TEST_HUFFMANWRITER_H_INCLUDED
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace gw2b {
+
+    /** Writes a bit stream the way BitReader reads it: most significant bit
+    *  first, into little endian 32-bit words. In .dat entries the last word
+    *  of every 64 KiB block is a checksum, written as 0. */
+    class BitWriter {
+        enum {
+            BlockWords = 0x4000,    /**< Amount of words in a 64 KiB block, checksum included. */
+        };
+
+        std::vector<byte>           m_output;
+        uint32                      m_word = 0;
+        uint                        m_count = 0;
+        bool                        m_hasChecksums;
+    public:
+        /** Constructor.
+        *  \param[in]  p_hasChecksums   true to leave room for the block checksums. */
+        BitWriter( bool p_hasChecksums = true )
+            : m_hasChecksums( p_hasChecksums ) {
+        }
+
+        /** Writes bits.
+        *  \param[in]  p_value      The bits, right aligned.
+        *  \param[in]  p_bits       Amount of bits to write, 0 to 32. */
+        void write( uint32 p_value, uint p_bits ) {
+            while ( p_bits ) {
+                auto count = std::min( p_bits, 32 - m_count );
+                auto bits = static_cast<uint32>( ( static_cast<uint64>( p_value ) >> ( p_bits - count ) ) & ( ( 1ull << count ) - 1 ) );
+                m_word |= static_cast<uint32>( static_cast<uint64>( bits ) << ( 32 - m_count - count ) );
+                m_count += count;
+                p_bits -= count;
+                if ( m_count == 32 ) {
+                    this->writeWord( m_word );
+                    m_word = 0;
+                    m_count = 0;
+                }
+            }
+        }
+        /** Pads the last word with zeros. */
+        void flush( ) {
+            if ( m_count ) {
+                this->write( 0, 32 - m_count );
+            }
+        }
+        /** Gets the written words. Flush first.
+        *  \return std::vector<byte>&   The words. */
+        const std::vector<byte>& data( ) const {
+            return m_output;
+        }
+
+    private:
+        void writeWord( uint32 p_word ) {
+            if ( m_hasChecksums && ( m_output.size( ) / 4 ) % BlockWords == BlockWords - 1 ) {
+                m_output.insert( m_output.end( ), 4, 0 );
+            }
+            byte bytes[4];
+            ::memcpy( bytes, &p_word, sizeof( bytes ) );
+            m_output.insert( m_output.end( ), bytes, bytes + sizeof( bytes ) );
+        }
+    }; // class BitWriter
+
+    /** Gets the codes HuffmanTree::build assigns to code lengths: per length,
+    *  shortest first, the smallest symbol of each length gets the highest
+    *  code.
+    *  \param[in]  p_codeBits   Code length of every symbol, 0 if unused.
+    *  \param[in]  p_numSymbols Amount of symbols.
+    *  \return std::vector<uint32>  Code of every symbol, right aligned. */
+    inline std::vector<uint32> huffmanCodes( const uint8* p_codeBits, uint p_numSymbols ) {
+        std::vector<uint32> codes( p_numSymbols, 0 );
+        int64 code = 0;
+        for ( uint bits = 1; bits < 32; bits++ ) {
+            code = code * 2 + 1;
+            for ( uint symbol = 0; symbol < p_numSymbols; symbol++ ) {
+                if ( p_codeBits[symbol] == bits ) {
+                    codes[symbol] = static_cast<uint32>( code );
+                    code--;
+                }
+            }
+        }
+        return codes;
+    }
+
+}; // namespace gw2b
+
+#endif // TEST_HUFFMANWRITER_H_INCLUDED
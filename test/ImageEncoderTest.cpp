@@ -0,0 +1,286 @@
+/** \file       test/ImageEncoderTest.cpp
+ *  \brief      Checks that encoded PNG and QOI images decode back to their pixels.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "stdafx.h"
+
+#include <cstring>
+#include <vector>
+#include <wx/image.h>
+#include <wx/init.h>
+#include <wx/mstream.h>
+
+#include "Util/ImageEncoder.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** QOI chunk types, counted while decoding. */
+    enum QoiOp {
+        QO_RGB,
+        QO_RGBA,
+        QO_Index,
+        QO_Diff,
+        QO_Luma,
+        QO_Run,
+        QO_Count,
+    };
+
+    const char* const QoiOpNames[] = { "QOI_OP_RGB", "QOI_OP_RGBA", "QOI_OP_INDEX", "QOI_OP_DIFF", "QOI_OP_LUMA", "QOI_OP_RUN" };
+
+    /** Kinds of test images, each favoring some QOI chunks. */
+    enum ImageKind {
+        IK_Noise,       // Random pixels: RGB and RGBA
+        IK_Gradient,    // Small steps: diffs and luma
+        IK_Flat,        // Long spans of one color: runs past 62 pixels
+        IK_Palette,     // A few colors: the index
+        IK_Count,
+    };
+
+    const char* const ImageKindNames[] = { "noise", "gradient", "flat", "palette" };
+
+    struct TestImage {
+        wxSize              size;
+        std::vector<byte>   colors;
+        std::vector<byte>   alphas;     // Empty without alpha
+    };
+
+    void testImage( ImageKind p_kind, const wxSize& p_size, bool p_hasAlpha, TestRandom& p_random, TestImage& po_image ) {
+        const size_t numPixels = static_cast<size_t>( p_size.x ) * p_size.y;
+        po_image.size = p_size;
+        po_image.colors.resize( numPixels * 3 );
+        po_image.alphas.assign( p_hasAlpha ? numPixels : 0, 0xff );
+
+        const byte palette[5][4] = {
+            { 0x00, 0x00, 0x00, 0xff }, { 0xff, 0xff, 0xff, 0xff }, { 0x80, 0x20, 0x10, 0x40 },
+            { 0x12, 0x34, 0x56, 0x00 }, { 0xfe, 0x80, 0x01, 0xc0 },
+        };
+        byte pixel[4] = { 0x40, 0x80, 0xc0, 0xff };
+
+        for ( size_t i = 0; i < numPixels; i++ ) {
+            switch ( p_kind ) {
+            case IK_Noise:
+                for ( auto& it : pixel ) {
+                    it = static_cast<byte>( p_random.next( ) );
+                }
+                break;
+            case IK_Gradient:
+                // Steps within the diff range, now and then within the luma range
+                for ( uint c = 0; c < 3; c++ ) {
+                    pixel[c] += static_cast<byte>( ( i % 5 ) ? p_random.range( 0, 3 ) - 2 : p_random.range( 0, 15 ) );
+                }
+                if ( !( i % 97 ) ) {
+                    pixel[3] -= 8;
+                }
+                break;
+            case IK_Flat:
+                // Spans up to 150 pixels, so runs get split at 62
+                if ( !p_random.range( 0, 150 ) ) {
+                    ::memcpy( pixel, palette[p_random.range( 0, 4 )], 4 );
+                }
+                break;
+            case IK_Palette:
+                ::memcpy( pixel, palette[p_random.range( 0, 4 )], 4 );
+                break;
+            default:
+                break;
+            }
+
+            ::memcpy( &po_image.colors[i * 3], pixel, 3 );
+            if ( p_hasAlpha ) {
+                po_image.alphas[i] = pixel[3];
+            }
+        }
+    }
+
+    uint32 readBigEndian( const byte* p_data ) {
+        return ( static_cast<uint32>( p_data[0] ) << 24 ) | ( p_data[1] << 16 ) | ( p_data[2] << 8 ) | p_data[3];
+    }
+
+    /** Decodes a QOI file as the specification describes it, independently of
+    *  the encoder, counting the chunks of each type.
+    *  \return bool    true if the file is valid, false if not. */
+    bool decodeQoi( const Array<byte>& p_file, wxSize& po_size, uint& po_channels, std::vector<byte>& po_rgba, uint64* po_counts ) {
+        const byte* data = p_file.GetPointer( );
+        const size_t size = p_file.GetSize( );
+        static const byte endMarker[] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+        if ( size < 14 + sizeof( endMarker ) || ::memcmp( data, "qoif", 4 ) ) {
+            return false;
+        }
+        po_size.Set( readBigEndian( data + 4 ), readBigEndian( data + 8 ) );
+        po_channels = data[12];
+        if ( ( po_channels != 3 && po_channels != 4 ) || data[13] > 1 ) {
+            return false;
+        }
+
+        const size_t numPixels = static_cast<size_t>( po_size.x ) * po_size.y;
+        const size_t end = size - sizeof( endMarker );
+        po_rgba.resize( numPixels * 4 );
+
+        byte index[64][4];
+        ::memset( index, 0, sizeof( index ) );
+        byte pixel[4] = { 0, 0, 0, 0xff };
+        size_t position = 14;
+        uint run = 0;
+
+        for ( size_t i = 0; i < numPixels; i++ ) {
+            if ( run ) {
+                run--;
+            } else {
+                if ( position >= end ) {
+                    return false;
+                }
+                byte tag = data[position++];
+                if ( tag == 0xfe ) {
+                    if ( position + 3 > end ) {
+                        return false;
+                    }
+                    ::memcpy( pixel, data + position, 3 );
+                    position += 3;
+                    po_counts[QO_RGB]++;
+                } else if ( tag == 0xff ) {
+                    if ( position + 4 > end ) {
+                        return false;
+                    }
+                    ::memcpy( pixel, data + position, 4 );
+                    position += 4;
+                    po_counts[QO_RGBA]++;
+                } else if ( ( tag >> 6 ) == 0 ) {
+                    ::memcpy( pixel, index[tag], 4 );
+                    po_counts[QO_Index]++;
+                } else if ( ( tag >> 6 ) == 1 ) {
+                    pixel[0] += static_cast<byte>( ( ( tag >> 4 ) & 3 ) - 2 );
+                    pixel[1] += static_cast<byte>( ( ( tag >> 2 ) & 3 ) - 2 );
+                    pixel[2] += static_cast<byte>( ( tag & 3 ) - 2 );
+                    po_counts[QO_Diff]++;
+                } else if ( ( tag >> 6 ) == 2 ) {
+                    if ( position >= end ) {
+                        return false;
+                    }
+                    byte second = data[position++];
+                    int dg = ( tag & 0x3f ) - 32;
+                    pixel[0] += static_cast<byte>( dg + ( second >> 4 ) - 8 );
+                    pixel[1] += static_cast<byte>( dg );
+                    pixel[2] += static_cast<byte>( dg + ( second & 0xf ) - 8 );
+                    po_counts[QO_Luma]++;
+                } else {
+                    // Runs of 63 and 64 would be the RGB and RGBA tags
+                    run = tag & 0x3f;
+                    po_counts[QO_Run]++;
+                }
+                auto hash = ( pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11 ) % 64;
+                ::memcpy( index[hash], pixel, 4 );
+            }
+            ::memcpy( &po_rgba[i * 4], pixel, 4 );
+        }
+
+        // Every chunk is used, then the end marker
+        return !run && position == end && !::memcmp( data + end, endMarker, sizeof( endMarker ) );
+    }
+
+    bool samePixels( const TestImage& p_image, const std::vector<byte>& p_rgba ) {
+        const size_t numPixels = static_cast<size_t>( p_image.size.x ) * p_image.size.y;
+        for ( size_t i = 0; i < numPixels; i++ ) {
+            byte alpha = p_image.alphas.empty( ) ? 0xff : p_image.alphas[i];
+            if ( ::memcmp( &p_rgba[i * 4], &p_image.colors[i * 3], 3 ) || p_rgba[i * 4 + 3] != alpha ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Decodes a PNG file with wxImage, the way the browser reads PNG files.
+    *  \return bool    true if the pixels and alpha match the image, false if not. */
+    bool checkPng( const Array<byte>& p_file, const TestImage& p_image ) {
+        wxMemoryInputStream stream( p_file.GetPointer( ), p_file.GetSize( ) );
+        wxImage image;
+        if ( !image.LoadFile( stream, wxBITMAP_TYPE_PNG ) || image.GetSize( ) != p_image.size ) {
+            return false;
+        }
+        if ( ::memcmp( image.GetData( ), p_image.colors.data( ), p_image.colors.size( ) ) ) {
+            return false;
+        }
+        if ( p_image.alphas.empty( ) ) {
+            return !image.HasAlpha( );
+        }
+        return image.HasAlpha( ) && !::memcmp( image.GetAlpha( ), p_image.alphas.data( ), p_image.alphas.size( ) );
+    }
+
+    /** Sizes of the test images: single pixel, odd, and rows of more than 62 pixels. */
+    const wxSize Sizes[] = { wxSize( 1, 1 ), wxSize( 7, 5 ), wxSize( 300, 1 ), wxSize( 64, 64 ) };
+    /** PNG levels: no filter, the fixed Up filter, and filters picked per row. */
+    const int PngLevels[] = { 0, IEPL_Fastest, IEPL_Default, 6, IEPL_Smallest };
+
+};
+
+int main( ) {
+    wxInitializer initializer;
+    wxImage::AddHandler( new wxPNGHandler );
+
+    TestResult result;
+    TestRandom random( 0x514f4946 );
+    uint64 counts[QO_Count] = { };
+
+    for ( uint kind = 0; kind < IK_Count; kind++ ) {
+        for ( auto const& size : Sizes ) {
+            for ( bool hasAlpha : { false, true } ) {
+                TestImage image;
+                testImage( static_cast<ImageKind>( kind ), size, hasAlpha, random, image );
+                auto alphas = hasAlpha ? image.alphas.data( ) : nullptr;
+
+                Array<byte> qoi;
+                wxSize qoiSize;
+                uint channels = 0;
+                std::vector<byte> rgba;
+                bool qoiOk = ImageEncoder::encode( size, image.colors.data( ), alphas, IFF_QOI, 0, qoi )
+                    && decodeQoi( qoi, qoiSize, channels, rgba, counts )
+                    && qoiSize == size && channels == ( hasAlpha ? 4u : 3u ) && samePixels( image, rgba );
+                TEST_CHECK( result, qoiOk );
+
+                for ( auto level : PngLevels ) {
+                    Array<byte> png;
+                    bool pngOk = ImageEncoder::encode( size, image.colors.data( ), alphas, IFF_PNG, level, png ) && checkPng( png, image );
+                    TEST_CHECK( result, pngOk );
+                    if ( !pngOk ) {
+                        ::fprintf( stderr, "PNG level %d of %s %dx%d%s differs\n", level, ImageKindNames[kind], size.x, size.y, hasAlpha ? " with alpha" : "" );
+                    }
+                }
+                if ( !qoiOk ) {
+                    ::fprintf( stderr, "QOI of %s %dx%d%s differs\n", ImageKindNames[kind], size.x, size.y, hasAlpha ? " with alpha" : "" );
+                }
+            }
+        }
+    }
+
+    // The images are made so the encoder writes every chunk type
+    for ( uint op = 0; op < QO_Count; op++ ) {
+        ::printf( "%-12s  %llu chunks\n", QoiOpNames[op], static_cast<unsigned long long>( counts[op] ) );
+        TEST_CHECK( result, counts[op] > 0 );
+    }
+
+    return result.exitCode( );
+}
@@ -0,0 +1,174 @@
+/** \file       test/MeshOptimizerTest.cpp
+ *  \brief      Checks that optimized meshes use the vertex cache better and draw the same triangles.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Viewers/ModelViewer/MeshOptimizer.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    typedef std::array<int, 3> Corners;
+
+    /** Builds a bumpy grid, two triangles per cell in rows. The u of each
+    *  vertex is its index, so vertices can be told apart once reordered.
+    *  \param[in]  p_size       Vertices along each side, at least 2.
+    *  \param[out] po_mesh      Receives the grid. */
+    void buildGrid( uint p_size, GW2Mesh& po_mesh ) {
+        po_mesh.vertices.clear( );
+        po_mesh.triangles.clear( );
+        for ( uint z = 0; z < p_size; z++ ) {
+            for ( uint x = 0; x < p_size; x++ ) {
+                Vertex vertex;
+                vertex.position = glm::vec3( x, std::sin( x * 0.3f ) * std::cos( z * 0.2f ), z );
+                vertex.normal = glm::vec3( 0.0f, 1.0f, 0.0f );
+                vertex.uv = glm::vec2( static_cast<float>( po_mesh.vertices.size( ) ), 0.0f );
+                po_mesh.vertices.push_back( vertex );
+            }
+        }
+        for ( uint z = 0; z + 1 < p_size; z++ ) {
+            for ( uint x = 0; x + 1 < p_size; x++ ) {
+                uint i = z * p_size + x;
+                Triangle first;
+                first.index1 = static_cast<uint16>( i );
+                first.index2 = static_cast<uint16>( i + p_size );
+                first.index3 = static_cast<uint16>( i + 1 );
+                Triangle second;
+                second.index1 = static_cast<uint16>( i + 1 );
+                second.index2 = static_cast<uint16>( i + p_size );
+                second.index3 = static_cast<uint16>( i + p_size + 1 );
+                po_mesh.triangles.push_back( first );
+                po_mesh.triangles.push_back( second );
+            }
+        }
+    }
+
+    /** Gets the triangles of a mesh by the vertices they use, each rotated
+    *  to start at its smallest vertex so the winding is kept, then sorted.
+    *  \param[in]  p_mesh       Mesh to list the triangles of.
+    *  \return std::vector<Corners>     The triangles. */
+    std::vector<Corners> triangleSet( const GW2Mesh& p_mesh ) {
+        std::vector<Corners> retval;
+        for ( auto& triangle : p_mesh.triangles ) {
+            Corners corners;
+            for ( uint i = 0; i < 3; i++ ) {
+                corners[i] = static_cast<int>( p_mesh.vertices[triangle.indices[i]].uv.x );
+            }
+            std::rotate( corners.begin( ), std::min_element( corners.begin( ), corners.end( ) ), corners.end( ) );
+            retval.push_back( corners );
+        }
+        std::sort( retval.begin( ), retval.end( ) );
+        return retval;
+    }
+
+    /** Gets the vertices of a mesh by the index they had, sorted. */
+    std::vector<int> vertexSet( const GW2Mesh& p_mesh ) {
+        std::vector<int> retval;
+        for ( auto& vertex : p_mesh.vertices ) {
+            retval.push_back( static_cast<int>( vertex.uv.x ) );
+        }
+        std::sort( retval.begin( ), retval.end( ) );
+        return retval;
+    }
+
+};
+
+int main( ) {
+    TestResult result;
+    std::mt19937 random( 0x41434d52 );
+
+    // In rows as modelled, shuffled as if exported without care, and
+    // shuffled with degenerate triangles and unused vertices
+    std::vector<GW2Mesh> meshes( 3 );
+    const char* names[] = { "rows", "shuffled", "shuffled, degenerate" };
+    for ( auto& mesh : meshes ) {
+        buildGrid( 100, mesh );
+    }
+    std::shuffle( meshes[1].triangles.begin( ), meshes[1].triangles.end( ), random );
+    for ( uint i = 0; i < 50; i++ ) {
+        Triangle triangle;
+        triangle.index1 = triangle.index2 = static_cast<uint16>( random( ) % meshes[2].vertices.size( ) );
+        triangle.index3 = static_cast<uint16>( random( ) % meshes[2].vertices.size( ) );
+        meshes[2].triangles.push_back( triangle );
+    }
+    for ( uint i = 0; i < 20; i++ ) {
+        Vertex vertex;
+        vertex.position = glm::vec3( -1.0f );
+        vertex.normal = glm::vec3( 0.0f, 1.0f, 0.0f );
+        vertex.uv = glm::vec2( static_cast<float>( meshes[2].vertices.size( ) ), 0.0f );
+        meshes[2].vertices.push_back( vertex );
+    }
+    std::shuffle( meshes[2].triangles.begin( ), meshes[2].triangles.end( ), random );
+
+    std::vector<std::vector<Corners>> triangles;
+    std::vector<std::vector<int>> vertices;
+    std::vector<VertexCacheStats> before;
+    for ( auto& mesh : meshes ) {
+        triangles.push_back( triangleSet( mesh ) );
+        vertices.push_back( vertexSet( mesh ) );
+        before.push_back( MeshOptimizer::analyze( mesh ) );
+    }
+
+    VertexCacheStats totalBefore;
+    VertexCacheStats totalAfter;
+    MeshOptimizer::optimize( meshes.data( ), static_cast<uint>( meshes.size( ) ), totalBefore, totalAfter );
+
+    for ( uint i = 0; i < meshes.size( ); i++ ) {
+        auto after = MeshOptimizer::analyze( meshes[i] );
+        ::printf( "%-22s ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", names[i], before[i].acmr( ), after.acmr( ), before[i].atvr( ), after.atvr( ) );
+
+        // Same triangles, same winding, same vertices
+        TEST_CHECK( result, triangleSet( meshes[i] ) == triangles[i] );
+        TEST_CHECK( result, vertexSet( meshes[i] ) == vertices[i] );
+        TEST_CHECK( result, after.numTriangles == before[i].numTriangles );
+
+        // Never worse, and much better where the order was poor
+        TEST_CHECK( result, after.acmr( ) <= before[i].acmr( ) );
+        if ( i > 0 ) {
+            TEST_CHECK( result, after.acmr( ) < before[i].acmr( ) * 0.5 );
+        }
+    }
+    TEST_CHECK( result, totalBefore.numTransforms == before[0].numTransforms + before[1].numTransforms + before[2].numTransforms );
+    TEST_CHECK( result, totalAfter.acmr( ) < totalBefore.acmr( ) );
+
+    // Meshes with indices out of range are left as they are
+    GW2Mesh broken;
+    buildGrid( 4, broken );
+    broken.triangles[3].index2 = static_cast<uint16>( broken.vertices.size( ) );
+    auto brokenTriangles = broken.triangles;
+    MeshOptimizer::optimize( broken );
+    TEST_CHECK( result, ::memcmp( broken.triangles.data( ), brokenTriangles.data( ), brokenTriangles.size( ) * sizeof( Triangle ) ) == 0 );
+
+    return result.exitCode( );
+}
@@ -0,0 +1,113 @@
+/** \file       test/PixelConverterBenchmark.cpp
+ *  \brief      Measures the pixel kernels against the plain C++ ones.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <random>
+#include <vector>
+
+#include "Util/PixelConverter.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Pixels converted per run, a 4096x4096 image. */
+    const uint NumPixels = 4096 * 4096;
+    /** Each kernel runs this many times, the fastest run counts. */
+    const uint NumRuns = 5;
+
+    /** Times a kernel of a converter, returns the fastest run in seconds. */
+    template <typename Run>
+    double bestTime( const PixelConverter& p_kernels, Run p_run ) {
+        double best = 0.0;
+        for ( uint run = 0; run < NumRuns; run++ ) {
+            Stopwatch stopwatch;
+            p_run( p_kernels );
+            auto time = stopwatch.seconds( );
+            if ( !run || time < best ) {
+                best = time;
+            }
+        }
+        return best;
+    }
+
+};
+
+int main( ) {
+    auto& converter = pixelConverter( );
+    auto& reference = pixelReferenceConverter( );
+
+    std::mt19937 random( 0x50495845 );
+    std::vector<uint8> pixels( static_cast<size_t>( NumPixels ) * 4 );
+    std::vector<uint8> alphas( NumPixels );
+    for ( auto& it : pixels ) {
+        it = static_cast<uint8>( random( ) );
+    }
+    for ( auto& it : alphas ) {
+        it = static_cast<uint8>( random( ) );
+    }
+    std::vector<uint8> output( static_cast<size_t>( NumPixels ) * 4 );
+
+    struct Kernel {
+        const char*                                 name;
+        void ( *run )( const PixelConverter&, const uint8*, const uint8*, uint8* );
+    };
+    const Kernel kernels[] = {
+        { "swizzle", [] ( const PixelConverter& p_kernels, const uint8* p_pixels, const uint8*, uint8* po_output ) {
+            const uint8 order[] = { 2, 1, 0, 3 };
+            p_kernels.swizzle( p_pixels, po_output, NumPixels, order );
+        } },
+        { "splitAlpha", [] ( const PixelConverter& p_kernels, const uint8* p_pixels, const uint8*, uint8* po_output ) {
+            const uint8 order[] = { 2, 1, 0, 3 };
+            p_kernels.splitAlpha( p_pixels, po_output, po_output + NumPixels * 3, NumPixels, order );
+        } },
+        { "mergeAlpha", [] ( const PixelConverter& p_kernels, const uint8* p_pixels, const uint8* p_alphas, uint8* po_output ) {
+            p_kernels.mergeAlpha( p_pixels, p_alphas, po_output, NumPixels, true );
+        } },
+        { "expandGray", [] ( const PixelConverter& p_kernels, const uint8* p_pixels, const uint8*, uint8* po_output ) {
+            p_kernels.expandGray( p_pixels, po_output, NumPixels, 4 );
+        } },
+        { "premultiply", [] ( const PixelConverter& p_kernels, const uint8*, const uint8* p_alphas, uint8* po_output ) {
+            p_kernels.premultiply( po_output, p_alphas, NumPixels );
+        } },
+    };
+
+    ::printf( "%u pixels per run, best of %u runs\n", NumPixels, NumRuns );
+    ::printf( "kernel        %s Mpixels/s   %s Mpixels/s   speedup\n", reference.name, converter.name );
+    for ( auto const& kernel : kernels ) {
+        auto run = [&] ( const PixelConverter& p_kernels ) {
+            kernel.run( p_kernels, pixels.data( ), alphas.data( ), output.data( ) );
+        };
+        auto referenceTime = bestTime( reference, run );
+        auto converterTime = bestTime( converter, run );
+        ::printf( "%-12s  %14.1f   %17.1f   %6.2fx\n", kernel.name,
+            referenceTime > 0.0 ? NumPixels / referenceTime / 1e6 : 0.0,
+            converterTime > 0.0 ? NumPixels / converterTime / 1e6 : 0.0,
+            converterTime > 0.0 ? referenceTime / converterTime : 0.0 );
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+/** \file       test/PixelConverterTest.cpp
+ *  \brief      Checks that the vector pixel kernels match the plain C++ ones bit for bit.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Util/PixelConverter.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Bytes past the output of a kernel, which must stay untouched. */
+    const uint Padding = 64;
+
+    /** Amounts of pixels converted, around the vector widths. */
+    const uint Counts[] = { 0, 1, 3, 4, 5, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 1021 };
+
+    /** Runs a kernel of both converters into padded buffers and compares them.
+    *  \param[in]  p_size       Size of the output, in bytes, without the padding.
+    *  \param[in]  p_run        Runs a kernel into the given buffer. */
+    template <typename Run>
+    bool sameOutput( size_t p_size, Run p_run ) {
+        std::vector<uint8> expected( p_size + Padding, 0xcd );
+        std::vector<uint8> actual( p_size + Padding, 0xcd );
+        p_run( pixelReferenceConverter( ), expected.data( ) );
+        p_run( pixelConverter( ), actual.data( ) );
+        return expected == actual;
+    }
+
+};
+
+int main( ) {
+    auto& converter = pixelConverter( );
+    auto& reference = pixelReferenceConverter( );
+    ::printf( "Comparing %s kernels with %s\n", converter.name, reference.name );
+
+    TestResult result;
+    std::mt19937 random( 0x50495845 );
+
+    // Fixed orders, then random ones with some 0xff fills
+    std::vector<std::vector<uint8>> orders = {
+        { 0, 1, 2, 3 }, { 2, 1, 0, 3 }, { 0, 1, 2, 4 }, { 3, 3, 3, 3 }, { 4, 4, 4, 4 },
+    };
+    for ( uint i = 0; i < 32; i++ ) {
+        orders.push_back( { static_cast<uint8>( random( ) % 5 ), static_cast<uint8>( random( ) % 5 ),
+            static_cast<uint8>( random( ) % 5 ), static_cast<uint8>( random( ) % 5 ) } );
+    }
+
+    for ( auto count : Counts ) {
+        std::vector<uint8> pixels( count * 4 + Padding );
+        std::vector<uint8> alphas( count + Padding );
+        for ( auto& it : pixels ) {
+            it = static_cast<uint8>( random( ) );
+        }
+        for ( auto& it : alphas ) {
+            it = static_cast<uint8>( random( ) );
+        }
+        auto input = pixels.data( );
+
+        for ( auto const& order : orders ) {
+            auto isSame = TEST_CHECK( result, sameOutput( count * 4, [&] ( const PixelConverter& p_kernels, uint8* po_output ) {
+                p_kernels.swizzle( input, po_output, count, order.data( ) );
+            } ) );
+            if ( !isSame ) {
+                ::fprintf( stderr, "  swizzle: %u pixels, order %u %u %u %u\n", count, order[0], order[1], order[2], order[3] );
+            }
+
+            // Colors and alphas share one buffer, alphas after the colors
+            isSame = TEST_CHECK( result, sameOutput( count * 4, [&] ( const PixelConverter& p_kernels, uint8* po_output ) {
+                p_kernels.splitAlpha( input, po_output, po_output + count * 3, count, order.data( ) );
+            } ) );
+            isSame = TEST_CHECK( result, sameOutput( count * 3, [&] ( const PixelConverter& p_kernels, uint8* po_output ) {
+                p_kernels.splitAlpha( input, po_output, nullptr, count, order.data( ) );
+            } ) ) && isSame;
+            if ( !isSame ) {
+                ::fprintf( stderr, "  splitAlpha: %u pixels, order %u %u %u %u\n", count, order[0], order[1], order[2], order[3] );
+            }
+        }
+
+        for ( uint i = 0; i < 4; i++ ) {
+            auto alphaInput = ( i & 1 ) ? alphas.data( ) : nullptr;
+            auto swapRedBlue = ( i & 2 ) != 0;
+            auto isSame = TEST_CHECK( result, sameOutput( count * 4, [&] ( const PixelConverter& p_kernels, uint8* po_output ) {
+                p_kernels.mergeAlpha( input, alphaInput, po_output, count, swapRedBlue );
+            } ) );
+            if ( !isSame ) {
+                ::fprintf( stderr, "  mergeAlpha: %u pixels, %s alphas, %s\n", count, alphaInput ? "with" : "without", swapRedBlue ? "swapped" : "not swapped" );
+            }
+        }
+
+        for ( uint pixelSize = 3; pixelSize <= 4; pixelSize++ ) {
+            auto isSame = TEST_CHECK( result, sameOutput( count * pixelSize, [&] ( const PixelConverter& p_kernels, uint8* po_output ) {
+                p_kernels.expandGray( input, po_output, count, pixelSize );
+            } ) );
+            if ( !isSame ) {
+                ::fprintf( stderr, "  expandGray: %u pixels of %u bytes\n", count, pixelSize );
+            }
+        }
+
+        // Premultiplies in place, so starts from a copy of the colors
+        auto isSame = TEST_CHECK( result, sameOutput( count * 3, [&] ( const PixelConverter& p_kernels, uint8* po_output ) {
+            std::copy( input, input + count * 3, po_output );
+            p_kernels.premultiply( po_output, alphas.data( ), count );
+        } ) );
+        if ( !isSame ) {
+            ::fprintf( stderr, "  premultiply: %u pixels\n", count );
+        }
+    }
+
+    // Every product of a color and an alpha
+    std::vector<uint8> colors( 256 * 256 * 3 );
+    std::vector<uint8> productAlphas( 256 * 256 );
+    for ( uint i = 0; i < 256 * 256; i++ ) {
+        colors[i * 3] = colors[i * 3 + 1] = colors[i * 3 + 2] = static_cast<uint8>( i & 0xff );
+        productAlphas[i] = static_cast<uint8>( i >> 8 );
+    }
+    auto expected = colors;
+    reference.premultiply( expected.data( ), productAlphas.data( ), 256 * 256 );
+    converter.premultiply( colors.data( ), productAlphas.data( ), 256 * 256 );
+    TEST_CHECK( result, colors == expected );
+
+    return result.exitCode( );
+}
@@ -0,0 +1,78 @@
+/** \file       test/TangentBenchmark.cpp
+ *  \brief      Times the tangents of indexed meshes against the old expand and weld path.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <vector>
+
+#include "Viewers/ModelViewer/Tangents.h"
+
+#include "TangentReference.h"
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Vertices along each side of the grid, about a million triangles. */
+    const uint GridSize = 708;
+    /** Each path runs this many times, the fastest run counts. */
+    const uint NumRuns = 5;
+
+    /** Times a path, returns the fastest run in seconds. */
+    template <typename Run>
+    double bestTime( Run p_run ) {
+        double best = 0.0;
+        for ( uint run = 0; run < NumRuns; run++ ) {
+            Stopwatch stopwatch;
+            p_run( );
+            auto time = stopwatch.seconds( );
+            if ( !run || time < best ) {
+                best = time;
+            }
+        }
+        return best;
+    }
+
+};
+
+int main( ) {
+    TangentMesh mesh;
+    tangentGrid( GridSize, mesh );
+    auto numTriangles = mesh.indices.size( ) / 3;
+
+    TangentMesh welded;
+    auto referenceTime = bestTime( [&] ( ) {
+        referenceTangents( mesh, welded );
+    } );
+    auto indexedTime = bestTime( [&] ( ) {
+        computeTangents( mesh.positions, mesh.normals, mesh.uvs, mesh.indices, mesh.tangents );
+    } );
+
+    ::printf( "%zu triangles, %zu vertices per run, best of %u runs\n", numTriangles, mesh.positions.size( ), NumRuns );
+    ::printf( "expand and weld  %8.1f ms\n", referenceTime * 1e3 );
+    ::printf( "indexed          %8.1f ms   %6.2fx\n", indexedTime * 1e3,
+        indexedTime > 0.0 ? referenceTime / indexedTime : 0.0 );
+    return EXIT_SUCCESS;
+}
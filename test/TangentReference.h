@@ -0,0 +1,137 @@
+/** \file       test/TangentReference.h
+ *  \brief      Tangents the way the model viewer computed them before meshes stayed indexed.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef TEST_TANGENTREFERENCE_H_INCLUDED
+#define TEST_TANGENTREFERENCE_H_INCLUDED
+
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace gw2b {
+
+    /** Mesh as the reference builds it, one tangent per vertex. */
+    struct TangentMesh {
+        std::vector<glm::vec3>      positions;
+        std::vector<glm::vec3>      normals;
+        std::vector<glm::vec2>      uvs;
+        std::vector<uint>           indices;
+        std::vector<glm::vec3>      tangents;
+    };
+
+    /** Computes tangents the old way: triangles are expanded to three
+    *  vertices each, each vertex gets the normalized tangent of its triangle,
+    *  then vertices with the same position, normal and UV are welded back
+    *  together, summing their tangents without normalizing them. Triangles
+    *  without UV area give NaN tangents.
+    *  \param[in]  p_mesh       Indexed mesh, tangents unused.
+    *  \param[out] po_welded    Receives the welded mesh and its tangents. */
+    inline void referenceTangents( const TangentMesh& p_mesh, TangentMesh& po_welded ) {
+        struct PackedVertex {
+            glm::vec3 position;
+            glm::vec3 normal;
+            glm::vec2 uv;
+
+            bool operator<( const PackedVertex& p_other ) const {
+                return ::memcmp( this, &p_other, sizeof( PackedVertex ) ) > 0;
+            }
+        };
+
+        // Expand the triangles
+        std::vector<PackedVertex> expanded;
+        expanded.reserve( p_mesh.indices.size( ) );
+        for ( auto index : p_mesh.indices ) {
+            expanded.push_back( { p_mesh.positions[index], p_mesh.normals[index], p_mesh.uvs[index] } );
+        }
+
+        // One tangent per triangle
+        std::vector<glm::vec3> tangents;
+        tangents.reserve( expanded.size( ) );
+        for ( size_t i = 0; i + 2 < expanded.size( ); i += 3 ) {
+            glm::vec3 deltaPos1 = expanded[i + 1].position - expanded[i].position;
+            glm::vec3 deltaPos2 = expanded[i + 2].position - expanded[i].position;
+            glm::vec2 deltaUV1 = expanded[i + 1].uv - expanded[i].uv;
+            glm::vec2 deltaUV2 = expanded[i + 2].uv - expanded[i].uv;
+
+            float f = 1.0f / ( deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y );
+
+            glm::vec3 tangent;
+            tangent.x = f * ( deltaUV2.y * deltaPos1.x - deltaUV1.y * deltaPos2.x );
+            tangent.y = f * ( deltaUV2.y * deltaPos1.y - deltaUV1.y * deltaPos2.y );
+            tangent.z = f * ( deltaUV2.y * deltaPos1.z - deltaUV1.y * deltaPos2.z );
+            tangent = glm::normalize( tangent );
+
+            tangents.push_back( tangent );
+            tangents.push_back( tangent );
+            tangents.push_back( tangent );
+        }
+
+        // Weld by value
+        std::map<PackedVertex, uint> welded;
+        po_welded = TangentMesh( );
+        for ( size_t i = 0; i < tangents.size( ); i++ ) {
+            auto it = welded.find( expanded[i] );
+            if ( it != welded.end( ) ) {
+                po_welded.indices.push_back( it->second );
+                po_welded.tangents[it->second] += tangents[i];
+                continue;
+            }
+            auto index = static_cast<uint>( po_welded.positions.size( ) );
+            po_welded.positions.push_back( expanded[i].position );
+            po_welded.normals.push_back( expanded[i].normal );
+            po_welded.uvs.push_back( expanded[i].uv );
+            po_welded.tangents.push_back( tangents[i] );
+            po_welded.indices.push_back( index );
+            welded[expanded[i]] = index;
+        }
+    }
+
+    /** Builds a bumpy grid with skewed UVs, all its vertices different.
+    *  \param[in]  p_size       Vertices along each side, at least 2.
+    *  \param[out] po_mesh      Receives the grid, two triangles per cell. */
+    inline void tangentGrid( uint p_size, TangentMesh& po_mesh ) {
+        po_mesh = TangentMesh( );
+        for ( uint z = 0; z < p_size; z++ ) {
+            for ( uint x = 0; x < p_size; x++ ) {
+                float height = 0.25f * std::sin( x * 0.37f ) * std::cos( z * 0.23f );
+                po_mesh.positions.push_back( glm::vec3( x, height, z ) );
+                po_mesh.normals.push_back( glm::normalize( glm::vec3( -height, 1.0f, height * 0.5f ) ) );
+                po_mesh.uvs.push_back( glm::vec2( x * 0.125f + z * 0.03125f, z * 0.0625f ) );
+            }
+        }
+        for ( uint z = 0; z + 1 < p_size; z++ ) {
+            for ( uint x = 0; x + 1 < p_size; x++ ) {
+                uint i = z * p_size + x;
+                uint triangles[] = { i, i + p_size, i + 1, i + 1, i + p_size, i + p_size + 1 };
+                po_mesh.indices.insert( po_mesh.indices.end( ), triangles, triangles + 6 );
+            }
+        }
+    }
+
+}; // namespace gw2b
+
+#endif // TEST_TANGENTREFERENCE_H_INCLUDED
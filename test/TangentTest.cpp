@@ -0,0 +1,121 @@
+/** \file       test/TangentTest.cpp
+ *  \brief      Checks the tangents of indexed meshes against the old expand and weld path.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cmath>
+#include <vector>
+
+#include "Viewers/ModelViewer/Tangents.h"
+
+#include "TangentReference.h"
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Tangents pointing the same way have a dot product above this. */
+    const float SameDirection = 0.9999f;
+    /** Largest error allowed on unit lengths and right angles. */
+    const float Tolerance = 1e-4f;
+
+    bool isFinite( const glm::vec3& p_vector ) {
+        return std::isfinite( p_vector.x ) && std::isfinite( p_vector.y ) && std::isfinite( p_vector.z );
+    }
+
+    /** Checks a tangent is usable for normal mapping: finite, of unit length
+    *  and perpendicular to the normal. */
+    bool isUnitAcross( const glm::vec3& p_tangent, const glm::vec3& p_normal ) {
+        return isFinite( p_tangent ) && std::abs( glm::length( p_tangent ) - 1.0f ) < Tolerance
+            && std::abs( glm::dot( p_tangent, p_normal ) ) < Tolerance;
+    }
+
+};
+
+int main( ) {
+    TestResult result;
+
+    // Where all vertices differ, the old weld joins the same corners as the
+    // indices do. Its sums were never normalized, so compare directions.
+    for ( uint size : { 2u, 3u, 17u, 64u } ) {
+        TangentMesh mesh;
+        tangentGrid( size, mesh );
+        computeTangents( mesh.positions, mesh.normals, mesh.uvs, mesh.indices, mesh.tangents );
+
+        TangentMesh welded;
+        referenceTangents( mesh, welded );
+        TEST_CHECK( result, welded.positions.size( ) == mesh.positions.size( ) );
+        TEST_CHECK( result, welded.indices.size( ) == mesh.indices.size( ) );
+
+        uint numDifferent = 0;
+        for ( size_t i = 0; i < mesh.indices.size( ) && i < welded.indices.size( ); i++ ) {
+            auto& tangent = mesh.tangents[mesh.indices[i]];
+            auto expected = glm::normalize( welded.tangents[welded.indices[i]] );
+            if ( !isFinite( tangent ) || !( glm::dot( tangent, expected ) > SameDirection ) ) {
+                numDifferent++;
+            }
+        }
+        TEST_CHECK( result, numDifferent == 0 );
+        if ( numDifferent ) {
+            ::fprintf( stderr, "%ux%u grid: %u corners differ\n", size, size, numDifferent );
+        }
+    }
+
+    // Triangles without UV area: the old path divided by zero
+    TangentMesh mesh;
+    mesh.positions = {
+        glm::vec3( 0, 0, 0 ), glm::vec3( 1, 0, 0 ), glm::vec3( 0, 0, 1 ),   // Same UV on all corners
+        glm::vec3( 0, 1, 0 ), glm::vec3( 1, 1, 0 ), glm::vec3( 2, 1, 0 ),   // UVs on a line
+        glm::vec3( 9, 0, 9 ), glm::vec3( 1, 0, 1 ), glm::vec3( 0, 0, 2 ),   // Fine triangle with vertex 2, 6 unused
+        glm::vec3( 9, 9, 9 ),                                               // Used by no triangle
+        glm::vec3( 0, 2, 0 ), glm::vec3( 0, 2, 1 ), glm::vec3( 0, 3, 0 ),   // Degenerate, normal along x
+    };
+    mesh.normals = {
+        glm::vec3( 0, 1, 0 ), glm::vec3( 0, 1, 0 ), glm::vec3( 0, 1, 0 ),
+        glm::vec3( 0, 0, 1 ), glm::vec3( 0, 0, 1 ), glm::vec3( 0, 0, 1 ),
+        glm::vec3( 0, 1, 0 ), glm::vec3( 0, 1, 0 ), glm::vec3( 0, 1, 0 ),
+        glm::normalize( glm::vec3( 1, 1, 1 ) ),
+        glm::vec3( 1, 0, 0 ), glm::vec3( 1, 0, 0 ), glm::vec3( 1, 0, 0 ),
+    };
+    mesh.uvs = {
+        glm::vec2( 0.5f, 0.5f ), glm::vec2( 0.5f, 0.5f ), glm::vec2( 0.5f, 0.5f ),
+        glm::vec2( 0, 0 ), glm::vec2( 0.5f, 0.5f ), glm::vec2( 1, 1 ),
+        glm::vec2( 0, 0 ), glm::vec2( 1.5f, 0.5f ), glm::vec2( 0.5f, 1.5f ),
+        glm::vec2( 0, 0 ),
+        glm::vec2( 0.25f, 0.25f ), glm::vec2( 0.25f, 0.25f ), glm::vec2( 0.25f, 0.25f ),
+    };
+    mesh.indices = { 0, 1, 2, 3, 4, 5, 2, 7, 8, 10, 11, 12 };
+    computeTangents( mesh.positions, mesh.normals, mesh.uvs, mesh.indices, mesh.tangents );
+
+    TEST_CHECK( result, mesh.tangents.size( ) == mesh.positions.size( ) );
+    for ( size_t i = 0; i < mesh.tangents.size( ); i++ ) {
+        TEST_CHECK( result, isUnitAcross( mesh.tangents[i], mesh.normals[i] ) );
+    }
+    // Vertex 2 takes the tangent of the only triangle that has one, along +u
+    TEST_CHECK( result, glm::dot( mesh.tangents[2], glm::vec3( 1, 0, 0 ) ) > SameDirection );
+    TEST_CHECK( result, glm::dot( mesh.tangents[7], glm::vec3( 1, 0, 0 ) ) > SameDirection );
+
+    return result.exitCode( );
+}
@@ -0,0 +1,175 @@
+/** \file       test/TestDatFile.cpp
+ *  \brief      Contains the definition of the raw .dat reader of the tests.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <gw2dattools/compression/inflateDatFileBuffer.h>
+#include <gw2dattools/exception/Exception.h>
+
+#include "TestDatFile.h"
+
+namespace gw2b {
+
+    const char* TestDatFile::path( int p_argc, char** p_argv ) {
+        if ( p_argc > 1 ) {
+            return p_argv[1];
+        }
+        return ::getenv( "GW2_DAT" );
+    }
+
+    //============================================================================/
+
+    bool TestDatFile::open( const char* p_path ) {
+        m_file.open( p_path, std::ios::binary );
+        if ( !m_file ) {
+            return false;
+        }
+
+        ANetDatHeader datHead;
+        if ( !m_file.read( reinterpret_cast<char*>( &datHead ), sizeof( datHead ) ) ) {
+            return false;
+        }
+        if ( !datHead.mftSize || datHead.mftSize % sizeof( ANetMftEntry ) ) {
+            return false;
+        }
+
+        m_mftEntries.resize( datHead.mftSize / sizeof( ANetMftEntry ) );
+        m_file.seekg( datHead.mftOffset );
+        return !!m_file.read( reinterpret_cast<char*>( m_mftEntries.data( ) ), datHead.mftSize );
+    }
+
+    //============================================================================/
+
+    std::vector<uint> TestDatFile::compressedEntries( uint p_maxEntries ) const {
+        std::vector<uint> entries;
+        // The first entries are the MFT itself and its tables
+        for ( uint i = 16; i < m_mftEntries.size( ); i++ ) {
+            auto& entry = m_mftEntries[i];
+            if ( ( entry.entryFlags & ANMEF_InUse ) && entry.compressionFlag && entry.size >= 8 ) {
+                entries.push_back( i );
+            }
+        }
+
+        if ( entries.size( ) <= p_maxEntries ) {
+            return entries;
+        }
+
+        std::vector<uint> spread( p_maxEntries );
+        for ( uint i = 0; i < p_maxEntries; i++ ) {
+            spread[i] = entries[static_cast<uint64>( i ) * entries.size( ) / p_maxEntries];
+        }
+        return spread;
+    }
+
+    //============================================================================/
+
+    bool TestDatFile::readRaw( uint p_entryNum, std::vector<byte>& po_data ) {
+        if ( p_entryNum >= m_mftEntries.size( ) ) {
+            return false;
+        }
+
+        auto& entry = m_mftEntries[p_entryNum];
+        po_data.resize( entry.size );
+        m_file.seekg( entry.offset );
+        return !!m_file.read( reinterpret_cast<char*>( po_data.data( ) ), entry.size );
+    }
+
+    //============================================================================/
+
+    bool TestDatFile::readInflated( uint p_entryNum, std::vector<byte>& po_data, uint32 p_peekSize ) {
+        if ( !this->readRaw( p_entryNum, m_input ) ) {
+            return false;
+        }
+
+        auto size = inflatedSize( m_input );
+        if ( !size ) {
+            return false;
+        }
+        if ( p_peekSize && p_peekSize < size ) {
+            size = p_peekSize;
+        }
+
+        po_data.resize( size );
+        try {
+            gw2dt::compression::inflateDatFileBuffer( m_input.size( ), m_input.data( ), size, po_data.data( ) );
+        } catch ( const gw2dt::exception::Exception& ) {
+            return false;
+        }
+        po_data.resize( size );
+        return true;
+    }
+
+    //============================================================================/
+
+    uint32 TestDatFile::textureBlocksSize( const std::vector<byte>& p_data ) {
+        if ( p_data.size( ) < sizeof( ANetAtexHeader ) ) {
+            return 0;
+        }
+
+        auto atex = reinterpret_cast<const ANetAtexHeader*>( p_data.data( ) );
+        switch ( atex->identifierInteger ) {
+        case FCC_ATEX:
+        case FCC_ATTX:
+        case FCC_ATEC:
+        case FCC_ATEP:
+        case FCC_ATEU:
+        case FCC_ATET:
+            break;
+        default:
+            return 0;
+        }
+
+        // Same as ImageReader::getUncompressedATEXSize
+        uint32 numBlocks = ( ( atex->width + 3 ) >> 2 ) * ( ( atex->height + 3 ) >> 2 );
+        switch ( atex->formatInteger ) {
+        case FCC_DXT1:
+        case FCC_DXTA:
+            return numBlocks * 8;
+        case FCC_DXT2:
+        case FCC_DXT3:
+        case FCC_DXT4:
+        case FCC_DXT5:
+        case FCC_DXTL:
+        case FCC_DXTN:
+        case FCC_3DCX:
+            return numBlocks * 16;
+        default:
+            return 0;
+        }
+    }
+
+    //============================================================================/
+
+    uint32 TestDatFile::inflatedSize( const std::vector<byte>& p_data ) {
+        if ( p_data.size( ) < 8 ) {
+            return 0;
+        }
+        uint32 size;
+        ::memcpy( &size, &p_data[4], sizeof( size ) );
+        return size;
+    }
+
+}; // namespace gw2b
@@ -0,0 +1,88 @@
+/** \file       test/TestDatFile.h
+ *  \brief      Contains the declaration of the raw .dat reader of the tests.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef TEST_TESTDATFILE_H_INCLUDED
+#define TEST_TESTDATFILE_H_INCLUDED
+
+#include <fstream>
+#include <vector>
+
+#include "ANetStructs.h"
+
+namespace gw2b {
+
+    /** Reads entries of a .dat as they are stored, without DatFile, its
+    *  caches or an inflater, so the inflaters can be fed the same bytes.
+    *  The .dat is named on the command line or by the GW2_DAT environment
+    *  variable. */
+    class TestDatFile {
+        std::ifstream               m_file;
+        std::vector<ANetMftEntry>   m_mftEntries;
+        std::vector<byte>           m_input;
+    public:
+        /** Gets the .dat to test with.
+        *  \param[in]  p_argc       Argument count of main.
+        *  \param[in]  p_argv       Arguments of main.
+        *  \return char*            Path of the .dat, nullptr if none given. */
+        static const char* path( int p_argc, char** p_argv );
+
+        /** Opens a .dat and reads its MFT.
+        *  \param[in]  p_path       Path of the .dat.
+        *  \return bool             true if opened, false if not. */
+        bool open( const char* p_path );
+        /** Gets the amount of MFT entries. */
+        uint numEntries( ) const {
+            return m_mftEntries.size( );
+        }
+        /** Gets the entries in use that are compressed, spread evenly over the MFT.
+        *  \param[in]  p_maxEntries Max amount of entries to get.
+        *  \return std::vector<uint>    Entry numbers. */
+        std::vector<uint> compressedEntries( uint p_maxEntries ) const;
+        /** Reads an entry as stored in the .dat.
+        *  \param[in]  p_entryNum   Entry to read.
+        *  \param[out] po_data      Receives the stored bytes.
+        *  \return bool             true if read, false if not. */
+        bool readRaw( uint p_entryNum, std::vector<byte>& po_data );
+        /** Reads and inflates an entry with gw2dattools, the reference for the
+        *  in-tree inflaters.
+        *  \param[in]  p_entryNum   Entry to read.
+        *  \param[out] po_data      Receives the inflated bytes.
+        *  \param[in]  p_peekSize   Max amount of bytes to inflate, 0 for all.
+        *  \return bool             true if read and inflated, false if not. */
+        bool readInflated( uint p_entryNum, std::vector<byte>& po_data, uint32 p_peekSize = 0 );
+        /** Gets the size of the blocks an ATEX family texture inflates to.
+        *  \param[in]  p_data       Inflated entry holding the texture.
+        *  \return uint32           Size of the blocks, 0 if not a supported texture. */
+        static uint32 textureBlocksSize( const std::vector<byte>& p_data );
+        /** Gets the inflated size of a compressed entry, from its first bytes.
+        *  \param[in]  p_data       Stored bytes of the entry.
+        *  \return uint32           Inflated size, 0 if unknown. */
+        static uint32 inflatedSize( const std::vector<byte>& p_data );
+    }; // class TestDatFile
+
+}; // namespace gw2b
+
+#endif // TEST_TESTDATFILE_H_INCLUDED
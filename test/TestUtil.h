@@ -0,0 +1,129 @@
+/** \file       test/TestUtil.h
+ *  \brief      Contains the helpers shared by the tests and benchmarks.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef TEST_TESTUTIL_H_INCLUDED
+#define TEST_TESTUTIL_H_INCLUDED
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace gw2b {
+
+    /** Exit code telling CTest a test was skipped, for tests missing their data. */
+    const int TestSkipped = 77;
+
+    /** Counts the failed checks of a test. */
+    class TestResult {
+        uint                        m_numChecks = 0;
+        uint                        m_numFailures = 0;
+    public:
+        /** Checks a condition, reporting it if false.
+        *  \param[in]  p_condition  Condition to check.
+        *  \param[in]  p_what       Text of the condition.
+        *  \param[in]  p_file       Source file of the check.
+        *  \param[in]  p_line       Source line of the check.
+        *  \return bool             p_condition. */
+        bool check( bool p_condition, const char* p_what, const char* p_file, int p_line ) {
+            m_numChecks++;
+            if ( !p_condition ) {
+                // Only the first failures, a broken kernel fails every check
+                if ( m_numFailures < 20 ) {
+                    ::fprintf( stderr, "%s(%d): check failed: %s\n", p_file, p_line, p_what );
+                }
+                m_numFailures++;
+            }
+            return p_condition;
+        }
+        /** Prints the summary and gets the exit code of the test.
+        *  \return int              EXIT_SUCCESS if all checks passed, EXIT_FAILURE if not. */
+        int exitCode( ) const {
+            ::printf( "%u checks, %u failed\n", m_numChecks, m_numFailures );
+            return m_numFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+    }; // class TestResult
+
+    /** Checks a condition of a test, reporting it with its source if false. */
+#define TEST_CHECK( p_result, p_condition ) ( p_result ).check( !!( p_condition ), #p_condition, __FILE__, __LINE__ )
+
+    /** Measures wall clock time for the benchmarks. */
+    class Stopwatch {
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point           m_start;
+    public:
+        /** Constructor. Starts the stopwatch. */
+        Stopwatch( )
+            : m_start( Clock::now( ) ) {
+        }
+        /** Restarts the stopwatch. */
+        void restart( ) {
+            m_start = Clock::now( );
+        }
+        /** Gets the time since the stopwatch was started.
+        *  \return double           Elapsed time, in seconds. */
+        double seconds( ) const {
+            return std::chrono::duration<double>( Clock::now( ) - m_start ).count( );
+        }
+    }; // class Stopwatch
+
+    /** Pseudo random numbers for synthetic test data, the same on every run
+    *  and platform. */
+    class TestRandom {
+        uint32                      m_state;
+    public:
+        /** Constructor.
+        *  \param[in]  p_seed       Seed, not 0. */
+        TestRandom( uint32 p_seed )
+            : m_state( p_seed ) {
+        }
+        /** Gets the next number.
+        *  \return uint32           The number. */
+        uint32 next( ) {
+            m_state ^= m_state << 13;
+            m_state ^= m_state >> 17;
+            m_state ^= m_state << 5;
+            return m_state;
+        }
+        /** Gets the next number in a range.
+        *  \param[in]  p_min        Lowest number.
+        *  \param[in]  p_max        Highest number, included.
+        *  \return uint32           The number. */
+        uint32 range( uint32 p_min, uint32 p_max ) {
+            return p_min + this->next( ) % ( p_max - p_min + 1 );
+        }
+    }; // class TestRandom
+
+    /** Gets the throughput of a benchmark.
+    *  \param[in]  p_bytes      Amount of bytes processed.
+    *  \param[in]  p_seconds    Time taken.
+    *  \return double           Throughput, in MB/s. */
+    inline double megabytesPerSecond( uint64 p_bytes, double p_seconds ) {
+        return p_seconds > 0.0 ? ( p_bytes / ( 1024.0 * 1024.0 ) ) / p_seconds : 0.0;
+    }
+
+}; // namespace gw2b
+
+#endif // TEST_TESTUTIL_H_INCLUDED
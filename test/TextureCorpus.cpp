@@ -0,0 +1,343 @@
+/** \file       test/TextureCorpus.cpp
+ *  \brief      Contains the definition of the synthetic ATEX textures.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cstring>
+
+#include "ANetStructs.h"
+
+#include "HuffmanWriter.h"
+#include "TestUtil.h"
+#include "TextureCorpus.h"
+
+namespace gw2b {
+
+    namespace {
+
+        /** Passes filling blocks of a single value, as given by the stream. */
+        enum CompressionFlags {
+            CF_WhiteColor = 0x01,
+            CF_ConstantAlphaFrom4Bits = 0x02,
+            CF_ConstantAlphaFrom8Bits = 0x04,
+            CF_PlainColor = 0x08,
+        };
+
+        /** Longest run of blocks a single code covers. */
+        const uint MaxRun = 0x12;
+
+        /** Where the components of a format's blocks are, and which of them
+        *  follow the bit stream when no pass filled them. */
+        struct TextureLayout {
+            uint                    bytesPerBlock;
+            uint                    colorOffset;        /**< Offset of the color component in the block. */
+            bool                    hasStoredAlpha;     /**< Alpha components follow the bit stream. */
+            bool                    hasStoredColor;     /**< Color components follow the bit stream. */
+        };
+
+        TextureLayout textureLayout( uint32 p_fourcc ) {
+            switch ( p_fourcc ) {
+            case FCC_DXT1:
+                return { 8, 0, false, true };
+            case FCC_DXTA:
+                return { 8, 0, true, false };
+            default:
+                // DXT5 and 3DCX
+                return { 16, 8, true, true };
+            }
+        }
+
+        /** What a texture is made of. Chances are in percent of the blocks
+        *  not yet done when the pass runs. */
+        struct TextureFixture {
+            const char*             name;
+            uint32                  fourcc;
+            uint16                  width;
+            uint16                  height;
+            uint32                  flags;              /**< See CompressionFlags. */
+            uint                    whiteChance;
+            uint                    alphaChance;        /**< Of either constant alpha pass. */
+            uint                    colorChance;
+            bool                    isExactColor;       /**< Plain color representable in 565, so the blocks are known. */
+        };
+
+        /** Writes a texture and builds the blocks it inflates to along. */
+        class TextureEncoder {
+            const TextureFixture&   m_fixture;
+            TextureLayout           m_layout;
+            uint                    m_numBlocks;
+            TestRandom              m_random;
+            BitWriter               m_writer;
+            std::vector<uint8>      m_colorDone;
+            std::vector<uint8>      m_alphaDone;
+            std::vector<uint8>      m_runBits;
+            std::vector<uint32>     m_runCodes;
+        public:
+            std::vector<byte>       output;
+
+            TextureEncoder( const TextureFixture& p_fixture, uint32 p_seed )
+                : m_fixture( p_fixture )
+                , m_layout( textureLayout( p_fixture.fourcc ) )
+                , m_numBlocks( ( ( p_fixture.width + 3 ) / 4 ) * ( ( p_fixture.height + 3 ) / 4 ) )
+                , m_random( p_seed )
+                , m_writer( false )
+                , m_colorDone( m_numBlocks, 0 )
+                , m_alphaDone( m_numBlocks, 0 )
+                , m_runBits( MaxRun + 1, 6 )
+                , output( m_numBlocks * m_layout.bytesPerBlock, 0 ) {
+                // Same tree as the inflaters read the runs with
+                m_runBits[0x00] = 0;
+                m_runBits[0x01] = 1;
+                m_runBits[0x12] = 2;
+                m_runCodes = huffmanCodes( m_runBits.data( ), m_runBits.size( ) );
+            }
+
+            std::vector<byte> encode( ) {
+                auto flags = m_fixture.flags;
+                m_writer.write( 0, 32 );
+                m_writer.write( flags, 32 );
+
+                if ( flags & CF_WhiteColor ) {
+                    this->encodeWhiteColor( );
+                }
+                if ( flags & CF_ConstantAlphaFrom4Bits ) {
+                    uint64 alpha = m_random.range( 0, 15 );
+                    m_writer.write( static_cast<uint32>( alpha ), 4 );
+                    alpha |= alpha << 4;
+                    alpha |= alpha << 8;
+                    alpha |= alpha << 16;
+                    alpha |= alpha << 32;
+                    this->encodeConstantAlpha( alpha );
+                }
+                if ( flags & CF_ConstantAlphaFrom8Bits ) {
+                    uint64 alpha = m_random.range( 0, 255 );
+                    m_writer.write( static_cast<uint32>( alpha ), 8 );
+                    this->encodeConstantAlpha( alpha | ( alpha << 8 ) );
+                }
+                if ( flags & CF_PlainColor ) {
+                    this->encodePlainColor( );
+                }
+                m_writer.flush( );
+
+                auto stream = m_writer.data( );
+                this->appendStored( stream );
+
+                // Size of the data, unused by the inflaters
+                auto size = static_cast<uint32>( stream.size( ) );
+                ::memcpy( stream.data( ), &size, sizeof( size ) );
+
+                ANetAtexHeader header;
+                header.identifierInteger = FCC_ATEX;
+                header.formatInteger = m_fixture.fourcc;
+                header.width = m_fixture.width;
+                header.height = m_fixture.height;
+                std::vector<byte> texture( sizeof( header ) + stream.size( ) );
+                ::memcpy( texture.data( ), &header, sizeof( header ) );
+                ::memcpy( texture.data( ) + sizeof( header ), stream.data( ), stream.size( ) );
+                return texture;
+            }
+
+        private:
+            byte* block( uint p_index ) {
+                return &output[p_index * m_layout.bytesPerBlock];
+            }
+
+            /** Writes a pass: runs of blocks not done in p_done, each with
+            *  the flags from p_choose written by p_writeFlags. A pass always
+            *  has a run, even with no block left. Chosen blocks are filled by
+            *  p_fill. */
+            template <typename Choose, typename WriteFlags, typename Fill>
+            void encodePass( const std::vector<uint8>& p_done, Choose p_choose, WriteFlags p_writeFlags, Fill p_fill ) {
+                std::vector<uint> pending;
+                std::vector<uint> choices;
+                for ( uint i = 0; i < m_numBlocks; i++ ) {
+                    if ( !p_done[i] ) {
+                        pending.push_back( i );
+                        choices.push_back( p_choose( ) );
+                    }
+                }
+                if ( pending.empty( ) ) {
+                    m_writer.write( m_runCodes[1], m_runBits[1] );
+                    p_writeFlags( 0 );
+                    return;
+                }
+
+                for ( uint i = 0; i < pending.size( ); ) {
+                    uint count = 1;
+                    while ( count < MaxRun && i + count < pending.size( ) && choices[i + count] == choices[i] ) {
+                        count++;
+                    }
+                    m_writer.write( m_runCodes[count], m_runBits[count] );
+                    p_writeFlags( choices[i] );
+                    for ( uint j = 0; j < count; j++ ) {
+                        if ( choices[i + j] ) {
+                            p_fill( pending[i + j], choices[i + j] );
+                        }
+                    }
+                    i += count;
+                }
+            }
+
+            /** Fill flag of the white and plain color passes. */
+            void writeFillFlag( uint p_choice ) {
+                m_writer.write( p_choice ? 1 : 0, 1 );
+            }
+
+            bool chance( uint p_percent ) {
+                return m_random.range( 0, 99 ) < p_percent;
+            }
+
+            void encodeWhiteColor( ) {
+                const uint64 white = 0xfffffffffffffffeull;
+                encodePass( m_colorDone, [this] ( ) {
+                    return this->chance( m_fixture.whiteChance ) ? 1u : 0u;
+                }, [this] ( uint p_choice ) {
+                    this->writeFillFlag( p_choice );
+                }, [this, &white] ( uint p_index, uint ) {
+                    ::memcpy( this->block( p_index ), &white, sizeof( white ) );
+                    if ( m_layout.colorOffset ) {
+                        ::memcpy( this->block( p_index ) + m_layout.colorOffset, &white, sizeof( white ) );
+                    }
+                    m_alphaDone[p_index] = 1;
+                    m_colorDone[p_index] = 1;
+                } );
+            }
+
+            /** Filled blocks get either the constant or 0. */
+            void encodeConstantAlpha( uint64 p_alpha ) {
+                enum {
+                    Skip,
+                    Zero,
+                    Constant,
+                };
+                encodePass( m_alphaDone, [this] ( ) {
+                    if ( !this->chance( m_fixture.alphaChance ) ) {
+                        return static_cast<uint>( Skip );
+                    }
+                    return static_cast<uint>( ( m_random.next( ) & 3 ) ? Constant : Zero );
+                }, [this] ( uint p_choice ) {
+                    // Fill bit, then for filled runs the constant bit
+                    if ( p_choice == Skip ) {
+                        m_writer.write( 0, 1 );
+                    } else {
+                        m_writer.write( p_choice == Constant ? 3 : 2, 2 );
+                    }
+                }, [this, p_alpha] ( uint p_index, uint p_choice ) {
+                    uint64 alpha = ( p_choice == Constant ) ? p_alpha : 0;
+                    ::memcpy( this->block( p_index ), &alpha, sizeof( alpha ) );
+                    m_alphaDone[p_index] = 1;
+                } );
+            }
+
+            void encodePlainColor( ) {
+                uint64 color = 0;
+                if ( m_fixture.isExactColor ) {
+                    // Channels that expand exactly from 5, 6 and 5 bits end
+                    // up as both end points, every index 1
+                    auto red = m_random.range( 0, 31 );
+                    auto green = m_random.range( 0, 63 );
+                    auto blue = m_random.range( 0, 31 );
+                    m_writer.write( ( blue << 3 ) | ( blue >> 2 ), 8 );
+                    m_writer.write( ( green << 2 ) | ( green >> 4 ), 8 );
+                    m_writer.write( ( red << 3 ) | ( red >> 2 ), 8 );
+                    uint64 packed = red | ( green << 5 ) | ( blue << 11 );
+                    color = packed | ( packed << 16 ) | ( 0x55555555ull << 32 );
+                } else {
+                    m_writer.write( m_random.range( 0, 255 ), 8 );
+                    m_writer.write( m_random.range( 0, 255 ), 8 );
+                    m_writer.write( m_random.range( 0, 255 ), 8 );
+                }
+
+                encodePass( m_colorDone, [this] ( ) {
+                    return this->chance( m_fixture.colorChance ) ? 1u : 0u;
+                }, [this] ( uint p_choice ) {
+                    this->writeFillFlag( p_choice );
+                }, [this, color] ( uint p_index, uint ) {
+                    ::memcpy( this->block( p_index ) + m_layout.colorOffset, &color, sizeof( color ) );
+                    m_colorDone[p_index] = 1;
+                } );
+            }
+
+            /** Appends the blocks no pass filled: whole alpha components first,
+            *  then the first and second half of the color components. */
+            void appendStored( std::vector<byte>& po_stream ) {
+                auto append = [&] ( byte* po_target ) {
+                    auto word = m_random.next( );
+                    ::memcpy( po_target, &word, sizeof( word ) );
+                    po_stream.insert( po_stream.end( ), po_target, po_target + sizeof( word ) );
+                };
+
+                if ( m_layout.hasStoredAlpha ) {
+                    for ( uint i = 0; i < m_numBlocks; i++ ) {
+                        if ( !m_alphaDone[i] ) {
+                            append( this->block( i ) );
+                            append( this->block( i ) + 4 );
+                        }
+                    }
+                }
+                if ( m_layout.hasStoredColor ) {
+                    for ( uint half = 0; half < 8; half += 4 ) {
+                        for ( uint i = 0; i < m_numBlocks; i++ ) {
+                            if ( !m_colorDone[i] ) {
+                                append( this->block( i ) + m_layout.colorOffset + half );
+                            }
+                        }
+                    }
+                }
+            }
+        }; // class TextureEncoder
+
+    };
+
+    //============================================================================/
+
+    std::vector<TextureCorpusEntry> textureCorpus( ) {
+        const TextureFixture fixtures[] = {
+            { "DXT1", FCC_DXT1, 64, 48, CF_WhiteColor | CF_PlainColor, 30, 0, 40, true },
+            { "DXT1 stored", FCC_DXT1, 37, 21, 0, 0, 0, 0, true },
+            { "DXT1 blended color", FCC_DXT1, 32, 32, CF_PlainColor, 0, 0, 50, false },
+            { "DXT5", FCC_DXT5, 64, 64, CF_WhiteColor | CF_ConstantAlphaFrom8Bits | CF_PlainColor, 20, 50, 50, true },
+            { "DXT5 4-bit alpha", FCC_DXT5, 48, 40, CF_ConstantAlphaFrom4Bits | CF_PlainColor, 0, 60, 30, true },
+            { "DXT5 blended color", FCC_DXT5, 32, 32, CF_PlainColor, 0, 0, 50, false },
+            { "DXTA", FCC_DXTA, 64, 32, CF_ConstantAlphaFrom4Bits | CF_ConstantAlphaFrom8Bits, 0, 40, 0, true },
+            { "DXTA all filled", FCC_DXTA, 16, 16, CF_ConstantAlphaFrom8Bits | CF_ConstantAlphaFrom4Bits, 0, 100, 0, true },
+            { "3DCX", FCC_3DCX, 64, 64, CF_WhiteColor | CF_ConstantAlphaFrom8Bits, 25, 50, 0, true },
+        };
+
+        std::vector<TextureCorpusEntry> corpus;
+        uint32 seed = 1;
+        for ( auto const& it : fixtures ) {
+            TextureEncoder encoder( it, seed++ );
+            TextureCorpusEntry entry;
+            entry.name = it.name;
+            entry.input = encoder.encode( );
+            if ( it.isExactColor || !( it.flags & CF_PlainColor ) ) {
+                entry.output = std::move( encoder.output );
+            }
+            corpus.push_back( std::move( entry ) );
+        }
+        return corpus;
+    }
+
+}; // namespace gw2b
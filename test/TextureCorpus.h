@@ -0,0 +1,50 @@
+/** \file       test/TextureCorpus.h
+ *  \brief      Contains the declaration of the synthetic ATEX textures.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef TEST_TEXTURECORPUS_H_INCLUDED
+#define TEST_TEXTURECORPUS_H_INCLUDED
+
+#include <vector>
+
+namespace gw2b {
+
+    /** A synthetic ATEX texture and the blocks it inflates to. */
+    struct TextureCorpusEntry {
+        const char*                 name;       /**< What the texture covers. */
+        std::vector<byte>           input;      /**< Texture file, header included. */
+        std::vector<byte>           output;     /**< Inflated blocks, empty if only gw2dattools knows them. */
+    };
+
+    /** Builds the synthetic textures the inflaters are checked against when
+    *  no .dat is at hand: DXT1, DXT5, DXTA and 3DCX, each mixing blocks
+    *  filled by the white, constant alpha and plain color passes with blocks
+    *  stored as they are. The textures are the same on every run.
+    *  \return std::vector<TextureCorpusEntry>  The textures. */
+    std::vector<TextureCorpusEntry> textureCorpus( );
+
+}; // namespace gw2b
+
+#endif // TEST_TEXTURECORPUS_H_INCLUDED
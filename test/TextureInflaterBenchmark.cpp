@@ -0,0 +1,134 @@
+/** \file       test/TextureInflaterBenchmark.cpp
+ *  \brief      Measures the throughput of the ATEX texture inflaters per format.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <map>
+#include <gw2dattools/compression/inflateTextureFileBuffer.h>
+#include <gw2dattools/exception/Exception.h>
+
+#include "Compression/TextureInflater.h"
+
+#include "TestDatFile.h"
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Amount of entries looked at for textures, spread over the whole .dat. */
+    const uint MaxEntries = 20000;
+    /** Amount of bytes inflated to tell textures from other entries. */
+    const uint PeekSize = 16;
+    /** Max amount of texture bytes kept in memory per format. */
+    const uint64 MaxInputBytes = 64 * 1024 * 1024;
+    /** Each inflater runs this many times, the fastest run counts. */
+    const uint NumRuns = 3;
+
+    struct Texture {
+        std::vector<byte>           input;
+        uint32                      outputSize;
+    };
+
+    struct Format {
+        std::vector<Texture>        textures;
+        uint64                      inputBytes = 0;
+        uint64                      outputBytes = 0;
+    };
+
+    /** Inflates all textures of a format, returns the time taken in seconds. */
+    template <typename Inflate>
+    double bestTime( const Format& p_format, std::vector<byte>& po_output, Inflate p_inflate ) {
+        double best = 0.0;
+        for ( uint run = 0; run < NumRuns; run++ ) {
+            Stopwatch stopwatch;
+            for ( auto& texture : p_format.textures ) {
+                p_inflate( texture, po_output.data( ) );
+            }
+            auto time = stopwatch.seconds( );
+            if ( !run || time < best ) {
+                best = time;
+            }
+        }
+        return best;
+    }
+
+};
+
+int main( int p_argc, char** p_argv ) {
+    auto path = TestDatFile::path( p_argc, p_argv );
+    TestDatFile datFile;
+    if ( !path || !datFile.open( path ) ) {
+        ::printf( "No .dat given, set GW2_DAT to run this benchmark.\n" );
+        return TestSkipped;
+    }
+
+    // Read the textures up front, grouped by format, so only inflating is timed
+    std::map<uint32, Format> formats;
+    std::vector<byte> peek;
+    uint32 maxOutputSize = 0;
+    for ( auto entryNum : datFile.compressedEntries( MaxEntries ) ) {
+        if ( !datFile.readInflated( entryNum, peek, PeekSize ) || !TestDatFile::textureBlocksSize( peek ) ) {
+            continue;
+        }
+
+        auto& format = formats[reinterpret_cast<const ANetAtexHeader*>( peek.data( ) )->formatInteger];
+        if ( format.inputBytes >= MaxInputBytes ) {
+            continue;
+        }
+
+        Texture texture;
+        if ( !datFile.readInflated( entryNum, texture.input ) ) {
+            continue;
+        }
+        texture.outputSize = TestDatFile::textureBlocksSize( texture.input );
+        format.inputBytes += texture.input.size( );
+        format.outputBytes += texture.outputSize;
+        maxOutputSize = std::max( maxOutputSize, texture.outputSize );
+        format.textures.push_back( std::move( texture ) );
+    }
+    std::vector<byte> output( maxOutputSize );
+
+    ::printf( "format  textures   inflated MB   gw2dattools MB/s   in-tree MB/s\n" );
+    for ( auto& it : formats ) {
+        auto& format = it.second;
+        auto reference = bestTime( format, output, [] ( const Texture& p_texture, byte* po_output ) {
+            uint32 size = p_texture.outputSize;
+            try {
+                gw2dt::compression::inflateTextureFileBuffer( p_texture.input.size( ), p_texture.input.data( ), size, po_output );
+            } catch ( const gw2dt::exception::Exception& ) {
+            }
+        } );
+        auto inTree = bestTime( format, output, [] ( const Texture& p_texture, byte* po_output ) {
+            uint32 size = p_texture.outputSize;
+            inflateTextureBuffer( p_texture.input.size( ), p_texture.input.data( ), size, po_output );
+        } );
+
+        ::printf( "%.4s    %8u   %11.1f   %16.1f   %12.1f\n", reinterpret_cast<const char*>( &it.first ),
+            static_cast<uint>( format.textures.size( ) ), format.outputBytes / ( 1024.0 * 1024.0 ),
+            megabytesPerSecond( format.outputBytes, reference ), megabytesPerSecond( format.outputBytes, inTree ) );
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+/** \file       test/TextureInflaterTest.cpp
+ *  \brief      Checks the in-tree ATEX texture inflater against gw2dattools.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cstring>
+#include <gw2dattools/compression/inflateTextureFileBuffer.h>
+#include <gw2dattools/exception/Exception.h>
+
+#include "Compression/TextureInflater.h"
+
+#include "TestDatFile.h"
+#include "TestUtil.h"
+#include "TextureCorpus.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Amount of entries looked at for textures, spread over the whole .dat. */
+    const uint MaxEntries = 20000;
+    /** Amount of bytes inflated to tell textures from other entries. */
+    const uint PeekSize = 16;
+
+    /** Inflates with gw2dattools.
+    *  \return bool    true if inflated, false if gw2dattools threw. */
+    bool inflateReference( const std::vector<byte>& p_input, uint32& po_outputSize, byte* po_output ) {
+        try {
+            gw2dt::compression::inflateTextureFileBuffer( p_input.size( ), p_input.data( ), po_outputSize, po_output );
+            return true;
+        } catch ( const gw2dt::exception::Exception& ) {
+            return false;
+        }
+    }
+
+    /** Inflates a texture, comparing the blocks with gw2dattools and, if
+    *  known, with what the texture inflates to.
+    *  \param[in,out] p_result  Result of the test.
+    *  \param[in]  p_name       Name of the texture, for the failures.
+    *  \param[in]  p_texture    Texture file, header included.
+    *  \param[in]  p_original   Blocks the texture inflates to, nullptr if unknown. */
+    void compareTexture( TestResult& p_result, const char* p_name, const std::vector<byte>& p_texture, const std::vector<byte>* p_original ) {
+        auto size = TestDatFile::textureBlocksSize( p_texture );
+        if ( !TEST_CHECK( p_result, size > 0 ) ) {
+            return;
+        }
+
+        std::vector<byte> expected( size, 0 );
+        std::vector<byte> actual( size, 0xcd );
+        uint32 expectedSize = size;
+        uint32 actualSize = size;
+        auto isExpectedOk = inflateReference( p_texture, expectedSize, expected.data( ) );
+        auto isActualOk = inflateTextureBuffer( p_texture.size( ), p_texture.data( ), actualSize, actual.data( ) );
+        if ( !TEST_CHECK( p_result, isExpectedOk == isActualOk ) ) {
+            ::fprintf( stderr, "  %s: gw2dattools %s, in-tree %s\n", p_name, isExpectedOk ? "inflated" : "failed", isActualOk ? "inflated" : "failed" );
+            return;
+        }
+        if ( p_original ) {
+            TEST_CHECK( p_result, isActualOk );
+            if ( !TEST_CHECK( p_result, expectedSize == p_original->size( ) && expected == *p_original ) ) {
+                ::fprintf( stderr, "  %s: gw2dattools blocks differ from the original\n", p_name );
+            }
+        }
+        if ( !isExpectedOk ) {
+            return;
+        }
+        TEST_CHECK( p_result, expectedSize == actualSize );
+        if ( !TEST_CHECK( p_result, ::memcmp( expected.data( ), actual.data( ), std::min( expectedSize, actualSize ) ) == 0 ) ) {
+            auto atex = reinterpret_cast<const ANetAtexHeader*>( p_texture.data( ) );
+            ::fprintf( stderr, "  %s: %.4s %ux%u differs\n", p_name, reinterpret_cast<const char*>( atex->format ), atex->width, atex->height );
+        }
+    }
+
+};
+
+int main( int p_argc, char** p_argv ) {
+    TestResult result;
+
+    // Synthetic textures, always at hand
+    uint numFixtures = 0;
+    for ( auto const& it : textureCorpus( ) ) {
+        compareTexture( result, it.name, it.input, it.output.empty( ) ? nullptr : &it.output );
+        numFixtures++;
+    }
+    ::printf( "%u synthetic textures compared\n", numFixtures );
+
+    // Textures of a real .dat, if given
+    auto path = TestDatFile::path( p_argc, p_argv );
+    TestDatFile datFile;
+    if ( !path || !datFile.open( path ) ) {
+        ::printf( "No .dat given, set GW2_DAT to also compare its textures.\n" );
+        return result.exitCode( );
+    }
+
+    std::vector<byte> texture;
+    uint numCompared = 0;
+    for ( auto entryNum : datFile.compressedEntries( MaxEntries ) ) {
+        // Only textures are inflated whole
+        if ( !datFile.readInflated( entryNum, texture, PeekSize ) || !TestDatFile::textureBlocksSize( texture ) ) {
+            continue;
+        }
+        if ( !datFile.readInflated( entryNum, texture ) ) {
+            continue;
+        }
+        char name[32];
+        ::snprintf( name, sizeof( name ), "entry %u", entryNum );
+        compareTexture( result, name, texture, nullptr );
+        numCompared++;
+    }
+
+    ::printf( "%u textures compared\n", numCompared );
+    TEST_CHECK( result, numCompared > 0 );
+    return result.exitCode( );
+}
@@ -0,0 +1,105 @@
+/** \file       test/VertexDecoderBenchmark.cpp
+ *  \brief      Times the decoders of the common vertex formats against the generic one.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Readers/VertexDecoder.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Vertices decoded per run. */
+    const uint NumVertices = 1 << 20;
+    /** Each decoder runs this many times, the fastest run counts. */
+    const uint NumRuns = 5;
+
+    typedef void ( *VertexDecoder )( const byte* p_data, uint p_vertexCount, uint32 p_vertexFormat, Vertex* po_vertices, Bounds& po_bounds );
+
+    /** Times a decoder on a format, returns the fastest run in seconds. */
+    double bestTime( VertexDecoder p_decoder, uint32 p_vertexFormat, const byte* p_data, Vertex* po_vertices ) {
+        double best = 0.0;
+        for ( uint run = 0; run < NumRuns; run++ ) {
+            Bounds bounds;
+            Stopwatch stopwatch;
+            p_decoder( p_data, NumVertices, p_vertexFormat, po_vertices, bounds );
+            auto time = stopwatch.seconds( );
+            if ( !run || time < best ) {
+                best = time;
+            }
+        }
+        return best;
+    }
+
+};
+
+int main( ) {
+    struct Format {
+        const char*     name;
+        uint32          format;
+    };
+    const Format formats[] = {
+        { "PositionUV16", CVF_PositionUV16 },
+        { "PositionNormalUV16", CVF_PositionNormalUV16 },
+        { "PositionNormalUV16x2", CVF_PositionNormalUV16x2 },
+        { "PositionNormalUV32", CVF_PositionNormalUV32 },
+        { "PositionNormalColorUV16", CVF_PositionNormalColorUV16 },
+        { "PositionNormalTangentUV16", CVF_PositionNormalTangentUV16 },
+        { "SkinnedPositionNormalUV16", CVF_SkinnedPositionNormalUV16 },
+    };
+
+    // Random 16-bit words, never infinities or NaNs as halves
+    std::mt19937 random( 0x56444543 );
+    uint maxSize = 0;
+    for ( auto const& format : formats ) {
+        maxSize = std::max( maxSize, vertexSize( format.format ) );
+    }
+    std::vector<uint16> words( ( static_cast<size_t>( NumVertices ) * maxSize + 1 ) / 2 );
+    for ( auto& it : words ) {
+        do {
+            it = static_cast<uint16>( random( ) );
+        } while ( ( it & 0x7c00 ) == 0x7c00 );
+    }
+    auto data = reinterpret_cast<const byte*>( words.data( ) );
+    std::vector<Vertex> vertices( NumVertices );
+
+    ::printf( "%u vertices per run, best of %u runs\n", NumVertices, NumRuns );
+    ::printf( "format                     size   generic Mvertices/s   specialized Mvertices/s   speedup\n" );
+    for ( auto const& format : formats ) {
+        auto genericTime = bestTime( &decodeVerticesGeneric, format.format, data, vertices.data( ) );
+        auto specializedTime = bestTime( &decodeVertices, format.format, data, vertices.data( ) );
+        ::printf( "%-25s  %4u   %19.1f   %23.1f   %6.2fx\n", format.name, vertexSize( format.format ),
+            genericTime > 0.0 ? NumVertices / genericTime / 1e6 : 0.0,
+            specializedTime > 0.0 ? NumVertices / specializedTime / 1e6 : 0.0,
+            specializedTime > 0.0 ? genericTime / specializedTime : 0.0 );
+    }
+    return EXIT_SUCCESS;
+}
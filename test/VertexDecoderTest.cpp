@@ -0,0 +1,251 @@
+/** \file       test/VertexDecoderTest.cpp
+ *  \brief      Checks the vertex decoders against the reader they replaced.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Readers/VertexDecoder.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Gets the size of a vertex the way the old reader did. */
+    uint referenceVertexSize( uint32 p_vertexFormat ) {
+        uint uvCount = 0;
+        uint uvField = ( p_vertexFormat & ANFVF_UV32Mask ) >> 0x08;
+        for ( uint i = 0; i < 7; i++ ) {
+            if ( ( ( uvField >> i ) & 1 ) != 0 )
+                uvCount++;
+        }
+
+        uvField = ( p_vertexFormat & ANFVF_UV16Mask ) >> 0x10;
+        uint uv16Count = 0;
+        for ( uint i = 0; i < 7; i++ ) {
+            if ( ( ( uvField >> i ) & 1 ) != 0 )
+                uv16Count++;
+        }
+
+        return ( ( p_vertexFormat & ANFVF_Position ) * 12 )
+            + ( ( p_vertexFormat & ANFVF_Weights ) * 2 )
+            + ( ( p_vertexFormat & ANFVF_Group ) )
+            + ( ( ( p_vertexFormat & ANFVF_Normal ) >> 3 ) * 12 )
+            + ( ( p_vertexFormat & ANFVF_Color ) >> 2 )
+            + ( ( ( p_vertexFormat & ANFVF_Tangent ) >> 5 ) * 12 )
+            + ( ( ( p_vertexFormat & ANFVF_Bitangent ) >> 6 ) * 12 )
+            + ( ( ( p_vertexFormat & ANFVF_TangentFrame ) >> 7 ) * 12 )
+            + ( uvCount * 8 )
+            + ( uv16Count * 4 )
+            + ( ( ( p_vertexFormat & ANFVF_Unknown1 ) >> 24 ) * 48 )
+            + ( ( ( p_vertexFormat & ANFVF_Unknown2 ) >> 25 ) * 4 )
+            + ( ( ( p_vertexFormat & ANFVF_Unknown3 ) >> 26 ) * 4 )
+            + ( ( ( p_vertexFormat & ANFVF_Unknown4 ) >> 27 ) * 16 )
+            + ( ( ( p_vertexFormat & ANFVF_PositionCompressed ) >> 28 ) * 6 )
+            + ( ( ( p_vertexFormat & ANFVF_Unknown5 ) >> 29 ) * 12 );
+    }
+
+    /** Decodes vertices the way the old reader did, field by field, then
+    *  rotated to OpenGL coordinates. */
+    void referenceDecode( const byte* p_data, uint p_vertexCount, uint32 p_vertexFormat, Vertex* po_vertices ) {
+        uint vertexSize = referenceVertexSize( p_vertexFormat );
+
+        for ( uint i = 0; i < p_vertexCount; i++ ) {
+            auto pos = &p_data[i * vertexSize];
+            Vertex& vertex = po_vertices[i];
+            vertex.position = glm::vec3( 0.0f );
+            vertex.normal = glm::vec3( 0.0f );
+            vertex.uv = glm::vec2( 0.0f );
+            uint uvIndex = 0;
+
+            if ( p_vertexFormat & ANFVF_Position ) {
+                ::memcpy( &vertex.position, pos, sizeof( vertex.position ) );
+                pos += sizeof( vertex.position );
+            }
+            if ( p_vertexFormat & ANFVF_Weights ) {
+                pos += 4;
+            }
+            if ( p_vertexFormat & ANFVF_Group ) {
+                pos += 4;
+            }
+            if ( p_vertexFormat & ANFVF_Normal ) {
+                ::memcpy( &vertex.normal, pos, sizeof( vertex.normal ) );
+                pos += sizeof( vertex.normal );
+            }
+            if ( p_vertexFormat & ANFVF_Color ) {
+                pos += sizeof( uint32 );
+            }
+            if ( p_vertexFormat & ANFVF_Tangent ) {
+                pos += sizeof( glm::vec3 );
+            }
+            if ( p_vertexFormat & ANFVF_Bitangent ) {
+                pos += sizeof( glm::vec3 );
+            }
+            if ( p_vertexFormat & ANFVF_TangentFrame ) {
+                pos += sizeof( glm::vec3 );
+            }
+            // The old reader never counted the 32-bit sets, so the last one stuck
+            uint uvFlag = ( p_vertexFormat & ANFVF_UV32Mask ) >> 8;
+            for ( uint j = 0; j < 7; j++ ) {
+                if ( ( ( uvFlag >> j ) & 1 ) == 0 ) {
+                    continue;
+                }
+                if ( uvIndex < 1 ) {
+                    ::memcpy( &vertex.uv, pos, sizeof( vertex.uv ) );
+                }
+                pos += sizeof( vertex.uv );
+            }
+            uvFlag = ( p_vertexFormat & ANFVF_UV16Mask ) >> 16;
+            for ( uint j = 0; j < 7; j++ ) {
+                if ( ( ( uvFlag >> j ) & 1 ) == 0 ) {
+                    continue;
+                }
+                if ( uvIndex < 1 ) {
+                    auto uv = reinterpret_cast<const half*>( pos );
+                    vertex.uv.x = uv[0];
+                    vertex.uv.y = uv[1];
+                    uvIndex++;
+                }
+                pos += sizeof( half ) * 2;
+            }
+            if ( p_vertexFormat & ANFVF_Unknown1 ) {
+                pos += 48;
+            }
+            if ( p_vertexFormat & ANFVF_Unknown2 ) {
+                pos += 4;
+            }
+            if ( p_vertexFormat & ANFVF_Unknown3 ) {
+                pos += 4;
+            }
+            if ( p_vertexFormat & ANFVF_Unknown4 ) {
+                pos += 16;
+            }
+            if ( p_vertexFormat & ANFVF_PositionCompressed ) {
+                vertex.position.x = *reinterpret_cast<const half*>( pos + 0 * sizeof( half ) );
+                vertex.position.y = *reinterpret_cast<const half*>( pos + 1 * sizeof( half ) );
+                vertex.position.z = *reinterpret_cast<const half*>( pos + 2 * sizeof( half ) );
+            }
+
+            // DirectX coordinate to OpenGL coordinate by rotate ZY and invert Z
+            const glm::mat3 transform = glm::mat3(
+                glm::vec3( 1.0f, 0.0f, 0.0f ),
+                glm::vec3( 0.0f, 0.0f, -1.0f ),
+                glm::vec3( 0.0f, -1.0f, 0.0f )
+                );
+            vertex.position = transform * vertex.position;
+            if ( p_vertexFormat & ANFVF_Normal ) {
+                vertex.normal = transform * vertex.normal;
+            }
+        }
+    }
+
+    /** Formats the decoders are laid out for, then some the game may use. */
+    const uint32 Formats[] = {
+        CVF_PositionUV16,
+        CVF_PositionNormalUV16,
+        CVF_PositionNormalUV16x2,
+        CVF_PositionNormalUV32,
+        CVF_PositionNormalColorUV16,
+        CVF_PositionNormalTangentUV16,
+        CVF_SkinnedPositionNormalUV16,
+        ANFVF_Position | ANFVF_Normal | ( 3 << 8 ),
+        ANFVF_Position | ANFVF_Normal | ( 3 << 8 ) | ( 1 << 16 ),
+        ANFVF_Position | ANFVF_Normal | ( 1 << 15 ) | ( 1 << 23 ),
+        ANFVF_Position | ( 0x81 << 16 ),
+        ANFVF_PositionCompressed | ANFVF_Normal | ( 1 << 16 ),
+        ANFVF_Position | ANFVF_Bitangent | ANFVF_TangentFrame | ANFVF_Unknown1 | ANFVF_Unknown5,
+        0,
+    };
+
+    /** Amounts of vertices decoded, around the chunk size. */
+    const uint Counts[] = { 1, 255, 256, 257, 1000 };
+
+    bool sameVector( const glm::vec3& p_a, const glm::vec3& p_b ) {
+        return p_a.x == p_b.x && p_a.y == p_b.y && p_a.z == p_b.z;
+    }
+
+};
+
+int main( ) {
+    TestResult result;
+    std::mt19937 random( 0x56455254 );
+
+    std::vector<uint32> formats( Formats, Formats + ArraySize( Formats ) );
+    for ( uint i = 0; i < 64; i++ ) {
+        formats.push_back( random( ) & 0x3fffffff );
+    }
+
+    for ( auto format : formats ) {
+        uint size = vertexSize( format );
+        TEST_CHECK( result, size == referenceVertexSize( format ) );
+
+        for ( auto count : Counts ) {
+            // Random 16-bit words, never infinities or NaNs as halves. Taken
+            // two at a time as 32-bit floats, they are finite too.
+            std::vector<uint16> words( ( static_cast<size_t>( count ) * size + 1 ) / 2 );
+            for ( auto& it : words ) {
+                do {
+                    it = static_cast<uint16>( random( ) );
+                } while ( ( it & 0x7c00 ) == 0x7c00 );
+            }
+            auto data = reinterpret_cast<const byte*>( words.data( ) );
+
+            std::vector<Vertex> expected( count );
+            std::vector<Vertex> actual( count );
+            referenceDecode( data, count, format, expected.data( ) );
+            Bounds bounds;
+            decodeVertices( data, count, format, actual.data( ), bounds );
+
+            // The decoders of the common formats match the generic one
+            std::vector<Vertex> generic( count );
+            Bounds genericBounds;
+            decodeVerticesGeneric( data, count, format, generic.data( ), genericBounds );
+            TEST_CHECK( result, !::memcmp( generic.data( ), actual.data( ), count * sizeof( Vertex ) ) );
+            TEST_CHECK( result, !::memcmp( &genericBounds, &bounds, sizeof( Bounds ) ) );
+
+            uint numDifferent = 0;
+            glm::vec3 min = actual[0].position;
+            glm::vec3 max = actual[0].position;
+            for ( uint i = 0; i < count; i++ ) {
+                if ( !sameVector( actual[i].position, expected[i].position ) || !sameVector( actual[i].normal, expected[i].normal )
+                    || actual[i].uv.x != expected[i].uv.x || actual[i].uv.y != expected[i].uv.y ) {
+                    numDifferent++;
+                }
+                min = glm::min( min, actual[i].position );
+                max = glm::max( max, actual[i].position );
+            }
+            TEST_CHECK( result, numDifferent == 0 );
+            TEST_CHECK( result, sameVector( bounds.min, min ) && sameVector( bounds.max, max ) );
+            if ( numDifferent ) {
+                ::fprintf( stderr, "format 0x%08x, %u vertices: %u differ\n", format, count, numDifferent );
+            }
+        }
+    }
+
+    return result.exitCode( );
+}
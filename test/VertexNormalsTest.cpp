@@ -0,0 +1,149 @@
+/** \file       test/VertexNormalsTest.cpp
+ *  \brief      Checks that computed vertex normals don't depend on the amount of threads.
+ *  \author     Khralkatorrix
+ */
+
+/**
+ * Copyright (C) 2024 Khralkatorrix <https://github.com/kytulendu>
+ *
+ * This file is part of Gw2Browser.
+ *
+ * Gw2Browser is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "stdafx.h"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "Readers/VertexNormals.h"
+
+#include "TestUtil.h"
+
+using namespace gw2b;
+
+namespace {
+
+    /** Vertices along each side of the grid. */
+    const uint GridSize = 128;
+    /** Faces around the fan vertex, so that its sum has many terms. */
+    const uint NumFanFaces = 512;
+
+    struct NormalsMesh {
+        std::vector<Vertex>     vertices;
+        std::vector<Triangle>   triangles;
+        uint                    lone;       // Vertex used only by degenerate faces
+    };
+
+    uint addVertex( NormalsMesh& p_mesh, const glm::vec3& p_position ) {
+        Vertex vertex;
+        vertex.position = p_position;
+        vertex.normal = glm::vec3( 0.0f, 0.0f, 0.0f );
+        vertex.uv = glm::vec2( 0.0f, 0.0f );
+        p_mesh.vertices.push_back( vertex );
+        return static_cast<uint>( p_mesh.vertices.size( ) - 1 );
+    }
+
+    void addFace( NormalsMesh& p_mesh, uint p_a, uint p_b, uint p_c ) {
+        Triangle triangle;
+        triangle.index1 = static_cast<uint16>( p_a );
+        triangle.index2 = static_cast<uint16>( p_b );
+        triangle.index3 = static_cast<uint16>( p_c );
+        p_mesh.triangles.push_back( triangle );
+    }
+
+    /** Builds a bumpy grid, each vertex shared by up to six faces, with a fan
+    *  of faces around one vertex, and degenerate faces mixed in: repeated
+    *  indices, repeated positions and indices out of range. */
+    void normalsMesh( NormalsMesh& po_mesh ) {
+        TestRandom random( 0x4e524d4c );
+
+        for ( uint y = 0; y < GridSize; y++ ) {
+            for ( uint x = 0; x < GridSize; x++ ) {
+                float height = random.range( 0, 1000 ) / 250.0f;
+                addVertex( po_mesh, glm::vec3( static_cast<float>( x ), height, static_cast<float>( y ) ) );
+            }
+        }
+
+        for ( uint y = 0; y + 1 < GridSize; y++ ) {
+            for ( uint x = 0; x + 1 < GridSize; x++ ) {
+                uint corner = y * GridSize + x;
+                addFace( po_mesh, corner, corner + GridSize, corner + 1 );
+                addFace( po_mesh, corner + 1, corner + GridSize, corner + GridSize + 1 );
+                if ( !( ( x + y ) % 7 ) ) {
+                    addFace( po_mesh, corner, corner, corner + 1 );
+                }
+            }
+        }
+
+        uint hub = addVertex( po_mesh, glm::vec3( GridSize / 2.0f, 8.0f, GridSize / 2.0f ) );
+        for ( uint i = 0; i < NumFanFaces; i++ ) {
+            uint a = random.range( 0, GridSize * GridSize - 1 );
+            uint b = random.range( 0, GridSize * GridSize - 1 );
+            addFace( po_mesh, hub, a, b );
+        }
+
+        // Same positions as a grid vertex give faces of no area
+        po_mesh.lone = addVertex( po_mesh, po_mesh.vertices[0].position );
+        uint twin = addVertex( po_mesh, po_mesh.vertices[0].position );
+        addFace( po_mesh, po_mesh.lone, twin, 0 );
+        addFace( po_mesh, po_mesh.lone, po_mesh.lone, po_mesh.lone );
+        addFace( po_mesh, 1, 2, static_cast<uint>( po_mesh.vertices.size( ) ) );
+        addFace( po_mesh, 0xffff, GridSize, GridSize + 1 );
+    }
+
+    bool isFinite( const glm::vec3& p_vector ) {
+        return std::isfinite( p_vector.x ) && std::isfinite( p_vector.y ) && std::isfinite( p_vector.z );
+    }
+
+};
+
+int main( ) {
+    TestResult result;
+
+    NormalsMesh mesh;
+    normalsMesh( mesh );
+
+    omp_set_num_threads( 1 );
+    auto serial = mesh.vertices;
+    computeVertexNormals( mesh.triangles, serial );
+
+    // The lone vertex only has degenerate faces
+    TEST_CHECK( result, glm::length( serial[mesh.lone].normal ) == 0.0f );
+    uint numBad = 0;
+    for ( uint i = 0; i < GridSize * GridSize; i++ ) {
+        if ( !isFinite( serial[i].normal ) || !( glm::length( serial[i].normal ) > 0.0f ) ) {
+            numBad++;
+        }
+    }
+    TEST_CHECK( result, numBad == 0 );
+
+    uint numThreads = std::max( 4, omp_get_num_procs( ) );
+    for ( uint threads = 2; threads <= numThreads; threads *= 2 ) {
+        omp_set_num_threads( static_cast<int>( threads ) );
+        auto parallel = mesh.vertices;
+        computeVertexNormals( mesh.triangles, parallel );
+
+        bool same = !::memcmp( parallel.data( ), serial.data( ), serial.size( ) * sizeof( Vertex ) );
+        ::printf( "%u threads: %s\n", threads, same ? "same as 1 thread" : "differs from 1 thread" );
+        TEST_CHECK( result, same );
+    }
+
+    return result.exitCode( );
+}